@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "../utils/types.h"
+#include "../utils/config.h"
+
+namespace container {
+    enum NeoRepresentation : uint8_t {
+        NEO_CLUSTERED = 0,      // a slice of a segment shared with the neighboring vertices
+        NEO_RANGE_TREE = 1,
+        NEO_ART = 2,
+    };
+
+    enum NeoAccessKind : uint8_t {
+        NEO_ACCESS_LOOKUP = 0,  // has_edge, edge properties
+        NEO_ACCESS_SCAN = 1,    // neighbor iteration and intersection
+        NEO_ACCESS_WRITE = 2,
+    };
+
+    ///@brief The access pattern a vertex was last classified with, it moves the degrees at which the vertex changes
+    /// representation
+    enum NeoWorkloadProfile : uint8_t {
+        NEO_PROFILE_BALANCED = 0,
+        NEO_PROFILE_WRITE_HEAVY = 1,    // leaves the shared segments early, a write there copies the whole segment
+        NEO_PROFILE_LOOKUP_HEAVY = 2,   // reaches the ART early, it finds an edge without searching a segment
+        NEO_PROFILE_SCAN_HEAVY = 3,     // stays in the contiguous segments of a RangeTree longer
+    };
+
+    ///@brief Degrees at which a vertex changes representation. It is promoted once its degree reaches a promote degree
+    /// and demoted once it falls below the matching demote degree, in between it keeps the representation it has.
+    struct NeoThresholds {
+        uint64_t range_promote;     // clustered -> RangeTree, at most range_leaf_size / 2
+        uint64_t art_promote;       // RangeTree -> ART
+        uint64_t range_demote;      // RangeTree -> clustered
+        uint64_t art_demote;        // ART -> RangeTree
+    };
+
+    inline NeoRepresentation representation_of(const NeoVertex &vertex) {
+        return vertex.is_art ? NEO_ART : vertex.is_independent ? NEO_RANGE_TREE : NEO_CLUSTERED;
+    }
+
+    NeoThresholds adaptive_thresholds(const NeoLayout* layout, NeoWorkloadProfile profile);
+
+    ///@return the representation a vertex of degree should move to, current while it is inside the hysteresis band
+    NeoRepresentation adaptive_target(const NeoThresholds &thresholds, NeoRepresentation current, uint64_t degree);
+
+    ///@return true for one of every ADAPTIVE_SAMPLE_RATE calls of the thread
+    inline bool adaptive_sample() {
+        static thread_local uint32_t countdown = 0;
+        if(countdown != 0) {
+            countdown--;
+            return false;
+        }
+        countdown = ADAPTIVE_SAMPLE_RATE - 1;
+        return true;
+    }
+
+    ///@brief Sampled accesses of the vertices of one tree and the profile each of them was last classified with.
+    /// The counters of a vertex saturate at 2^ADAPTIVE_COUNTER_BITS - 1 and share one word, readers record with a CAS.
+    class NeoAccessStats {
+    public:
+        explicit NeoAccessStats(uint64_t group_size);
+
+        ~NeoAccessStats();
+
+        NeoAccessStats(const NeoAccessStats &) = delete;
+        NeoAccessStats &operator=(const NeoAccessStats &) = delete;
+
+        ///@return whether the vertex gathered enough samples to be classified again
+        bool record(uint64_t idx, NeoAccessKind kind);
+
+        [[nodiscard]] NeoWorkloadProfile profile(uint64_t idx) const {
+            return (NeoWorkloadProfile) profiles[idx].load(std::memory_order_relaxed);
+        }
+
+        ///@brief Classify the vertex from its samples once it has ADAPTIVE_MIN_SAMPLES, then halve them so that the
+        /// profile follows a shifting workload. A vertex keeps its profile until the share of the favoured access kind
+        /// drops ADAPTIVE_HYSTERESIS_PERCENT below ADAPTIVE_DOMINANT_PERCENT.
+        ///@return whether the profile changed
+        bool classify(uint64_t idx);
+
+    private:
+        std::atomic<uint32_t>* counters;
+        std::atomic<uint8_t>* profiles;
+    };
+}
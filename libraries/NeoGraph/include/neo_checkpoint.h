@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "utils/config.h"
+#include "utils/types.h"
+
+namespace container {
+    class NeoTreeVersion;
+    struct NeoGraphIndex;
+    struct WriterTraceBlock;
+
+    // -----------------------------Checkpoint file format-----------------------------
+    // A checkpoint stores one NeoTreeVersion per tree, all taken at the same timestamp. Every section starts at a page
+    // boundary and holds a flat array of fixed-size entries; pointers are replaced by indexes into other sections.
+    // Segments are stored at their full RANGE_LEAF_SIZE capacity, the header records the NeoLayout the trees were built with.
+    constexpr uint64_t CHECKPOINT_MAGIC = 0x335450434b4f454eULL; // "NEOKCPT3"
+    constexpr uint64_t CHECKPOINT_PAGE_SIZE = 4096;
+    constexpr uint64_t CHECKPOINT_NONE = std::numeric_limits<uint64_t>::max();
+
+    enum CheckpointSectionType {
+        CHECKPOINT_TREES = 0,           // CheckpointTree per forest slot
+        CHECKPOINT_VERTEX_MAPS = 1,     // NeoVertex[1 << vertex_group_bits] per existing tree
+        CHECKPOINT_RANGE_NODES = 2,     // CheckpointRangeNode, the range node blocks of all trees
+        CHECKPOINT_NEIGHBORHOODS = 3,   // CheckpointNeighborhood per independent vertex
+        CHECKPOINT_RANGE_TREE_NODES = 4,// CheckpointRangeNode, the node arrays of all RangeTrees
+        CHECKPOINT_RANGE_SEGMENTS = 5,  // RangeElement[RANGE_LEAF_SIZE] per segment
+        CHECKPOINT_RANGE_PROPERTIES = 6,// Property_t[RANGE_LEAF_SIZE] per segment property
+        CHECKPOINT_ART_ELEMENTS = 7,    // sorted RangeElement list of every serialized ART
+        CHECKPOINT_ART_PROPERTIES = 8,  // Property_t per ART element
+        CHECKPOINT_VERTEX_DICT = 9,     // external ID (uint64_t) per internal one, empty without a vertex dictionary
+        CHECKPOINT_SECTION_NUM = 10,
+    };
+
+    struct CheckpointSection {
+        uint64_t offset;
+        uint64_t size;  // in bytes
+    };
+
+    struct CheckpointHeader {
+        uint64_t magic;
+        uint32_t vertex_group_bits;
+        uint32_t range_leaf_size;   // of the layout
+        uint32_t edge_property_num;
+        uint32_t segment_capacity;  // RANGE_LEAF_SIZE
+        uint64_t art_extract_threshold;
+        uint64_t element_size;      // sizeof(RangeElement), 8 in a NEO_WIDE_VERTEX_ID build
+        uint64_t timestamp;
+        uint64_t tree_num;
+        uint64_t vertex_count;
+        uint64_t edge_count;
+        CheckpointSection sections[CHECKPOINT_SECTION_NUM];
+    };
+
+    struct CheckpointTree {
+        uint64_t vertex_map_idx;    // CHECKPOINT_NONE if the slot holds no tree
+        uint64_t node_begin;
+        uint64_t node_num;
+    };
+
+    ///@brief Clustered vertices keep range_node_idx and neighbor_offset; the neighborhood_ptr of an independent vertex
+    /// is the index of its CheckpointNeighborhood
+    struct CheckpointNeighborhood {
+        uint64_t begin; // first RangeTree node, or first ART element
+        uint64_t num;   // RangeTree nodes, or ART elements
+    };
+
+    struct CheckpointRangeNode {
+        uint64_t key;
+        uint64_t size;
+        uint64_t segment;
+        uint64_t property;  // CHECKPOINT_NONE if the node carries no property vector
+    };
+
+    ///@brief Read-only mapping of a checkpoint file
+    class NeoCheckpoint {
+    public:
+        ///@param populate fault the whole file in before returning (MAP_POPULATE)
+        explicit NeoCheckpoint(const std::string &path, bool populate = false);
+        NeoCheckpoint(const NeoCheckpoint &) = delete;
+        NeoCheckpoint &operator=(const NeoCheckpoint &) = delete;
+        ~NeoCheckpoint();
+
+        [[nodiscard]] const CheckpointHeader &header() const {
+            return *(const CheckpointHeader*) data;
+        }
+
+        template<typename T>
+        [[nodiscard]] const T* section(CheckpointSectionType type) const {
+            return (const T*) (data + header().sections[type].offset);
+        }
+
+        template<typename T>
+        [[nodiscard]] uint64_t section_num(CheckpointSectionType type) const {
+            return header().sections[type].size / sizeof(T);
+        }
+
+        [[nodiscard]] const RangeElement* segment(uint64_t idx) const {
+            return section<RangeElement>(CHECKPOINT_RANGE_SEGMENTS) + idx * RANGE_LEAF_SIZE;
+        }
+
+        [[nodiscard]] const Property_t* property(uint64_t idx) const {
+            return section<Property_t>(CHECKPOINT_RANGE_PROPERTIES) + idx * RANGE_LEAF_SIZE;
+        }
+
+        [[nodiscard]] NeoLayout layout() const {
+            return NeoLayout{header().vertex_group_bits, header().range_leaf_size, header().art_extract_threshold};
+        }
+
+        [[nodiscard]] uint64_t size() const {
+            return length;
+        }
+
+        [[nodiscard]] const char* begin() const {
+            return data;
+        }
+
+    private:
+        int fd;
+        const char* data;
+        uint64_t length;
+    };
+
+    ///@brief Dump the given versions (indexed by tree direction) as a checkpoint, the file is replaced atomically
+    ///@param vertex_dict see NeoVertexDictionary::externals, empty if the graph uses its vertex IDs as they are
+    void save_checkpoint(const std::vector<NeoTreeVersion*> &versions, const NeoLayout &layout, uint64_t timestamp, const std::string &path,
+                         const std::vector<uint64_t> &vertex_dict = {});
+
+    ///@brief Rebuild the forest of an empty index from a checkpoint, segments are copied out of the mapping
+    ///@note throws std::runtime_error if the checkpoint was written with another layout than the index's
+    void load_checkpoint(const NeoCheckpoint &checkpoint, NeoGraphIndex* index, WriterTraceBlock* trace_block);
+}
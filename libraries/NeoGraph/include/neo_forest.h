@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "../utils/config.h"
+#include "neo_tree.h"
+
+namespace container {
+    ///@brief Directory from tree direction to NeoTree, readable without any lock while it grows.
+    /// Slots live in chunks of FOREST_CHUNK_SIZE that are appended and never moved, so a published tree stays where it is
+    /// until clear(). Only the array of chunk pointers is reallocated when it is full: the copy is published with a
+    /// release store and the old array is kept until destruction for the readers that may still hold it.
+    class NeoForest {
+    public:
+        explicit NeoForest(const NeoLayout* layout);
+
+        ~NeoForest();
+
+        NeoForest(const NeoForest &) = delete;
+        NeoForest &operator=(const NeoForest &) = delete;
+
+        ///@return nullptr if no tree has been published at direction
+        [[nodiscard]] NeoTree* get(uint64_t direction) const {
+            auto chunk_idx = direction >> FOREST_CHUNK_BITS;
+            auto directory = current.load(std::memory_order_acquire);
+            if(chunk_idx >= directory->capacity) {
+                return nullptr;
+            }
+            auto chunk = directory->chunks[chunk_idx].load(std::memory_order_acquire);
+            if(chunk == nullptr) {
+                return nullptr;
+            }
+            return chunk[direction & FOREST_CHUNK_MASK].load(std::memory_order_acquire);
+        }
+
+        ///@return one past the largest direction a tree has been published at
+        [[nodiscard]] uint64_t size() const {
+            return tree_num.load(std::memory_order_acquire);
+        }
+
+        ///@brief Publish tree at direction, the forest owns it from now on
+        ///@return the tree at direction, which is not `tree` if another writer published first (`tree` is deleted then)
+        NeoTree* install(uint64_t direction, NeoTree* tree);
+
+        ///@return the tree at direction, an empty one is published if there is none
+        NeoTree* get_or_create(uint64_t direction);
+
+        ///@brief Delete every tree, the chunks are kept
+        ///@note not thread-safe
+        void clear();
+
+    private:
+        using Slot = std::atomic<NeoTree*>;
+
+        struct Directory {
+            const uint64_t capacity;
+            std::atomic<Slot*>* const chunks;
+            Directory* const prev;  // retired array, freed with the forest
+
+            Directory(uint64_t capacity, Directory* prev);
+
+            ~Directory();
+        };
+
+        const NeoLayout* const layout;
+        std::atomic<Directory*> current;
+        std::atomic<uint64_t> tree_num{0};
+        std::mutex grow_mutex;
+
+        ///@return the slot of direction, allocating its chunk (and a larger directory) if needed
+        Slot* reserve(uint64_t direction);
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "utils/config.h"
+#include "utils/types.h"
+#include "neo_checkpoint.h"
+
+namespace container {
+    ///@brief How the pages of a frozen graph are brought in
+    enum FrozenPrefault {
+        FROZEN_PREFAULT_NONE = 0,       // fault pages in on first touch, default kernel readahead
+        FROZEN_PREFAULT_RANDOM = 1,     // no readahead, for point lookups on a graph larger than memory
+        FROZEN_PREFAULT_WILLNEED = 2,   // start asynchronous readahead of the whole file when it is opened
+        FROZEN_PREFAULT_POPULATE = 3,   // fault every page in before the constructor returns
+    };
+
+    ///@brief Read-only graph served straight from a mapped checkpoint (see NeoSnapshot::save).
+    /// Reads take no reference counts, register no reader and walk no version chain: a frozen graph never changes, so
+    /// it is safe to share between any number of threads for its whole lifetime. Clustered neighborhoods and RangeTree
+    /// segments are read in place, ART neighborhoods are stored as flat sorted lists in the checkpoint.
+    class NeoFrozenGraph {
+    public:
+        using Chunk = std::span<const RangeElement>;
+
+        explicit NeoFrozenGraph(const std::string &path, FrozenPrefault prefault = FROZEN_PREFAULT_WILLNEED);
+
+        NeoFrozenGraph(const NeoFrozenGraph &) = delete;
+        NeoFrozenGraph &operator=(const NeoFrozenGraph &) = delete;
+
+        [[nodiscard]] uint64_t timestamp() const {
+            return checkpoint.header().timestamp;
+        }
+
+        [[nodiscard]] uint64_t vertex_count() const {
+            return checkpoint.header().vertex_count;
+        }
+
+        [[nodiscard]] uint64_t edge_count() const {
+            return checkpoint.header().edge_count;
+        }
+
+        [[nodiscard]] bool has_vertex(uint64_t vertex) const;
+
+        [[nodiscard]] bool has_edge(uint64_t src, uint64_t dest) const;
+
+        [[nodiscard]] uint64_t get_degree(uint64_t src) const;
+
+        bool get_neighbor(uint64_t src, std::vector<uint64_t> &neighbor) const;
+
+        ///@return the sorted neighbors if they are stored contiguously (clustered and ART vertices), nullptr otherwise
+        [[nodiscard]] const RangeElement* get_neighbor_addr(uint64_t src) const;
+
+#if EDGE_PROPERTY_NUM == 1
+        [[nodiscard]] Property_t get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const;
+#endif
+
+        ///@brief Hand the sorted neighbors out as contiguous chunks, one per RangeTree segment or a single one otherwise
+        template<typename F>
+        void for_each_chunk(uint64_t src, F &&callback) const;
+
+        template<typename F>
+        void edges(uint64_t src, F &&callback) const;
+
+        void intersect(uint64_t src1, uint64_t src2, std::vector<uint64_t> &result) const;
+
+        uint64_t intersect(uint64_t src1, uint64_t src2) const;
+
+    private:
+        NeoCheckpoint checkpoint;
+        uint64_t tree_num;
+        const CheckpointTree* trees;
+        const NeoVertex* vertex_maps;
+        uint64_t vertex_group_bits;
+        const CheckpointRangeNode* range_nodes;
+        const CheckpointNeighborhood* neighborhoods;
+        const CheckpointRangeNode* range_tree_nodes;
+        const RangeElement* art_elements;
+#if EDGE_PROPERTY_NUM == 1
+        const Property_t* art_properties;
+#endif
+
+        ///@return nullptr if the tree of the vertex does not exist
+        [[nodiscard]] const NeoVertex* find_vertex(uint64_t vertex) const;
+
+        [[nodiscard]] const CheckpointRangeNode &clustered_node(uint64_t vertex, const NeoVertex &entry) const {
+            return range_nodes[trees[vertex >> vertex_group_bits].node_begin + entry.range_node_idx];
+        }
+
+        ///@return the neighbors of a non-RangeTree vertex
+        [[nodiscard]] const RangeElement* contiguous(uint64_t vertex, const NeoVertex &entry) const;
+
+        ///@return the neighbors of src, gathered into buffer when they are spread over RangeTree segments
+        const RangeElement* flatten(uint64_t src, std::vector<RangeElement> &buffer, uint64_t &size) const;
+    };
+
+    template<typename F>
+    void NeoFrozenGraph::for_each_chunk(uint64_t src, F &&callback) const {
+        auto entry = find_vertex(src);
+        if(entry == nullptr || entry->degree == 0) {
+            return;
+        }
+        if(!entry->is_independent || entry->is_art) {
+            callback(Chunk(contiguous(src, *entry), entry->degree));
+            return;
+        }
+        auto &neighborhood = neighborhoods[entry->neighborhood_ptr];
+        for(uint64_t i = neighborhood.begin; i < neighborhood.begin + neighborhood.num; i++) {
+            auto &node = range_tree_nodes[i];
+            if(node.size != 0) {
+                callback(Chunk(checkpoint.segment(node.segment), node.size));
+            }
+        }
+    }
+
+    template<typename F>
+    void NeoFrozenGraph::edges(uint64_t src, F &&callback) const {
+        for_each_chunk(src, [&](Chunk chunk) {
+            for(auto dst: chunk) {
+                callback((uint64_t) dst, 0.0);
+            }
+        });
+    }
+}
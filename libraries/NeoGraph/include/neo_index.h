@@ -15,23 +15,36 @@
 
 #include "../utils/types.h"
 #include "neo_tree.h"
+#include "neo_forest.h"
+#include "../utils/numa_topology.h"
 //#include "../utils/art_new/include/art.h"
 #include "../utils/c_art/include/art.h"
 
 // Definition
 namespace container {
     struct NeoGraphIndex {
-        std::vector<std::unique_ptr<NeoTree>> *forest;
+        NeoLayout layout;   // fixed once the forest holds a tree
+        NeoForest *forest;
 
-        NeoGraphIndex();
+        explicit NeoGraphIndex(const NeoLayout &layout);
+
+        ///@brief Switch an index without any tree to another layout
+        void set_layout(const NeoLayout &new_layout);
 
         ~NeoGraphIndex();
 
-        static inline uint64_t gen_tree_direction(uint64_t val) {
-            return val >> VERTEX_GROUP_BITS;
+        [[nodiscard]] inline uint64_t gen_tree_direction(uint64_t val) const {
+            return val >> layout.vertex_group_bits;
+        }
+
+        ///@return the NUMA node the tree of vertex lives on, see numa_home_node
+        [[nodiscard]] inline uint64_t home_node(uint64_t vertex) const {
+            return numa_home_node(gen_tree_direction(vertex));
         }
 
-        NeoTree* lock(uint64_t direction);
+        ///@param create publish an empty tree if there is none, so that writers creating a tree are serialized by its lock
+        ///@return nullptr if the tree does not exist and create is false
+        NeoTree* lock(uint64_t direction, bool create = false);
 
         void unlock(uint64_t direction);
 
@@ -100,11 +113,16 @@ namespace container {
 
         [[nodiscard]] bool remove_edge(uint64_t src, uint64_t dest, WriterTraceBlock* trace_block);
 
+        ///@brief Remove edges sorted by source and destination, each tree they belong to gets one version. The trees
+        /// are served in parallel like insert_edge_batch, the caller holds their locks.
+        ///@return the number of edges that existed
+        uint64_t remove_edge_batch(const std::pair<RangeElement, RangeElement> *edges, uint64_t count, WriterTraceBlock* trace_block);
+
         void clear();
 
         NeoTree* commit(uint64_t direction, uint64_t timestamp);
 
-        void gc(uint64_t direction, WriterTraceBlock* trace_block);
+        void gc(uint64_t direction, WriterTraceBlock* trace_block, uint64_t read_timestamp);
         ///@return false if vertex does not exist
         template<typename F>
         bool edges(uint64_t src, F &&callback, uint64_t timestamp) const;
@@ -116,7 +134,7 @@ namespace container {
     ///@return false if vertex does not exist
     template<typename F>
     bool NeoGraphIndex::edges(uint64_t src, F &&callback, uint64_t timestamp) const {
-        auto iter = forest->at(gen_tree_direction(src)).get();
+        auto iter = forest->get(gen_tree_direction(src));
         if(iter != nullptr) {
             iter->edges(src, std::forward<F>(callback), timestamp);
             return true;
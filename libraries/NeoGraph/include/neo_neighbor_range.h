@@ -0,0 +1,76 @@
+#pragma once
+
+#include <span>
+#include "neo_range_tree.h"
+#include "../utils/types.h"
+#include "../utils/config.h"
+
+namespace container {
+    ///@brief Zero-copy view over the neighborhood of a vertex in one tree version.
+    /// The sorted neighbors are handed out as contiguous chunks: the whole list of a clustered vertex, one chunk per
+    /// segment of a RangeTree, and one chunk per leaf of an ART. 32-bit ART leaves are exposed in place, the compressed
+    /// ones are decoded into a block on the stack, so a chunk is only valid inside the callback.
+    /// The view must not outlive the snapshot (or version reference) it was taken from.
+    class NeighborRange {
+    public:
+        using Chunk = std::span<const RangeElement>;
+
+        NeighborRange() = default;
+
+        explicit NeighborRange(NeoVertex vertex): vertex(vertex) {}
+
+        [[nodiscard]] uint64_t size() const {
+            return vertex.degree;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return vertex.degree == 0;
+        }
+
+        ///@return true if all neighbors are handed out in a single chunk
+        [[nodiscard]] bool is_contiguous() const {
+            return !vertex.is_independent;
+        }
+
+        ///@return the neighbors of a clustered vertex, or an empty chunk if they are stored independently
+        [[nodiscard]] Chunk contiguous() const {
+            if(!is_contiguous() || empty()) {
+                return {};
+            }
+            return {(RangeElement*) (uintptr_t) vertex.neighborhood_ptr + vertex.neighbor_offset, vertex.degree};
+        }
+
+        template<typename F>
+        void for_each_chunk(F &&callback) const;
+
+    private:
+        NeoVertex vertex{};
+    };
+
+    template<typename F>
+    void NeighborRange::for_each_chunk(F &&callback) const {
+        if(empty()) {
+            return;
+        }
+        if(!vertex.is_independent) {
+            callback(contiguous());
+        } else if(!vertex.is_art) {
+            for(auto& node: ((RangeTree*) (uintptr_t) vertex.neighborhood_ptr)->node_block) {
+                if(node.size != 0) {
+                    callback(Chunk(((RangeElementSegment_t*) (uintptr_t) node.arr_ptr)->value.data(), node.size));
+                }
+            }
+        } else {
+            std::array<RangeElement, ART_LEAF_SIZE> block;
+            ((ART*) (uintptr_t) vertex.neighborhood_ptr)->for_each_leaf([&](ARTLeaf* leaf) {
+                if(leaf->type == LEAF32) {
+                    // the key of a 32-bit leaf carries no bits, the values are the elements themselves
+                    callback(Chunk(((ARTLeaf32*) leaf)->value->data(), leaf->size));
+                } else {
+                    leaf_decode(leaf, 0, leaf->size, block.data());
+                    callback(Chunk(block.data(), leaf->size));
+                }
+            });
+        }
+    }
+}
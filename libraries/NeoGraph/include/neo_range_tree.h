@@ -12,10 +12,12 @@ namespace container {
 //        std::array<InRangeNode, 32> node_block;
 //        std::array<uint64_t, 32> keys;
         std::vector<InRangeNode> node_block;
-        std::vector<uint32_t> keys;
+        std::vector<RangeElement> keys;
 
         RangeTree();
 
+        ~RangeTree();
+
         RangeTree(RangeElement* elements, Property_t** properties, uint64_t element_num, WriterTraceBlock* trace_block);
 
         RangeTree(std::vector<RangeElement>& elements, Property_t** properties, uint64_t element_num, WriterTraceBlock* trace_block);
@@ -48,6 +50,9 @@ namespace container {
 
         ART* range_tree2art(uint64_t src, uint64_t degree, uint64_t new_element, Property_t* new_property, std::vector<GCResourceInfo>& gc_resources, WriterTraceBlock* trace_block);
 
+        ///@brief Build an ART holding the elements of the tree, which is left untouched
+        ART* range_tree2art(uint64_t degree, WriterTraceBlock* trace_block) const;
+
         RangeTreeInsertElemBatchRes range_tree2art_batch(uint64_t src, uint64_t degree, const std::pair<RangeElement, RangeElement> *edges, Property_t** properties, uint64_t count, std::vector<GCResourceInfo>& gc_resources, WriterTraceBlock* trace_block);
 
 
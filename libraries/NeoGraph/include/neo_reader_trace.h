@@ -1,12 +1,14 @@
 #pragma once
 #include "utils/config.h"
 #include "utils/spin_lock.h"
+#include "utils/slab_allocator.h"
 #include "utils/types.h"
+#include "neo_vertex_map.h"
+#include "neo_wal.h"
 #include <vector>
-#include <stack>
 
 namespace container {
-    struct ReaderTraceBlock {
+    struct alignas(64) ReaderTraceBlock {   // one cache line per reader, readers on different cores never share one
     private:
         std::atomic<uint64_t> atomic_value;
 
@@ -19,6 +21,8 @@ namespace container {
         static constexpr uint64_t TIMESTAMP_MASK = (1ULL << 60) - 1; // 60 bits for timestamp
 
     public:
+        uint32_t shard{};   // shard of ActiveReaderTracer the block belongs to
+
         ReaderTraceBlock() : atomic_value(0) {}
 
         // Lock the ReaderTraceBlock
@@ -86,8 +90,28 @@ namespace container {
         }
     };
 
+    ///@brief Registry of the active readers, sharded by the core a reader registers on.
+    /// A shard is a list of chunks of INIT_READER_NUM blocks; a chunk is prepended when the shard is full and lives as
+    /// long as the tracer, so registering never fails. Every shard keeps the minimum timestamp of its stamped readers,
+    /// which lets the collectors skip the shards whose readers all see the newest version.
     struct ActiveReaderTracer{
-        std::array<ReaderTraceBlock, INIT_READER_NUM> blocks{};
+        struct ReaderChunk {
+            std::array<ReaderTraceBlock, INIT_READER_NUM> blocks{};
+            ReaderChunk* next{};
+        };
+
+        struct alignas(64) ReaderShard {
+            std::atomic<ReaderChunk*> chunks{};
+            SpinLock lock;  // serializes min_timestamp updates and chunk publication
+            std::atomic<uint64_t> min_timestamp{std::numeric_limits<uint64_t>::max()};
+            std::atomic<uint64_t> active{};     // registered readers
+            std::atomic<uint64_t> pending{};    // registered readers without a timestamp yet
+        };
+
+        std::array<ReaderShard, READER_SHARD_NUM> shards;
+
+        ActiveReaderTracer() = default;
+        ~ActiveReaderTracer();
 
         ReaderTraceBlock* reader_register();
 
@@ -97,39 +121,60 @@ namespace container {
 
         void reader_unregister(ReaderTraceBlock* block);
 
-        void get_active_reader_info(std::vector<uint64_t>&readers);
+        ///@brief Collect the distinct timestamps of the active readers in ascending order
+        ///@param below readers at or after below are reported once, as below itself
+        void get_active_reader_info(std::vector<uint64_t>&readers, uint64_t below = std::numeric_limits<uint64_t>::max());
 
+        ///@return the minimum timestamp of the active readers, max() if there is none
         uint64_t get_min_timestamp();
+
+    private:
+        ///@brief Wait for the timestamps of the pending readers of shard, and report them through callback
+        template<typename F>
+        static void scan_shard(ReaderShard &shard, F &&callback);
     };
 
     struct ARTNode_48;
     struct ARTNode_256;
 
+    ///@brief Writer state, the pools of the fixed-size structures are the writer's caches of the slab classes
+    /// (see utils/slab_allocator.h); they go back to the shared depot when the writer unregisters.
     struct WriterTraceBlock {
         SpinLock lock;
-        std::stack<RangeElementSegment_t*>* range_element_segments;
+        SlabCache range_element_segments;
 //        std::stack<InRangeElementSegment_t*>* in_range_element_segments;
-        std::stack<VertexMap_t*>* vertex_maps;
-        std::stack<std::array<uint32_t, ART_LEAF_SIZE>*>* art_leaf32s;
-        std::stack<std::array<uint64_t, ART_LEAF_SIZE>*>* art_leaf64s;
-        std::stack<ARTNode_48*>* art_node48s;
-        std::stack<ARTNode_256*>* art_node256s;
+        SlabCache vertex_maps;
+        SlabCache vertex_map_chunks;
+        SlabCache art_leaf32s;
+        SlabCache art_leaf64s;
+        SlabCache art_node48s;
+        SlabCache art_node256s;
 #if EDGE_PROPERTY_NUM > 0
-        std::stack<PropertyVec<RANGE_LEAF_SIZE>*>* range_prop_vecs;
-        std::stack<PropertyVec<ART_LEAF_SIZE>*>* art_prop_vecs;
+        SlabCache range_prop_vecs;
+        SlabCache art_prop_vecs;
 #endif
+        WALBuffer* wal_buffer;
+
+        WriterTraceBlock();
 
-        RangeElementSegment_t* allocate_range_element_segment();
+        ///@brief Segment of a clustered range node
+        ///@param filled the caller writes value[0, filled) itself, a recycled segment is only zeroed past it
+        RangeElementSegment_t* allocate_range_element_segment(uint16_t filled = 0);
+        ///@brief Segment of a RangeTree, the same pool as the clustered ones but counted apart in memory_report
+        RangeElementSegment_t* allocate_range_tree_segment(uint16_t filled = 0);
 //        InRangeElementSegment_t* allocate_inrange_element_segment();
-        VertexMap_t* allocate_vertex_map();
+        VertexMap* allocate_vertex_map();
+        VertexMapChunk_t* allocate_vertex_map_chunk();
         std::array<uint32_t, ART_LEAF_SIZE>* allocate_art_leaf32();
         std::array<uint64_t, ART_LEAF_SIZE>* allocate_art_leaf64();
         ARTNode_48* allocate_art_node48();
         ARTNode_256* allocate_art_node256();
 
         void deallocate_range_element_segment(RangeElementSegment_t *segment);
+        void deallocate_range_tree_segment(RangeElementSegment_t *segment);
 //        void deallocate_inrange_element_segment(InRangeElementSegment_t *segment);
-        void deallocate_vertex_map(VertexMap_t *segment);
+        void deallocate_vertex_map(VertexMap *segment);
+        void deallocate_vertex_map_chunk(VertexMapChunk_t *chunk);
         void deallocate_art_leaf32(std::array<uint32_t, ART_LEAF_SIZE> *leaf);
         void deallocate_art_leaf64(std::array<uint64_t, ART_LEAF_SIZE> *leaf);
         void deallocate_art_node48(ARTNode_48 *node);
@@ -145,6 +190,19 @@ namespace container {
 #endif
     };
 
+    // Return a structure allocated by a WriterTraceBlock without one at hand, e.g. when a whole tree is destroyed
+    void release_range_element_segment(RangeElementSegment_t *segment);
+    void release_range_tree_segment(RangeElementSegment_t *segment);
+    void release_vertex_map(VertexMap *map);
+    void release_vertex_map_chunk(VertexMapChunk_t *chunk);
+    void release_art_leaf32(std::array<uint32_t, ART_LEAF_SIZE> *leaf);
+    void release_art_node48(ARTNode_48 *node);
+    void release_art_node256(ARTNode_256 *node);
+#if EDGE_PROPERTY_NUM > 0
+    void release_range_prop_vec(PropertyVec<RANGE_LEAF_SIZE> *vec);
+    void release_art_prop_vec(PropertyVec<ART_LEAF_SIZE> *vec);
+#endif
+
     struct ActiveWriterTracer{
         std::array<WriterTraceBlock*, INIT_WRITER_NUM> blocks{};
 
@@ -173,7 +231,7 @@ namespace container {
 
     void set_timestamp(ReaderTraceBlock* block, uint64_t timestamp);
 
-    void get_active_reader_info(std::vector<uint64_t>&readers);
+    void get_active_reader_info(std::vector<uint64_t>&readers, uint64_t below = std::numeric_limits<uint64_t>::max());
 
     uint64_t get_min_timestamp();
 
@@ -184,4 +242,15 @@ namespace container {
     WriterTraceBlock* get_trace_block(uint64_t idx);
 
     void writer_unregister(WriterTraceBlock* block);
+
+    ///@brief Register the writer block owned by the calling batch pool worker, run when the worker starts
+    void batch_worker_register();
+
+    ///@brief Release the block of the calling batch pool worker, run when the pool shuts down
+    void batch_worker_unregister();
+
+    ///@return the writer block owned by the calling batch pool worker, the tasks a worker runs (nested ones included)
+    /// write with its block only
+    ///@note throws std::logic_error if the caller is not a worker of batch_update_pool()
+    WriterTraceBlock* batch_trace_block();
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 namespace  container {
     class NeoSnapshot {
         const NeoGraphIndex* index;
+        const NeoVertexDictionary* dictionary;  // saved with the checkpoint, nullptr if the graph has none
         uint64_t timestamp;
         ReaderTraceBlock* trace_block;
         std::vector<NeoTreeVersion*>* versions;
@@ -26,6 +27,9 @@ namespace  container {
 
         [[nodiscard]] RangeElement *get_neighbor_addr(uint64_t src) const;
 
+        ///@return a zero-copy view of the neighbors, valid as long as the snapshot is alive
+        [[nodiscard]] NeighborRange neighbors(uint64_t src) const;
+
 #if VERTEX_PROPERTY_NUM >= 1
         [[nodiscard]] Property_t get_vertex_property(uint64_t vertex, uint8_t property_id) const;
 #endif
@@ -46,14 +50,32 @@ namespace  container {
 
         uint64_t intersect(uint64_t src1, uint64_t src2) const;
 
+        ///@brief Write the snapshot as a checkpoint, see TransactionManager::load_checkpoint
+        void save(const std::string &path) const;
+
+        ///@return the timestamp the snapshot reads at, it changes with every commit
+        [[nodiscard]] uint64_t get_timestamp() const {
+            return timestamp;
+        }
+
     private:
         [[nodiscard]] NeoTreeVersion* find_version(uint64_t vertex) const;
+
+        ///@brief Sample an access to vertex for the adaptive layout of its tree
+        void note_access(const NeoTreeVersion* version, uint64_t vertex, NeoAccessKind kind) const {
+#if ADAPTIVE_LAYOUT_ENABLE
+            if(adaptive_sample()) {
+                index->forest->get(index->gen_tree_direction(vertex))->record_access(version, vertex, kind);
+            }
+#endif
+        }
     };
 
     template<typename F>
     void NeoSnapshot::edges(uint64_t src, F &&callback) const {
         NeoTreeVersion* version = find_version(src);
         if(version != nullptr) {
+            note_access(version, src, NEO_ACCESS_SCAN);
             version->edges(src, callback);
         }
     }
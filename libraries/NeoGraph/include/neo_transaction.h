@@ -5,13 +5,19 @@
 #include <cstdint>
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <tbb/parallel_sort.h>
 #include "utils/config.h"
 #include "utils/types.h"
 #include "utils/helper.h"
 #include "neo_index.h"
 #include "neo_reader_trace.h"
+#include "neo_wal.h"
+#include "neo_vertex_dict.h"
 #include "../../../types/types.hpp"
 
 using PUU = std::pair<uint64_t, uint64_t>;
@@ -26,19 +32,55 @@ namespace container {
     struct WriteTransaction;
     struct LightWriteTransaction;
 
+    ///@brief Bytes held by the graph structures, see TransactionManager::memory_report
+    struct NeoMemoryReport {
+        uint64_t clustered_segments;
+        uint64_t range_tree_nodes;      // the RangeTree objects
+        uint64_t range_tree_segments;
+        uint64_t art_node4;
+        uint64_t art_node16;
+        uint64_t art_node48;
+        uint64_t art_node256;
+        uint64_t art_leaf8;             // leaves with their element arrays
+        uint64_t art_leaf16;
+        uint64_t art_leaf32;
+        uint64_t art_leaf64;
+        uint64_t property_vecs;
+        uint64_t vertex_maps;
+        uint64_t versions;              // the NeoTreeVersion objects of the version chains
+        uint64_t pooled_free;           // slab memory in the depot or cached by the writers
+
+        [[nodiscard]] uint64_t total() const;
+    };
+
     struct TransactionManager {
         std::atomic<uint64_t> write_timestamp {0};
         std::atomic<uint64_t> read_timestamp {0};
+        std::atomic<uint64_t>* commit_ring;    // slot timestamp & COMMIT_RING_MASK holds timestamp once it is finished
         NeoGraphIndex* index_impl;
+        WriteAheadLog* wal{nullptr};
+        NeoVertexDictionary* dictionary{nullptr};   // nullptr if the vertex IDs are used as they are
         uint64_t m_vertex_count{};
         uint64_t m_edge_count{};
         bool is_directed;
         bool is_weighted;
+#if EDGE_TTL_ENABLE
+        std::atomic<uint64_t> edge_epoch{0};
+        uint64_t edge_ttl{0};               // in epochs, 0 while edges do not expire
+        std::thread* edge_expirer{};
+        std::mutex expirer_mutex;
+        std::condition_variable expirer_wake;
+        bool expirer_stop{};
+#endif
 
-        explicit TransactionManager(bool is_directed, bool is_weighted);
+        ///@param layout shape of the trees, see choose_layout
+        explicit TransactionManager(bool is_directed, bool is_weighted, const NeoLayout &layout = NEO_LAYOUT_DEFAULT);
 
         ~TransactionManager();
 
+        ///@return the preset suiting a graph with the given degree statistics
+        static NeoLayout choose_layout(uint64_t vertex_num, uint64_t edge_num, uint64_t max_degree);
+
         [[nodiscard]] uint64_t vertex_count() const;
 
         [[nodiscard]] uint64_t edge_count() const;
@@ -47,6 +89,8 @@ namespace container {
 
         [[nodiscard]] uint64_t get_read_timestamp() const;
 
+        ///@brief Mark timestamp finished, read_timestamp moves on to the last of the contiguous finished timestamps
+        ///@note never waits for another writer unless timestamp is COMMIT_RING_SIZE ahead of read_timestamp
         void finish_commit(uint64_t timestamp);
 
         [[nodiscard]] WriteTransaction* get_write_transaction();
@@ -55,6 +99,91 @@ namespace container {
 
         [[nodiscard]] ReadTransaction* get_read_transaction() const;
 
+        ///@brief Replay the log at path (if any) and log all following updates to it
+        void enable_wal(const std::string &path);
+
+        ///@brief Rebuild the forest from a log, using the batch insert path for runs of insertions
+        ///@return length of the valid prefix of the log
+        uint64_t recover(const std::string &path);
+
+        ///@brief Rebuild the forest of an empty graph from a checkpoint written by NeoSnapshot::save
+        ///@return timestamp of the checkpoint, log records up to it are skipped by a following recovery
+        uint64_t load_checkpoint(const std::string &path);
+
+        ///@brief Build the forest of an empty graph from an edge list in one pass, every endpoint becomes a vertex.
+        /// Edges are sorted in parallel and every tree gets its first version directly instead of one version per edge.
+        ///@param edges in any order, duplicates are dropped; the reverse edges are added if the graph is undirected
+        ///@param adapt_layout replace the layout the manager was constructed with by the one choose_layout() picks for
+        /// the degrees of the loaded graph
+        ///@return timestamp the loaded graph is visible at
+        uint64_t bulk_load(const std::vector<PUU> &edges, bool adapt_layout = false);
+
+        ///@brief Make the updates logged by the writer durable
+        void wal_commit(WriterTraceBlock* tracer);
+
+        ///@brief Translate vertex IDs through a NeoVertexDictionary, whose mappings are logged and checkpointed with the graph
+        ///@return the dictionary, it is owned by the manager
+        NeoVertexDictionary* enable_vertex_dictionary();
+
+        ///@return the internal ID of external, a newly assigned one is durable before it is returned if the log is enabled
+        uint64_t assign_vertex(uint64_t external);
+
+        ///@brief Assign internal IDs in the given order, see NeoVertexDictionary::assign_all
+        void assign_vertices(const std::vector<uint64_t> &externals);
+
+        ///@return the bytes held per structure, read from counters kept up to date by the allocations, so it is cheap
+        /// enough to export every few seconds. The pools are shared, the counts cover every graph of the process.
+        [[nodiscard]] static NeoMemoryReport memory_report();
+
+        void wal_append(WriterTraceBlock* tracer, uint64_t timestamp, WALOperation op, uint64_t src, uint64_t dest, uint64_t property = 0) {
+            if(wal) {
+                wal->append(tracer->wal_buffer, timestamp, op, src, dest, property);
+            }
+        }
+
+        ///@brief Remove edges in any order, each tree they belong to gets one version and all of them one timestamp
+        ///@return the number of edges that existed
+        uint64_t remove_edge_batch(std::vector<PRR> &edges, WriterTraceBlock* tracer);
+
+        ///@brief Remove edges sorted and distinct from the trees of directions, sorted and locked by the caller, then
+        /// commit and unlock them
+        ///@return the number of edges that existed
+        uint64_t commit_edge_removal(const std::vector<PRR> &edges, const std::vector<uint64_t> &directions, WriterTraceBlock* tracer);
+
+        ///@return the property an inserted edge is stored with, its insertion epoch once a TTL is set
+        [[nodiscard]] Property_t* edge_property(Property_t* property) const {
+#if EDGE_TTL_ENABLE
+            if(edge_ttl != 0) {
+                return (Property_t*) edge_epoch.load(std::memory_order_relaxed);
+            }
+#endif
+            return property;
+        }
+
+#if EDGE_TTL_ENABLE
+        ///@brief Let every edge inserted from now on expire ttl epochs after the epoch it is inserted in. The epoch is
+        /// kept in the edge property, so the graph must not be weighted; edges inserted before count as epoch 0, and
+        /// inserting an edge that exists refreshes its epoch on the batch and the single-edge paths alike.
+        ///@param epoch the epoch to continue from, it is not logged, so a recovered graph passes the one it stopped at
+        ///@note set before the writers start
+        void enable_edge_ttl(uint64_t ttl, uint64_t epoch = 0);
+
+        ///@return the new epoch
+        uint64_t advance_edge_epoch() {
+            return edge_epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        ///@brief Remove the edges that reached their TTL. Every tree holding expired edges is scanned and committed on
+        /// its own through the batch path; on an undirected graph the commit includes the trees of the reverse edges.
+        ///@return the number of edges removed
+        uint64_t expire_edges(WriterTraceBlock* tracer);
+
+        ///@brief Start a thread that advances the epoch and expires edges once every period
+        void start_edge_expirer(std::chrono::milliseconds period);
+
+        void stop_edge_expirer();
+#endif
+
 
 #if VERTEX_PROPERTY_NUM >= 1 || EDGE_PROPERTY_NUM >= 1
         [[nodiscard]] auto get_write_property_transaction();
@@ -154,6 +283,8 @@ namespace container {
 
         void abort();
 
+    private:
+        void log_updates();
     };
 
     /// Write transaction
@@ -175,39 +306,49 @@ namespace container {
 
         void insert_edge(std::vector<PUU>* edges, uint64_t start, uint64_t end);
 
+        ///@note the update is only buffered in the tracer's log, it becomes durable with TransactionManager::wal_commit or writer_unregister
         static void insert_edge(uint64_t source, uint64_t destination, Property_t* property, bool is_directed, TransactionManager* tm, WriterTraceBlock* tracer) {
+            property = tm->edge_property(property);
+#if GROUP_COMMIT_ENABLE
+            if(is_directed || tm->index_impl->gen_tree_direction(source) == tm->index_impl->gen_tree_direction(destination)) {
+                group_insert_edge(source, destination, property, !is_directed, tm, tracer);
+                return;
+            }
+#endif
             if(is_directed) {
-                auto tree = tm->index_impl->lock(source >> VERTEX_GROUP_BITS);
+                auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(source));
                 if (!tree) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return;
                 }
                 tree->insert_edge(source, destination, property, tracer);
                 auto timestamp = tm->get_write_timestamp();
+                tm->wal_append(tracer, timestamp, WAL_INSERT_EDGE, source, destination, (uint64_t) property);
                 tree->commit_version(timestamp);
                 tm->m_edge_count += 1;
                 tm->finish_commit(timestamp);
-                tree->gc(tracer);
+                tree->gc(tracer, tm->get_read_timestamp());
                 tree->writer_lock.unlock();
-            } else if ((source >> VERTEX_GROUP_BITS) != (destination >> VERTEX_GROUP_BITS)) {
+            } else if (tm->index_impl->gen_tree_direction(source) != tm->index_impl->gen_tree_direction(destination)) {
                 if(source > destination) {
                     std::swap(source, destination);
                 }
-                auto tree1 = tm->index_impl->lock(source >> VERTEX_GROUP_BITS);
-                auto tree2 = tm->index_impl->lock(destination >> VERTEX_GROUP_BITS);
+                auto tree1 = tm->index_impl->lock(tm->index_impl->gen_tree_direction(source));
+                auto tree2 = tm->index_impl->lock(tm->index_impl->gen_tree_direction(destination));
                 if (!tree1 || !tree2) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return;
                 }
                 tree1->insert_edge(source, destination, property, tracer);
                 auto timestamp = tm->get_write_timestamp();
+                tm->wal_append(tracer, timestamp, WAL_INSERT_UNDIRECTED_EDGE, source, destination, (uint64_t) property);
                 tree1->commit_version(timestamp);
                 tree2->insert_edge(destination, source, property, tracer);
                 tree2->commit_version(timestamp);
 
                 tm->finish_commit(timestamp);
-                tree1->gc(tracer);
-                tree2->gc(tracer);
+                tree1->gc(tracer, tm->get_read_timestamp());
+                tree2->gc(tracer, tm->get_read_timestamp());
                 tree1->writer_lock.unlock();
                 tree2->writer_lock.unlock();
                 tm->m_edge_count += 2;
@@ -215,18 +356,19 @@ namespace container {
                 if(source > destination) {
                     std::swap(source, destination);
                 }
-                auto tree = tm->index_impl->lock(source >> VERTEX_GROUP_BITS);
+                auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(source));
                 if (!tree) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return;
                 }
                 tree->insert_edge(source, destination, property, tracer);
                 auto timestamp = tm->get_write_timestamp();
+                tm->wal_append(tracer, timestamp, WAL_INSERT_UNDIRECTED_EDGE, source, destination, (uint64_t) property);
                 tree->commit_version(timestamp);
-                tree->gc(tracer);
+                tree->gc(tracer, tm->get_read_timestamp());
                 tree->insert_edge(destination, source, property, tracer);
                 tree->commit_version(timestamp);
-                tree->gc(tracer);
+                tree->gc(tracer, tm->get_read_timestamp());
 
                 tm->finish_commit(timestamp);
                 tree->writer_lock.unlock();
@@ -234,39 +376,49 @@ namespace container {
             }
         }
 
+        ///@brief Queue the insertion on the tree of source and wait until it is committed
+        /// Whichever waiter acquires the tree lock commits all queued insertions as one version under one timestamp.
+        ///@note both endpoints must belong to the same tree if undirected
+        static void group_insert_edge(uint64_t source, uint64_t destination, Property_t* property, bool undirected, TransactionManager* tm, WriterTraceBlock* tracer);
+
+        ///@brief Commit the queued insertions of tree, its writer_lock must be held
+        static void commit_group(NeoTree* tree, TransactionManager* tm, WriterTraceBlock* tracer);
+
         static void remove_edge(uint64_t source, uint64_t destination, bool is_directed, TransactionManager* tm, WriterTraceBlock* tracer) {
             if(is_directed) {
-                auto tree = tm->index_impl->lock(source >> VERTEX_GROUP_BITS);
+                auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(source));
                 if (!tree) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return;
                 }
-                tree->insert_edge(source, destination, nullptr, tracer);
+                tree->remove_edge(source, destination, tracer);
                 auto timestamp = tm->get_write_timestamp();
+                tm->wal_append(tracer, timestamp, WAL_REMOVE_EDGE, source, destination);
                 tree->commit_version(timestamp);
                 tm->m_edge_count -= 1;
                 tm->finish_commit(timestamp);
-                tree->gc(tracer);
+                tree->gc(tracer, tm->get_read_timestamp());
                 tree->writer_lock.unlock();
-            } else if ((source >> VERTEX_GROUP_BITS) != (destination >> VERTEX_GROUP_BITS)) {
+            } else if (tm->index_impl->gen_tree_direction(source) != tm->index_impl->gen_tree_direction(destination)) {
                 if(source > destination) {
                     std::swap(source, destination);
                 }
-                auto tree1 = tm->index_impl->lock(source >> VERTEX_GROUP_BITS);
-                auto tree2 = tm->index_impl->lock(destination >> VERTEX_GROUP_BITS);
+                auto tree1 = tm->index_impl->lock(tm->index_impl->gen_tree_direction(source));
+                auto tree2 = tm->index_impl->lock(tm->index_impl->gen_tree_direction(destination));
                 if (!tree1 || !tree2) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return;
                 }
                 tree1->remove_edge(source, destination, tracer);
                 auto timestamp = tm->get_write_timestamp();
+                tm->wal_append(tracer, timestamp, WAL_REMOVE_UNDIRECTED_EDGE, source, destination);
                 tree1->commit_version(timestamp);
                 tree2->remove_edge(destination, source, tracer);
                 tree2->commit_version(timestamp);
 
                 tm->finish_commit(timestamp);
-                tree1->gc(tracer);
-                tree2->gc(tracer);
+                tree1->gc(tracer, tm->get_read_timestamp());
+                tree2->gc(tracer, tm->get_read_timestamp());
                 tree1->writer_lock.unlock();
                 tree2->writer_lock.unlock();
                 tm->m_edge_count -= 2;
@@ -274,18 +426,19 @@ namespace container {
                 if(source > destination) {
                     std::swap(source, destination);
                 }
-                auto tree = tm->index_impl->lock(source >> VERTEX_GROUP_BITS);
+                auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(source));
                 if (!tree) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return;
                 }
                 tree->remove_edge(source, destination, tracer);
                 auto timestamp = tm->get_write_timestamp();
+                tm->wal_append(tracer, timestamp, WAL_REMOVE_UNDIRECTED_EDGE, source, destination);
                 tree->commit_version(timestamp);
-                tree->gc(tracer);
+                tree->gc(tracer, tm->get_read_timestamp());
                 tree->remove_edge(destination, source, tracer);
                 tree->commit_version(timestamp);
-                tree->gc(tracer);
+                tree->gc(tracer, tm->get_read_timestamp());
 
                 tm->finish_commit(timestamp);
                 tree->writer_lock.unlock();
@@ -13,20 +13,40 @@
 #include "../utils/types.h"
 #include "../utils/config.h"
 #include "neo_tree_version.h"
+#include "neo_adaptive_layout.h"
 #include "../utils/c_art/include/art.h"
 //#include "../utils/art_new/include/art.h"
-#include "utils/thread_pool.h"
 
 namespace container {
+    ///@brief Single-edge insertion waiting in the group commit queue of a NeoTree
+    struct GroupCommitRequest {
+        uint64_t src;
+        uint64_t dest;
+        Property_t* property;
+        bool undirected;            // dest -> src is inserted as well
+        uint64_t timestamp{};       // of the version the edge is committed in, valid once done
+        std::atomic<bool> done{};
+        GroupCommitRequest* next{};
+    };
+
     class NeoTree {
     public:
-        NeoTreeVersion* version_head{};
-        NeoTreeVersion* uncommited_version{};
+        // published with release stores by commit_version, readers acquire it without any wait
+        std::atomic<NeoTreeVersion*> version_head{};
+        // written by the writer holding writer_lock, readers only wait on it in wait_for_commit
+        std::atomic<NeoTreeVersion*> uncommited_version{};
         uint16_t version_num: 15;
         uint16_t direct_gc_flag: 1;
         SpinLock writer_lock{};
-
-        explicit NeoTree(uint64_t prefix);
+        // requests pushed by the writers waiting for writer_lock, drained by the one holding it
+        std::atomic<GroupCommitRequest*> group_requests{};
+        const NeoLayout* const layout;
+        // sampled accesses of the vertices, allocated by the first sample
+        mutable std::atomic<NeoAccessStats*> access_stats{};
+        // set by a sample that asks for a re-layout, the next gc of the tree runs it
+        mutable std::atomic<bool> relayout_pending{};
+
+        NeoTree(uint64_t prefix, const NeoLayout* layout);
         ~NeoTree();
 
         [[nodiscard]] bool has_vertex(uint64_t vertex, uint64_t timestamp) const;
@@ -93,6 +113,9 @@ namespace container {
 
         void remove_edge(uint64_t src, uint64_t dest, WriterTraceBlock* trace_block);
 
+        ///@return the number of edges that existed
+        uint64_t remove_edge_batch(const std::pair<RangeElement, RangeElement> *edges, uint64_t count, WriterTraceBlock* trace_block);
+
         void clean(WriterTraceBlock* trace_block);
 
         [[nodiscard]] NeoTreeVersion* find_version(uint64_t timestamp) const;
@@ -104,10 +127,49 @@ namespace container {
             version->ref_cnt.fetch_sub(1, std::memory_order_release) == 1;
         }
 
+        ///@brief Back off, then block until pending is no longer the uncommitted version
+        void wait_for_commit(const NeoTreeVersion* pending) const;
+
+        void enqueue_group_request(GroupCommitRequest* request) {
+            auto head = group_requests.load(std::memory_order_relaxed);
+            do {
+                request->next = head;
+            } while(!group_requests.compare_exchange_weak(head, request, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        ///@return the queued requests, newest first
+        GroupCommitRequest* take_group_requests() {
+            return group_requests.exchange(nullptr, std::memory_order_acquire);
+        }
+
         bool finish_version(NeoTreeVersion* version);
         bool commit_version(uint64_t timestamp);
-        void version_gc(NeoTreeVersion*& version, std::vector<uint64_t>& readers, WriterTraceBlock* trace_block);
-        void gc(WriterTraceBlock* trace_block);
+        void version_gc(NeoTreeVersion* version, std::vector<uint64_t>& readers, WriterTraceBlock* trace_block);
+        ///@param read_timestamp read timestamp of the graph loaded by the caller, later readers start at or after it
+        void gc(WriterTraceBlock* trace_block, uint64_t read_timestamp);
+
+        ///@brief Sample an access to vertex in version, see record_access
+        void note_access(const NeoTreeVersion* version, uint64_t vertex, NeoAccessKind kind) const {
+#if ADAPTIVE_LAYOUT_ENABLE
+            if(adaptive_sample()) {
+                record_access(version, vertex, kind);
+            }
+#endif
+        }
+
+        ///@brief Record a sampled access, asking for a re-layout once the vertex is due to be classified again or its
+        /// representation falls behind its degree
+        void record_access(const NeoTreeVersion* version, uint64_t vertex, NeoAccessKind kind) const;
+
+        ///@brief Classify the vertices from their samples and move those whose degree passed a promote or demote degree
+        /// of their profile, in a version of its own that takes the timestamp of the head. Its writer_lock must be held.
+        ///@return whether a version was committed
+        bool relayout(WriterTraceBlock* trace_block);
+
+    private:
+        ///@brief Collect the versions no reader can reach any more after a commit
+        ///@return false if the tree has a single version, writer_lock is released then
+        bool collect(WriterTraceBlock* trace_block, uint64_t read_timestamp);
     };
 }
 
@@ -120,6 +182,7 @@ namespace container {
         if(version == nullptr) {
             return;
         }
+        note_access(version, src, NEO_ACCESS_SCAN);
         version->edges(src, std::forward<F>(callback));
         release_version(version);
     }
@@ -3,10 +3,12 @@
 #include <fstream>
 #include "neo_range_ops.h"
 #include "neo_range_tree.h"
-#include "../utils/thread_pool.h"
+#include "neo_neighbor_range.h"
 #include "../utils/types.h"
 #include "../utils/config.h"
 #include "neo_reader_trace.h"
+#include "neo_vertex_map.h"
+#include "neo_adaptive_layout.h"
 
 namespace container {
     class NeoTreeVersion {
@@ -14,7 +16,10 @@ namespace container {
         RangeNodeSegment_t* node_block;
         NeoTreeVersion* next;
         uint64_t timestamp;
-        VertexMap_t * vertex_map;
+        VertexMap * vertex_map;
+        const NeoLayout* layout;
+        // profiles of the vertices set by NeoTree::relayout, inherited from the previous version
+        const NeoAccessStats* access_stats{};
         Bitmap<INDEPENDENT_MAP_BLOCK_NUM> independent_map{};
         bool resource_handled{};
 #if VERTEX_PROPERTY_NUM == 1
@@ -26,7 +31,7 @@ namespace container {
         std::vector<GCResourceInfo>* resources;
 
         // functions
-        explicit NeoTreeVersion(NeoTreeVersion* , WriterTraceBlock* trace_block);
+        NeoTreeVersion(NeoTreeVersion* prev, const NeoLayout* layout, WriterTraceBlock* trace_block);
         void clean(WriterTraceBlock* trace_block);
         ~NeoTreeVersion();
 
@@ -36,8 +41,11 @@ namespace container {
 
         [[nodiscard]] uint64_t get_degree(uint64_t vertex) const;
 
+        ///@return the neighbor array of a clustered vertex, nullptr if the neighborhood is stored independently
         [[nodiscard]] RangeElement* get_neighbor_addr(uint64_t vertex) const;
 
+        [[nodiscard]] NeighborRange neighbors(uint64_t src) const;
+
 #if VERTEX_PROPERTY_NUM >= 1
         [[nodiscard]] Property_t get_vertex_property(uint64_t vertex, uint8_t property_id) const;
 #endif
@@ -86,12 +94,24 @@ namespace container {
 
         void second_insert_edge(uint64_t src, RangeElement target, NeoVertex& vertex, Property_t* property, WriterTraceBlock* trace_block);
 
-        void append_new_list(uint64_t cur_node_num, std::vector<NeoRangeNode> &new_nodes, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block);
+        ///@brief insert_edge met an edge that is stored already: give it property like insert_edge_batch does, so a
+        /// re-inserted edge takes the new weight or TTL stamp on either path
+        void replace_edge_property(uint64_t src, uint64_t dest, Property_t* property, WriterTraceBlock* trace_block);
+
+        void append_new_list(uint64_t cur_node_num, std::vector<NeoRangeNode> &new_nodes, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, std::vector<GCResourceInfo> &resources, WriterTraceBlock* trace_block);
 
-        void node_insert_edge_batch(uint16_t node_idx, std::vector<NeoRangeNode> &new_nodes, uint64_t cur_node_num, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block);
+        void node_insert_edge_batch(uint16_t node_idx, std::vector<NeoRangeNode> &new_nodes, uint64_t cur_node_num, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, std::vector<GCResourceInfo> &resources, WriterTraceBlock* trace_block);
 
+        ///@brief Insert edges sorted by source into the version. A batch of BATCH_UPDATE_GRAIN edges or more is spread
+        /// over the batch update pool, see insert_edge_batch_parallel.
         void insert_edge_batch(const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block);
 
+        ///@brief Fill a version without predecessor in one pass: short neighborhoods are packed into segments, the others
+        /// get a RangeTree or an ART built from their slice of edges
+        ///@param vertices sorted and distinct, every source of edges among them
+        ///@param edges sorted and distinct, may be empty
+        void bulk_build(const uint64_t* vertices, uint64_t vertex_num, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block);
+
 #if EDGE_PROPERTY_NUM >= 1
         void set_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, Property_t property, WriterTraceBlock* trace_block);
 
@@ -102,6 +122,10 @@ namespace container {
         void set_edge_properties(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, Property_t* properties);
 #endif
 
+        ///@brief Move every vertex of moves to its representation without changing its edges, the version is still
+        /// private to its writer
+        void relayout(const std::pair<uint16_t, NeoRepresentation>* moves, uint64_t count, WriterTraceBlock* trace_block);
+
         void gc_copied(WriterTraceBlock* trace_block);
 
         void handle_resources_ref();
@@ -114,10 +138,58 @@ namespace container {
 
         void remove_edge(uint64_t src, uint64_t dest, WriterTraceBlock* trace_block);
 
+        ///@brief Remove edges sorted by source and destination from the version, every segment and every tree of a
+        /// vertex is rewritten once however many of its edges go
+        ///@return the number of edges that existed
+        uint64_t remove_edge_batch(const std::pair<RangeElement, RangeElement>* edges, uint64_t count, WriterTraceBlock* trace_block);
+
+#if EDGE_TTL_ENABLE
+        ///@brief Append the edges whose insertion epoch is at most deadline, sorted by source and destination
+        ///@param prefix the first vertex of the tree
+        void collect_expired(uint64_t prefix, uint64_t deadline, std::vector<std::pair<RangeElement, RangeElement>> &expired) const;
+#endif
+
     private:
 
         [[nodiscard]] NeoRangeNode* find_range_node(uint64_t vertex) const;
 
+        ///@return the degrees at which the vertex changes representation under its profile
+        [[nodiscard]] NeoThresholds thresholds_of(uint64_t vertex) const {
+            return adaptive_thresholds(layout, access_stats ? access_stats->profile(vertex & layout->group_mask()) : NEO_PROFILE_BALANCED);
+        }
+
+        ///@brief Move the edges of a clustered vertex out of its segment into a RangeTree or an ART of its own
+        void extract2independent(uint16_t vertex, NeoRepresentation target, WriterTraceBlock* trace_block);
+
+        ///@brief Rebuild a vertex living in a RangeTree or an ART in target, which is at most its representation, leaving
+        /// out the removed_num edges of removed sorted by destination. The old tree goes to the resources of the previous
+        /// version.
+        void rebuild(uint16_t vertex, NeoRepresentation target, const std::pair<RangeElement, RangeElement>* removed, uint64_t removed_num, WriterTraceBlock* trace_block);
+
+        ///@brief Lay the edges of a vertex without neighborhood into the segment of its NeoRangeNode, cutting the node
+        /// at the vertex when they do not fit
+        void merge2clustered(uint16_t vertex, const std::vector<RangeElement> &list, const std::vector<Property_t*> &props, WriterTraceBlock* trace_block);
+
+        ///@brief Remove the edges of runs, each a range of edges with one clustered source, from the NeoRangeNode at
+        /// node_idx that holds all of these sources
+        ///@return the number of edges that existed
+        uint64_t remove_from_node(uint64_t node_idx, const std::pair<uint64_t, uint64_t>* runs, uint64_t run_num, const std::pair<RangeElement, RangeElement>* edges, WriterTraceBlock* trace_block);
+
+        ///@brief Drop the segment of a replaced NeoRangeNode, a reader of the previous version may still hold it
+        void retire_segment(const NeoRangeNode &old_node, WriterTraceBlock* trace_block);
+
+        ///@brief Insert the edges of a vertex living in a RangeTree or an ART into that tree, upgrading a RangeTree
+        /// reaching art_extract_threshold
+        void insert_to_independent(uint16_t vertex, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, std::vector<GCResourceInfo> &resources, WriterTraceBlock* trace_block);
+
+        ///@brief insert_edge_batch of a large batch: the vertices already living in a tree of their own are served by
+        /// one task each, then every touched NeoRangeNode is merged by a task of its own. The tasks write disjoint
+        /// vertices and nodes; their nodes and GC resources are assembled into this version once all of them are done.
+        void insert_edge_batch_parallel(const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count);
+
+        ///@brief Record in independent_map the sources of edges that live in a tree of their own after a batch insert
+        void mark_independent_vertices(const std::pair<RangeElement, RangeElement>* edges, uint64_t count);
+
         //@return -1 when exist
         int find_position_to_be_inserted(uint64_t src, uint64_t dest, NeoVertex vertex, RangeElementSegment_t * arr, uint16_t arr_size, std::vector<uint16_t>* vertices);
 
@@ -139,7 +211,7 @@ namespace container {
 namespace container {
     template<typename F>
     void NeoTreeVersion::edges(uint64_t src, F&& callback) const {
-        auto vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        auto vertex = vertex_map->at(src & layout->group_mask());
         if (!vertex.is_independent) {
             auto iter = (RangeElement *) node_block->at(vertex.range_node_idx).arr_ptr + vertex.neighbor_offset;
             for (auto i = 0; i < vertex.degree; i++) {
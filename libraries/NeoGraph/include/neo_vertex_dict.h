@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <tbb/concurrent_hash_map.h>
+
+#include "../utils/config.h"
+
+namespace container {
+    enum NeoVertexOrder {
+        VERTEX_ORDER_DEGREE = 0,    // descending degree, the hubs share the first trees
+        VERTEX_ORDER_BFS = 1,       // breadth-first from the highest-degree vertex of every component
+    };
+
+    ///@brief Concurrent dictionary from external vertex IDs to dense internal ones.
+    /// The store addresses trees by vertex >> vertex_group_bits, so sparse external IDs would get a tree each. Internal
+    /// IDs are handed out densely from 0 instead. The forward direction is a tbb::concurrent_hash_map, the reverse one an
+    /// array of VERTEX_DICT_CHUNK_SIZE chunks that never move, so to_external() is two loads and takes no lock.
+    /// IDs are never reused, a removed vertex keeps its internal ID.
+    class NeoVertexDictionary {
+    public:
+        static constexpr uint64_t NONE = std::numeric_limits<uint64_t>::max();
+
+        NeoVertexDictionary();
+
+        ~NeoVertexDictionary();
+
+        NeoVertexDictionary(const NeoVertexDictionary &) = delete;
+        NeoVertexDictionary &operator=(const NeoVertexDictionary &) = delete;
+
+        ///@return the internal ID of external, the next dense one is assigned if it has none
+        ///@param assigned set to whether a new internal ID was handed out
+        ///@note throws std::overflow_error once VERTEX_DICT_MAX_CHUNK_NUM chunks are full
+        uint64_t assign(uint64_t external, bool* assigned = nullptr);
+
+        ///@brief Re-enter a mapping read back from a log or a checkpoint, in any order
+        ///@note throws std::runtime_error if external or internal is already mapped to another ID
+        void restore(uint64_t external, uint64_t internal);
+
+        ///@brief Assign internal IDs in the given order, the externals already known keep theirs
+        void assign_all(const std::vector<uint64_t> &externals);
+
+        ///@return NONE if external has not been assigned
+        [[nodiscard]] uint64_t to_internal(uint64_t external) const;
+
+        ///@param internal must have been returned by assign()
+        [[nodiscard]] uint64_t to_external(uint64_t internal) const {
+            auto chunk = chunks[internal >> VERTEX_DICT_CHUNK_BITS].load(std::memory_order_acquire);
+            return chunk[internal & VERTEX_DICT_CHUNK_MASK];
+        }
+
+        ///@return the external ID of every internal one handed out, NONE for the slots that are not filled yet
+        [[nodiscard]] std::vector<uint64_t> externals() const;
+
+        ///@return the number of internal IDs handed out
+        [[nodiscard]] uint64_t size() const {
+            return next_id.load(std::memory_order_acquire);
+        }
+
+        ///@return the vertices of the edge list in the given order, to be passed to assign_all() before loading it
+        static std::vector<uint64_t> order(const std::vector<std::pair<uint64_t, uint64_t>> &edges, NeoVertexOrder order);
+
+    private:
+        using Map = tbb::concurrent_hash_map<uint64_t, uint64_t>;
+
+        Map map;
+        std::atomic<uint64_t*>* const chunks;
+        std::atomic<uint64_t> next_id{0};
+        std::mutex grow_mutex;
+
+        ///@return the reverse slot of internal, allocating its chunk if needed
+        uint64_t* reserve(uint64_t internal);
+    };
+}
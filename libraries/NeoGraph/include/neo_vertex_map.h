@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include "../utils/types.h"
+#include "../utils/config.h"
+
+namespace container {
+    struct WriterTraceBlock;
+
+    struct VertexMapChunk_t {
+        std::array<NeoVertex, VERTEX_MAP_CHUNK_SIZE> value;
+        uint32_t ref_cnt{1};    // versions sharing the chunk, only changed under the writer lock of the tree
+    };
+
+    ///@brief Vertex map of a NeoTreeVersion, stored as a path-copied array of chunks covering the vertex group.
+    /// A new version shares every chunk of the version it derives from and copies a chunk the first time it writes
+    /// to it, so a write only copies the chunks it touches instead of the whole map. Lookups stay one indirection.
+    /// Only the uncommitted version of a tree is written, hence a chunk with ref_cnt == 1 is private to it.
+    class VertexMap {
+    public:
+        ///@brief Start from an all-empty map of 2^group_bits vertices, chunks are taken from trace_block
+        void init(uint64_t group_bits, WriterTraceBlock* trace_block);
+
+        ///@brief Reference every chunk of other, the chunks copied later are taken from trace_block
+        void share(const VertexMap &other, WriterTraceBlock* trace_block);
+
+        ///@brief Drop the references to the chunks, the last holder returns them to trace_block (or frees them if nullptr)
+        void release(WriterTraceBlock* trace_block);
+
+        [[nodiscard]] uint64_t size() const {
+            return chunk_num << VERTEX_MAP_CHUNK_BITS;
+        }
+
+        [[nodiscard]] const NeoVertex &at(uint64_t idx) const {
+            return chunks[idx >> VERTEX_MAP_CHUNK_BITS]->value[idx & VERTEX_MAP_CHUNK_MASK];
+        }
+
+        ///@return the entry of idx, writable after its chunk is made private to this map
+        NeoVertex &modify(uint64_t idx) {
+            auto chunk_idx = idx >> VERTEX_MAP_CHUNK_BITS;
+            if(chunks[chunk_idx]->ref_cnt != 1) {
+                copy_chunk(chunk_idx);
+            }
+            return chunks[chunk_idx]->value[idx & VERTEX_MAP_CHUNK_MASK];
+        }
+
+        ///@brief Flatten the size() entries into out, e.g. for a checkpoint
+        void copy_to(NeoVertex* out) const;
+
+        ///@brief Overwrite every entry with the size() entries of in
+        void assign(const NeoVertex* in);
+
+    private:
+        std::array<VertexMapChunk_t*, VERTEX_MAP_CHUNK_NUM> chunks{};
+        uint64_t chunk_num{};
+        WriterTraceBlock* trace_block{};
+
+        void copy_chunk(uint64_t chunk_idx);
+    };
+}
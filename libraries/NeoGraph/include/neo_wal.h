@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "utils/config.h"
+
+namespace container {
+    enum WALOperation : uint8_t {
+        WAL_INSERT_VERTEX = 0,
+        WAL_REMOVE_VERTEX = 1,
+        WAL_INSERT_EDGE = 2,            // directed edge src -> dest
+        WAL_INSERT_UNDIRECTED_EDGE = 3, // both src -> dest and dest -> src
+        WAL_REMOVE_EDGE = 4,
+        WAL_REMOVE_UNDIRECTED_EDGE = 5,
+        WAL_UPDATE_EDGE = 6,            // set the property of an existing edge
+        WAL_ASSIGN_VERTEX = 7,          // the vertex dictionary mapped external ID src to internal ID dest
+    };
+
+    ///@brief A logged update, keyed by the write timestamp of the transaction that produced it
+    struct WALRecord {
+        uint64_t timestamp: 56;
+        uint64_t op: 8;
+        uint64_t src;
+        uint64_t dest;
+        uint64_t property;
+    };
+
+    ///@brief Every flushed group is prefixed by a header, a torn or corrupted group ends the log on recovery
+    struct WALGroupHeader {
+        uint32_t magic;
+        uint32_t count;
+        uint64_t checksum;
+    };
+
+    struct WriteAheadLog;
+
+    ///@brief Per-writer log buffer hung off a WriterTraceBlock, appended to without any synchronization
+    struct WALBuffer {
+        WriteAheadLog* log{nullptr};
+        std::vector<WALRecord> records;
+    };
+
+    ///@brief Group-committed redo log.
+    /// Writers append to their own WALBuffer; a full buffer is handed to the log under a mutex (one lock per
+    /// WAL_BUFFER_SIZE records). Handed-off records are written and fdatasync'ed in groups: whoever waits for
+    /// durability first becomes the leader and flushes everything handed off so far, the others wait for it.
+    /// The file is append-only and records of different writers interleave, recovery orders them by timestamp.
+    struct WriteAheadLog {
+        static constexpr uint32_t GROUP_MAGIC = 0x4e57414c; // "NWAL"
+
+        explicit WriteAheadLog(const std::string &path);
+
+        ~WriteAheadLog();
+
+        ///@brief Log a record into the writer's buffer, the record is not durable before the buffer is committed
+        void append(WALBuffer* buffer, uint64_t timestamp, WALOperation op, uint64_t src, uint64_t dest, uint64_t property = 0);
+
+        ///@brief Hand off the buffer and return once all of its records are durable.
+        /// Throws std::runtime_error once a group failed to write, for this and every later commit.
+        void commit(WALBuffer* buffer);
+
+        ///@brief Flush and fdatasync everything handed off so far
+        void sync();
+
+        ///@brief Read all valid groups of a log file, records are returned sorted by timestamp
+        ///@return length of the valid prefix of the file, 0 if the file does not exist
+        static uint64_t read(const std::string &path, std::vector<WALRecord> &records);
+
+    private:
+        int fd;
+        std::mutex mutex;
+        std::condition_variable flushed;
+        std::vector<WALRecord> pending;
+        uint64_t handed_off{0};   // records handed off so far
+        uint64_t durable{0};      // records written and synced so far
+        bool flushing{false};
+        bool failed{false};       // a group could not be written, nothing handed off is durable anymore
+
+        void hand_off(WALBuffer* buffer, std::unique_lock<std::mutex> &lock);
+
+        void flush(std::unique_lock<std::mutex> &lock);
+
+        void write_group(const std::vector<WALRecord> &records) const;
+    };
+}
@@ -17,8 +17,8 @@ private:
     const bool m_is_weighted;
 public:
     // Constructor
-    explicit Neo_Graph_Wrapper(bool is_directed = false, bool is_weighted = true, int block_size = 1024)
-            :tm(is_directed, is_weighted), m_is_weighted(is_weighted), m_is_directed(is_directed) {}
+    explicit Neo_Graph_Wrapper(bool is_directed = false, bool is_weighted = true, int block_size = 1024, const NeoLayout &layout = NEO_LAYOUT_DEFAULT)
+            :tm(is_directed, is_weighted, layout), m_is_weighted(is_weighted), m_is_directed(is_directed) {}
 
     Neo_Graph_Wrapper(const Neo_Graph_Wrapper &) = delete;
 
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include "../include/neo_adaptive_layout.h"
+
+namespace container {
+    static constexpr uint32_t ADAPTIVE_COUNTER_MASK = (1u << ADAPTIVE_COUNTER_BITS) - 1;
+
+    static uint32_t access_count(uint32_t word, NeoAccessKind kind) {
+        return (word >> (kind * ADAPTIVE_COUNTER_BITS)) & ADAPTIVE_COUNTER_MASK;
+    }
+
+    NeoThresholds adaptive_thresholds(const NeoLayout* layout, NeoWorkloadProfile profile) {
+        // a clustered neighborhood never reaches half a segment, the insert path relies on it
+        uint64_t range_promote = layout->range_leaf_size / 2;
+        uint64_t art_promote = layout->art_extract_threshold;
+        switch(profile) {
+            case NEO_PROFILE_WRITE_HEAVY:
+                range_promote = std::max<uint64_t>(range_promote / ADAPTIVE_THRESHOLD_FACTOR, std::min<uint64_t>(range_promote, ADAPTIVE_MIN_PROMOTE_DEGREE));
+                break;
+            case NEO_PROFILE_LOOKUP_HEAVY:
+                art_promote = art_promote / ADAPTIVE_THRESHOLD_FACTOR;
+                break;
+            case NEO_PROFILE_SCAN_HEAVY:
+                if(art_promote <= std::numeric_limits<uint64_t>::max() / ADAPTIVE_THRESHOLD_FACTOR) {
+                    art_promote = art_promote * ADAPTIVE_THRESHOLD_FACTOR;
+                }
+                break;
+            default:
+                break;
+        }
+        art_promote = std::max(art_promote, range_promote);
+        return NeoThresholds{range_promote, art_promote, range_promote / ADAPTIVE_HYSTERESIS_RATIO, art_promote / ADAPTIVE_HYSTERESIS_RATIO};
+    }
+
+    NeoRepresentation adaptive_target(const NeoThresholds &thresholds, NeoRepresentation current, uint64_t degree) {
+        switch(current) {
+            case NEO_CLUSTERED:
+                if(degree >= thresholds.art_promote) {
+                    return NEO_ART;
+                }
+                return degree >= thresholds.range_promote ? NEO_RANGE_TREE : NEO_CLUSTERED;
+            case NEO_RANGE_TREE:
+                if(degree >= thresholds.art_promote) {
+                    return NEO_ART;
+                }
+                return degree < thresholds.range_demote ? NEO_CLUSTERED : NEO_RANGE_TREE;
+            default:
+                if(degree >= thresholds.art_demote) {
+                    return NEO_ART;
+                }
+                return degree < thresholds.range_demote ? NEO_CLUSTERED : NEO_RANGE_TREE;
+        }
+    }
+
+    NeoAccessStats::NeoAccessStats(uint64_t group_size) {
+        counters = new std::atomic<uint32_t>[group_size]{};
+        profiles = new std::atomic<uint8_t>[group_size]{};
+    }
+
+    NeoAccessStats::~NeoAccessStats() {
+        delete[] counters;
+        delete[] profiles;
+    }
+
+    bool NeoAccessStats::record(uint64_t idx, NeoAccessKind kind) {
+        auto &counter = counters[idx];
+        auto word = counter.load(std::memory_order_relaxed);
+        uint32_t sum;
+        do {
+            sum = access_count(word, NEO_ACCESS_LOOKUP) + access_count(word, NEO_ACCESS_SCAN) + access_count(word, NEO_ACCESS_WRITE);
+            if(access_count(word, kind) == ADAPTIVE_COUNTER_MASK) {
+                return true;
+            }
+        } while(!counter.compare_exchange_weak(word, word + (1u << (kind * ADAPTIVE_COUNTER_BITS)), std::memory_order_relaxed));
+        return sum + 1 >= ADAPTIVE_MIN_SAMPLES;
+    }
+
+    bool NeoAccessStats::classify(uint64_t idx) {
+        auto word = counters[idx].load(std::memory_order_relaxed);
+        uint64_t counts[3] = {access_count(word, NEO_ACCESS_LOOKUP), access_count(word, NEO_ACCESS_SCAN), access_count(word, NEO_ACCESS_WRITE)};
+        uint64_t sum = counts[0] + counts[1] + counts[2];
+        if(sum < ADAPTIVE_MIN_SAMPLES) {
+            return false;
+        }
+        // the profile an access kind leads to
+        constexpr NeoWorkloadProfile favoured[3] = {NEO_PROFILE_LOOKUP_HEAVY, NEO_PROFILE_SCAN_HEAVY, NEO_PROFILE_WRITE_HEAVY};
+        auto current = profile(idx);
+        auto next = NEO_PROFILE_BALANCED;
+        for(uint8_t kind = 0; kind < 3; kind++) {
+            if(favoured[kind] == current && counts[kind] * 100 >= (ADAPTIVE_DOMINANT_PERCENT - ADAPTIVE_HYSTERESIS_PERCENT) * sum) {
+                next = current;
+                break;
+            }
+            if(counts[kind] * 100 >= ADAPTIVE_DOMINANT_PERCENT * sum) {
+                next = favoured[kind];
+            }
+        }
+        profiles[idx].store(next, std::memory_order_relaxed);
+
+        // age the samples, an access recorded meanwhile may get lost, which sampling tolerates anyway
+        uint32_t halved = 0;
+        for(uint8_t kind = 0; kind < 3; kind++) {
+            halved |= (uint32_t) (counts[kind] / 2) << (kind * ADAPTIVE_COUNTER_BITS);
+        }
+        counters[idx].store(halved, std::memory_order_relaxed);
+        return next != current;
+    }
+}
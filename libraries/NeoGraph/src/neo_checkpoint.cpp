@@ -0,0 +1,437 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include "include/neo_checkpoint.h"
+#include "include/neo_index.h"
+
+namespace container {
+    namespace {
+        uint64_t page_align(uint64_t offset) {
+            return (offset + CHECKPOINT_PAGE_SIZE - 1) & ~(CHECKPOINT_PAGE_SIZE - 1);
+        }
+
+        void write_padding(std::ofstream &file, uint64_t offset) {
+            static const char zeros[CHECKPOINT_PAGE_SIZE]{};
+            file.write(zeros, (std::streamsize) (page_align(offset) - offset));
+        }
+
+        template<typename T>
+        void write_section(std::ofstream &file, const std::vector<T> &entries) {
+            file.write((const char*) entries.data(), (std::streamsize) (entries.size() * sizeof(T)));
+            write_padding(file, entries.size() * sizeof(T));
+        }
+
+        ///@brief walk the elements (and the properties) of an ART in key order
+        template<typename F>
+        void art_for_each(const ART* art, F &&callback) {
+            std::array<RangeElement, ART_LEAF_SIZE> block;
+            art->for_each_leaf([&](ARTLeaf* leaf) {
+                leaf_decode(leaf, 0, leaf->size, block.data());
+                for(uint16_t i = 0; i < leaf->size; i++) {
+#if EDGE_PROPERTY_NUM == 1
+                    callback(block[i], leaf->property_map ? leaf->get_property(i, 0) : Property_t());
+#else
+                    callback(block[i], Property_t());
+#endif
+                }
+            });
+        }
+    }
+
+    NeoCheckpoint::NeoCheckpoint(const std::string &path, bool populate) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::runtime_error("NeoCheckpoint: cannot open " + path);
+        }
+        struct stat st{};
+        ::fstat(fd, &st);
+        length = st.st_size;
+        if(length < sizeof(CheckpointHeader)) {
+            ::close(fd);
+            throw std::runtime_error("NeoCheckpoint: " + path + " is truncated");
+        }
+        auto addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+        if(addr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("NeoCheckpoint: cannot map " + path);
+        }
+        data = (const char*) addr;
+
+        auto &head = header();
+        bool valid = head.magic == CHECKPOINT_MAGIC && head.segment_capacity == RANGE_LEAF_SIZE && head.element_size == sizeof(RangeElement)
+                     && head.edge_property_num == EDGE_PROPERTY_NUM
+                     && head.vertex_group_bits >= VERTEX_MAP_CHUNK_BITS && head.vertex_group_bits <= MAX_VERTEX_GROUP_BITS;
+        for(auto &section: head.sections) {
+            valid = valid && section.offset % CHECKPOINT_PAGE_SIZE == 0 && section.offset + section.size <= length;
+        }
+        if(!valid) {
+            ::munmap(addr, length);
+            ::close(fd);
+            throw std::runtime_error("NeoCheckpoint: " + path + " is corrupted or was written with another configuration");
+        }
+    }
+
+    NeoCheckpoint::~NeoCheckpoint() {
+        ::munmap((void*) data, length);
+        ::close(fd);
+    }
+
+    void save_checkpoint(const std::vector<NeoTreeVersion*> &versions, const NeoLayout &layout, uint64_t timestamp, const std::string &path,
+                         const std::vector<uint64_t> &vertex_dict) {
+#if VERTEX_PROPERTY_NUM != 0 || EDGE_PROPERTY_NUM > 1
+        throw std::runtime_error("save_checkpoint(): vertex properties and multiple edge properties are not supported");
+#else
+        CheckpointHeader header{};
+        header.magic = CHECKPOINT_MAGIC;
+        header.vertex_group_bits = layout.vertex_group_bits;
+        header.range_leaf_size = layout.range_leaf_size;
+        header.edge_property_num = EDGE_PROPERTY_NUM;
+        header.segment_capacity = RANGE_LEAF_SIZE;
+        header.art_extract_threshold = layout.art_extract_threshold;
+        header.element_size = sizeof(RangeElement);
+        header.timestamp = timestamp;
+        header.tree_num = versions.size();
+
+        std::vector<CheckpointTree> trees(versions.size(), CheckpointTree{CHECKPOINT_NONE, 0, 0});
+        std::vector<NeoVertex> vertex_maps;
+        std::vector<CheckpointRangeNode> range_nodes;
+        std::vector<CheckpointNeighborhood> neighborhoods;
+        std::vector<CheckpointRangeNode> range_tree_nodes;
+        std::vector<const RangeElement*> segments;
+        std::vector<const Property_t*> properties;
+        std::vector<const ART*> arts;
+        uint64_t art_element_num = 0;
+
+        // segments may be shared, each one is dumped once
+        std::unordered_map<uint64_t, uint64_t> segment_idx;
+        std::unordered_map<const void*, uint64_t> property_idx;
+        auto dump_node = [&](uint64_t key, uint64_t size, uint64_t arr_ptr, const void* property) {
+            CheckpointRangeNode node{key, size, CHECKPOINT_NONE, CHECKPOINT_NONE};
+            if(arr_ptr) {
+                auto res = segment_idx.try_emplace(arr_ptr, segments.size());
+                if(res.second) {
+                    segments.push_back((const RangeElement*) arr_ptr);
+                }
+                node.segment = res.first->second;
+            }
+#if EDGE_PROPERTY_NUM == 1
+            if(property) {
+                auto res = property_idx.try_emplace(property, properties.size());
+                if(res.second) {
+                    properties.push_back(((const RangePropertyVec_t*) property)->value.data());
+                }
+                node.property = res.first->second;
+            }
+#endif
+            return node;
+        };
+
+        for(uint64_t idx = 0; idx < versions.size(); idx++) {
+            auto version = versions[idx];
+            if(version == nullptr) {
+                continue;
+            }
+            trees[idx] = CheckpointTree{vertex_maps.size() >> layout.vertex_group_bits, range_nodes.size(), version->node_block->size()};
+            for(auto &node: *version->node_block) {
+#if EDGE_PROPERTY_NUM == 1
+                range_nodes.push_back(dump_node(node.key, node.size, node.arr_ptr, node.property));
+#else
+                range_nodes.push_back(dump_node(node.key, node.size, node.arr_ptr, nullptr));
+#endif
+            }
+
+            auto vertex_map_begin = vertex_maps.size();
+            vertex_maps.resize(vertex_map_begin + layout.group_size());
+            version->vertex_map->copy_to(vertex_maps.data() + vertex_map_begin);
+            for(uint64_t v = vertex_map_begin; v < vertex_maps.size(); v++) {
+                auto &vertex = vertex_maps[v];
+                if(vertex.exist) {
+                    header.vertex_count += 1;
+                    header.edge_count += vertex.degree;
+                }
+                if(!vertex.is_independent) {
+                    vertex.neighborhood_ptr = 0;
+                    continue;
+                }
+                CheckpointNeighborhood neighborhood{};
+                if(!vertex.is_art) {
+                    auto tree = (RangeTree*) vertex.neighborhood_ptr;
+                    neighborhood = CheckpointNeighborhood{range_tree_nodes.size(), tree->node_block.size()};
+                    for(uint64_t i = 0; i < tree->node_block.size(); i++) {
+                        auto &node = tree->node_block[i];
+#if EDGE_PROPERTY_NUM == 1
+                        range_tree_nodes.push_back(dump_node(tree->keys[i], node.size, node.arr_ptr, node.property_map));
+#else
+                        range_tree_nodes.push_back(dump_node(tree->keys[i], node.size, node.arr_ptr, nullptr));
+#endif
+                    }
+                } else {
+                    neighborhood = CheckpointNeighborhood{art_element_num, vertex.degree};
+                    art_element_num += vertex.degree;
+                    arts.push_back((const ART*) vertex.neighborhood_ptr);
+                }
+                vertex.neighborhood_ptr = neighborhoods.size();
+                neighborhoods.push_back(neighborhood);
+            }
+        }
+
+        // lay the sections out
+        uint64_t section_sizes[CHECKPOINT_SECTION_NUM] = {
+                trees.size() * sizeof(CheckpointTree),
+                vertex_maps.size() * sizeof(NeoVertex),
+                range_nodes.size() * sizeof(CheckpointRangeNode),
+                neighborhoods.size() * sizeof(CheckpointNeighborhood),
+                range_tree_nodes.size() * sizeof(CheckpointRangeNode),
+                segments.size() * RANGE_LEAF_SIZE * sizeof(RangeElement),
+                properties.size() * RANGE_LEAF_SIZE * sizeof(Property_t),
+                art_element_num * sizeof(RangeElement),
+                EDGE_PROPERTY_NUM == 1 ? art_element_num * sizeof(Property_t) : 0,
+                vertex_dict.size() * sizeof(uint64_t),
+        };
+        uint64_t offset = page_align(sizeof(CheckpointHeader));
+        for(uint64_t i = 0; i < CHECKPOINT_SECTION_NUM; i++) {
+            header.sections[i] = CheckpointSection{offset, section_sizes[i]};
+            offset = page_align(offset + section_sizes[i]);
+        }
+
+        auto tmp_path = path + ".tmp";
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if(!file.good()) {
+            throw std::runtime_error("save_checkpoint(): cannot open " + tmp_path);
+        }
+        file.write((const char*) &header, sizeof(header));
+        write_padding(file, sizeof(header));
+        write_section(file, trees);
+        write_section(file, vertex_maps);
+        write_section(file, range_nodes);
+        write_section(file, neighborhoods);
+        write_section(file, range_tree_nodes);
+        for(auto segment: segments) {
+            file.write((const char*) segment, RANGE_LEAF_SIZE * sizeof(RangeElement));
+        }
+        write_padding(file, section_sizes[CHECKPOINT_RANGE_SEGMENTS]);
+        for(auto property: properties) {
+            file.write((const char*) property, RANGE_LEAF_SIZE * sizeof(Property_t));
+        }
+        write_padding(file, section_sizes[CHECKPOINT_RANGE_PROPERTIES]);
+
+        uint64_t written = 0;
+        for(auto art: arts) {
+            art_for_each(art, [&](RangeElement element, Property_t) {
+                file.write((const char*) &element, sizeof(element));
+                written += 1;
+            });
+        }
+        if(written != art_element_num) {
+            throw std::runtime_error("save_checkpoint(): ART degree does not match its elements");
+        }
+        write_padding(file, section_sizes[CHECKPOINT_ART_ELEMENTS]);
+#if EDGE_PROPERTY_NUM == 1
+        for(auto art: arts) {
+            art_for_each(art, [&](RangeElement, Property_t property) {
+                file.write((const char*) &property, sizeof(property));
+            });
+        }
+        write_padding(file, section_sizes[CHECKPOINT_ART_PROPERTIES]);
+#endif
+        write_section(file, vertex_dict);
+        file.close();
+        if(!file.good() || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("save_checkpoint(): cannot write " + path);
+        }
+#endif
+    }
+
+    namespace {
+        uint64_t load_segment(const NeoCheckpoint &checkpoint, uint64_t idx, WriterTraceBlock* trace_block, bool in_range_tree) {
+            if(idx == CHECKPOINT_NONE) {
+                return 0;
+            }
+            auto segment = in_range_tree ? trace_block->allocate_range_tree_segment(RANGE_LEAF_SIZE) : trace_block->allocate_range_element_segment(RANGE_LEAF_SIZE);
+            std::memcpy(segment->value.data(), checkpoint.segment(idx), sizeof(segment->value));
+            return (uint64_t) segment;
+        }
+
+#if EDGE_PROPERTY_NUM == 1
+        RangePropertyVec_t* load_property(const NeoCheckpoint &checkpoint, uint64_t idx, WriterTraceBlock* trace_block) {
+            if(idx == CHECKPOINT_NONE) {
+                return nullptr;
+            }
+            auto property = trace_block->allocate_range_prop_vec();
+            std::memcpy(property->value.data(), checkpoint.property(idx), sizeof(property->value));
+            property->ref_cnt = 1;
+            return property;
+        }
+#endif
+
+        ///@brief Check every index the file holds against the section it points into, before anything is allocated
+        void check_checkpoint(const NeoCheckpoint &checkpoint, const NeoLayout &layout) {
+            auto &header = checkpoint.header();
+            auto tree_num = checkpoint.section_num<CheckpointTree>(CHECKPOINT_TREES);
+            auto vertex_map_num = checkpoint.section_num<NeoVertex>(CHECKPOINT_VERTEX_MAPS) >> layout.vertex_group_bits;
+            auto range_node_num = checkpoint.section_num<CheckpointRangeNode>(CHECKPOINT_RANGE_NODES);
+            auto neighborhood_num = checkpoint.section_num<CheckpointNeighborhood>(CHECKPOINT_NEIGHBORHOODS);
+            auto range_tree_node_num = checkpoint.section_num<CheckpointRangeNode>(CHECKPOINT_RANGE_TREE_NODES);
+            auto segment_num = checkpoint.section_num<RangeElement>(CHECKPOINT_RANGE_SEGMENTS) / RANGE_LEAF_SIZE;
+            auto property_num = checkpoint.section_num<Property_t>(CHECKPOINT_RANGE_PROPERTIES) / RANGE_LEAF_SIZE;
+            auto art_element_num = checkpoint.section_num<RangeElement>(CHECKPOINT_ART_ELEMENTS);
+#if EDGE_PROPERTY_NUM == 1
+            art_element_num = std::min(art_element_num, checkpoint.section_num<Property_t>(CHECKPOINT_ART_PROPERTIES));
+#endif
+            auto check = [](bool valid, const std::string &what) {
+                if(!valid) {
+                    throw std::runtime_error("load_checkpoint(): " + what + " is out of range, the checkpoint is corrupted");
+                }
+            };
+            // begin and num of a slice of a section of size entries
+            auto in_section = [](uint64_t begin, uint64_t num, uint64_t size) {
+                return begin <= size && num <= size - begin;
+            };
+            auto check_node = [&](const CheckpointRangeNode &node, const std::string &what) {
+                check(node.segment == CHECKPOINT_NONE || node.segment < segment_num, what + " segment");
+                check(node.size <= RANGE_LEAF_SIZE, what + " size");
+                check(node.property == CHECKPOINT_NONE || node.property < property_num, what + " property");
+            };
+
+            check(header.tree_num <= tree_num, "tree number");
+            auto trees = checkpoint.section<CheckpointTree>(CHECKPOINT_TREES);
+            auto vertex_maps = checkpoint.section<NeoVertex>(CHECKPOINT_VERTEX_MAPS);
+            auto range_nodes = checkpoint.section<CheckpointRangeNode>(CHECKPOINT_RANGE_NODES);
+            auto neighborhoods = checkpoint.section<CheckpointNeighborhood>(CHECKPOINT_NEIGHBORHOODS);
+            auto range_tree_nodes = checkpoint.section<CheckpointRangeNode>(CHECKPOINT_RANGE_TREE_NODES);
+            for(uint64_t idx = 0; idx < header.tree_num; idx++) {
+                auto &entry = trees[idx];
+                if(entry.vertex_map_idx == CHECKPOINT_NONE) {
+                    continue;
+                }
+                auto tree_name = "tree " + std::to_string(idx);
+                check(entry.vertex_map_idx < vertex_map_num, tree_name + " vertex map");
+                check(in_section(entry.node_begin, entry.node_num, range_node_num), tree_name + " range nodes");
+                for(uint64_t i = entry.node_begin; i < entry.node_begin + entry.node_num; i++) {
+                    check_node(range_nodes[i], tree_name + " range node");
+                }
+                auto vertex_map = vertex_maps + (entry.vertex_map_idx << layout.vertex_group_bits);
+                for(uint64_t v = 0; v < layout.group_size(); v++) {
+                    auto &vertex = vertex_map[v];
+                    auto vertex_name = tree_name + " vertex " + std::to_string(v);
+                    if(!vertex.is_independent) {
+                        if(vertex.degree != 0) {
+                            check(vertex.range_node_idx < entry.node_num && range_nodes[entry.node_begin + vertex.range_node_idx].segment != CHECKPOINT_NONE, vertex_name + " range node");
+                            check(vertex.neighbor_offset + vertex.degree <= RANGE_LEAF_SIZE, vertex_name + " neighbor offset");
+                        }
+                        continue;
+                    }
+                    check(vertex.neighborhood_ptr < neighborhood_num, vertex_name + " neighborhood");
+                    auto &neighborhood = neighborhoods[vertex.neighborhood_ptr];
+                    if(!vertex.is_art) {
+                        check(in_section(neighborhood.begin, neighborhood.num, range_tree_node_num), vertex_name + " RangeTree nodes");
+                        for(uint64_t i = neighborhood.begin; i < neighborhood.begin + neighborhood.num; i++) {
+                            check_node(range_tree_nodes[i], vertex_name + " RangeTree node");
+                        }
+                    } else {
+                        check(in_section(neighborhood.begin, neighborhood.num, art_element_num), vertex_name + " ART elements");
+                    }
+                }
+            }
+        }
+    }
+
+    void load_checkpoint(const NeoCheckpoint &checkpoint, NeoGraphIndex* index, WriterTraceBlock* trace_block) {
+#if VERTEX_PROPERTY_NUM != 0 || EDGE_PROPERTY_NUM > 1
+        throw std::runtime_error("load_checkpoint(): vertex properties and multiple edge properties are not supported");
+#else
+        auto &header = checkpoint.header();
+        auto &layout = index->layout;
+        if(header.vertex_group_bits != layout.vertex_group_bits || header.range_leaf_size != layout.range_leaf_size
+           || header.art_extract_threshold != layout.art_extract_threshold) {
+            throw std::runtime_error("load_checkpoint(): the checkpoint was written with another layout");
+        }
+        check_checkpoint(checkpoint, layout);
+        auto trees = checkpoint.section<CheckpointTree>(CHECKPOINT_TREES);
+        auto vertex_maps = checkpoint.section<NeoVertex>(CHECKPOINT_VERTEX_MAPS);
+        auto range_nodes = checkpoint.section<CheckpointRangeNode>(CHECKPOINT_RANGE_NODES);
+        auto neighborhoods = checkpoint.section<CheckpointNeighborhood>(CHECKPOINT_NEIGHBORHOODS);
+        auto range_tree_nodes = checkpoint.section<CheckpointRangeNode>(CHECKPOINT_RANGE_TREE_NODES);
+        auto art_elements = checkpoint.section<RangeElement>(CHECKPOINT_ART_ELEMENTS);
+#if EDGE_PROPERTY_NUM == 1
+        auto art_properties = checkpoint.section<Property_t>(CHECKPOINT_ART_PROPERTIES);
+#endif
+
+        std::vector<RangeElement> elements;
+        std::vector<Property_t*> properties;
+        for(uint64_t idx = 0; idx < header.tree_num; idx++) {
+            auto &entry = trees[idx];
+            if(entry.vertex_map_idx == CHECKPOINT_NONE) {
+                continue;
+            }
+            auto tree = std::make_unique<NeoTree>(idx << layout.vertex_group_bits, &layout);
+            auto version = new NeoTreeVersion(nullptr, &layout, trace_block);
+
+            version->node_block->clear();
+            for(uint64_t i = entry.node_begin; i < entry.node_begin + entry.node_num; i++) {
+                auto &node = range_nodes[i];
+#if EDGE_PROPERTY_NUM == 1
+                version->node_block->emplace_back(node.key, node.size, load_segment(checkpoint, node.segment, trace_block, false), load_property(checkpoint, node.property, trace_block));
+#else
+                version->node_block->emplace_back(node.key, node.size, load_segment(checkpoint, node.segment, trace_block, false), nullptr);
+#endif
+            }
+            if(version->node_block->empty()) {
+                version->node_block->push_back(NeoRangeNode{0, 0, 0, nullptr});
+            }
+
+            version->vertex_map->assign(vertex_maps + (entry.vertex_map_idx << layout.vertex_group_bits));
+            for(uint64_t v = 0; v < layout.group_size(); v++) {
+                auto &vertex = version->vertex_map->modify(v);
+                if(!vertex.is_independent) {
+                    bool has_node = vertex.degree != 0 && vertex.range_node_idx < version->node_block->size();
+                    vertex.neighborhood_ptr = has_node ? version->node_block->at(vertex.range_node_idx).arr_ptr : 0;
+                    continue;
+                }
+                version->independent_map.set(v);
+                auto &neighborhood = neighborhoods[vertex.neighborhood_ptr];
+                if(!vertex.is_art) {
+                    auto range_tree = new RangeTree();
+                    for(uint64_t i = neighborhood.begin; i < neighborhood.begin + neighborhood.num; i++) {
+                        auto &node = range_tree_nodes[i];
+                        range_tree->keys.push_back(node.key);
+#if EDGE_PROPERTY_NUM == 1
+                        range_tree->node_block.emplace_back(node.size, load_segment(checkpoint, node.segment, trace_block, true), load_property(checkpoint, node.property, trace_block));
+#else
+                        range_tree->node_block.emplace_back(node.size, load_segment(checkpoint, node.segment, trace_block, true));
+#endif
+                    }
+                    vertex.neighborhood_ptr = (uint64_t) range_tree;
+                } else {
+                    elements.assign(art_elements + neighborhood.begin, art_elements + neighborhood.begin + neighborhood.num);
+#if EDGE_PROPERTY_NUM == 1
+                    properties.resize(neighborhood.num);
+                    for(uint64_t i = 0; i < neighborhood.num; i++) {
+                        properties[i] = (Property_t*) art_properties[neighborhood.begin + i];
+                    }
+                    auto property_list = properties.data();
+#else
+                    Property_t** property_list = nullptr;
+#endif
+                    auto art = new ART();
+                    delete (ARTNode_4*) art->root;
+                    batch_subtree_build<false>(&art->root, 0, elements.data(), property_list, elements.size(), trace_block);
+                    vertex.neighborhood_ptr = (uint64_t) art;
+                }
+            }
+
+            tree->finish_version(version);
+            tree->commit_version(header.timestamp);
+            if(index->forest->get(idx) != nullptr) {
+                throw std::runtime_error("load_checkpoint: tree " + std::to_string(idx) + " already exists");
+            }
+            index->forest->install(idx, tree.release());
+        }
+#endif
+    }
+}
@@ -0,0 +1,93 @@
+#include "include/neo_forest.h"
+
+namespace container {
+    NeoForest::Directory::Directory(uint64_t capacity, Directory* prev): capacity(capacity), chunks(new std::atomic<Slot*>[capacity]), prev(prev) {
+        for(uint64_t i = 0; i < capacity; i++) {
+            chunks[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    NeoForest::Directory::~Directory() {
+        delete[] chunks;
+    }
+
+    NeoForest::NeoForest(const NeoLayout* layout): layout(layout), current(new Directory(FOREST_INIT_CHUNK_NUM, nullptr)) {}
+
+    NeoForest::~NeoForest() {
+        clear();
+        auto directory = current.load();
+        for(uint64_t i = 0; i < directory->capacity; i++) {
+            delete[] directory->chunks[i].load();
+        }
+        while(directory != nullptr) {
+            auto prev = directory->prev;
+            delete directory;
+            directory = prev;
+        }
+    }
+
+    NeoForest::Slot* NeoForest::reserve(uint64_t direction) {
+        auto chunk_idx = direction >> FOREST_CHUNK_BITS;
+        auto directory = current.load(std::memory_order_acquire);
+        if(chunk_idx < directory->capacity) {
+            auto chunk = directory->chunks[chunk_idx].load(std::memory_order_acquire);
+            if(chunk != nullptr) {
+                return chunk + (direction & FOREST_CHUNK_MASK);
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(grow_mutex);
+        directory = current.load(std::memory_order_relaxed);
+        if(chunk_idx >= directory->capacity) {
+            auto grown = new Directory(std::max(directory->capacity * 2, chunk_idx + 1), directory);
+            for(uint64_t i = 0; i < directory->capacity; i++) {
+                grown->chunks[i].store(directory->chunks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            current.store(grown, std::memory_order_release);
+            directory = grown;
+        }
+        auto chunk = directory->chunks[chunk_idx].load(std::memory_order_relaxed);
+        if(chunk == nullptr) {
+            chunk = new Slot[FOREST_CHUNK_SIZE];
+            for(uint64_t i = 0; i < FOREST_CHUNK_SIZE; i++) {
+                chunk[i].store(nullptr, std::memory_order_relaxed);
+            }
+            directory->chunks[chunk_idx].store(chunk, std::memory_order_release);
+        }
+        return chunk + (direction & FOREST_CHUNK_MASK);
+    }
+
+    NeoTree* NeoForest::install(uint64_t direction, NeoTree* tree) {
+        auto slot = reserve(direction);
+        NeoTree* expected = nullptr;
+        if(!slot->compare_exchange_strong(expected, tree, std::memory_order_acq_rel)) {
+            delete tree;
+            return expected;
+        }
+        auto num = tree_num.load(std::memory_order_relaxed);
+        while(num <= direction && !tree_num.compare_exchange_weak(num, direction + 1, std::memory_order_release)) {}
+        return tree;
+    }
+
+    NeoTree* NeoForest::get_or_create(uint64_t direction) {
+        auto tree = get(direction);
+        if(tree != nullptr) {
+            return tree;
+        }
+        return install(direction, new NeoTree(direction << layout->vertex_group_bits, layout));
+    }
+
+    void NeoForest::clear() {
+        auto directory = current.load();
+        for(uint64_t i = 0; i < directory->capacity; i++) {
+            auto chunk = directory->chunks[i].load();
+            if(chunk == nullptr) {
+                continue;
+            }
+            for(uint64_t j = 0; j < FOREST_CHUNK_SIZE; j++) {
+                delete chunk[j].exchange(nullptr);
+            }
+        }
+        tree_num.store(0);
+    }
+}
@@ -0,0 +1,180 @@
+#include <sys/mman.h>
+#include <algorithm>
+#include <iostream>
+#include "include/neo_frozen.h"
+#include "utils/intersect/include/intersect.h"
+
+namespace container {
+    NeoFrozenGraph::NeoFrozenGraph(const std::string &path, FrozenPrefault prefault): checkpoint(path, prefault == FROZEN_PREFAULT_POPULATE) {
+        tree_num = checkpoint.header().tree_num;
+        trees = checkpoint.section<CheckpointTree>(CHECKPOINT_TREES);
+        vertex_maps = checkpoint.section<NeoVertex>(CHECKPOINT_VERTEX_MAPS);
+        vertex_group_bits = checkpoint.header().vertex_group_bits;
+        range_nodes = checkpoint.section<CheckpointRangeNode>(CHECKPOINT_RANGE_NODES);
+        neighborhoods = checkpoint.section<CheckpointNeighborhood>(CHECKPOINT_NEIGHBORHOODS);
+        range_tree_nodes = checkpoint.section<CheckpointRangeNode>(CHECKPOINT_RANGE_TREE_NODES);
+        art_elements = checkpoint.section<RangeElement>(CHECKPOINT_ART_ELEMENTS);
+#if EDGE_PROPERTY_NUM == 1
+        art_properties = checkpoint.section<Property_t>(CHECKPOINT_ART_PROPERTIES);
+#endif
+
+        int advice = MADV_NORMAL;
+        if(prefault == FROZEN_PREFAULT_RANDOM) {
+            advice = MADV_RANDOM;
+        } else if(prefault == FROZEN_PREFAULT_WILLNEED) {
+            advice = MADV_WILLNEED;
+        }
+        if(advice != MADV_NORMAL && ::madvise((void*) checkpoint.begin(), checkpoint.size(), advice) != 0) {
+            std::cerr << "NeoFrozenGraph: madvise failed on " << path << std::endl;
+        }
+        if(prefault == FROZEN_PREFAULT_RANDOM) {
+            // the index sections are touched by every lookup, only the neighborhoods are read at random
+            auto &vertex_section = checkpoint.header().sections[CHECKPOINT_VERTEX_MAPS];
+            auto &end_section = checkpoint.header().sections[CHECKPOINT_RANGE_TREE_NODES];
+            ::madvise((void*) (checkpoint.begin() + vertex_section.offset), end_section.offset + end_section.size - vertex_section.offset, MADV_WILLNEED);
+        }
+    }
+
+    const NeoVertex* NeoFrozenGraph::find_vertex(uint64_t vertex) const {
+        auto idx = vertex >> vertex_group_bits;
+        if(idx >= tree_num || trees[idx].vertex_map_idx == CHECKPOINT_NONE) {
+            return nullptr;
+        }
+        return &vertex_maps[(trees[idx].vertex_map_idx << vertex_group_bits) + (vertex & ((1ull << vertex_group_bits) - 1))];
+    }
+
+    const RangeElement* NeoFrozenGraph::contiguous(uint64_t vertex, const NeoVertex &entry) const {
+        if(entry.is_independent) {
+            return art_elements + neighborhoods[entry.neighborhood_ptr].begin;
+        }
+        return checkpoint.segment(clustered_node(vertex, entry).segment) + entry.neighbor_offset;
+    }
+
+    bool NeoFrozenGraph::has_vertex(uint64_t vertex) const {
+        auto entry = find_vertex(vertex);
+        return entry != nullptr && entry->exist;
+    }
+
+    bool NeoFrozenGraph::has_edge(uint64_t src, uint64_t dest) const {
+        auto entry = find_vertex(src);
+        if(entry == nullptr || entry->degree == 0) {
+            return false;
+        }
+        if(!entry->is_independent || entry->is_art) {
+            auto neighbor = contiguous(src, *entry);
+            return std::binary_search(neighbor, neighbor + entry->degree, (RangeElement) dest);
+        }
+        // the first key of a RangeTree node is the smallest element of its segment
+        auto &neighborhood = neighborhoods[entry->neighborhood_ptr];
+        auto begin = range_tree_nodes + neighborhood.begin;
+        auto end = begin + neighborhood.num;
+        auto node = std::upper_bound(begin, end, dest, [](uint64_t value, const CheckpointRangeNode &node) {
+            return value < node.key;
+        });
+        if(node == begin) {
+            return false;
+        }
+        node -= 1;
+        auto segment = checkpoint.segment(node->segment);
+        return std::binary_search(segment, segment + node->size, (RangeElement) dest);
+    }
+
+    uint64_t NeoFrozenGraph::get_degree(uint64_t src) const {
+        auto entry = find_vertex(src);
+        return entry ? entry->degree : 0;
+    }
+
+    bool NeoFrozenGraph::get_neighbor(uint64_t src, std::vector<uint64_t> &neighbor) const {
+        auto entry = find_vertex(src);
+        if(entry == nullptr || !entry->exist) {
+            return false;
+        }
+        neighbor.reserve(neighbor.size() + entry->degree);
+        for_each_chunk(src, [&](Chunk chunk) {
+            neighbor.insert(neighbor.end(), chunk.begin(), chunk.end());
+        });
+        return true;
+    }
+
+    const RangeElement* NeoFrozenGraph::get_neighbor_addr(uint64_t src) const {
+        auto entry = find_vertex(src);
+        if(entry == nullptr || entry->degree == 0 || (entry->is_independent && !entry->is_art)) {
+            return nullptr;
+        }
+        return contiguous(src, *entry);
+    }
+
+#if EDGE_PROPERTY_NUM == 1
+    Property_t NeoFrozenGraph::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const {
+        auto entry = find_vertex(src);
+        if(entry == nullptr || entry->degree == 0) {
+            return Property_t();
+        }
+        if(!entry->is_independent) {
+            auto &node = clustered_node(src, *entry);
+            auto neighbor = checkpoint.segment(node.segment) + entry->neighbor_offset;
+            auto pos = std::lower_bound(neighbor, neighbor + entry->degree, (RangeElement) dest);
+            if(pos == neighbor + entry->degree || *pos != dest || node.property == CHECKPOINT_NONE) {
+                return Property_t();
+            }
+            return checkpoint.property(node.property)[pos - checkpoint.segment(node.segment)];
+        }
+        if(entry->is_art) {
+            auto &neighborhood = neighborhoods[entry->neighborhood_ptr];
+            auto neighbor = art_elements + neighborhood.begin;
+            auto pos = std::lower_bound(neighbor, neighbor + neighborhood.num, (RangeElement) dest);
+            if(pos == neighbor + neighborhood.num || *pos != dest) {
+                return Property_t();
+            }
+            return art_properties[pos - art_elements];
+        }
+        auto &neighborhood = neighborhoods[entry->neighborhood_ptr];
+        for(uint64_t i = neighborhood.begin; i < neighborhood.begin + neighborhood.num; i++) {
+            auto &node = range_tree_nodes[i];
+            auto segment = checkpoint.segment(node.segment);
+            auto pos = std::lower_bound(segment, segment + node.size, (RangeElement) dest);
+            if(pos != segment + node.size && *pos == dest) {
+                return node.property == CHECKPOINT_NONE ? Property_t() : checkpoint.property(node.property)[pos - segment];
+            }
+        }
+        return Property_t();
+    }
+#endif
+
+    const RangeElement* NeoFrozenGraph::flatten(uint64_t src, std::vector<RangeElement> &buffer, uint64_t &size) const {
+        auto entry = find_vertex(src);
+        size = entry ? entry->degree : 0;
+        if(size == 0) {
+            return nullptr;
+        }
+        if(!entry->is_independent || entry->is_art) {
+            return contiguous(src, *entry);
+        }
+        buffer.clear();
+        for_each_chunk(src, [&](Chunk chunk) {
+            buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+        });
+        return buffer.data();
+    }
+
+    void NeoFrozenGraph::intersect(uint64_t src1, uint64_t src2, std::vector<uint64_t> &result) const {
+        thread_local std::vector<RangeElement> buffer1, buffer2;
+        uint64_t size1, size2;
+        auto neighbor1 = flatten(src1, buffer1, size1);
+        auto neighbor2 = flatten(src2, buffer2, size2);
+        if(size1 != 0 && size2 != 0) {
+            sorted_intersect(neighbor1, size1, neighbor2, size2, result);
+        }
+    }
+
+    uint64_t NeoFrozenGraph::intersect(uint64_t src1, uint64_t src2) const {
+        thread_local std::vector<RangeElement> buffer1, buffer2;
+        uint64_t size1, size2;
+        auto neighbor1 = flatten(src1, buffer1, size1);
+        auto neighbor2 = flatten(src2, buffer2, size2);
+        if(size1 == 0 || size2 == 0) {
+            return 0;
+        }
+        return sorted_intersect(neighbor1, size1, neighbor2, size2);
+    }
+}
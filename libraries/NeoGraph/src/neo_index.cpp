@@ -2,22 +2,87 @@
 
 #include "include/neo_index.h"
 #include "utils/helper.h"
-#include "utils/thread_pool.h"
+#include "utils/work_stealing_pool.h"
+#include "utils/numa_topology.h"
 
 namespace container {
-    NeoGraphIndex::NeoGraphIndex() {
-        forest = new std::vector<std::unique_ptr<NeoTree>>();
+    namespace {
+        ///@brief Cut a batch sorted by tree into tasks of whole trees, each holding about BATCH_UPDATE_GRAIN updates.
+        /// A tree reaching the grain by itself gets a task of its own; the largest tasks come first. The trees of a
+        /// task share their home node.
+        template<typename F>
+        std::vector<std::pair<uint64_t, uint64_t>> split_batch(uint64_t count, F &&direction_of) {
+            std::vector<std::pair<uint64_t, uint64_t>> parts;
+            uint64_t part_begin = 0;
+            uint64_t st = 0;
+            while(st != count) {
+                auto direction = direction_of(st);
+                auto ed = st;
+                while(ed != count && direction_of(ed) == direction) {
+                    ed++;
+                }
+                if(part_begin != st && numa_home_node(direction) != numa_home_node(direction_of(part_begin))) {
+                    parts.emplace_back(part_begin, st);
+                    part_begin = st;
+                }
+                if(ed - st >= BATCH_UPDATE_GRAIN && part_begin != st) {
+                    parts.emplace_back(part_begin, st);
+                    part_begin = st;
+                }
+                if(ed - part_begin >= BATCH_UPDATE_GRAIN) {
+                    parts.emplace_back(part_begin, ed);
+                    part_begin = ed;
+                }
+                st = ed;
+            }
+            if(part_begin != count) {
+                parts.emplace_back(part_begin, count);
+            }
+            std::stable_sort(parts.begin(), parts.end(), [](const auto &lhs, const auto &rhs) {
+                return lhs.second - lhs.first > rhs.second - rhs.first;
+            });
+            return parts;
+        }
+
+        ///@brief Run body(part, tracer) for every part of split_batch on the batch update pool, tracer being the block of
+        /// the worker running the part. With the trees spread over NUMA nodes, a part is queued on a worker of its home node.
+        template<typename D, typename F>
+        void run_batch_parts(const std::vector<std::pair<uint64_t, uint64_t>> &parts, D &&direction_of, F &&body) {
+            auto &pool = batch_update_pool();
+            if(pool.node_num() > 1) {
+                pool.parallel_for_homed(0, parts.size(), [&](uint64_t i) {
+                    return numa_home_node(direction_of(parts[i].first));
+                }, [&](uint64_t i, size_t) {
+                    body(parts[i], batch_trace_block());
+                });
+                return;
+            }
+            pool.parallel_for(0, parts.size(), 1, [&](uint64_t begin, uint64_t end, size_t) {
+                auto tracer = batch_trace_block();
+                for(auto i = begin; i < end; i++) {
+                    body(parts[i], tracer);
+                }
+            });
+        }
+    }
+
+    NeoGraphIndex::NeoGraphIndex(const NeoLayout &layout): layout(layout) {
+        forest = new NeoForest(&this->layout);
     }
 
     NeoGraphIndex::~NeoGraphIndex() {
         delete forest;
     }
 
-    NeoTree* NeoGraphIndex::lock(uint64_t direction) {
-        if(forest->size() <= direction) {
-            forest->resize(direction + 1);
+    void NeoGraphIndex::set_layout(const NeoLayout &new_layout) {
+        if(forest->size() != 0) {
+            throw std::runtime_error("NeoGraphIndex::set_layout(): the forest already holds trees");
         }
-        auto raw_direction = forest->at(direction).get();
+        layout = new_layout;
+    }
+
+    NeoTree* NeoGraphIndex::lock(uint64_t direction, bool create) {
+        auto raw_direction = create ? forest->get_or_create(direction) : forest->get(direction);
         if(raw_direction == nullptr) {
             return nullptr;
         }
@@ -26,7 +91,7 @@ namespace container {
     }
 
     void NeoGraphIndex::unlock(uint64_t direction) {
-        auto raw_direction = forest->at(direction).get();
+        auto raw_direction = forest->get(direction);
         if(raw_direction == nullptr) {
             return;
         }
@@ -34,11 +99,7 @@ namespace container {
     }
 
     bool NeoGraphIndex::has_vertex(uint64_t vertex, uint64_t timestamp) const {
-        auto direction = gen_tree_direction(vertex);
-        if(forest->size() <= direction) {
-            return false;
-        }
-        auto raw_direction = forest->at(gen_tree_direction(vertex)).get();
+        auto raw_direction = forest->get(gen_tree_direction(vertex));
         if(raw_direction == nullptr) {
             return false;
         }
@@ -46,11 +107,7 @@ namespace container {
     }
 
     bool NeoGraphIndex::has_edge(uint64_t src, uint64_t dest, uint64_t timestamp) const {
-        auto direction = gen_tree_direction(src);
-        if(forest->size() <= direction) {
-            return false;
-        }
-        auto raw_direction = forest->at(gen_tree_direction(src)).get();
+        auto raw_direction = forest->get(gen_tree_direction(src));
         if(raw_direction == nullptr) {
             return false;
         }
@@ -58,11 +115,7 @@ namespace container {
     }
 
     uint64_t NeoGraphIndex::get_degree(uint64_t src, uint64_t timestamp) const {
-        auto direction = gen_tree_direction(src);
-        if(forest->size() <= direction) {
-            return false;
-        }
-        auto raw_direction = forest->at(gen_tree_direction(src)).get();
+        auto raw_direction = forest->get(gen_tree_direction(src));
         if(raw_direction == nullptr) {
             return 0;
         }
@@ -70,11 +123,7 @@ namespace container {
     }
 
     RangeElement *NeoGraphIndex::get_neighbor_addr(uint64_t vertex, uint64_t timestamp) const {
-        auto direction = gen_tree_direction(vertex);
-        if(forest->size() <= direction) {
-            return nullptr;
-        }
-        auto raw_direction = forest->at(gen_tree_direction(vertex)).get();
+        auto raw_direction = forest->get(gen_tree_direction(vertex));
         if(raw_direction == nullptr) {
             return nullptr;
         }
@@ -93,7 +142,7 @@ namespace container {
 
 #if VERTEX_PROPERTY_NUM >= 1
     Property_t NeoGraphIndex::get_vertex_property(uint64_t vertex, uint8_t property_id, uint64_t timestamp) const {
-        auto raw_direction = forest->at(gen_tree_direction(vertex)).get();
+        auto raw_direction = forest->get(gen_tree_direction(vertex));
         if(raw_direction == nullptr) {
             return std::numeric_limits<Property_t>::max();
         }
@@ -102,7 +151,7 @@ namespace container {
 #endif
 #if VERTEX_PROPERTY_NUM > 1
     void NeoGraphIndex::get_vertex_multi_property(uint64_t vertex, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res, uint64_t timestamp) const {
-        auto iter = forest->at(gen_tree_direction(vertex)).get();
+        auto iter = forest->get(gen_tree_direction(vertex));
         if(iter != nullptr) {
             iter->get_vertex_multi_property(vertex, property_ids, res, timestamp);
         } else {
@@ -112,7 +161,7 @@ namespace container {
 #endif
 #if EDGE_PROPERTY_NUM >= 1
     Property_t NeoGraphIndex::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, uint64_t timestamp) const {
-        auto iter = forest->at(gen_tree_direction(src)).get();
+        auto iter = forest->get(gen_tree_direction(src));
         if(iter != nullptr) {
             return iter->get_edge_property(src, dest, property_id, timestamp);
         } else {
@@ -122,7 +171,7 @@ namespace container {
 #endif
 #if EDGE_PROPERTY_NUM > 1
     void NeoGraphIndex::get_edge_multi_property(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res, uint64_t timestamp) const {
-        auto iter = forest->at(gen_tree_direction(src)).get();
+        auto iter = forest->get(gen_tree_direction(src));
         if(iter != nullptr) {
             iter->get_edge_multi_property(src, dest, property_ids, res, timestamp);
         } else {
@@ -145,11 +194,7 @@ namespace container {
 
     ///@return false if the vertex does not exist
     bool NeoGraphIndex::get_neighbor(uint64_t src, std::vector<RangeElement> &neighbor, uint64_t timestamp) const {
-        auto direction = gen_tree_direction(src);
-        if(forest->size() <= direction) {
-            return false;
-        }
-        auto raw_direction = forest->at(direction).get();
+        auto raw_direction = forest->get(gen_tree_direction(src));
         if(raw_direction == nullptr) {
             return false;
         }
@@ -161,14 +206,14 @@ namespace container {
         uint64_t tree_dir1 = gen_tree_direction(src1);
         uint64_t tree_dir2 = gen_tree_direction(src2);
         if(tree_dir1 == tree_dir2) {
-            auto raw_direction = forest->at(tree_dir1).get();
+            auto raw_direction = forest->get(tree_dir1);
             if(raw_direction == nullptr) {
                 return;
             }
             NeoTree::intersect(raw_direction, src1, raw_direction, src2, result, timestamp);
         } else {
-            auto raw_direction1 = forest->at(tree_dir1).get();
-            auto raw_direction2 = forest->at(tree_dir2).get();
+            auto raw_direction1 = forest->get(tree_dir1);
+            auto raw_direction2 = forest->get(tree_dir2);
             if(raw_direction1 == nullptr || raw_direction2 == nullptr) {
                 return;
             }
@@ -181,14 +226,14 @@ namespace container {
         uint64_t tree_dir2 = gen_tree_direction(src2);
         uint64_t res = 0;
         if(tree_dir1 == tree_dir2) {
-            auto raw_direction = forest->at(tree_dir1).get();
+            auto raw_direction = forest->get(tree_dir1);
             if(raw_direction == nullptr) {
                 return 0;
             }
             res = NeoTree::intersect(raw_direction, src1, raw_direction, src2, timestamp);
         } else {
-            auto raw_direction1 = forest->at(tree_dir1).get();
-            auto raw_direction2 = forest->at(tree_dir2).get();
+            auto raw_direction1 = forest->get(tree_dir1);
+            auto raw_direction2 = forest->get(tree_dir2);
             if(raw_direction1 == nullptr || raw_direction2 == nullptr) {
                 return 0;
             }
@@ -198,22 +243,7 @@ namespace container {
     }
 
     bool NeoGraphIndex::insert_vertex(uint64_t vertex, Property_t* property, WriterTraceBlock* trace_block) {
-        auto direction = gen_tree_direction(vertex);
-        if(forest->size() <= direction) {
-            forest->resize(direction + 1);
-        }
-        auto raw_direction = forest->at(direction).get();
-        if(raw_direction == nullptr) {
-            auto new_tree = std::make_unique<NeoTree>(vertex & ~VERTEX_GROUP_MASK);
-            new_tree->insert_vertex(vertex, property, trace_block);
-            if(forest->size() >= direction) {
-                // enlarge forest
-                forest->resize(direction + 1);
-            }
-            (*forest)[direction] = std::move(new_tree);
-        } else {
-            raw_direction->insert_vertex(vertex, property, trace_block);
-        }
+        forest->get_or_create(gen_tree_direction(vertex))->insert_vertex(vertex, property, trace_block);
         return true;
     }
 
@@ -221,51 +251,29 @@ namespace container {
         if(count == 0 || vertices == nullptr) {
             throw std::invalid_argument("insert_vertex_batch: vertices is nullptr or count is 0");
         }
-        uint64_t st = 0;
-        uint64_t ed = 0;
-        if(properties != nullptr) {
-            while(ed != count) {
-                while(ed != count && gen_tree_direction(vertices[ed]) == gen_tree_direction(vertices[st])) {
-                    ed++;
-                }
-                auto direction = gen_tree_direction(vertices[st]);
-
-                if(forest->size() <= direction) {
-                    forest->resize(direction + 1);
-                }
-
-                auto raw_direction = forest->at(direction).get();
-                if(!raw_direction) {
-                    auto new_tree = std::make_unique<NeoTree>(vertices[st] & VERTEX_GROUP_MASK);
-                    new_tree->insert_vertex_batch(vertices + st, properties + st, ed - st, trace_block);
-                    (*forest)[direction] = std::move(new_tree);
-                } else {
-                    raw_direction->insert_vertex_batch(vertices + st, properties + st, ed - st, trace_block);
-                }
-                st = ed;
-            }
-        } else {
-            while(ed != count) {
-                while(ed != count && gen_tree_direction(vertices[ed]) == gen_tree_direction(vertices[st])) {
+        auto insert_trees = [&](uint64_t begin, uint64_t end, WriterTraceBlock* tracer) {
+            uint64_t st = begin;
+            uint64_t ed = begin;
+            while(st != end) {
+                while(ed != end && gen_tree_direction(vertices[ed]) == gen_tree_direction(vertices[st])) {
                     ed++;
                 }
-                auto direction = gen_tree_direction(vertices[st]);
-
-                if(forest->size() <= direction) {
-                    forest->resize(direction + 1);
-                }
-
-                auto raw_direction = forest->at(direction).get();
-                if(!raw_direction) {
-                    auto new_tree = std::make_unique<NeoTree>(vertices[st] & VERTEX_GROUP_MASK);
-                    new_tree->insert_vertex_batch(vertices + st, nullptr, ed - st, trace_block);
-                    (*forest)[direction] = std::move(new_tree);
-                } else {
-                    raw_direction->insert_vertex_batch(vertices + st, nullptr, ed - st, trace_block);
-                }
+                auto raw_direction = forest->get_or_create(gen_tree_direction(vertices[st]));
+                raw_direction->insert_vertex_batch(vertices + st, properties != nullptr ? properties + st : nullptr, ed - st, tracer);
                 st = ed;
             }
+        };
+        if(count <= BATCH_UPDATE_ENABLE_THRESHOLD) {
+            insert_trees(0, count, trace_block);
+            return true;
         }
+        auto direction_of = [&](uint64_t i) {
+            return gen_tree_direction(vertices[i]);
+        };
+        auto parts = split_batch(count, direction_of);
+        run_batch_parts(parts, direction_of, [&](const std::pair<uint64_t, uint64_t> &part, WriterTraceBlock* tracer) {
+            insert_trees(part.first, part.second, tracer);
+        });
         return true;
     }
 
@@ -304,8 +312,8 @@ namespace container {
 #endif
 
     bool NeoGraphIndex::insert_edge(uint64_t src, uint64_t dest, Property_t* property, WriterTraceBlock* trace_block) {
-        auto raw_direction = forest->at(gen_tree_direction(src)).get();
-        if(raw_direction == nullptr) {
+        auto raw_direction = forest->get(gen_tree_direction(src));
+        if(raw_direction == nullptr || raw_direction->version_head == nullptr) {
             return false;
         }
         raw_direction->insert_edge(src, dest, property, trace_block);
@@ -337,16 +345,16 @@ namespace container {
 #endif
 
     bool NeoGraphIndex::remove_vertex(uint64_t vertex, bool is_directed, WriterTraceBlock* trace_block) {
-        auto raw_direction = forest->at(gen_tree_direction(vertex)).get();
-        if(raw_direction == nullptr) {
+        auto raw_direction = forest->get(gen_tree_direction(vertex));
+        if(raw_direction == nullptr || raw_direction->version_head == nullptr) {
             return false;
         }
         return raw_direction->remove_vertex(vertex, is_directed, trace_block);
     }
 
     bool NeoGraphIndex::remove_edge(uint64_t src, uint64_t dest, WriterTraceBlock* trace_block) {
-        auto raw_direction = forest->at(gen_tree_direction(src)).get();
-        if(raw_direction == nullptr) {
+        auto raw_direction = forest->get(gen_tree_direction(src));
+        if(raw_direction == nullptr || raw_direction->version_head == nullptr) {
             return false;
         }
         raw_direction->remove_edge(src, dest, trace_block);
@@ -354,7 +362,7 @@ namespace container {
     }
 
     NeoTree* NeoGraphIndex::commit(uint64_t direction, uint64_t timestamp) {
-        auto raw_direction = forest->at(direction).get();
+        auto raw_direction = forest->get(direction);
         if(raw_direction == nullptr) {
             abort();
         }
@@ -362,12 +370,12 @@ namespace container {
         return raw_direction;
     }
 
-    void NeoGraphIndex::gc(uint64_t direction, WriterTraceBlock* trace_block) {
-        auto raw_direction = forest->at(direction).get();
+    void NeoGraphIndex::gc(uint64_t direction, WriterTraceBlock* trace_block, uint64_t read_timestamp) {
+        auto raw_direction = forest->get(direction);
         if(raw_direction == nullptr) {
             abort();
         }
-        raw_direction->gc(trace_block);
+        raw_direction->gc(trace_block, read_timestamp);
     }
 
     void NeoGraphIndex::clear() {
@@ -380,68 +388,53 @@ namespace container {
             std::cerr << "insert_edge_batch: edges is nullptr or count is 0" << std::endl;
             return true;
         }
-//        std::cout << "pool with" << BATCH_UPDATE_THREAD_NUM << std::endl;
-
-        uint64_t st = 0;
-        uint64_t ed = 0;
-        auto tree_direction = gen_tree_direction(edges[st].first);
-        std::vector<std::pair<uint64_t, uint64_t>> directions;
-        if (properties != nullptr) {
-
-            while (ed != count) {
-                while (ed != count && gen_tree_direction(edges[ed].first) == tree_direction) {
+        auto direction_of = [&](uint64_t i) {
+            return gen_tree_direction(edges[i].first);
+        };
+        auto parts = split_batch(count, direction_of);
+        run_batch_parts(parts, direction_of, [&](const std::pair<uint64_t, uint64_t> &part, WriterTraceBlock* tracer) {
+            uint64_t st = part.first;
+            while(st != part.second) {
+                auto ed = st;
+                while(ed != part.second && direction_of(ed) == direction_of(st)) {
                     ed++;
                 }
-                directions.emplace_back(st, ed - st);
-                tree_direction = gen_tree_direction(edges[ed].first);
+                insert_edge_batch_single_thread(edges + st, properties != nullptr ? properties + st : nullptr, ed - st, tracer);
                 st = ed;
             }
-            if (st != count) {
-                directions.emplace_back(st, ed - st);
-            }
-            if(directions.size() <= BATCH_UPDATE_THREAD_NUM) {
-                std::vector<std::thread> threads;
-                for(uint64_t i = 0; i < directions.size(); i++) {
-                    auto direction = directions.at(i);
-                    threads.emplace_back([edges, properties, direction, this] (size_t thread_id) {
-                        insert_edge_batch_single_thread(edges + direction.first, properties + direction.first, direction.second, get_trace_block(thread_id));
-                    }, i);
-                }
-                for(auto &thread: threads) {
-                    thread.join();
-                }
-            } else {
-                ThreadPool pool(BATCH_UPDATE_THREAD_NUM);
-                std::vector< std::future<bool> > results;
-                for(auto &direction: directions){
-                    results.emplace_back(
-                        pool.enqueue([edges, properties, direction, this] (size_t thread_id) {
-                            insert_edge_batch_single_thread(edges + direction.first, properties + direction.first, direction.second, get_trace_block(thread_id));
-                            return true;
-                        })
-                    );
-                }
-                for(auto && result: results) {
-                    result.get();
-                }
-            }
-        }
-        else {
-            while(ed != count) {
-                while (ed != count && gen_tree_direction(edges[ed].first) == tree_direction) {
+        });
+        return true;
+    }
+
+    uint64_t NeoGraphIndex::remove_edge_batch(const std::pair<RangeElement, RangeElement> *edges, uint64_t count, WriterTraceBlock* trace_block) {
+        auto remove_trees = [&](uint64_t begin, uint64_t end, WriterTraceBlock* tracer) {
+            uint64_t removed = 0;
+            uint64_t st = begin;
+            while(st != end) {
+                auto ed = st;
+                while(ed != end && gen_tree_direction(edges[ed].first) == gen_tree_direction(edges[st].first)) {
                     ed++;
                 }
-                if(ed - st != 0) {
-                    this->insert_edge_batch_single_thread(edges + st, nullptr, ed - st, trace_block);
+                auto raw_direction = forest->get(gen_tree_direction(edges[st].first));
+                if(raw_direction != nullptr && raw_direction->version_head != nullptr) {
+                    removed += raw_direction->remove_edge_batch(edges + st, ed - st, tracer);
                 }
-                tree_direction = gen_tree_direction(edges[ed].first);
                 st = ed;
             }
-            if (st != count) {
-                insert_edge_batch_single_thread(edges + st, nullptr, count - st, trace_block);
-            }
-        }
-        return true;
+            return removed;
+        };
+        if(count <= BATCH_UPDATE_ENABLE_THRESHOLD) {
+            return remove_trees(0, count, trace_block);
+        }
+        auto direction_of = [&](uint64_t i) {
+            return gen_tree_direction(edges[i].first);
+        };
+        std::atomic<uint64_t> removed{0};
+        auto parts = split_batch(count, direction_of);
+        run_batch_parts(parts, direction_of, [&](const std::pair<uint64_t, uint64_t> &part, WriterTraceBlock* tracer) {
+            removed.fetch_add(remove_trees(part.first, part.second, tracer), std::memory_order_relaxed);
+        });
+        return removed.load(std::memory_order_relaxed);
     }
 
     void NeoGraphIndex::insert_edge_batch_single_thread(const std::pair<RangeElement, RangeElement> *edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block) {
@@ -449,8 +442,8 @@ namespace container {
             throw std::invalid_argument("insert_edge_batch_single_thread: edges is nullptr or count is 0");
         }
 
-        auto raw_direction = forest->at(gen_tree_direction(edges[0].first)).get();
-        if(raw_direction == nullptr) {
+        auto raw_direction = forest->get(gen_tree_direction(edges[0].first));
+        if(raw_direction == nullptr || raw_direction->version_head == nullptr) {
             return;
         }
 //        if(gen_tree_direction(edges[0].first) != gen_tree_direction(948)) {
@@ -1,13 +1,19 @@
 #include "include/neo_range_tree.h"
+#include "utils/intersect/include/intersect.h"
 
 
 namespace container {
     RangeTree::RangeTree() {
+        memory_count(MEMORY_RANGE_TREE, sizeof(RangeTree));
+    }
+
+    RangeTree::~RangeTree() {
+        memory_count(MEMORY_RANGE_TREE, -(int64_t) sizeof(RangeTree));
     }
 
     // TODO not used till now
-    RangeTree::RangeTree(RangeElement* elements, Property_t** properties, uint64_t element_num, WriterTraceBlock* trace_block) {
-        auto arr = trace_block->allocate_range_element_segment();
+    RangeTree::RangeTree(RangeElement* elements, Property_t** properties, uint64_t element_num, WriterTraceBlock* trace_block): RangeTree() {
+        auto arr = trace_block->allocate_range_tree_segment();
         for(uint64_t i = 0; i < element_num; i++) {
             arr->value.at(i) = elements[i];
         }
@@ -24,12 +30,12 @@ namespace container {
 #endif
     }
 
-    RangeTree::RangeTree(std::vector<RangeElement>& elements, Property_t** properties, uint64_t element_num, WriterTraceBlock* trace_block) {
+    RangeTree::RangeTree(std::vector<RangeElement>& elements, Property_t** properties, uint64_t element_num, WriterTraceBlock* trace_block): RangeTree() {
         auto segment_num = (element_num + RANGE_LEAF_SIZE - 1) / RANGE_LEAF_SIZE;
         const uint64_t EXPECTED_SEGMENT_SIZE = (element_num + segment_num - 1) / segment_num;
-        assert(EXPECTED_SEGMENT_SIZE >= RANGE_LEAF_SIZE / 3);
+        assert(segment_num == 1 || EXPECTED_SEGMENT_SIZE >= RANGE_LEAF_SIZE / 3);
 #ifndef NDEBUG
-        if(EXPECTED_SEGMENT_SIZE < RANGE_LEAF_SIZE / 3 || EXPECTED_SEGMENT_SIZE > RANGE_LEAF_SIZE) {
+        if((segment_num != 1 && EXPECTED_SEGMENT_SIZE < RANGE_LEAF_SIZE / 3) || EXPECTED_SEGMENT_SIZE > RANGE_LEAF_SIZE) {
             std::cerr << "Error: unexpected segment size " << EXPECTED_SEGMENT_SIZE << std::endl;   // DEBUG
             assert(false);
         }
@@ -39,7 +45,7 @@ namespace container {
         std::fill(keys.begin(), keys.end(), 0);
         node_block.resize(segment_num);
         for(uint64_t i = 0; i < segment_num; i++) {
-            auto arr = trace_block->allocate_range_element_segment();
+            auto arr = trace_block->allocate_range_tree_segment();
             uint64_t start = i * EXPECTED_SEGMENT_SIZE;
             uint64_t end = std::min((i + 1) * EXPECTED_SEGMENT_SIZE, element_num);
             std::copy(elements.begin() + start, elements.begin() + end, arr->value.begin());
@@ -76,8 +82,8 @@ namespace container {
         keys.at(0) = 0;
     }
 
-    RangeTree::RangeTree(RangeElement* elements, Property_t* properties, uint64_t element_num, uint64_t new_element, Property_t* property, uint64_t pos, WriterTraceBlock* trace_block) {
-        auto arr = (RangeElementSegment_t*)trace_block->allocate_range_element_segment();
+    RangeTree::RangeTree(RangeElement* elements, Property_t* properties, uint64_t element_num, uint64_t new_element, Property_t* property, uint64_t pos, WriterTraceBlock* trace_block): RangeTree() {
+        auto arr = (RangeElementSegment_t*)trace_block->allocate_range_tree_segment();
         std::fill(arr->value.begin(), arr->value.end(), 0);
 
         for(uint64_t i = 0; i < element_num; i++) {
@@ -124,27 +130,17 @@ namespace container {
     }
 
     void RangeTree::range_intersect(RangeElement* range, uint16_t range_size, std::vector<uint64_t>& result) const {
-        uint16_t range_idx = 0;
-        uint16_t node_idx = 0;
-        while(range_idx < range_size && node_idx < node_block.size()) {
+        uint64_t range_idx = 0;
+        for(uint16_t node_idx = 0; node_idx < node_block.size() && range_idx < range_size; node_idx++) {
             InRangeNode node = node_block.at(node_idx);
-            auto arr = (RangeElementSegment_t*)node.arr_ptr;
-            uint16_t arr_size = node.size;
-            uint16_t arr_idx = 0;
-            while(range_idx < range_size && arr_idx < arr_size) {
-                if(arr->value.at(arr_idx) < range[range_idx]) {
-                    arr_idx++;
-                } else if(arr->value.at(arr_idx) > range[range_idx]) {
-                    range_idx++;
-                } else {
-                    result.push_back(arr->value.at(arr_idx));
-                    arr_idx++;
-                    range_idx++;
-                }
-            }
-            if(arr_idx == arr_size) {
-                node_idx++;
+            if(node.size == 0) {
+                continue;
             }
+            auto arr = (RangeElementSegment_t*)node.arr_ptr;
+            // the part of range that can only match this segment
+            uint64_t range_ed = std::upper_bound(range + range_idx, range + range_size, arr->value.at(node.size - 1)) - range;
+            sorted_intersect(arr->value.data(), node.size, range + range_idx, range_ed - range_idx, result);
+            range_idx = range_ed;
         }
     }
 
@@ -154,55 +150,39 @@ namespace container {
         while(node_idx1 < node_block.size() && node_idx2 < other_tree->node_block.size()) {
             InRangeNode node1 = node_block.at(node_idx1);
             InRangeNode node2 = other_tree->node_block.at(node_idx2);
+            if(node1.size == 0 || node2.size == 0) {
+                node_idx1 += node1.size == 0;
+                node_idx2 += node2.size == 0;
+                continue;
+            }
             auto arr1 = (RangeElementSegment_t*)node1.arr_ptr;
             auto arr2 = (RangeElementSegment_t*)node2.arr_ptr;
-            uint16_t arr_size1 = node1.size;
-            uint16_t arr_size2 = node2.size;
-            uint16_t arr_idx1 = 0;
-            uint16_t arr_idx2 = 0;
-            while(arr_idx1 < arr_size1 && arr_idx2 < arr_size2) {
-                if(arr1->value.at(arr_idx1) < arr2->value.at(arr_idx2)) {
-                    arr_idx1++;
-                } else if(arr1->value.at(arr_idx1) > arr2->value.at(arr_idx2)) {
-                    arr_idx2++;
-                } else {
-                    result.push_back(arr1->value.at(arr_idx1));
-                    arr_idx1++;
-                    arr_idx2++;
-                }
+            RangeElement last1 = arr1->value.at(node1.size - 1);
+            RangeElement last2 = arr2->value.at(node2.size - 1);
+            if(last1 >= arr2->value.at(0) && last2 >= arr1->value.at(0)) {
+                sorted_intersect(arr1->value.data(), node1.size, arr2->value.data(), node2.size, result);
             }
-            if(arr_idx1 == arr_size1) {
+            if(last1 <= last2) {
                 node_idx1++;
             }
-            if(arr_idx2 == arr_size2) {
+            if(last2 <= last1) {
                 node_idx2++;
             }
         }
     }
 
     uint64_t RangeTree::range_intersect(RangeElement* range, uint16_t range_size) const {
-        uint16_t range_idx = 0;
-        uint16_t node_idx = 0;
+        uint64_t range_idx = 0;
         uint64_t res = 0;
-        while(range_idx < range_size && node_idx < node_block.size()) {
+        for(uint16_t node_idx = 0; node_idx < node_block.size() && range_idx < range_size; node_idx++) {
             InRangeNode node = node_block.at(node_idx);
-            auto arr = (RangeElementSegment_t*)node.arr_ptr;
-            uint16_t arr_size = node.size;
-            uint16_t arr_idx = 0;
-            while(range_idx < range_size && arr_idx < arr_size) {
-                if(arr->value.at(arr_idx) < range[range_idx]) {
-                    arr_idx++;
-                } else if(arr->value.at(arr_idx) > range[range_idx]) {
-                    range_idx++;
-                } else {
-                    res++;
-                    arr_idx++;
-                    range_idx++;
-                }
-            }
-            if(arr_idx == arr_size) {
-                node_idx++;
+            if(node.size == 0) {
+                continue;
             }
+            auto arr = (RangeElementSegment_t*)node.arr_ptr;
+            uint64_t range_ed = std::upper_bound(range + range_idx, range + range_size, arr->value.at(node.size - 1)) - range;
+            res += sorted_intersect(arr->value.data(), node.size, range + range_idx, range_ed - range_idx);
+            range_idx = range_ed;
         }
         return res;
     }
@@ -214,27 +194,22 @@ namespace container {
         while(node_idx1 < node_block.size() && node_idx2 < other_tree->node_block.size()) {
             InRangeNode node1 = node_block.at(node_idx1);
             InRangeNode node2 = other_tree->node_block.at(node_idx2);
+            if(node1.size == 0 || node2.size == 0) {
+                node_idx1 += node1.size == 0;
+                node_idx2 += node2.size == 0;
+                continue;
+            }
             auto arr1 = (RangeElementSegment_t*)node1.arr_ptr;
             auto arr2 = (RangeElementSegment_t*)node2.arr_ptr;
-            uint16_t arr_size1 = node1.size;
-            uint16_t arr_size2 = node2.size;
-            uint16_t arr_idx1 = 0;
-            uint16_t arr_idx2 = 0;
-            while(arr_idx1 < arr_size1 && arr_idx2 < arr_size2) {
-                if(arr1->value.at(arr_idx1) < arr2->value.at(arr_idx2)) {
-                    arr_idx1++;
-                } else if(arr1->value.at(arr_idx1) > arr2->value.at(arr_idx2)) {
-                    arr_idx2++;
-                } else {
-                    res++;
-                    arr_idx1++;
-                    arr_idx2++;
-                }
+            RangeElement last1 = arr1->value.at(node1.size - 1);
+            RangeElement last2 = arr2->value.at(node2.size - 1);
+            if(last1 >= arr2->value.at(0) && last2 >= arr1->value.at(0)) {
+                res += sorted_intersect(arr1->value.data(), node1.size, arr2->value.data(), node2.size);
             }
-            if(arr_idx1 == arr_size1) {
+            if(last1 <= last2) {
                 node_idx1++;
             }
-            if(arr_idx2 == arr_size2) {
+            if(last2 <= last1) {
                 node_idx2++;
             }
         }
@@ -248,7 +223,7 @@ namespace container {
         uint16_t arr_size = node.size;
 
         if(arr == nullptr) {
-            auto new_arr = (RangeElementSegment_t*)trace_block->allocate_range_element_segment();
+            auto new_arr = (RangeElementSegment_t*)trace_block->allocate_range_tree_segment();
             new_arr->value.at(0) = element;
             node.arr_ptr = (uint64_t)new_arr;
             node.size = 1;
@@ -265,7 +240,7 @@ namespace container {
         }
 #endif
         if(arr_size < RANGE_LEAF_SIZE) {
-            auto new_arr = (RangeElementSegment_t*)trace_block->allocate_range_element_segment();
+            auto new_arr = (RangeElementSegment_t*)trace_block->allocate_range_tree_segment(arr_size + 1);
             std::copy(arr->value.begin(), arr->value.begin() + pos, new_arr->value.begin());
             new_arr->value.at(pos) = element;
             std::copy(arr->value.begin() + pos, arr->value.begin() + arr_size, new_arr->value.begin() + pos + 1);
@@ -281,8 +256,8 @@ namespace container {
 #endif
             node.size++;
         } else {
-            auto new_l_arr = (RangeElementSegment_t*)trace_block->allocate_range_element_segment();
-            auto new_r_arr = (RangeElementSegment_t*)trace_block->allocate_range_element_segment();
+            auto new_l_arr = (RangeElementSegment_t*)trace_block->allocate_range_tree_segment();
+            auto new_r_arr = (RangeElementSegment_t*)trace_block->allocate_range_tree_segment();
 
             std::copy(arr->value.begin(), arr->value.begin() + RANGE_LEAF_SIZE / 2, new_l_arr->value.begin());
             std::copy(arr->value.begin() + RANGE_LEAF_SIZE / 2, arr->value.begin() + arr_size, new_r_arr->value.begin());
@@ -355,7 +330,7 @@ namespace container {
         int64_t list_ed = 0;
 
         uint64_t new_segment_size = 0;
-        auto new_segment = trace_block->allocate_range_element_segment();
+        auto new_segment = trace_block->allocate_range_tree_segment();
 
         auto new_property_map = trace_block->allocate_range_prop_vec();
         auto move_to_next_node = [&]() {
@@ -363,7 +338,7 @@ namespace container {
             new_range_tree->keys.push_back(new_segment->value.at(0));
 
             new_segment_size = 0;
-            new_segment = trace_block->allocate_range_element_segment();
+            new_segment = trace_block->allocate_range_tree_segment();
             new_property_map = trace_block->allocate_range_prop_vec();
         };
 
@@ -483,7 +458,7 @@ namespace container {
             new_range_tree->node_block.push_back(InRangeNode{new_segment_size, (uint64_t) new_segment, new_property_map});
             new_range_tree->keys.push_back(new_segment->value.at(0));
         } else {
-            trace_block->deallocate_range_element_segment(new_segment);
+            trace_block->deallocate_range_tree_segment(new_segment);
             trace_block->deallocate_range_prop_vec(new_property_map);
         }
 #ifndef NDEBUG
@@ -542,7 +517,7 @@ namespace container {
             }
         } else {
             // remove the element
-            auto new_arr = (RangeElementSegment_t*)trace_block->allocate_range_element_segment();
+            auto new_arr = (RangeElementSegment_t*)trace_block->allocate_range_tree_segment(arr_size - 1);
             std::copy(arr->value.begin(), arr->value.begin() + pos, new_arr->value.begin());
             std::copy(arr->value.begin() + pos + 1, arr->value.begin() + arr_size, new_arr->value.begin() + pos);
 #if EDGE_PROPERTY_NUM > 0
@@ -622,7 +597,7 @@ namespace container {
 
     ART* RangeTree::range_tree2art(uint64_t src, uint64_t degree, uint64_t new_element, Property_t* new_property, std::vector<GCResourceInfo>& gc_resources, WriterTraceBlock* trace_block) {
         ART* new_art = new ART();
-        delete new_art->root;
+        delete (ARTNode_4*) new_art->root;
 
         std::vector<RangeElement> extract_list;
         extract_list.reserve(degree + 1);
@@ -677,9 +652,40 @@ namespace container {
     }
 
 
+    ART* RangeTree::range_tree2art(uint64_t degree, WriterTraceBlock* trace_block) const {
+        std::vector<RangeElement> extract_list;
+        extract_list.reserve(degree);
+        std::vector<Property_t*> extract_prop_list;
+        extract_prop_list.reserve(degree);
+        for (auto &node: node_block) {
+            auto arr = (RangeElementSegment_t*)node.arr_ptr;
+            for (auto j = 0; j < node.size; j++) {
+                extract_list.push_back(arr->value.at(j));
+#if EDGE_PROPERTY_NUM != 0
+                extract_prop_list.push_back(node.property_map ? map_get_all_range_property(node.property_map, j) : nullptr);
+#endif
+            }
+        }
+        assert(extract_list.size() == degree);
+
+        ART* new_art = new ART();
+        delete (ARTNode_4*) new_art->root;
+#if EDGE_PROPERTY_NUM != 0
+        batch_subtree_build<false>(&new_art->root, 0, extract_list.data(), extract_prop_list.data(), extract_list.size(), trace_block);
+#if EDGE_PROPERTY_NUM > 1
+        for (auto prop: extract_prop_list) {
+            delete [] prop;
+        }
+#endif
+#else
+        batch_subtree_build<false>(&new_art->root, 0, extract_list.data(), nullptr, extract_list.size(), trace_block);
+#endif
+        return new_art;
+    }
+
     RangeTreeInsertElemBatchRes RangeTree::range_tree2art_batch(uint64_t src, uint64_t degree, const std::pair<RangeElement, RangeElement> *edges, Property_t** properties, uint64_t count, std::vector<GCResourceInfo>& gc_resources, WriterTraceBlock* trace_block) {
         ART* new_art = new ART();
-        delete new_art->root;
+        delete (ARTNode_4*) new_art->root;
         uint64_t inserted = 0;
         std::vector<RangeElement> insert_list;
         insert_list.reserve(count + degree);
@@ -699,8 +705,8 @@ namespace container {
                 insert_list.push_back(edges[list_idx++].second);
                 inserted++;
             } else if (old_arr->value.at(old_idx) < edges[list_idx].second) {
-                insert_list.push_back(old_arr->value.at(old_idx++));
                 insert_prop_list.push_back(old_prop_arr ? map_get_all_range_property(old_prop_arr, old_idx) : nullptr);
+                insert_list.push_back(old_arr->value.at(old_idx++));
             } else {
                 insert_prop_list.push_back(properties[list_idx]);
                 insert_list.push_back(edges[list_idx++].second);
@@ -719,8 +725,8 @@ namespace container {
 
         if (old_node_idx < child_num) {
             while(old_node_idx < child_num) {
-                insert_list.push_back(old_arr->value.at(old_idx++));
                 insert_prop_list.push_back(old_prop_arr ? map_get_all_range_property(old_prop_arr, old_idx) : nullptr);
+                insert_list.push_back(old_arr->value.at(old_idx++));
 
                 if(old_idx == node_block.at(old_node_idx).size) {
                     old_node_idx++;
@@ -1,17 +1,59 @@
+#include <sched.h>
 #include <algorithm>
+#include <stdexcept>
 #include "include/neo_reader_trace.h"
 #include "utils/c_art/include/art_node.h"
 //#include "utils/art_new/include/art_node.h"
 
 namespace container{
+    static uint32_t current_reader_shard() {
+        auto cpu = sched_getcpu();
+        if(cpu >= 0) {
+            return cpu % READER_SHARD_NUM;
+        }
+        static std::atomic<uint32_t> next_shard{};
+        thread_local uint32_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % READER_SHARD_NUM;
+        return shard;
+    }
+
+    ActiveReaderTracer::~ActiveReaderTracer() {
+        for(auto &shard: shards) {
+            auto chunk = shard.chunks.load();
+            while(chunk != nullptr) {
+                auto next = chunk->next;
+                delete chunk;
+                chunk = next;
+            }
+        }
+    }
+
     ReaderTraceBlock* ActiveReaderTracer::reader_register() {
-        for(auto & block: blocks) {
-            if(block.get_status() == 0 && block.try_lock()) {
-                block.set_status(1);   // acquiring
-                return &block;
+        auto shard_idx = current_reader_shard();
+        auto &shard = shards[shard_idx];
+        ReaderTraceBlock* res = nullptr;
+        for(auto chunk = shard.chunks.load(std::memory_order_acquire); chunk != nullptr && res == nullptr; chunk = chunk->next) {
+            for(auto &block: chunk->blocks) {
+                if(block.get_status() == 0 && block.try_lock()) {
+                    res = &block;
+                    break;
+                }
             }
         }
-        return nullptr;
+        if(res == nullptr) {
+            auto chunk = new ReaderChunk();
+            res = &chunk->blocks[0];
+            res->try_lock();
+            shard.lock.lock();
+            chunk->next = shard.chunks.load(std::memory_order_relaxed);
+            shard.chunks.store(chunk, std::memory_order_release);
+            shard.lock.unlock();
+        }
+        res->shard = shard_idx;
+        res->set_status(1);   // acquiring
+        shard.active.fetch_add(1);
+        // the caller reads the timestamp after this, a collector that misses the increment sees a newer timestamp
+        shard.pending.fetch_add(1);
+        return res;
     }
 
     void ActiveReaderTracer::set_status(ReaderTraceBlock* block, uint64_t status) {
@@ -19,57 +61,173 @@ namespace container{
     }
 
     void ActiveReaderTracer::set_timestamp(ReaderTraceBlock* block, uint64_t timestamp) {
+        auto &shard = shards[block->shard];
         block->set_timestamp(timestamp);
+        shard.lock.lock();
+        if(timestamp < shard.min_timestamp.load(std::memory_order_relaxed)) {
+            shard.min_timestamp.store(timestamp, std::memory_order_release);
+        }
+        shard.lock.unlock();
+        shard.pending.fetch_sub(1, std::memory_order_release);
         block->unlock();
     }
 
     void ActiveReaderTracer::reader_unregister(ReaderTraceBlock* block) {
+        auto &shard = shards[block->shard];
         block->lock();
+        auto timestamp = block->get_timestamp();
         block->clear();
+        shard.lock.lock();
+        if(timestamp <= shard.min_timestamp.load(std::memory_order_relaxed)) {
+            // the minimum may have left, readers still waiting for the lock lower it again in set_timestamp
+            uint64_t min_timestamp = std::numeric_limits<uint64_t>::max();
+            for(auto chunk = shard.chunks.load(std::memory_order_relaxed); chunk != nullptr; chunk = chunk->next) {
+                for(auto &other: chunk->blocks) {
+                    auto other_timestamp = other.get_timestamp();
+                    if(other.get_status() == 1 && other_timestamp != 0 && other_timestamp < min_timestamp) {
+                        min_timestamp = other_timestamp;
+                    }
+                }
+            }
+            shard.min_timestamp.store(min_timestamp, std::memory_order_release);
+        }
+        shard.lock.unlock();
+        shard.active.fetch_sub(1, std::memory_order_release);
+    }
+
+    template<typename F>
+    void ActiveReaderTracer::scan_shard(ReaderShard &shard, F &&callback) {
+        for(auto chunk = shard.chunks.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->next) {
+            for(auto &block: chunk->blocks) {
+                if(block.get_status() == 1) {
+                    uint64_t timestamp;
+                    do {
+                        timestamp = block.get_timestamp();
+                    } while(timestamp == 0 && block.get_status() == 1);
+                    if(timestamp != 0) {
+                        callback(timestamp);
+                    }
+                }
+            }
+        }
     }
 
-    void ActiveReaderTracer::get_active_reader_info(std::vector<uint64_t>&readers) {
-        for(auto &block: blocks) {
-            if(block.get_status() == 1) {
-                uint64_t timestamp;
-                do {
-                    timestamp = block.get_timestamp();
-                } while(timestamp == 0);
-                readers.push_back(timestamp);
+    void ActiveReaderTracer::get_active_reader_info(std::vector<uint64_t>&readers, uint64_t below) {
+        // pairs with the registration of the readers: a reader registered after this reads a timestamp published before
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool has_later = false;
+        for(auto &shard: shards) {
+            if(shard.active.load(std::memory_order_acquire) == 0) {
+                continue;
             }
+            if(shard.pending.load(std::memory_order_acquire) == 0) {
+                auto min_timestamp = shard.min_timestamp.load(std::memory_order_acquire);
+                if(min_timestamp >= below) {
+                    has_later |= min_timestamp != std::numeric_limits<uint64_t>::max();
+                    continue;
+                }
+            }
+            scan_shard(shard, [&](uint64_t timestamp) {
+                if(timestamp < below) {
+                    readers.push_back(timestamp);
+                } else {
+                    has_later = true;
+                }
+            });
+        }
+        if(has_later) {
+            readers.push_back(below);
         }
         std::sort(readers.begin(), readers.end());
         readers.erase(std::unique(readers.begin(), readers.end()), readers.end());
     }
 
     uint64_t ActiveReaderTracer::get_min_timestamp() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
         uint64_t min_timestamp = std::numeric_limits<uint64_t>::max();
-        for(auto &block: blocks) {
-            if(block.get_status() == 1) {
-                block.lock();
-                auto timestamp = block.get_timestamp();
-                block.unlock();
-                if(timestamp < min_timestamp) {
-                    min_timestamp = timestamp;
-                }
+        for(auto &shard: shards) {
+            if(shard.active.load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            if(shard.pending.load(std::memory_order_acquire) != 0) {
+                scan_shard(shard, [&](uint64_t timestamp) {
+                    min_timestamp = std::min(min_timestamp, timestamp);
+                });
+            } else {
+                min_timestamp = std::min(min_timestamp, shard.min_timestamp.load(std::memory_order_acquire));
             }
         }
         return min_timestamp;
     }
 
-    RangeElementSegment_t* WriterTraceBlock::allocate_range_element_segment() {
-        RangeElementSegment_t* res = nullptr;
-        if(range_element_segments->empty()) {
-            res = (RangeElementSegment_t*)malloc(sizeof(RangeElementSegment_t));
-        } else {
-            res = range_element_segments->top();
-            range_element_segments->pop();
+    ///@brief The slab classes behind the writer pools, shared by every writer
+    struct WriterSlabs {
+        SlabClass range_element_segments{"range_element_segment", sizeof(RangeElementSegment_t)};
+        SlabClass vertex_maps{"vertex_map", sizeof(VertexMap)};
+        SlabClass vertex_map_chunks{"vertex_map_chunk", sizeof(VertexMapChunk_t)};
+        SlabClass art_leaf32s{"art_leaf32", sizeof(std::array<uint32_t, ART_LEAF_SIZE>)};
+        SlabClass art_leaf64s{"art_leaf64", sizeof(std::array<uint64_t, ART_LEAF_SIZE>)};
+        SlabClass art_node48s{"art_node48", sizeof(ARTNode_48)};
+        SlabClass art_node256s{"art_node256", sizeof(ARTNode_256)};
+#if EDGE_PROPERTY_NUM > 0
+        SlabClass range_prop_vecs{"range_prop_vec", sizeof(PropertyVec<RANGE_LEAF_SIZE>)};
+        SlabClass art_prop_vecs{"art_prop_vec", sizeof(PropertyVec<ART_LEAF_SIZE>)};
+#endif
+    };
+
+    static WriterSlabs &writer_slabs() {
+        // never destroyed, trees torn down by later static destructors still return their structures
+        static auto* slabs = new WriterSlabs();
+        return *slabs;
+    }
+
+    WriterTraceBlock::WriterTraceBlock() {
+        auto &slabs = writer_slabs();
+        range_element_segments.slab_class = &slabs.range_element_segments;
+        vertex_maps.slab_class = &slabs.vertex_maps;
+        vertex_map_chunks.slab_class = &slabs.vertex_map_chunks;
+        art_leaf32s.slab_class = &slabs.art_leaf32s;
+        art_leaf64s.slab_class = &slabs.art_leaf64s;
+        art_node48s.slab_class = &slabs.art_node48s;
+        art_node256s.slab_class = &slabs.art_node256s;
+#if EDGE_PROPERTY_NUM > 0
+        range_prop_vecs.slab_class = &slabs.range_prop_vecs;
+        art_prop_vecs.slab_class = &slabs.art_prop_vecs;
+#endif
+        wal_buffer = nullptr;
+    }
+
+    // Every pooled structure is counted in its memory_report category while it is handed out
+    template<typename T>
+    static void count_pooled(MemoryCategory category, const T* object, int64_t sign) {
+        if(object != nullptr) {
+            memory_count(category, sign * (int64_t) sizeof(T));
+        }
+    }
+
+    // An object fresh from a slab is still zero, only a recycled one is cleared
+    static RangeElementSegment_t* allocate_segment(SlabCache &cache, uint16_t filled) {
+        bool zeroed;
+        auto res = (RangeElementSegment_t*) cache.allocate(zeroed);
+        if(!zeroed && filled < RANGE_LEAF_SIZE) {
+            memset(res->value.data() + filled, 0, (RANGE_LEAF_SIZE - filled) * sizeof(RangeElement));
         }
-        memset(res, 0, sizeof(RangeElementSegment_t));
         res->ref_cnt = 1;
         return res;
     }
 
+    RangeElementSegment_t* WriterTraceBlock::allocate_range_element_segment(uint16_t filled) {
+        auto res = allocate_segment(range_element_segments, filled);
+        count_pooled(MEMORY_CLUSTERED_SEGMENT, res, 1);
+        return res;
+    }
+
+    RangeElementSegment_t* WriterTraceBlock::allocate_range_tree_segment(uint16_t filled) {
+        auto res = allocate_segment(range_element_segments, filled);
+        count_pooled(MEMORY_RANGE_TREE_SEGMENT, res, 1);
+        return res;
+    }
+
 //    InRangeElementSegment_t* WriterTraceBlock::allocate_inrange_element_segment() {
 //        InRangeElementSegment_t* res = nullptr;
 //        if(in_range_element_segments->empty()) {
@@ -83,130 +241,185 @@ namespace container{
 //        return res;
 //    }
     
-    VertexMap_t* WriterTraceBlock::allocate_vertex_map() {
-        VertexMap_t* res = nullptr;
-        if(vertex_maps->empty()) {
-            res = new VertexMap_t();
-        } else {
-            res = vertex_maps->top();
-            vertex_maps->pop();
-        }
-        memset(res, 0, sizeof(VertexMap_t));
+    VertexMap* WriterTraceBlock::allocate_vertex_map() {
+        // init or share overwrites a recycled map
+        bool zeroed;
+        auto res = (VertexMap*) vertex_maps.allocate(zeroed);
+        count_pooled(MEMORY_VERTEX_MAP, res, 1);
+        return res;
+    }
+
+    VertexMapChunk_t* WriterTraceBlock::allocate_vertex_map_chunk() {
+        bool zeroed;
+        auto res = (VertexMapChunk_t*) vertex_map_chunks.allocate(zeroed);
+        res->ref_cnt = 1;
+        count_pooled(MEMORY_VERTEX_MAP, res, 1);
         return res;
     }
 
     std::array<uint32_t, ART_LEAF_SIZE>* WriterTraceBlock::allocate_art_leaf32() {
-        std::array<uint32_t, ART_LEAF_SIZE> *res = nullptr;
-        if(art_leaf32s->empty()) {
-            res = new std::array<uint32_t, ART_LEAF_SIZE>();
-        } else {
-            res = art_leaf32s->top();
-            art_leaf32s->pop();
+        bool zeroed;
+        auto res = (std::array<uint32_t, ART_LEAF_SIZE>*) art_leaf32s.allocate(zeroed);
+        if(!zeroed) {
+            memset(res, 0, sizeof(std::array<uint32_t, ART_LEAF_SIZE>));
         }
-        memset(res, 0, sizeof(std::array<uint32_t, ART_LEAF_SIZE>));
+        count_pooled(MEMORY_ART_LEAF32, res, 1);
         return res;
     }
 
     std::array<uint64_t, ART_LEAF_SIZE>* WriterTraceBlock::allocate_art_leaf64() {
-        std::array<uint64_t, ART_LEAF_SIZE> *res = nullptr;
-        if(art_leaf64s->empty()) {
-            res = new std::array<uint64_t, ART_LEAF_SIZE>();
-        } else {
-            res = art_leaf64s->top();
-            art_leaf64s->pop();
+        bool zeroed;
+        auto res = (std::array<uint64_t, ART_LEAF_SIZE>*) art_leaf64s.allocate(zeroed);
+        if(!zeroed) {
+            memset(res, 0, sizeof(std::array<uint64_t, ART_LEAF_SIZE>));
         }
-        memset(res, 0, sizeof(std::array<uint64_t, ART_LEAF_SIZE>));
+        count_pooled(MEMORY_ART_LEAF64, res, 1);
         return res;
     }
 
     ARTNode_48* WriterTraceBlock::allocate_art_node48() {
-        ARTNode_48* res = nullptr;
-        if(art_node48s->empty()) {
-            res = new ARTNode_48();
-        } else {
-            res = art_node48s->top();
-            art_node48s->pop();
+        bool zeroed;
+        auto res = (ARTNode_48*) art_node48s.allocate(zeroed);
+        if(!zeroed) {
+            memset(res, 0, sizeof(ARTNode_48));
         }
-        memset(res, 0, sizeof(ARTNode_48));
         res->n.ref_cnt = 1;
+        count_pooled(MEMORY_ART_NODE48, res, 1);
         return res;
     }
 
     ARTNode_256* WriterTraceBlock::allocate_art_node256() {
-        ARTNode_256* res = nullptr;
-        if(art_node256s->empty()) {
-            res = new ARTNode_256();
-        } else {
-            res = art_node256s->top();
-            art_node256s->pop();
+        bool zeroed;
+        auto res = (ARTNode_256*) art_node256s.allocate(zeroed);
+        if(!zeroed) {
+            memset(res, 0, sizeof(ARTNode_256));
         }
-        memset(res, 0, sizeof(ARTNode_256));
         res->n.ref_cnt = 1;
+        count_pooled(MEMORY_ART_NODE256, res, 1);
         return res;
     }
 
 #if EDGE_PROPERTY_NUM > 0
+    // The values of a property vector are written before they are read, only the count is reset
     PropertyVec<RANGE_LEAF_SIZE>* WriterTraceBlock::allocate_range_prop_vec() {
-        PropertyVec<RANGE_LEAF_SIZE>* res = nullptr;
-        if(range_prop_vecs->empty()) {
-            res = new PropertyVec<RANGE_LEAF_SIZE>();
-        } else {
-            res = range_prop_vecs->top();
-            range_prop_vecs->pop();
-        }
+        bool zeroed;
+        auto res = (PropertyVec<RANGE_LEAF_SIZE>*) range_prop_vecs.allocate(zeroed);
+        res->ref_cnt = 1;
+        count_pooled(MEMORY_PROPERTY_VEC, res, 1);
         return res;
     }
 
     PropertyVec<ART_LEAF_SIZE>* WriterTraceBlock::allocate_art_prop_vec() {
-        PropertyVec<ART_LEAF_SIZE>* res = nullptr;
-        if(art_prop_vecs->empty()) {
-            res = new PropertyVec<ART_LEAF_SIZE>();
-        } else {
-            res = art_prop_vecs->top();
-            art_prop_vecs->pop();
-        }
+        bool zeroed;
+        auto res = (PropertyVec<ART_LEAF_SIZE>*) art_prop_vecs.allocate(zeroed);
+        res->ref_cnt = 1;
+        count_pooled(MEMORY_PROPERTY_VEC, res, 1);
         return res;
     }
 #endif
 
     void WriterTraceBlock::deallocate_range_element_segment(RangeElementSegment_t *segment) {
-        range_element_segments->push(segment);
+        count_pooled(MEMORY_CLUSTERED_SEGMENT, segment, -1);
+        range_element_segments.deallocate(segment);
+    }
+
+    void WriterTraceBlock::deallocate_range_tree_segment(RangeElementSegment_t *segment) {
+        count_pooled(MEMORY_RANGE_TREE_SEGMENT, segment, -1);
+        range_element_segments.deallocate(segment);
     }
 
 //    void WriterTraceBlock::deallocate_inrange_element_segment(InRangeElementSegment_t *segment) {
 //        in_range_element_segments->push(segment);
 //    }
 
-    void WriterTraceBlock::deallocate_vertex_map(VertexMap_t *segment) {
-        vertex_maps->push(segment);
+    void WriterTraceBlock::deallocate_vertex_map(VertexMap *segment) {
+        count_pooled(MEMORY_VERTEX_MAP, segment, -1);
+        vertex_maps.deallocate(segment);
+    }
+
+    void WriterTraceBlock::deallocate_vertex_map_chunk(VertexMapChunk_t *chunk) {
+        count_pooled(MEMORY_VERTEX_MAP, chunk, -1);
+        vertex_map_chunks.deallocate(chunk);
     }
 
     void WriterTraceBlock::deallocate_art_leaf32(std::array<uint32_t, ART_LEAF_SIZE> *leaf) {
-        art_leaf32s->push(leaf);
+        count_pooled(MEMORY_ART_LEAF32, leaf, -1);
+        art_leaf32s.deallocate(leaf);
     }
 
     void WriterTraceBlock::deallocate_art_leaf64(std::array<uint64_t, ART_LEAF_SIZE> *leaf) {
-        art_leaf64s->push(leaf);
+        count_pooled(MEMORY_ART_LEAF64, leaf, -1);
+        art_leaf64s.deallocate(leaf);
     }
 
     void WriterTraceBlock::deallocate_art_node48(ARTNode_48 *node) {
-        art_node48s->push(node);
+        count_pooled(MEMORY_ART_NODE48, node, -1);
+        art_node48s.deallocate(node);
     }
 
     void WriterTraceBlock::deallocate_art_node256(ARTNode_256 *node) {
-        art_node256s->push(node);
+        count_pooled(MEMORY_ART_NODE256, node, -1);
+        art_node256s.deallocate(node);
     }
 
 #if EDGE_PROPERTY_NUM > 0
     void WriterTraceBlock::deallocate_range_prop_vec(PropertyVec<RANGE_LEAF_SIZE> *vec) {
-        range_prop_vecs->push(vec);
+        count_pooled(MEMORY_PROPERTY_VEC, vec, -1);
+        range_prop_vecs.deallocate(vec);
     }
 
     void WriterTraceBlock::deallocate_art_prop_vec(PropertyVec<ART_LEAF_SIZE> *vec) {
-        art_prop_vecs->push(vec);
+        count_pooled(MEMORY_PROPERTY_VEC, vec, -1);
+        art_prop_vecs.deallocate(vec);
     }
 #endif
 
+    void release_range_element_segment(RangeElementSegment_t *segment) {
+        count_pooled(MEMORY_CLUSTERED_SEGMENT, segment, -1);
+        writer_slabs().range_element_segments.release(segment);
+    }
+
+    void release_range_tree_segment(RangeElementSegment_t *segment) {
+        count_pooled(MEMORY_RANGE_TREE_SEGMENT, segment, -1);
+        writer_slabs().range_element_segments.release(segment);
+    }
+
+    void release_vertex_map(VertexMap *map) {
+        count_pooled(MEMORY_VERTEX_MAP, map, -1);
+        writer_slabs().vertex_maps.release(map);
+    }
+
+    void release_vertex_map_chunk(VertexMapChunk_t *chunk) {
+        count_pooled(MEMORY_VERTEX_MAP, chunk, -1);
+        writer_slabs().vertex_map_chunks.release(chunk);
+    }
+
+    void release_art_leaf32(std::array<uint32_t, ART_LEAF_SIZE> *leaf) {
+        count_pooled(MEMORY_ART_LEAF32, leaf, -1);
+        writer_slabs().art_leaf32s.release(leaf);
+    }
+
+    void release_art_node48(ARTNode_48 *node) {
+        count_pooled(MEMORY_ART_NODE48, node, -1);
+        writer_slabs().art_node48s.release(node);
+    }
+
+    void release_art_node256(ARTNode_256 *node) {
+        count_pooled(MEMORY_ART_NODE256, node, -1);
+        writer_slabs().art_node256s.release(node);
+    }
+
+#if EDGE_PROPERTY_NUM > 0
+    void release_range_prop_vec(PropertyVec<RANGE_LEAF_SIZE> *vec) {
+        count_pooled(MEMORY_PROPERTY_VEC, vec, -1);
+        writer_slabs().range_prop_vecs.release(vec);
+    }
+
+    void release_art_prop_vec(PropertyVec<ART_LEAF_SIZE> *vec) {
+        count_pooled(MEMORY_PROPERTY_VEC, vec, -1);
+        writer_slabs().art_prop_vecs.release(vec);
+    }
+#endif
     
     ActiveWriterTracer::ActiveWriterTracer() {
         for(uint64_t i = 0; i < INIT_WRITER_NUM; i++) {
@@ -224,16 +437,7 @@ namespace container{
         while(true) {
             for (auto &block: blocks) {
                 if (block->lock.try_lock()) {
-                    block->range_element_segments = new std::stack<RangeElementSegment_t *>();
-                    block->vertex_maps = new std::stack<VertexMap_t *>();
-                    block->art_leaf32s = new std::stack<std::array<uint32_t, ART_LEAF_SIZE> *>();
-                    block->art_leaf64s = new std::stack<std::array<uint64_t, ART_LEAF_SIZE> *>();
-                    block->art_node48s = new std::stack<ARTNode_48 *>();
-                    block->art_node256s = new std::stack<ARTNode_256 *>();
-#if EDGE_PROPERTY_NUM > 0
-                    block->range_prop_vecs = new std::stack<PropertyVec<RANGE_LEAF_SIZE> *>();
-                    block->art_prop_vecs = new std::stack<PropertyVec<ART_LEAF_SIZE> *>();
-#endif
+                    block->wal_buffer = new WALBuffer();
                     return block;
                 }
             }
@@ -246,53 +450,28 @@ namespace container{
     }
 
     void ActiveWriterTracer::writer_unregister(WriterTraceBlock* block) {
-        while(!block->range_element_segments->empty()) {
-            free(block->range_element_segments->top());
-            block->range_element_segments->pop();
-        }
-        delete block->range_element_segments;
+        // the cached objects go back to the depot, where the other writers pick them up
+        block->range_element_segments.flush();
 //        while(!block->in_range_element_segments->empty()) {
 //            delete block->in_range_element_segments->top();
 //            block->in_range_element_segments->pop();
 //        }
 //        delete block->in_range_element_segments;
-        while(!block->vertex_maps->empty()) {
-            delete block->vertex_maps->top();
-            block->vertex_maps->pop();
-        }
-        delete block->vertex_maps;
-        while(!block->art_leaf32s->empty()) {
-            delete block->art_leaf32s->top();
-            block->art_leaf32s->pop();
-        }
-        delete block->art_leaf32s;
-        while(!block->art_leaf64s->empty()) {
-            delete block->art_leaf64s->top();
-            block->art_leaf64s->pop();
-        }
-        delete block->art_leaf64s;
-        while(!block->art_node48s->empty()) {
-            delete block->art_node48s->top();
-            block->art_node48s->pop();
-        }
-        delete block->art_node48s;
-        while(!block->art_node256s->empty()) {
-            delete block->art_node256s->top();
-            block->art_node256s->pop();
-        }
-        delete block->art_node256s;
+        block->vertex_maps.flush();
+        block->vertex_map_chunks.flush();
+        block->art_leaf32s.flush();
+        block->art_leaf64s.flush();
+        block->art_node48s.flush();
+        block->art_node256s.flush();
 #if EDGE_PROPERTY_NUM > 0
-        while(!block->range_prop_vecs->empty()) {
-            delete block->range_prop_vecs->top();
-            block->range_prop_vecs->pop();
-        }
-        delete block->range_prop_vecs;
-        while(!block->art_prop_vecs->empty()) {
-            delete block->art_prop_vecs->top();
-            block->art_prop_vecs->pop();
-        }
-        delete block->art_prop_vecs;
+        block->range_prop_vecs.flush();
+        block->art_prop_vecs.flush();
 #endif
+        // records of a leaving writer must not be lost with its buffer
+        if(block->wal_buffer->log && !block->wal_buffer->records.empty()) {
+            block->wal_buffer->log->commit(block->wal_buffer);
+        }
+        delete block->wal_buffer;
         block->lock.unlock();
     }
 
@@ -330,8 +509,8 @@ namespace container{
         global_tracer.set_timestamp(block, timestamp);
     }
 
-    void get_active_reader_info(std::vector<uint64_t>&readers) {
-        global_tracer.get_active_reader_info(readers);
+    void get_active_reader_info(std::vector<uint64_t>&readers, uint64_t below) {
+        global_tracer.get_active_reader_info(readers, below);
     }
 
     uint64_t get_min_timestamp() {
@@ -346,6 +525,26 @@ namespace container{
         return global_writer_tracer.writer_batch_register(writer_num);
     }
 
+    namespace {
+        thread_local WriterTraceBlock* batch_worker_block = nullptr;
+    }
+
+    void batch_worker_register() {
+        batch_worker_block = writer_register();
+    }
+
+    void batch_worker_unregister() {
+        writer_unregister(batch_worker_block);
+        batch_worker_block = nullptr;
+    }
+
+    WriterTraceBlock* batch_trace_block() {
+        if(batch_worker_block == nullptr) {
+            throw std::logic_error("batch_trace_block(): not called by a worker of the batch update pool");
+        }
+        return batch_worker_block;
+    }
+
     WriterTraceBlock* get_trace_block(uint64_t idx) {
         return global_writer_tracer.blocks.at(idx);
     }
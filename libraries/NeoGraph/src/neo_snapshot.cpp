@@ -1,16 +1,17 @@
 #include "../include/neo_snapshot.h"
 #include "utils/helper.h"
+#include "include/neo_checkpoint.h"
 
 namespace container {
-    NeoSnapshot::NeoSnapshot(const TransactionManager *tm) : index(tm->index_impl),
+    NeoSnapshot::NeoSnapshot(const TransactionManager *tm) : index(tm->index_impl), dictionary(tm->dictionary),
                                                                         versions(new std::vector<NeoTreeVersion *>()) {
         trace_block = reader_register();
         timestamp = tm->get_read_timestamp();
         set_timestamp(trace_block, timestamp);
         // add all versions
         versions->resize(index->forest->size());
-        for (uint64_t idx = 0; idx < index->forest->size(); idx++) {
-            auto tree = index->forest->at(idx).get();
+        for (uint64_t idx = 0; idx < versions->size(); idx++) {
+            auto tree = index->forest->get(idx);
             if(tree != nullptr) {
                 versions->at(idx) = tree->find_version(timestamp);
             }
@@ -19,7 +20,7 @@ namespace container {
         set_status(trace_block, 2); // running
     }
 
-    NeoSnapshot::NeoSnapshot(const NeoSnapshot &other) : index(other.index), timestamp(other.timestamp),
+    NeoSnapshot::NeoSnapshot(const NeoSnapshot &other) : index(other.index), dictionary(other.dictionary), timestamp(other.timestamp),
                                                          versions(new std::vector<NeoTreeVersion *>) {
         trace_block = reader_register();
         set_timestamp(trace_block, timestamp);
@@ -62,6 +63,7 @@ namespace container {
     bool NeoSnapshot::has_edge(uint64_t src, uint64_t dest) const {
         NeoTreeVersion *version = find_version(src);
         if (version != nullptr) {
+            note_access(version, src, NEO_ACCESS_LOOKUP);
             return version->has_edge(src, dest);
         }
         return false;
@@ -78,6 +80,7 @@ namespace container {
     bool NeoSnapshot::get_neighbor(uint64_t src, std::vector<uint64_t> &neighbor) const {
         NeoTreeVersion *version = find_version(src);
         if (version != nullptr) {
+            note_access(version, src, NEO_ACCESS_SCAN);
             return version->get_neighbor(src, neighbor);
         }
         return false;
@@ -86,11 +89,21 @@ namespace container {
     RangeElement *NeoSnapshot::get_neighbor_addr(uint64_t src) const {
         NeoTreeVersion *version = find_version(src);
         if (version != nullptr) {
+            note_access(version, src, NEO_ACCESS_SCAN);
             return version->get_neighbor_addr(src);
         }
         return nullptr;
     }
 
+    NeighborRange NeoSnapshot::neighbors(uint64_t src) const {
+        NeoTreeVersion *version = find_version(src);
+        if (version != nullptr) {
+            note_access(version, src, NEO_ACCESS_SCAN);
+            return version->neighbors(src);
+        }
+        return {};
+    }
+
 #if VERTEX_PROPERTY_NUM >= 1
     Property_t NeoSnapshot::get_vertex_property(uint64_t vertex, uint8_t property_id) const {
         NeoTreeVersion *version = find_version(vertex);
@@ -113,6 +126,7 @@ namespace container {
     Property_t NeoSnapshot::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const {
         NeoTreeVersion *version = find_version(src);
         if (version != nullptr) {
+            note_access(version, src, NEO_ACCESS_LOOKUP);
             return version->get_edge_property(src, dest, property_id);
         }
         return std::numeric_limits<Property_t>::max();
@@ -134,6 +148,8 @@ namespace container {
         if(version1 == nullptr || version2 == nullptr) {
             return;
         }
+        note_access(version1, src1, NEO_ACCESS_SCAN);
+        note_access(version2, src2, NEO_ACCESS_SCAN);
         NeoTreeVersion::intersect(version1, src1, version2, src2, result);
     }
 
@@ -143,6 +159,8 @@ namespace container {
         if(version1 == nullptr || version2 == nullptr) {
             return 0;
         }
+        note_access(version1, src1, NEO_ACCESS_SCAN);
+        note_access(version2, src2, NEO_ACCESS_SCAN);
 
 //        auto res2 = 0;
 //        std::vector<uint64_t> neighbor_1;
@@ -171,11 +189,16 @@ namespace container {
         return res1;
     }
 
+    void NeoSnapshot::save(const std::string &path) const {
+        // IDs are never reused, so the mappings assigned after the snapshot was taken can be saved with it
+        save_checkpoint(*versions, index->layout, timestamp, path, dictionary ? dictionary->externals() : std::vector<uint64_t>());
+    }
+
     NeoTreeVersion *NeoSnapshot::find_version(uint64_t vertex) const {
-        if(NeoGraphIndex::gen_tree_direction(vertex) >= versions->size()) {
+        if(index->gen_tree_direction(vertex) >= versions->size()) {
             return nullptr;
         }
-        return versions->at(NeoGraphIndex::gen_tree_direction(vertex));
+        return versions->at(index->gen_tree_direction(vertex));
     }
 
 }
\ No newline at end of file
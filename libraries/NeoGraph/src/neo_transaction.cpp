@@ -1,4 +1,9 @@
+#include <unistd.h>
+#include <thread>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #include "include/neo_transaction.h"
+#include "include/neo_checkpoint.h"
 #include "../../../types/types.hpp"
 
 
@@ -6,12 +11,50 @@
 // TransactionManager
 namespace container {
     std::stack<uint64_t> reusable_vertex_pool{};
-    TransactionManager::TransactionManager(bool is_directed, bool is_weighted): is_directed(is_directed), is_weighted(is_weighted) {
-        index_impl = new NeoGraphIndex();
+
+    namespace {
+        ///@return layout as this build serves it
+        NeoLayout served_layout(const NeoLayout &layout) {
+#ifdef NEO_WIDE_VERTEX_ID
+            // the ART indexes 32-bit keys, wide neighborhoods of any degree stay in RangeTrees
+            auto wide_layout = layout;
+            wide_layout.art_extract_threshold = std::numeric_limits<uint64_t>::max();
+            return wide_layout;
+#else
+            return layout;
+#endif
+        }
+    }
+    TransactionManager::TransactionManager(bool is_directed, bool is_weighted, const NeoLayout &layout): is_directed(is_directed), is_weighted(is_weighted) {
+        if(layout.vertex_group_bits < VERTEX_MAP_CHUNK_BITS || layout.vertex_group_bits > MAX_VERTEX_GROUP_BITS || layout.range_leaf_size > RANGE_LEAF_SIZE) {
+            throw std::invalid_argument("TransactionManager: layout exceeds the capacities of config.h");
+        }
+        index_impl = new NeoGraphIndex(served_layout(layout));
+        commit_ring = new std::atomic<uint64_t>[COMMIT_RING_SIZE];
+        for(uint64_t i = 0; i < COMMIT_RING_SIZE; i++) {
+            commit_ring[i].store(0, std::memory_order_relaxed);
+        }
     }
 
     TransactionManager::~TransactionManager() {
+#if EDGE_TTL_ENABLE
+        stop_edge_expirer();
+#endif
+        delete wal;
+        delete dictionary;
         delete index_impl;
+        delete[] commit_ring;
+    }
+
+    NeoLayout TransactionManager::choose_layout(uint64_t vertex_num, uint64_t edge_num, uint64_t max_degree) {
+        auto avg_degree = vertex_num == 0 ? 0 : edge_num / vertex_num;
+        if(avg_degree < LAYOUT_SPARSE_DEGREE) {
+            return NEO_LAYOUT_SPARSE;
+        }
+        if(max_degree >= LAYOUT_SKEWED_RATIO * avg_degree) {
+            return NEO_LAYOUT_SKEWED;
+        }
+        return NEO_LAYOUT_DEFAULT;
     }
 
     uint64_t TransactionManager::vertex_count() const {
@@ -22,20 +65,62 @@ namespace container {
         return m_edge_count;
     }
 
+    uint64_t NeoMemoryReport::total() const {
+        return clustered_segments + range_tree_nodes + range_tree_segments + art_node4 + art_node16 + art_node48
+               + art_node256 + art_leaf8 + art_leaf16 + art_leaf32 + art_leaf64 + property_vecs + vertex_maps + versions
+               + pooled_free;
+    }
+
+    NeoMemoryReport TransactionManager::memory_report() {
+        auto counted = memory_counted();
+        // a free racing with the snapshot may leave a counter briefly negative
+        auto bytes = [&counted](MemoryCategory category) {
+            return (uint64_t) std::max<int64_t>(counted[category], 0);
+        };
+        uint64_t mapped = 0;
+        for(auto &stats: slab_stats()) {
+            mapped += stats.slab_num * stats.slab_size;
+        }
+        return NeoMemoryReport{
+            bytes(MEMORY_CLUSTERED_SEGMENT), bytes(MEMORY_RANGE_TREE), bytes(MEMORY_RANGE_TREE_SEGMENT),
+            bytes(MEMORY_ART_NODE4), bytes(MEMORY_ART_NODE16), bytes(MEMORY_ART_NODE48), bytes(MEMORY_ART_NODE256),
+            bytes(MEMORY_ART_LEAF8), bytes(MEMORY_ART_LEAF16), bytes(MEMORY_ART_LEAF32), bytes(MEMORY_ART_LEAF64),
+            bytes(MEMORY_PROPERTY_VEC), bytes(MEMORY_VERTEX_MAP), bytes(MEMORY_VERSION),
+            mapped - std::min(mapped, bytes(MEMORY_SLAB_USED))
+        };
+    }
+
     uint64_t TransactionManager::get_write_timestamp() {
         // update +1 and return the new value, return the new value
         return write_timestamp.fetch_add(1, std::memory_order_relaxed) + 1;
     }
 
     void TransactionManager::finish_commit(uint64_t timestamp) {
-        // read_timestamp + 1 only when read_timestamp = timestamp - 1, CAS
-        auto target = timestamp - 1;
-        while(!read_timestamp.compare_exchange_weak(target, timestamp, std::memory_order_relaxed)) {
+        // the slot is still owned by timestamp - COMMIT_RING_SIZE until read_timestamp has passed it
+        uint64_t backoff = 1;
+        while(timestamp - read_timestamp.load(std::memory_order_acquire) > COMMIT_RING_SIZE) {
+            if(backoff <= SPIN_BACKOFF_LIMIT) {
+                for(uint64_t i = 0; i < backoff; i++) {
+                    _mm_pause();
+                }
+                backoff <<= 1;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        // seq_cst on both sides: either this writer sees the advance up to timestamp - 1, or the advancing one sees the slot
+        commit_ring[timestamp & COMMIT_RING_MASK].store(timestamp, std::memory_order_seq_cst);
+        auto current = read_timestamp.load(std::memory_order_seq_cst);
+        while(commit_ring[(current + 1) & COMMIT_RING_MASK].load(std::memory_order_seq_cst) == current + 1) {
+            // also releases the versions committed under current + 1 to the readers that acquire it
+            if(read_timestamp.compare_exchange_weak(current, current + 1, std::memory_order_seq_cst, std::memory_order_seq_cst)) {
+                current += 1;
+            }
         }
     }
 
     uint64_t TransactionManager::get_read_timestamp() const {
-        return read_timestamp;
+        return read_timestamp.load(std::memory_order_acquire);
     }
 
     WriteTransaction* TransactionManager::get_write_transaction() {
@@ -50,6 +135,491 @@ namespace container {
         return new ReadTransaction(this->index_impl, this);
     }
 
+    void TransactionManager::enable_wal(const std::string &path) {
+        if(wal) {
+            throw std::runtime_error("TransactionManager::enable_wal(): log already enabled");
+        }
+        auto valid = recover(path);
+        // cut a torn tail off, new groups must directly follow the last valid one
+        ::truncate(path.c_str(), (off_t) valid);
+        wal = new WriteAheadLog(path);
+    }
+
+    uint64_t TransactionManager::recover(const std::string &path) {
+        if(wal) {
+            throw std::runtime_error("TransactionManager::recover(): recovery must run before the log is enabled");
+        }
+        std::vector<WALRecord> records;
+        auto valid = WriteAheadLog::read(path, records);
+        // dictionary mappings are restored whatever their timestamp, a checkpoint may hold only part of them
+        for(auto &record: records) {
+            if(record.op == WAL_ASSIGN_VERTEX) {
+                if(!dictionary) {
+                    throw std::runtime_error("TransactionManager::recover(): the log holds a vertex dictionary, enable it first");
+                }
+                dictionary->restore(record.src, record.dest);
+            }
+        }
+        // records already covered by a loaded checkpoint are dropped
+        uint64_t checkpoint_timestamp = read_timestamp;
+        records.erase(records.begin(), std::upper_bound(records.begin(), records.end(), checkpoint_timestamp, [](uint64_t timestamp, const WALRecord &record) {
+            return timestamp < record.timestamp;
+        }));
+        if(records.empty()) {
+            return valid;
+        }
+        auto tracer = writer_register();
+#if EDGE_TTL_ENABLE
+        // the logged properties already hold the epochs of the edges
+        auto edge_ttl_set = edge_ttl;
+        edge_ttl = 0;
+#endif
+
+        // insertions and removals are each collected until an operation that depends on their order shows up
+        std::vector<uint64_t> vertices;
+        std::vector<WALRecord> edges;
+        std::vector<PRR> removals;
+        auto apply_removals = [&]() {
+            if(!removals.empty()) {
+                remove_edge_batch(removals, tracer);
+                removals.clear();
+            }
+        };
+        auto apply_insertions = [&]() {
+            if(!vertices.empty()) {
+                std::sort(vertices.begin(), vertices.end());
+                vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+                WriteTransaction tx(index_impl, this);
+                for(auto vertex: vertices) {
+                    tx.insert_vertex(vertex, nullptr);
+                }
+                if(!tx.commit(true, false)) {
+                    throw std::runtime_error("TransactionManager::recover(): vertex replay failed");
+                }
+                vertices.clear();
+            }
+            if(!edges.empty()) {
+                // the last logged version of an edge wins
+                std::stable_sort(edges.begin(), edges.end(), [](const WALRecord &lhs, const WALRecord &rhs) {
+                    return lhs.src != rhs.src ? lhs.src < rhs.src : lhs.dest < rhs.dest;
+                });
+                uint64_t edge_count = m_edge_count;
+                WriteTransaction tx(index_impl, this);
+                for(uint64_t i = 0; i < edges.size(); i++) {
+                    if(i + 1 != edges.size() && edges[i].src == edges[i + 1].src && edges[i].dest == edges[i + 1].dest) {
+                        continue;
+                    }
+                    tx.insert_edge(edges[i].src, edges[i].dest, (Property_t*) edges[i].property);
+                    edge_count += 1;
+                }
+                if(!tx.commit(false, true)) {
+                    throw std::runtime_error("TransactionManager::recover(): edge replay failed");
+                }
+                m_edge_count = edge_count;
+                edges.clear();
+            }
+        };
+
+        uint64_t max_timestamp = 0;
+        for(auto &record: records) {
+            max_timestamp = std::max<uint64_t>(max_timestamp, record.timestamp);
+            switch(record.op) {
+                case WAL_INSERT_VERTEX:
+                    apply_removals();
+                    vertices.push_back(record.src);
+                    break;
+                case WAL_INSERT_UNDIRECTED_EDGE:
+                    apply_removals();
+                    edges.push_back(WALRecord{record.timestamp, WAL_INSERT_EDGE, record.dest, record.src, record.property});
+                    edges.push_back(record);
+                    break;
+                case WAL_INSERT_EDGE:
+                    apply_removals();
+                    edges.push_back(record);
+                    break;
+                case WAL_REMOVE_VERTEX: {
+                    apply_insertions();
+                    apply_removals();
+                    WriteTransaction tx(index_impl, this);
+                    tx.remove_vertex(record.src);
+                    if(!tx.commit()) {
+                        throw std::runtime_error("TransactionManager::recover(): vertex removal replay failed");
+                    }
+                    break;
+                }
+                case WAL_REMOVE_UNDIRECTED_EDGE:
+                    apply_insertions();
+                    removals.emplace_back(record.dest, record.src);
+                    removals.emplace_back(record.src, record.dest);
+                    break;
+                case WAL_REMOVE_EDGE:
+                    apply_insertions();
+                    removals.emplace_back(record.src, record.dest);
+                    break;
+                case WAL_UPDATE_EDGE: {
+                    apply_insertions();
+                    apply_removals();
+                    LightWriteTransaction tx(this, tracer);
+                    tx.update_edge(record.src, record.dest, (double) record.property);
+                    tx.commit();
+                    break;
+                }
+                case WAL_ASSIGN_VERTEX:
+                    break;
+                default:
+                    throw std::runtime_error("TransactionManager::recover(): unknown log record");
+            }
+        }
+        apply_insertions();
+        apply_removals();
+#if EDGE_TTL_ENABLE
+        edge_ttl = edge_ttl_set;
+#endif
+
+        writer_unregister(tracer);
+        // timestamps handed out after the recovery must order after the logged ones
+        if(write_timestamp < max_timestamp) {
+            write_timestamp = max_timestamp;
+            read_timestamp = max_timestamp;
+        }
+        return valid;
+    }
+
+    uint64_t TransactionManager::load_checkpoint(const std::string &path) {
+        if(m_vertex_count != 0 || m_edge_count != 0) {
+            throw std::runtime_error("TransactionManager::load_checkpoint(): the graph is not empty");
+        }
+        NeoCheckpoint checkpoint(path);
+        auto &header = checkpoint.header();
+        auto vertex_dict = checkpoint.section<uint64_t>(CHECKPOINT_VERTEX_DICT);
+        auto vertex_dict_num = checkpoint.section_num<uint64_t>(CHECKPOINT_VERTEX_DICT);
+        if(vertex_dict_num != 0 && !dictionary) {
+            throw std::runtime_error("TransactionManager::load_checkpoint(): the checkpoint holds a vertex dictionary, enable it first");
+        }
+        auto tracer = writer_register();
+        container::load_checkpoint(checkpoint, index_impl, tracer);
+        writer_unregister(tracer);
+        for(uint64_t internal = 0; internal < vertex_dict_num; internal++) {
+            if(vertex_dict[internal] != NeoVertexDictionary::NONE) {
+                dictionary->restore(vertex_dict[internal], internal);
+            }
+        }
+        m_vertex_count = header.vertex_count;
+        m_edge_count = header.edge_count;
+        if(write_timestamp < header.timestamp) {
+            write_timestamp = header.timestamp;
+            read_timestamp = header.timestamp;
+        }
+        return header.timestamp;
+    }
+
+    uint64_t TransactionManager::bulk_load(const std::vector<PUU> &edges, bool adapt_layout) {
+        if(m_vertex_count != 0 || m_edge_count != 0 || index_impl->forest->size() != 0) {
+            throw std::runtime_error("TransactionManager::bulk_load(): the graph is not empty");
+        }
+        std::vector<PRR> sorted_edges(is_directed ? edges.size() : edges.size() * 2);
+        std::atomic<bool> too_wide{false};
+        tbb::parallel_for(tbb::blocked_range<uint64_t>(0, edges.size()), [&](const tbb::blocked_range<uint64_t> &range) {
+            for(auto i = range.begin(); i != range.end(); i++) {
+                if(std::max(edges[i].first, edges[i].second) > std::numeric_limits<RangeElement>::max()) {
+                    too_wide.store(true, std::memory_order_relaxed);
+                }
+                sorted_edges[i] = {edges[i].first, edges[i].second};
+                if(!is_directed) {
+                    sorted_edges[edges.size() + i] = {edges[i].second, edges[i].first};
+                }
+            }
+        });
+        if(too_wide) {
+            throw std::invalid_argument("TransactionManager::bulk_load(): vertex ID exceeds RangeElement, see NEO_WIDE_VERTEX_ID");
+        }
+        tbb::parallel_sort(sorted_edges.begin(), sorted_edges.end());
+        sorted_edges.erase(std::unique(sorted_edges.begin(), sorted_edges.end()), sorted_edges.end());
+
+        std::vector<uint64_t> vertices(sorted_edges.size() * 2);
+        tbb::parallel_for(tbb::blocked_range<uint64_t>(0, sorted_edges.size()), [&](const tbb::blocked_range<uint64_t> &range) {
+            for(auto i = range.begin(); i != range.end(); i++) {
+                vertices[2 * i] = sorted_edges[i].first;
+                vertices[2 * i + 1] = sorted_edges[i].second;
+            }
+        });
+        tbb::parallel_sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+        if(adapt_layout) {
+            uint64_t max_degree = 0;
+            for(uint64_t st = 0, ed = 0; st < sorted_edges.size(); st = ed) {
+                while(ed < sorted_edges.size() && sorted_edges[ed].first == sorted_edges[st].first) {
+                    ed++;
+                }
+                max_degree = std::max(max_degree, ed - st);
+            }
+            index_impl->set_layout(served_layout(choose_layout(vertices.size(), sorted_edges.size(), max_degree)));
+        }
+
+        // the vertices of a tree are contiguous in both sorted arrays
+        std::vector<uint64_t> tree_begins;
+        for(uint64_t i = 0; i < vertices.size(); i++) {
+            if(i == 0 || index_impl->gen_tree_direction(vertices[i]) != index_impl->gen_tree_direction(vertices[i - 1])) {
+                tree_begins.push_back(i);
+            }
+        }
+        tree_begins.push_back(vertices.size());
+        auto property = edge_property(nullptr);
+        std::vector<Property_t*> properties(sorted_edges.size(), property);
+
+        auto timestamp = get_write_timestamp();
+        auto &layout = index_impl->layout;
+        auto thread_num = std::min<uint64_t>(std::max(1u, std::thread::hardware_concurrency()), BATCH_UPDATE_THREAD_NUM);
+        std::vector<WriterTraceBlock*> tracers;
+        for(uint64_t i = 0; i < thread_num; i++) {
+            tracers.push_back(writer_register());
+        }
+        tbb::task_arena arena((int) thread_num);
+        arena.execute([&]() {
+            tbb::parallel_for(tbb::blocked_range<uint64_t>(0, tree_begins.size() - 1), [&](const tbb::blocked_range<uint64_t> &range) {
+                auto tracer = tracers[tbb::this_task_arena::current_thread_index()];
+                for(auto t = range.begin(); t != range.end(); t++) {
+                    auto vertex_begin = vertices.data() + tree_begins[t];
+                    auto direction = index_impl->gen_tree_direction(*vertex_begin);
+                    // the first vertex of the next tree may not fit a RangeElement, so the directions are compared instead
+                    auto edge_begin = std::partition_point(sorted_edges.begin(), sorted_edges.end(), [&](const PRR &edge) {
+                        return index_impl->gen_tree_direction(edge.first) < direction;
+                    });
+                    auto edge_end = std::partition_point(edge_begin, sorted_edges.end(), [&](const PRR &edge) {
+                        return index_impl->gen_tree_direction(edge.first) == direction;
+                    });
+                    auto tree = new NeoTree(direction << layout.vertex_group_bits, &layout);
+                    auto version = new NeoTreeVersion(nullptr, &layout, tracer);
+                    auto edge_offset = edge_begin - sorted_edges.begin();
+                    version->bulk_build(vertex_begin, tree_begins[t + 1] - tree_begins[t], sorted_edges.data() + edge_offset, properties.data() + edge_offset, edge_end - edge_begin, tracer);
+                    tree->finish_version(version);
+                    tree->commit_version(timestamp);
+                    index_impl->forest->install(direction, tree);
+                }
+            });
+        });
+
+        if(wal) {
+            for(auto vertex: vertices) {
+                wal_append(tracers[0], timestamp, WAL_INSERT_VERTEX, vertex, 0);
+            }
+            for(auto &edge: edges) {
+                wal_append(tracers[0], timestamp, is_directed ? WAL_INSERT_EDGE : WAL_INSERT_UNDIRECTED_EDGE, edge.first, edge.second, (uint64_t) property);
+            }
+            wal_commit(tracers[0]);
+        }
+        for(auto tracer: tracers) {
+            writer_unregister(tracer);
+        }
+        m_vertex_count = vertices.size();
+        m_edge_count = sorted_edges.size();
+        finish_commit(timestamp);
+        return timestamp;
+    }
+
+    void TransactionManager::wal_commit(WriterTraceBlock* tracer) {
+        if(wal) {
+            wal->commit(tracer->wal_buffer);
+        }
+    }
+
+    NeoVertexDictionary* TransactionManager::enable_vertex_dictionary() {
+        if(!dictionary) {
+            dictionary = new NeoVertexDictionary();
+        }
+        return dictionary;
+    }
+
+    uint64_t TransactionManager::assign_vertex(uint64_t external) {
+        bool assigned;
+        auto internal = dictionary->assign(external, &assigned);
+        if(assigned && wal) {
+            WALBuffer buffer;
+            wal->append(&buffer, get_read_timestamp(), WAL_ASSIGN_VERTEX, external, internal);
+            wal->commit(&buffer);
+        }
+        return internal;
+    }
+
+    void TransactionManager::assign_vertices(const std::vector<uint64_t> &externals) {
+        WALBuffer buffer;
+        for(auto external: externals) {
+            bool assigned;
+            auto internal = dictionary->assign(external, &assigned);
+            if(assigned && wal) {
+                wal->append(&buffer, get_read_timestamp(), WAL_ASSIGN_VERTEX, external, internal);
+            }
+        }
+        if(wal) {
+            wal->commit(&buffer);
+        }
+    }
+
+    uint64_t TransactionManager::remove_edge_batch(std::vector<PRR> &edges, WriterTraceBlock* tracer) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        std::vector<uint64_t> directions;
+        for(uint64_t i = 0; i < edges.size(); i++) {
+            auto direction = index_impl->gen_tree_direction(edges[i].first);
+            if(i != 0 && index_impl->gen_tree_direction(edges[i - 1].first) == direction) {
+                continue;
+            }
+            auto tree = index_impl->lock(direction);
+            if(tree == nullptr) {
+                continue;
+            }
+            if(tree->version_head.load(std::memory_order_relaxed) == nullptr) {
+                tree->writer_lock.unlock();
+                continue;
+            }
+            directions.push_back(direction);
+        }
+        // the edges of a tree without any version are dropped
+        edges.erase(std::remove_if(edges.begin(), edges.end(), [&](const PRR &edge) {
+            return !std::binary_search(directions.begin(), directions.end(), index_impl->gen_tree_direction(edge.first));
+        }), edges.end());
+        return commit_edge_removal(edges, directions, tracer);
+    }
+
+    uint64_t TransactionManager::commit_edge_removal(const std::vector<PRR> &edges, const std::vector<uint64_t> &directions, WriterTraceBlock* tracer) {
+        if(directions.empty()) {
+            return 0;
+        }
+        auto removed = index_impl->remove_edge_batch(edges.data(), edges.size(), tracer);
+        auto timestamp = get_write_timestamp();
+        for(auto &edge: edges) {
+            wal_append(tracer, timestamp, WAL_REMOVE_EDGE, edge.first, edge.second);
+        }
+        std::vector<NeoTree*> trees;
+        trees.reserve(directions.size());
+        for(auto direction: directions) {
+            trees.push_back(index_impl->commit(direction, timestamp));
+        }
+        m_edge_count -= removed;
+        finish_commit(timestamp);
+        for(auto tree: trees) {
+            tree->gc(tracer, get_read_timestamp());
+            tree->writer_lock.unlock();
+        }
+        wal_commit(tracer);
+        return removed;
+    }
+
+#if EDGE_TTL_ENABLE
+    void TransactionManager::enable_edge_ttl(uint64_t ttl, uint64_t epoch) {
+        if(ttl == 0) {
+            throw std::invalid_argument("TransactionManager::enable_edge_ttl(): ttl is 0");
+        }
+        if(is_weighted) {
+            throw std::logic_error("TransactionManager::enable_edge_ttl(): the epoch would replace the weights of a weighted graph");
+        }
+        edge_ttl = ttl;
+        edge_epoch.store(epoch, std::memory_order_relaxed);
+    }
+
+    uint64_t TransactionManager::expire_edges(WriterTraceBlock* tracer) {
+        auto epoch = edge_epoch.load(std::memory_order_relaxed);
+        if(edge_ttl == 0 || epoch < edge_ttl) {
+            return 0;
+        }
+        auto deadline = epoch - edge_ttl;
+        uint64_t expired_num = 0;
+        std::vector<PRR> expired;
+        std::vector<uint64_t> directions;
+        // every tree is scanned and committed on its own, a writer never waits for more than one tree
+        for(uint64_t direction = 0; direction < index_impl->forest->size(); direction++) {
+            auto tree = index_impl->lock(direction);
+            if(tree == nullptr) {
+                continue;
+            }
+            auto version = tree->version_head.load(std::memory_order_relaxed);
+            expired.clear();
+            if(version != nullptr) {
+                version->collect_expired(direction << index_impl->layout.vertex_group_bits, deadline, expired);
+            }
+            if(expired.empty()) {
+                tree->writer_lock.unlock();
+                continue;
+            }
+            directions.assign(1, direction);
+            if(!is_directed) {
+                // both directions of an undirected edge are removed in the same commit
+                auto count = expired.size();
+                for(uint64_t i = 0; i < count; i++) {
+                    expired.emplace_back(expired[i].second, expired[i].first);
+                    directions.push_back(index_impl->gen_tree_direction(expired[i].second));
+                }
+                std::sort(expired.begin(), expired.end());
+                expired.erase(std::unique(expired.begin(), expired.end()), expired.end());
+                std::sort(directions.begin(), directions.end());
+                directions.erase(std::unique(directions.begin(), directions.end()), directions.end());
+                if(directions.front() == direction) {
+                    for(auto other: directions) {
+                        if(other != direction) {
+                            index_impl->lock(other);
+                        }
+                    }
+                } else {
+                    // trees are locked in ascending order, so this one is released first and the edges are checked
+                    // again, an insert in between refreshes both directions
+                    tree->writer_lock.unlock();
+                    for(auto other: directions) {
+                        index_impl->lock(other);
+                    }
+                    expired.erase(std::remove_if(expired.begin(), expired.end(), [&](const PRR &edge) {
+                        auto current = index_impl->forest->get(index_impl->gen_tree_direction(edge.first))->version_head.load(std::memory_order_relaxed);
+                        return !current->has_edge(edge.first, edge.second) || current->get_edge_property(edge.first, edge.second, 0) > deadline;
+                    }), expired.end());
+                    if(expired.empty()) {
+                        for(auto other: directions) {
+                            index_impl->unlock(other);
+                        }
+                        continue;
+                    }
+                }
+            }
+            expired_num += commit_edge_removal(expired, directions, tracer);
+        }
+        return expired_num;
+    }
+
+    void TransactionManager::start_edge_expirer(std::chrono::milliseconds period) {
+        if(edge_ttl == 0) {
+            throw std::runtime_error("TransactionManager::start_edge_expirer(): no TTL set, see enable_edge_ttl");
+        }
+        if(edge_expirer) {
+            throw std::runtime_error("TransactionManager::start_edge_expirer(): expirer already running");
+        }
+        expirer_stop = false;
+        edge_expirer = new std::thread([this, period]() {
+            auto tracer = writer_register();
+            std::unique_lock<std::mutex> lock(expirer_mutex);
+            while(!expirer_wake.wait_for(lock, period, [this]() { return expirer_stop; })) {
+                lock.unlock();
+                advance_edge_epoch();
+                expire_edges(tracer);
+                lock.lock();
+            }
+            writer_unregister(tracer);
+        });
+    }
+
+    void TransactionManager::stop_edge_expirer() {
+        if(!edge_expirer) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(expirer_mutex);
+            expirer_stop = true;
+        }
+        expirer_wake.notify_all();
+        edge_expirer->join();
+        delete edge_expirer;
+        edge_expirer = nullptr;
+    }
+#endif
+
 #if VERTEX_PROPERTY_NUM >= 1 || EDGE_PROPERTY_NUM >= 1
     auto TransactionManager::get_write_property_transaction() {
         return WritePropertyTransaction(this->index_impl, ++write_timestamp);
@@ -173,7 +743,7 @@ namespace container {
 
     void WriteTransaction::insert_vertex(uint64_t vertex, Property_t* property) {
         vertex_insert_vec->push_back(vertex);
-        locks_to_acquire->push_back(vertex >> VERTEX_GROUP_BITS);
+        locks_to_acquire->push_back(index_impl->gen_tree_direction(vertex));
         tm->m_vertex_count += 1;    // TODO: not thread-safe, debug only
 #if VERTEX_PROPERTY_NUM >= 1
         vertex_property_insert_vec->push_back(property);
@@ -190,7 +760,7 @@ namespace container {
         }
 
         vertex_insert_vec->push_back(vertex);
-        locks_to_acquire->push_back(vertex >> VERTEX_GROUP_BITS);
+        locks_to_acquire->push_back(index_impl->gen_tree_direction(vertex));
         tm->m_vertex_count += 1;    // TODO: not thread-safe, debug only
 #if VERTEX_PROPERTY_NUM >= 1
         vertex_property_insert_vec->push_back(property);
@@ -200,10 +770,10 @@ namespace container {
     /// Note: the src. and dest. must been inserted transaction where the edge is inserted
     void WriteTransaction::insert_edge(uint64_t source, uint64_t destination, Property_t* property) {
         edge_insert_vec->emplace_back(source, destination);
-        locks_to_acquire->push_back(source >> VERTEX_GROUP_BITS);
+        locks_to_acquire->push_back(index_impl->gen_tree_direction(source));
         tm->m_edge_count += 2;    // TODO: not thread-safe, debug only
 #if EDGE_PROPERTY_NUM >= 1
-        edge_property_insert_vec->push_back(property);
+        edge_property_insert_vec->push_back(tm->edge_property(property));
 #endif
     }
 
@@ -213,7 +783,7 @@ namespace container {
             vertex_remove_vec = new std::vector<uint64_t>();
         }
         for(auto i = 0; i < tm->m_vertex_count; i++) {
-            locks_to_acquire->push_back(i >> VERTEX_GROUP_BITS);
+            locks_to_acquire->push_back(index_impl->gen_tree_direction(i));
         }
         vertex_remove_vec->emplace_back(vertex);
     }
@@ -222,7 +792,7 @@ namespace container {
         if(edge_remove_vec == nullptr) {
             edge_remove_vec = new std::vector<PRR>();
         }
-        locks_to_acquire->push_back(source >> VERTEX_GROUP_BITS);
+        locks_to_acquire->push_back(index_impl->gen_tree_direction(source));
         edge_remove_vec->emplace_back(source, destination);
     }
 
@@ -240,7 +810,7 @@ namespace container {
         std::sort(locks_to_acquire->begin(), locks_to_acquire->end());
         locks_to_acquire->erase(std::unique(locks_to_acquire->begin(), locks_to_acquire->end()), locks_to_acquire->end());
         for(auto &lock: *locks_to_acquire) {
-            index_impl->lock(lock);
+            index_impl->lock(lock, true);
         }
 
         // delete vertex
@@ -318,13 +888,14 @@ namespace container {
             int64_t last_direction = -1;
             for (auto i = 0; i < edge_insert_vec->size(); i++) {
 //                std::cout << edge_insert_vec->at(i).first << " " << edge_insert_vec->at(i).second << std::endl;
-                if(last_direction == edge_insert_vec->at(i).first >> VERTEX_GROUP_BITS) {
-                    index_impl->commit(edge_insert_vec->at(i).first >> VERTEX_GROUP_BITS, timestamp);
-                    index_impl->gc(edge_insert_vec->at(i).first >> VERTEX_GROUP_BITS, trace_block);
+                if(last_direction == index_impl->gen_tree_direction(edge_insert_vec->at(i).first)) {
+                    index_impl->commit(index_impl->gen_tree_direction(edge_insert_vec->at(i).first), timestamp);
+                    index_impl->gc(index_impl->gen_tree_direction(edge_insert_vec->at(i).first), trace_block, tm->get_read_timestamp());
                 } else {
-                    last_direction = edge_insert_vec->at(i).first >> VERTEX_GROUP_BITS;
+                    last_direction = index_impl->gen_tree_direction(edge_insert_vec->at(i).first);
                 }
                 if(!index_impl->insert_edge(edge_insert_vec->at(i).first, edge_insert_vec->at(i).second, edge_property_insert_vec->at(i), trace_block)) {
+                    tm->finish_commit(timestamp);   // an unfinished timestamp would hold read_timestamp back for good
                     return false;
                 }
             }
@@ -335,6 +906,7 @@ namespace container {
         if(!edge_batch_update || edge_insert_vec->size() <= BATCH_UPDATE_ENABLE_THRESHOLD) {
             for (auto i = 0; i < edge_insert_vec->size(); i++) {
                 if(!index_impl->insert_edge(edge_insert_vec->at(i).first, edge_insert_vec->at(i).second, nullptr, trace_block)) {
+                    tm->finish_commit(timestamp);
                     return false;
                 }
             }
@@ -346,24 +918,55 @@ namespace container {
         if(edge_remove_vec != nullptr) {
             for (auto &edge: *edge_remove_vec) {
                 if (!index_impl->remove_edge(edge.first, edge.second, trace_block)) {
+                    tm->finish_commit(timestamp);
                     return false;
                 }
             }
         }
 
+        if(tm->wal) {
+            log_updates();
+        }
+
         auto trees = new std::vector<NeoTree*>(locks_to_acquire->size());
         for(uint64_t i = 0; i < locks_to_acquire->size(); i++) {
             trees->at(i) = index_impl->commit(locks_to_acquire->at(i), timestamp);
         }
         tm->finish_commit(timestamp);
         for(uint64_t i = 0; i < locks_to_acquire->size(); i++) {
-            trees->at(i)->gc(trace_block);
+            trees->at(i)->gc(trace_block, tm->get_read_timestamp());
             trees->at(i)->writer_lock.unlock();
         }
         delete trees;
+        // wait for the group flush only after the tree locks are released
+        tm->wal_commit(trace_block);
         return true;
     }
 
+    void WriteTransaction::log_updates() {
+        if(vertex_remove_vec != nullptr) {
+            for(auto vertex: *vertex_remove_vec) {
+                tm->wal_append(trace_block, timestamp, WAL_REMOVE_VERTEX, vertex, 0);
+            }
+        }
+        for(auto vertex: *vertex_insert_vec) {
+            tm->wal_append(trace_block, timestamp, WAL_INSERT_VERTEX, vertex, 0);
+        }
+        for(uint64_t i = 0; i < edge_insert_vec->size(); i++) {
+#if EDGE_PROPERTY_NUM >= 1
+            auto property = (uint64_t) edge_property_insert_vec->at(i);
+#else
+            uint64_t property = 0;
+#endif
+            tm->wal_append(trace_block, timestamp, WAL_INSERT_EDGE, edge_insert_vec->at(i).first, edge_insert_vec->at(i).second, property);
+        }
+        if(edge_remove_vec != nullptr) {
+            for(auto &edge: *edge_remove_vec) {
+                tm->wal_append(trace_block, timestamp, WAL_REMOVE_EDGE, edge.first, edge.second);
+            }
+        }
+    }
+
     void WriteTransaction::abort() {
         // TODO rollback is not implemented
         std::cout << "write txn aborted" << std::endl;
@@ -448,6 +1051,94 @@ namespace container {
         delete edges_to_update;
     }
 
+    void LightWriteTransaction::group_insert_edge(uint64_t source, uint64_t destination, Property_t* property, bool undirected, TransactionManager* tm, WriterTraceBlock* tracer) {
+        if(undirected && source > destination) {
+            std::swap(source, destination);
+        }
+        property = tm->edge_property(property);
+        auto tree = tm->index_impl->forest->get(tm->index_impl->gen_tree_direction(source));
+        if (!tree) {
+            std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
+            return;
+        }
+        GroupCommitRequest request{source, destination, property, undirected};
+        tree->enqueue_group_request(&request);
+        uint64_t backoff = 1;
+        while(!request.done.load(std::memory_order_acquire)) {
+            if(tree->writer_lock.try_lock()) {
+                // the previous holder may have committed the request before releasing the lock
+                if(!request.done.load(std::memory_order_acquire)) {
+                    commit_group(tree, tm, tracer);
+                }
+                tree->writer_lock.unlock();
+                continue;
+            }
+            if(backoff <= SPIN_BACKOFF_LIMIT) {
+                for(uint64_t i = 0; i < backoff; i++) {
+                    _mm_pause();
+                }
+                backoff <<= 1;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        tm->wal_append(tracer, request.timestamp, undirected ? WAL_INSERT_UNDIRECTED_EDGE : WAL_INSERT_EDGE, source, destination, (uint64_t) property);
+    }
+
+    void LightWriteTransaction::commit_group(NeoTree* tree, TransactionManager* tm, WriterTraceBlock* tracer) {
+        std::vector<GroupCommitRequest*> requests;
+        for(auto request = tree->take_group_requests(); request != nullptr; request = request->next) {
+            requests.push_back(request);
+        }
+        if(requests.empty()) {
+            return;
+        }
+
+        uint64_t edge_num = 0;
+        if(requests.size() == 1 && !requests[0]->undirected) {
+            tree->insert_edge(requests[0]->src, requests[0]->dest, requests[0]->property, tracer);
+            edge_num = 1;
+        } else {
+            std::vector<std::pair<std::pair<RangeElement, RangeElement>, Property_t*>> entries;
+            entries.reserve(requests.size() * 2);
+            for(auto request: requests) {
+                entries.push_back({{request->src, request->dest}, request->property});
+                edge_num += 1;
+                if(request->undirected) {
+                    entries.push_back({{request->dest, request->src}, request->property});
+                    edge_num += 1;
+                }
+            }
+            // the batch path expects sorted and distinct edges
+            std::stable_sort(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs) {
+                return lhs.first < rhs.first;
+            });
+            std::vector<std::pair<RangeElement, RangeElement>> edges;
+            std::vector<Property_t*> properties;
+            edges.reserve(entries.size());
+            properties.reserve(entries.size());
+            for(auto &entry: entries) {
+                if(!edges.empty() && edges.back() == entry.first) {
+                    continue;
+                }
+                edges.push_back(entry.first);
+                properties.push_back(entry.second);
+            }
+            tree->insert_edge_batch(edges.data(), properties.data(), edges.size(), tracer);
+        }
+
+        auto timestamp = tm->get_write_timestamp();
+        tree->commit_version(timestamp);
+        tm->m_edge_count += edge_num;
+        tm->finish_commit(timestamp);
+        tree->gc(tracer, tm->get_read_timestamp());
+        // a request belongs to the stack of its waiter, which may leave as soon as it is done
+        for(auto request: requests) {
+            request->timestamp = timestamp;
+            request->done.store(true, std::memory_order_release);
+        }
+    }
+
     /// Note: the src. and dest. must been inserted transaction where the edge is inserted
     void LightWriteTransaction::insert_edge(uint64_t source, uint64_t destination, Property_t* property) {
         edges->emplace_back(source, destination);
@@ -475,17 +1166,19 @@ namespace container {
     bool LightWriteTransaction::commit(bool vertex_batch_update, bool edge_batch_update) {
         for(uint64_t idx = 0; idx < edges->size(); idx++) {
             auto edge = edges->at(idx);
-            auto tree = tm->index_impl->lock(edge.first >> VERTEX_GROUP_BITS);
+            auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(edge.first));
             if (!tree) {
                 std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                 return false;
             }
-            tree->insert_edge(edge.first, edge.second, nullptr, trace_block);
+            auto property = tm->edge_property(nullptr);
+            tree->insert_edge(edge.first, edge.second, property, trace_block);
             timestamp = tm->get_write_timestamp();
+            tm->wal_append(trace_block, timestamp, WAL_INSERT_EDGE, edge.first, edge.second, (uint64_t) property);
             tree->commit_version(timestamp);
             tm->m_edge_count += 1;
             tm->finish_commit(timestamp);
-            tree->gc(trace_block);
+            tree->gc(trace_block, tm->get_read_timestamp());
             tree->writer_lock.unlock();
         }
         if(edges_to_delete) {
@@ -494,17 +1187,18 @@ namespace container {
 //                    std::cout << "Deleting edge " << idx << "/ " << edges_to_delete->size() << std::endl;
 //                }
                 auto edge = edges_to_delete->at(idx);
-                auto tree = tm->index_impl->lock(edge.first >> VERTEX_GROUP_BITS);
+                auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(edge.first));
                 if (!tree) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return false;
                 }
                 tree->remove_edge(edge.first, edge.second, trace_block);
                 timestamp = tm->get_write_timestamp();
+                tm->wal_append(trace_block, timestamp, WAL_REMOVE_EDGE, edge.first, edge.second);
                 tree->commit_version(timestamp);
                 tm->m_edge_count -= 1;
                 tm->finish_commit(timestamp);
-                tree->gc(trace_block);
+                tree->gc(trace_block, tm->get_read_timestamp());
                 tree->writer_lock.unlock();
             }
         }
@@ -514,7 +1208,7 @@ namespace container {
 //                    std::cout << "Update edge " << idx << "/ " << edges_to_update->size() << std::endl;
 //                }
                 auto edge = edges_to_update->at(idx);
-                auto tree = tm->index_impl->lock(edge.e.first >> VERTEX_GROUP_BITS);
+                auto tree = tm->index_impl->lock(tm->index_impl->gen_tree_direction(edge.e.first));
                 if (!tree) {
                     std::cout << "Warning: LightWriteTransaction::commit(): No tree" << std::endl;
                     return false;
@@ -523,12 +1217,14 @@ namespace container {
                 tree->set_edge_property(edge.e.first, edge.e.second, 0, edge.weight, trace_block);
 #endif
                 timestamp = tm->get_write_timestamp();
+                tm->wal_append(trace_block, timestamp, WAL_UPDATE_EDGE, edge.e.first, edge.e.second, (Property_t) edge.weight);
                 tree->commit_version(timestamp);
                 tm->finish_commit(timestamp);
-                tree->gc(trace_block);
+                tree->gc(trace_block, tm->get_read_timestamp());
                 tree->writer_lock.unlock();
             }
         }
+        tm->wal_commit(trace_block);
         return true;
     }
 
@@ -12,10 +12,11 @@
 // Node256: 8 Byte * 256 -> pooling
 
 namespace container {
-    NeoTree::NeoTree(uint64_t prefix): version_head(nullptr), direct_gc_flag(true), version_num(0) {}
+    NeoTree::NeoTree(uint64_t prefix, const NeoLayout* layout): version_head(nullptr), direct_gc_flag(true), version_num(0), layout(layout) {}
 
     NeoTree::~NeoTree() {
-        NeoTreeVersion* version = version_head;
+        delete access_stats.load(std::memory_order_relaxed);
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
         if(version == nullptr) {
             return;
         }
@@ -38,6 +39,7 @@ namespace container {
         if(version == nullptr) {
             return false;
         }
+        note_access(version, src, NEO_ACCESS_LOOKUP);
         auto res = version->has_edge(src, dest);
         release_version(version);
         return res;
@@ -58,6 +60,7 @@ namespace container {
         if(version == nullptr) {
             return nullptr;
         }
+        note_access(version, vertex, NEO_ACCESS_SCAN);
         auto res = version->get_neighbor_addr(vertex);
         release_version(version);
         return res;
@@ -102,6 +105,7 @@ namespace container {
         if(version == nullptr) {
             throw std::runtime_error("version not found");
         }
+        note_access(version, src, NEO_ACCESS_LOOKUP);
         auto res = version->get_edge_property(src, dest, property_id);
         release_version(version);
         return res;
@@ -141,6 +145,8 @@ namespace container {
         if(version1 == nullptr || version2 == nullptr) {
             return;
         }
+        tree1->note_access(version1, src1, NEO_ACCESS_SCAN);
+        tree2->note_access(version2, src2, NEO_ACCESS_SCAN);
         NeoTreeVersion::intersect(version1, src1, version2, src2, result);
         if(tree1 == tree2) {
             NeoTree::release_version(version1);
@@ -163,6 +169,8 @@ namespace container {
         if(version1 == nullptr || version2 == nullptr) {
             return 0;
         }
+        tree1->note_access(version1, src1, NEO_ACCESS_SCAN);
+        tree2->note_access(version2, src2, NEO_ACCESS_SCAN);
         uint64_t res = NeoTreeVersion::intersect(version1, src1, version2, src2);
         if(tree1 == tree2) {
             NeoTree::release_version(version1);
@@ -175,22 +183,22 @@ namespace container {
 
     void NeoTree::insert_vertex(uint64_t vertex, Property_t* property, WriterTraceBlock* trace_block) {
         assert(!uncommited_version);
-        NeoTreeVersion* version = version_head;
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
         if(version) {
             version->ref_cnt += 1;
         }
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         new_version->insert_vertex(vertex, property);
         finish_version(new_version);
     }
 
     void NeoTree::insert_vertex_batch(const uint64_t* vertices, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block) {
         assert(!uncommited_version);
-        NeoTreeVersion* version = version_head;
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
         if(version) {
             version->ref_cnt += 1;
         }
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         new_version->insert_vertex_batch(vertices, properties, count);
         finish_version(new_version);
     }
@@ -198,14 +206,14 @@ namespace container {
 #if VERTEX_PROPERTY_NUM >= 1
     void NeoTree::set_vertex_property(uint64_t vertex, uint8_t property_id, Property_t property) {
         NeoTreeVersion* version = find_version(timestamp);
-        auto new_version = new NeoTreeVersion(version, timestamp);
+        auto new_version = new NeoTreeVersion(version, layout, timestamp);
         new_version->set_vertex_property(vertex, property_id, property);
         commit_version(new_version);
     }
 
     void NeoTree::set_vertex_string_property(uint64_t vertex, uint8_t property_id, std::string&& property) {
         NeoTreeVersion* version = find_version(timestamp);
-        auto new_version = new NeoTreeVersion(version, timestamp);
+        auto new_version = new NeoTreeVersion(version, layout, timestamp);
         new_version->set_vertex_string_property(vertex, property_id, std::move(property));
         commit_version(new_version);
     }
@@ -214,7 +222,7 @@ namespace container {
 #if VERTEX_PROPERTY_NUM > 1
     void NeoTree::set_vertex_properties(uint64_t vertex, std::vector<uint8_t>* property_ids, Property_t* properties) {
         NeoTreeVersion* version = find_version(timestamp);
-        auto new_version = new NeoTreeVersion(version, timestamp);
+        auto new_version = new NeoTreeVersion(version, layout, timestamp);
         new_version->set_vertex_properties(vertex, property_ids, properties);
         commit_version(new_version);
     }
@@ -225,11 +233,12 @@ namespace container {
 //        if(src != 2) return;
 #endif
         assert(!uncommited_version);
-        NeoTreeVersion* version = version_head;
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
         version->ref_cnt += 1;
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         assert(new_version->next);
         new_version->insert_edge(src, dest, property, trace_block);
+        note_access(new_version, src, NEO_ACCESS_WRITE);
         finish_version(new_version);
         assert(uncommited_version);
     }
@@ -237,10 +246,13 @@ namespace container {
 
     void NeoTree::insert_edge_batch(const std::pair<RangeElement, RangeElement> *edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block) {
         assert(!uncommited_version);
-        NeoTreeVersion* version = version_head;
-        version_head->ref_cnt += 1;
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
+        version->ref_cnt += 1;
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         new_version->insert_edge_batch(edges, properties, count, trace_block);
+        for(uint64_t i = 0; i < count; i++) {
+            note_access(new_version, edges[i].first, NEO_ACCESS_WRITE);
+        }
         finish_version(new_version);
         assert(uncommited_version);
     }
@@ -248,11 +260,12 @@ namespace container {
 #if EDGE_PROPERTY_NUM >= 1
     void NeoTree::set_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, Property_t property, WriterTraceBlock* trace_block) {
         assert(!uncommited_version);
-        NeoTreeVersion* version = version_head;
-        version_head->ref_cnt += 1;
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
+        version->ref_cnt += 1;
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         assert(new_version->next);
         new_version->set_edge_property(src, dest, 0, property, trace_block);
+        note_access(new_version, src, NEO_ACCESS_WRITE);
         finish_version(new_version);
         assert(uncommited_version);
     }
@@ -261,17 +274,17 @@ namespace container {
 #if EDGE_PROPERTY_NUM > 1
     void NeoTree::set_edge_properties(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, Property_t* properties) {
         NeoTreeVersion* version = find_version(timestamp);
-        auto new_version = new NeoTreeVersion(version, timestamp);
+        auto new_version = new NeoTreeVersion(version, layout, timestamp);
         new_version->set_edge_properties(src, dest, property_ids, properties);
         commit_version(new_version);
     }
 #endif
 
     bool NeoTree::remove_vertex(uint64_t vertex, bool is_directed, WriterTraceBlock* trace_block) {
-        NeoTreeVersion* version = version_head;
-        NeoVertex& vertex_entry = version->vertex_map->at(vertex);
-        version_head->ref_cnt += 1;
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
+        const NeoVertex& vertex_entry = version->vertex_map->at(vertex);
+        version->ref_cnt += 1;
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         new_version->remove_vertex(vertex, is_directed, trace_block);
         finish_version(new_version);
         return true;
@@ -282,27 +295,45 @@ namespace container {
 //        if(src != 2) return;
 #endif
         assert(!uncommited_version);
-        NeoTreeVersion* version = version_head;
-        version_head->ref_cnt += 1;
-        auto new_version = new NeoTreeVersion(version, trace_block);
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
+        version->ref_cnt += 1;
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
         assert(new_version->next);
         new_version->remove_edge(src, dest, trace_block);
+        note_access(new_version, src, NEO_ACCESS_WRITE);
         finish_version(new_version);
         assert(uncommited_version);
     }
 
+    uint64_t NeoTree::remove_edge_batch(const std::pair<RangeElement, RangeElement> *edges, uint64_t count, WriterTraceBlock* trace_block) {
+        assert(!uncommited_version);
+        NeoTreeVersion* version = version_head.load(std::memory_order_relaxed);
+        version->ref_cnt += 1;
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
+        auto removed = new_version->remove_edge_batch(edges, count, trace_block);
+        for(uint64_t i = 0; i < count; i++) {
+            note_access(new_version, edges[i].first, NEO_ACCESS_WRITE);
+        }
+        finish_version(new_version);
+        assert(uncommited_version);
+        return removed;
+    }
+
 
     NeoTreeVersion* NeoTree::find_version(uint64_t timestamp) const {
-        auto cur = version_head;
+        auto cur = version_head.load(std::memory_order_acquire);
         if(!(cur && cur->timestamp >= timestamp)) {
-            while(uncommited_version) {
-                // wait for writer's commit
+            auto pending = uncommited_version.load(std::memory_order_acquire);
+            if(pending != nullptr) {
+                // wait for writer's commit of this version only, later ones get a newer timestamp than ours
+                wait_for_commit(pending);
+                cur = version_head.load(std::memory_order_acquire);
             }
         }
         while(cur != nullptr) {
             if(timestamp >= cur->timestamp) {
                 // add reference
-                cur->ref_cnt = cur->ref_cnt + 1;
+                cur->ref_cnt.fetch_add(1, std::memory_order_acq_rel);
                 return cur;
             }
             cur = cur->next;
@@ -311,31 +342,40 @@ namespace container {
         return nullptr;
     }
 
+    void NeoTree::wait_for_commit(const NeoTreeVersion* pending) const {
+        // most commits are a single update, so back off exponentially before sleeping on the futex
+        uint32_t backoff = 1;
+        while(uncommited_version.load(std::memory_order_acquire) == pending) {
+            if(backoff <= SPIN_BACKOFF_LIMIT) {
+                for(uint32_t i = 0; i < backoff; i++) {
+                    _mm_pause();
+                }
+                backoff <<= 1;
+            } else {
+                uncommited_version.wait((NeoTreeVersion*) pending, std::memory_order_acquire);
+            }
+        }
+    }
+
     bool NeoTree::finish_version(NeoTreeVersion *version) {
-        uncommited_version = version;
+        uncommited_version.store(version, std::memory_order_relaxed);
         assert(uncommited_version);
         return true;
     }
 
     bool NeoTree::commit_version(uint64_t timestamp) {
-#ifndef NDEBUG
-        if(uncommited_version) {
-            uncommited_version->timestamp = timestamp;
-            version_head = uncommited_version;
-            uncommited_version = nullptr;
-        }
-#else
-        // set new version as head
-        if(uncommited_version) {
-            uncommited_version->timestamp = timestamp;
-            version_head = uncommited_version;
-            uncommited_version = nullptr;
+        // set new version as head, the head is published before the pending slot is cleared for wait_for_commit
+        auto version = uncommited_version.load(std::memory_order_relaxed);
+        if(version) {
+            version->timestamp = timestamp;
+            version_head.store(version, std::memory_order_release);
+            uncommited_version.store(nullptr, std::memory_order_release);
+            uncommited_version.notify_all();
         }
-#endif
         return true;
     }
 
-    void NeoTree::version_gc(NeoTreeVersion*& head, std::vector<uint64_t>& readers, WriterTraceBlock* trace_block) {
+    void NeoTree::version_gc(NeoTreeVersion* head, std::vector<uint64_t>& readers, WriterTraceBlock* trace_block) {
         NeoTreeVersion* curr_version = head;
         NeoTreeVersion* prev_version = nullptr;
         int curr_reader_idx = readers.size() - 1;
@@ -376,23 +416,36 @@ namespace container {
         }
     }
 
-    void NeoTree::gc(WriterTraceBlock* trace_block) {
-        uncommited_version = nullptr;
+    void NeoTree::gc(WriterTraceBlock* trace_block, uint64_t read_timestamp) {
+        if(!collect(trace_block, read_timestamp)) {
+            return;
+        }
+#if ADAPTIVE_LAYOUT_ENABLE
+        // the writer re-lays the tree out on its way out, its readers never wait for it
+        if(relayout_pending.load(std::memory_order_relaxed) && relayout(trace_block)) {
+            collect(trace_block, read_timestamp);
+        }
+#endif
+    }
+
+    bool NeoTree::collect(WriterTraceBlock* trace_block, uint64_t read_timestamp) {
+        uncommited_version.store(nullptr, std::memory_order_relaxed);
         version_num += 1;
         if(version_num > 2) {
             direct_gc_flag = false;
         }
-        auto version = version_head;
-        if(version_head->next == nullptr) {
+        auto version = version_head.load(std::memory_order_relaxed);
+        if(version->next == nullptr) {
             writer_lock.unlock();
-            return;
+            return false;
         }
         version->next->ref_cnt.fetch_and(~VERSION_HEAD_MASK);
         version->next->ref_cnt.fetch_sub(1);
         if(direct_gc_flag) {  // try direct gc
 //                auto next_timestamp = version_head->next->timestamp;
 //                auto head_timestamp = version_head->timestamp;
-            if (version_head->next->ref_cnt == 0 && !version_head->next->resource_handled && get_read_txn_num() == 0) {
+            // a reader arriving now may still start before the head while the timestamps before it are being finished
+            if (version->next->ref_cnt == 0 && !version->next->resource_handled && get_read_txn_num() == 0 && read_timestamp >= version->timestamp) {
 //                    if(*read_txn_count != 0) {
 //                        std::vector<uint64_t> actives;
 //                        get_active_reader_info(actives);
@@ -410,7 +463,7 @@ namespace container {
 
 #ifndef NDEBUG
                 // check the correctness of the version num
-                auto cur = version_head;
+                auto cur = version;
                 int cnt = 0;
                 while(cur != nullptr) {
                     cnt += 1;
@@ -418,21 +471,87 @@ namespace container {
                 }
                 assert(cnt == version_num);
 #endif
-                version_head->next->gc_copied(trace_block);
-                version_head->next->clean(trace_block);
-                delete version_head->next;
-                version_head->next = nullptr;
+                version->next->gc_copied(trace_block);
+                version->next->clean(trace_block);
+                delete version->next;
+                version->next = nullptr;
                 version_num -= 1;
 //                writer_lock.unlock();
-                return;
+                return true;
             }
         }
 
-        // acquire actives
+        // acquire actives, the readers at or after the head all keep nothing but the head
         std::vector<uint64_t> actives;
-        get_active_reader_info(actives);
-        version_gc(version_head, actives, trace_block);
+        get_active_reader_info(actives, version->timestamp);
+        if(read_timestamp < version->timestamp) {
+            auto pos = std::lower_bound(actives.begin(), actives.end(), read_timestamp);
+            if(pos == actives.end() || *pos != read_timestamp) {
+                actives.insert(pos, read_timestamp);
+            }
+        }
+        version_gc(version, actives, trace_block);
 //        writer_lock.unlock();
+        return true;
+    }
+
+    void NeoTree::record_access(const NeoTreeVersion* version, uint64_t vertex, NeoAccessKind kind) const {
+        auto stats = access_stats.load(std::memory_order_acquire);
+        if(stats == nullptr) {
+            auto fresh = new NeoAccessStats(layout->group_size());
+            if(access_stats.compare_exchange_strong(stats, fresh, std::memory_order_acq_rel)) {
+                stats = fresh;
+            } else {
+                delete fresh;
+            }
+        }
+        auto idx = vertex & layout->group_mask();
+        bool due = stats->record(idx, kind);
+        if(!due) {
+            auto entry = version->vertex_map->at(idx);
+            auto current = representation_of(entry);
+            auto target = adaptive_target(adaptive_thresholds(layout, stats->profile(idx)), current, entry.degree);
+            due = REPRESENTATION_DEMOTE_ENABLE ? target != current : target > current;
+        }
+        if(due && !relayout_pending.load(std::memory_order_relaxed)) {
+            relayout_pending.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool NeoTree::relayout(WriterTraceBlock* trace_block) {
+        relayout_pending.store(false, std::memory_order_relaxed);
+        auto stats = access_stats.load(std::memory_order_acquire);
+        auto version = version_head.load(std::memory_order_relaxed);
+        if(stats == nullptr || version == nullptr) {
+            return false;
+        }
+        // only writers read it, the versions built from the head on size their conversions to the profiles
+        version->access_stats = stats;
+
+        std::vector<std::pair<uint16_t, NeoRepresentation>> moves;
+        for(uint64_t idx = 0; idx < layout->group_size(); idx++) {
+            stats->classify(idx);
+            auto vertex = version->vertex_map->at(idx);
+            if(!vertex.exist || vertex.degree == 0) {
+                continue;
+            }
+            auto current = representation_of(vertex);
+            auto target = adaptive_target(adaptive_thresholds(layout, stats->profile(idx)), current, vertex.degree);
+            if(REPRESENTATION_DEMOTE_ENABLE ? target != current : target > current) {
+                moves.emplace_back(idx, target);
+            }
+        }
+        if(moves.empty()) {
+            return false;
+        }
+
+        version->ref_cnt += 1;
+        auto new_version = new NeoTreeVersion(version, layout, trace_block);
+        new_version->relayout(moves.data(), moves.size(), trace_block);
+        finish_version(new_version);
+        // the edges stay the same, so readers may take either version at the timestamp of the head
+        commit_version(version->timestamp);
+        return true;
     }
 }
 
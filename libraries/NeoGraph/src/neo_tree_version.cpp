@@ -2,25 +2,30 @@
 #include <set>
 #include "include/neo_tree_version.h"
 #include "utils/helper.h"
+#include "utils/work_stealing_pool.h"
+#include "utils/intersect/include/intersect.h"
 #include "include/neo_property.h"
 
 namespace container {
 #if FROM_CLUSTERED_TO_SMALL_VEC_ENABLE != 0
-    NeoTreeVersion::NeoTreeVersion(NeoTreeVersion* prev, WriterTraceBlock* trace_block): next(prev) {
+    NeoTreeVersion::NeoTreeVersion(NeoTreeVersion* prev, const NeoLayout* layout, WriterTraceBlock* trace_block): next(prev), layout(layout), access_stats(prev ? prev->access_stats : nullptr) {
         ref_cnt = VERSION_HEAD_MASK;
+        memory_count(MEMORY_VERSION, sizeof(NeoTreeVersion));
         this->vertex_map = trace_block->allocate_vertex_map();
         resources = new std::vector<GCResourceInfo>{};
         resources->reserve(2);
         this->node_block = new std::vector<NeoRangeNode>{NeoRangeNode{0, 0, 0, nullptr}};
-        this->node_block->resize(VERTEX_GROUP_SIZE);
+        this->node_block->resize(layout->group_size());
         if(next == nullptr || next->node_block->empty()) {
             if(next != nullptr) {
-                std::copy(next->vertex_map->begin(), next->vertex_map->end(), this->vertex_map->begin());
+                this->vertex_map->share(*next->vertex_map, trace_block);
 #if VERTEX_PROPERTY_NUM >= 1
                 this->vertex_property_map = next->vertex_property_map;  // directly copy the pointer
                 resources->emplace_back(GCResourceInfo{Multi_Vertex_Property_Vec_Mounted, next->vertex_property_map});
 #endif
                 this->independent_map = next->independent_map;
+            } else {
+                this->vertex_map->init(layout->vertex_group_bits, trace_block);
             }
             return;
         } else {
@@ -29,7 +34,7 @@ namespace container {
             if(!next->node_block->empty()) {
                 std::copy(next->node_block->begin(), next->node_block->end(), this->node_block->begin());
             }
-            std::copy(next->vertex_map->begin(), next->vertex_map->end(), this->vertex_map->begin());
+            this->vertex_map->share(*next->vertex_map, trace_block);
 #if VERTEX_PROPERTY_NUM >= 1
             this->vertex_property_map = next->vertex_property_map;  // directly copy the pointer
             resources->emplace_back(GCResourceInfo{Multi_Vertex_Property_Vec_Mounted, next->vertex_property_map});
@@ -38,20 +43,23 @@ namespace container {
         }
     }
 #else
-    NeoTreeVersion::NeoTreeVersion(NeoTreeVersion* prev, WriterTraceBlock* trace_block): next(prev) {
+    NeoTreeVersion::NeoTreeVersion(NeoTreeVersion* prev, const NeoLayout* layout, WriterTraceBlock* trace_block): next(prev), layout(layout), access_stats(prev ? prev->access_stats : nullptr) {
         ref_cnt = VERSION_HEAD_MASK;
+        memory_count(MEMORY_VERSION, sizeof(NeoTreeVersion));
         this->vertex_map = trace_block->allocate_vertex_map();
         resources = new std::vector<GCResourceInfo>{};
         resources->reserve(2);
         if(next == nullptr || next->node_block->empty()) {
             this->node_block = new std::vector<NeoRangeNode>{NeoRangeNode{0, 0, 0, nullptr}};
             if(next != nullptr) {
-                std::copy(next->vertex_map->begin(), next->vertex_map->end(), this->vertex_map->begin());
+                this->vertex_map->share(*next->vertex_map, trace_block);
 #if VERTEX_PROPERTY_NUM >= 1
                 this->vertex_property_map = next->vertex_property_map;  // directly copy the pointer
                 resources->emplace_back(GCResourceInfo{Multi_Vertex_Property_Vec_Mounted, next->vertex_property_map});
 #endif
                 this->independent_map = next->independent_map;
+            } else {
+                this->vertex_map->init(layout->vertex_group_bits, trace_block);
             }
             return;
         } else {
@@ -61,7 +69,7 @@ namespace container {
             if(!next->node_block->empty()) {
                 std::copy(next->node_block->begin(), next->node_block->end(), this->node_block->begin());
             }
-            std::copy(next->vertex_map->begin(), next->vertex_map->end(), this->vertex_map->begin());
+            this->vertex_map->share(*next->vertex_map, trace_block);
 #if VERTEX_PROPERTY_NUM >= 1
             this->vertex_property_map = next->vertex_property_map;  // directly copy the pointer
             resources->emplace_back(GCResourceInfo{Multi_Vertex_Property_Vec_Mounted, next->vertex_property_map});
@@ -72,20 +80,22 @@ namespace container {
 #endif
 
     void NeoTreeVersion::clean(WriterTraceBlock* trace_block) {
+        vertex_map->release(trace_block);
         trace_block->deallocate_vertex_map(vertex_map);
     }
 
     NeoTreeVersion::~NeoTreeVersion() {
+        memory_count(MEMORY_VERSION, -(int64_t) sizeof(NeoTreeVersion));
         delete node_block;
         delete resources;
     }
 
     bool NeoTreeVersion::has_vertex(uint64_t vertex) const {
-        return vertex_map->at(vertex & VERTEX_GROUP_MASK).exist;
+        return vertex_map->at(vertex & layout->group_mask()).exist;
     }
 
     bool NeoTreeVersion::has_edge(uint64_t src, uint64_t dest) const {
-        NeoVertex vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex vertex = vertex_map->at(src & layout->group_mask());
         uint64_t degree = vertex.degree;
         auto neighbor = (RangeElement*) vertex.neighborhood_ptr;
         if(degree == 0 || !neighbor) {
@@ -93,7 +103,7 @@ namespace container {
         }
 
         if(!vertex.is_independent) {
-            assert(!independent_map.get(src & VERTEX_GROUP_MASK));
+            assert(!independent_map.get(src & layout->group_mask()));
              return range_segment_find(neighbor + vertex.neighbor_offset, degree, dest) != RANGE_LEAF_SIZE;
         } else if (!vertex.is_art) {
             return ((RangeTree*) neighbor)->has_element(dest);
@@ -103,17 +113,20 @@ namespace container {
     }
 
     uint64_t NeoTreeVersion::get_degree(uint64_t vertex) const {
-        return vertex_map->at(vertex & VERTEX_GROUP_MASK).degree;
+        return vertex_map->at(vertex & layout->group_mask()).degree;
     }
 
     RangeElement *NeoTreeVersion::get_neighbor_addr(uint64_t vertex) const {
-        std::cout << "NeoTreeVersion::get_neighbor_addr(): no offset for Range now" << std::endl;
-        return (RangeElement*)vertex_map->at(vertex & VERTEX_GROUP_MASK).neighborhood_ptr;
+        return (RangeElement*) neighbors(vertex).contiguous().data();
+    }
+
+    NeighborRange NeoTreeVersion::neighbors(uint64_t src) const {
+        return NeighborRange(vertex_map->at(src & layout->group_mask()));
     }
 
 #if VERTEX_PROPERTY_NUM >= 1
     Property_t NeoTreeVersion::get_vertex_property(uint64_t vertex, uint8_t property_id) const {
-        return map_get_vertex_property((void*) vertex_property_map, vertex & VERTEX_GROUP_MASK, property_id);
+        return map_get_vertex_property((void*) vertex_property_map, vertex & layout->group_mask(), property_id);
     }
 #endif
 
@@ -127,7 +140,7 @@ namespace container {
 
 #if EDGE_PROPERTY_NUM != 0
     Property_t NeoTreeVersion::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const {
-        NeoVertex vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex vertex = vertex_map->at(src & layout->group_mask());
         uint64_t degree = vertex.degree;
         auto neighbor = (RangeElement*)vertex.neighborhood_ptr;
         if(degree == 0) {
@@ -141,7 +154,7 @@ namespace container {
                 if(inner_seg_idx == RANGE_LEAF_SIZE) {
                     return Property_t();
                 }
-                return map_get_range_property(node_block->at(vertex.range_node_idx).property, vertex.neighbor_offset, property_id);
+                return map_get_range_property(node_block->at(vertex.range_node_idx).property, vertex.neighbor_offset + inner_seg_idx, property_id);
             }
             case 1: {
                 return ((RangeTree*) neighbor)->get_property(dest, property_id);
@@ -167,13 +180,14 @@ namespace container {
     }
 
     void NeoTreeVersion::intersect(NeoTreeVersion* version1, uint64_t src1, NeoTreeVersion* version2, uint64_t src2, std::vector<uint64_t> &result) {
-        NeoVertex vertex1 = version1->vertex_map->at(src1 & VERTEX_GROUP_MASK);
-        NeoVertex vertex2 = version2->vertex_map->at(src2 & VERTEX_GROUP_MASK);
+        NeoVertex vertex1 = version1->vertex_map->at(src1 & version1->layout->group_mask());
+        NeoVertex vertex2 = version2->vertex_map->at(src2 & version2->layout->group_mask());
         uint8_t storage_type1 = vertex1.is_independent + vertex1.is_art;
         uint8_t storage_type2 = vertex2.is_independent + vertex2.is_art;
 
         if(storage_type1 < storage_type2) {
             std::swap(vertex1, vertex2);
+            std::swap(storage_type1, storage_type2);
         }
         if(vertex1.degree == 0 || vertex2.degree == 0) {
             return;
@@ -184,19 +198,7 @@ namespace container {
                 assert(storage_type2 == 0);
                 auto neighbor1 = (RangeElement*)vertex1.neighborhood_ptr + vertex1.neighbor_offset;
                 auto neighbor2 = (RangeElement*)vertex2.neighborhood_ptr + vertex2.neighbor_offset;
-                uint64_t idx1 = 0;
-                uint64_t idx2 = 0;
-                while(idx1 < vertex1.degree && idx2 < vertex2.degree) {
-                    if(neighbor1[idx1] == neighbor2[idx2]) {
-                        result.push_back(neighbor1[idx1]);
-                        idx1++;
-                        idx2++;
-                    } else if(neighbor1[idx1] < neighbor2[idx2]) {
-                        idx1++;
-                    } else {
-                        idx2++;
-                    }
-                }
+                sorted_intersect(neighbor1, vertex1.degree, neighbor2, vertex2.degree, result);
                 break;
             }
             case 1: {   // Inner range storage
@@ -237,8 +239,8 @@ namespace container {
 //        if(src1 == 92 && src2 == 934) {
 //            std::cout << "debug" << std::endl;
 //        }
-        NeoVertex vertex1 = version1->vertex_map->at(src1 & VERTEX_GROUP_MASK);
-        NeoVertex vertex2 = version2->vertex_map->at(src2 & VERTEX_GROUP_MASK);
+        NeoVertex vertex1 = version1->vertex_map->at(src1 & version1->layout->group_mask());
+        NeoVertex vertex2 = version2->vertex_map->at(src2 & version2->layout->group_mask());
         uint8_t storage_type1 = vertex1.is_independent + vertex1.is_art;
         uint8_t storage_type2 = vertex2.is_independent + vertex2.is_art;
 
@@ -256,19 +258,7 @@ namespace container {
                 assert(storage_type2 == 0);
                 auto neighbor1 = (RangeElement*)vertex1.neighborhood_ptr + vertex1.neighbor_offset;
                 auto neighbor2 = (RangeElement*)vertex2.neighborhood_ptr + vertex2.neighbor_offset;
-                uint64_t idx1 = 0;
-                uint64_t idx2 = 0;
-                while(idx1 < vertex1.degree && idx2 < vertex2.degree) {
-                    if(neighbor1[idx1] == neighbor2[idx2]) {
-                        res++;
-                        idx1++;
-                        idx2++;
-                    } else if(neighbor1[idx1] < neighbor2[idx2]) {
-                        idx1++;
-                    } else {
-                        idx2++;
-                    }
-                }
+                res = sorted_intersect(neighbor1, vertex1.degree, neighbor2, vertex2.degree);
                 break;
             }
             case 1: {   // Inner range storage
@@ -323,7 +313,7 @@ namespace container {
     std::vector<uint16_t>* NeoTreeVersion::get_vertices_in_node(uint16_t node_idx) {
         auto target = node_block->at(node_idx).arr_ptr;
         uint16_t start_vertex = node_block->at(node_idx).key;
-        uint16_t end_vertex = node_idx == node_block->size() - 1 ? VERTEX_GROUP_SIZE : node_block->at(node_idx + 1).key;
+        uint16_t end_vertex = node_idx == node_block->size() - 1 ? layout->group_size() : node_block->at(node_idx + 1).key;
 
         auto vertices = new std::vector<uint16_t>();
         vertices->reserve(end_vertex - start_vertex);
@@ -343,7 +333,7 @@ namespace container {
             return vertices;
         }
         uint16_t start_vertex = node_block->at(node_idx).key;
-        uint16_t end_vertex = node_idx == node_block->size() - 1 ? VERTEX_GROUP_SIZE : node_block->at(node_idx + 1).key;
+        uint16_t end_vertex = node_idx == node_block->size() - 1 ? layout->group_size() : node_block->at(node_idx + 1).key;
         vertices->reserve(end_vertex - start_vertex);
 
         for(int cur = start_vertex; cur < end_vertex; cur++) {
@@ -355,8 +345,8 @@ namespace container {
     }
 
     void NeoTreeVersion::insert_vertex(uint64_t vertex, Property_t* property) {
-        vertex_map->at(vertex & VERTEX_GROUP_MASK).exist = true;
-        assert(vertex_map->at(vertex & VERTEX_GROUP_MASK).degree == 0);
+        vertex_map->modify(vertex & layout->group_mask()).exist = true;
+        assert(vertex_map->at(vertex & layout->group_mask()).degree == 0);
 
 #if VERTEX_PROPERTY_NUM != 0
         void* new_vertex_prop_map = alloc_vertex_property_map_with_vec();
@@ -364,7 +354,7 @@ namespace container {
             vertex_property_map_copy(vertex_property_map, new_vertex_prop_map);
             this->next->resources->emplace_back(GCResourceInfo{Vertex_Property_Map_All_Modified, (void *) vertex_property_map});
         }
-        map_set_sa_vertex_property((void *) new_vertex_prop_map, vertex & VERTEX_GROUP_MASK, (void *) property);
+        map_set_sa_vertex_property((void *) new_vertex_prop_map, vertex & layout->group_mask(), (void *) property);
         force_pointer_set(&(this->vertex_property_map), new_vertex_prop_map);
 #endif
     }
@@ -372,8 +362,8 @@ namespace container {
     void NeoTreeVersion::insert_vertex_batch(const uint64_t* vertices, Property_t ** properties, uint64_t count) {
         if(properties == nullptr) {
             for (auto i = 0; i < count; i++) {
-                vertex_map->at(vertices[i] & VERTEX_GROUP_MASK).exist = true;
-                assert(vertex_map->at(vertices[i] & VERTEX_GROUP_MASK).degree == 0);
+                vertex_map->modify(vertices[i] & layout->group_mask()).exist = true;
+                assert(vertex_map->at(vertices[i] & layout->group_mask()).degree == 0);
             }
         } else {
 #if VERTEX_PROPERTY_NUM != 0
@@ -384,9 +374,9 @@ namespace container {
             for (auto i = 0; i < count; i++) {
                 auto vertex = vertices[i];
                 auto property = properties[i];
-                vertex_map->at(vertex & VERTEX_GROUP_MASK).exist = true;
-                assert(vertex_map->at(vertex & VERTEX_GROUP_MASK).degree == 0);
-                map_set_sa_vertex_property((void *) new_vertex_prop_map, vertex & VERTEX_GROUP_MASK, (void *) property);
+                vertex_map->at(vertex & layout->group_mask()).exist = true;
+                assert(vertex_map->at(vertex & layout->group_mask()).degree == 0);
+                map_set_sa_vertex_property((void *) new_vertex_prop_map, vertex & layout->group_mask(), (void *) property);
             }
             if(this->next) {
                 this->next->resources->emplace_back(GCResourceInfo{Vertex_Property_Map_All_Modified, (void *) vertex_property_map});
@@ -394,8 +384,8 @@ namespace container {
             force_pointer_set(&(this->vertex_property_map), new_vertex_prop_map);
 #else
             for (auto i = 0; i < count; i++) {
-                vertex_map->at(vertices[i] & VERTEX_GROUP_MASK).exist = true;
-                assert(vertex_map->at(vertices[i] & VERTEX_GROUP_MASK).degree == 0);
+                vertex_map->modify(vertices[i] & layout->group_mask()).exist = true;
+                assert(vertex_map->at(vertices[i] & layout->group_mask()).degree == 0);
             }
 #endif
         }
@@ -404,7 +394,7 @@ namespace container {
 #if VERTEX_PROPERTY_NUM != 0
     void NeoTreeVersion::set_vertex_property(uint64_t vertex, uint8_t property_id, Property_t property) {
         auto new_vertex_prop_map = alloc_vertex_property_map_mount(vertex_property_map);
-        map_set_vertex_property(new_vertex_prop_map, vertex & VERTEX_GROUP_MASK, property_id, (Property_t)property);
+        map_set_vertex_property(new_vertex_prop_map, vertex & layout->group_mask(), property_id, (Property_t)property);
 
 #if VERTEX_PROPERTY_NUM == 1
         this->next->resources->emplace_back(GCResourceInfo{Vertex_Property_Vec, (void*)vertex_property_map});
@@ -417,7 +407,7 @@ namespace container {
 
     void NeoTreeVersion::set_vertex_string_property(uint64_t vertex, uint8_t property_id, std::string&& property) {
         auto new_vertex_prop_map = alloc_vertex_property_map_mount(vertex_property_map);
-        map_set_vertex_string_property(new_vertex_prop_map, vertex & VERTEX_GROUP_MASK, property_id, std::move(property));
+        map_set_vertex_string_property(new_vertex_prop_map, vertex & layout->group_mask(), property_id, std::move(property));
 #if VERTEX_PROPERTY_NUM == 1
         this->next->resources->emplace_back(GCResourceInfo{Vertex_Property_Vec, (void*)vertex_property_map});
 #else
@@ -444,11 +434,11 @@ namespace container {
 
 #if FROM_CLUSTERED_TO_SMALL_VEC_ENABLE != 0
     void NeoTreeVersion::insert_edge(uint64_t src, uint64_t dest, Property_t* property, WriterTraceBlock* trace_block) {
-//        if((src & VERTEX_GROUP_MASK) != (6138 & VERTEX_GROUP_MASK)) return;
+//        if((src & layout->group_mask()) != (6138 & layout->group_mask())) return;
 #ifndef NDEBUG
         {
             int cur_node_idx = 0;
-            for (int i = 0; i < VERTEX_GROUP_SIZE; i++) {
+            for (int i = 0; i < layout->group_size(); i++) {
                 auto ver = vertex_map->at(i);
                 if(ver.degree == 0 || ver.is_independent) continue;
                 assert(cur_node_idx <= ver.range_node_idx);
@@ -465,12 +455,12 @@ namespace container {
 //        std::cout << src << " " << dest << std::endl;
 #endif
 
-        NeoVertex &vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex &vertex = vertex_map->modify(src & layout->group_mask());
         assert(vertex.exist);
         uint64_t degree = vertex.degree;
 
         if (!vertex.is_independent) {    // Use clustered range tree to store
-            NeoRangeNode &node = node_block->at(src & VERTEX_GROUP_MASK);
+            NeoRangeNode &node = node_block->at(src & layout->group_mask());
             uint64_t node_idx = &node - node_block->data();
             if ((RangeElementSegment_t *) node.arr_ptr == nullptr) {
                 // Create new array, don't need to update array m_size
@@ -489,7 +479,7 @@ namespace container {
 #endif
                 return;
             }
-            else if (degree == RANGE_LEAF_SIZE - 1) {
+            else if (degree == layout->range_leaf_size - 1) {
                 auto new_art = direct2art(src, degree, dest, property, node, trace_block);
                 if(new_art == nullptr) {
                     return;
@@ -501,7 +491,7 @@ namespace container {
                 vertex.is_art = true;
                 vertex.degree++;
                 vertex.range_node_idx = 0;
-                independent_map.set(src & VERTEX_GROUP_MASK);
+                independent_map.set(src & layout->group_mask());
             }
             else {
                 auto arr = (RangeElementSegment_t *) node.arr_ptr;
@@ -514,7 +504,7 @@ namespace container {
                 }
                 int pos_idx = std::distance(arr->value.begin(), pos);
 //                assert(pos_idx != 512);
-                auto new_arr = trace_block->allocate_range_element_segment();
+                auto new_arr = trace_block->allocate_range_element_segment(arr_size + 1);
 #if EDGE_PROPERTY_NUM != 0
                 auto new_property_map = trace_block->allocate_range_prop_vec();
                 range_segment_insert_copy(arr, node.property, arr_size, new_arr, new_property_map, pos_idx, dest, property);
@@ -542,7 +532,7 @@ namespace container {
 #endif
         }
         else if (!vertex.is_art) {    // Use independent range storage to store
-            if(degree == ART_EXTRACT_THRESHOLD - 1) {
+            if(degree == layout->art_extract_threshold - 1) {
                 this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex.neighborhood_ptr});
                 auto new_art = ((RangeTree*)vertex.neighborhood_ptr)->range_tree2art(src, degree, dest, property, *this->next->resources, trace_block);
                 if (new_art == nullptr) {    // already exists
@@ -561,7 +551,7 @@ namespace container {
                     this->next->resources->pop_back();
                     return;
                 }
-                
+
                 vertex.neighborhood_ptr = (uint64_t) new_range_tree;
                 vertex.degree++;
             }
@@ -586,11 +576,11 @@ namespace container {
     }
 #else
     void NeoTreeVersion::insert_edge(uint64_t src, uint64_t dest, Property_t* property, WriterTraceBlock* trace_block) {
-//        if((src & VERTEX_GROUP_MASK) != (6138 & VERTEX_GROUP_MASK)) return;
+//        if((src & layout->group_mask()) != (6138 & layout->group_mask())) return;
 #ifndef NDEBUG
         {
             int cur_node_idx = 0;
-            for (int i = 0; i < VERTEX_GROUP_SIZE; i++) {
+            for (int i = 0; i < layout->group_size(); i++) {
                 auto ver = vertex_map->at(i);
                 if(ver.degree == 0 || ver.is_independent) continue;
                 assert(cur_node_idx <= ver.range_node_idx);
@@ -606,12 +596,12 @@ namespace container {
 //            std::cout << "src: " << src << " dest: " << dest << std::endl;
 //        }
 
-        NeoVertex &vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex &vertex = vertex_map->modify(src & layout->group_mask());
         assert(vertex.exist);
         uint64_t degree = vertex.degree;
 
         if (!vertex.is_independent) {    // Use clustered range tree to store
-            NeoRangeNode &node = *find_range_node(src & VERTEX_GROUP_MASK);
+            NeoRangeNode &node = *find_range_node(src & layout->group_mask());
             uint64_t node_idx = &node - node_block->data();
             if ((RangeElementSegment_t *) node.arr_ptr == nullptr) {
                 // Create new array, don't need to update array m_size
@@ -626,6 +616,7 @@ namespace container {
                 vertex.degree++;
 #if EDGE_PROPERTY_NUM != 0
                 auto new_property_map = trace_block->allocate_range_prop_vec();
+                map_set_sa_range_property(new_property_map, 0, property);
                 force_pointer_set(&(node.property), new_property_map);
 #endif
 
@@ -648,12 +639,13 @@ namespace container {
 //                vertex.is_art = true;
 //                vertex.degree++;
 //                vertex.range_node_idx = 0;
-//                independent_map.set(src & VERTEX_GROUP_MASK);
+//                independent_map.set(src & layout->group_mask());
                 return;
             }
-            else if (degree == RANGE_LEAF_SIZE / 2 - 1) {
+            else if (degree + 1 >= thresholds_of(src).range_promote) {
                 auto new_range_tree = extract2range_tree(src, degree, dest, property, node, trace_block);
                 if(new_range_tree == nullptr) {
+                    replace_edge_property(src, dest, property, trace_block);
                     return;
                 }
                 vertex.neighborhood_ptr = (uint64_t) new_range_tree;
@@ -661,7 +653,7 @@ namespace container {
                 vertex.is_independent = true;
                 vertex.degree++;
                 vertex.range_node_idx = 0;
-                independent_map.set(src & VERTEX_GROUP_MASK);
+                independent_map.set(src & layout->group_mask());
 
             }
             else {
@@ -669,14 +661,15 @@ namespace container {
                 uint16_t arr_size = node.size + 1;
                 std::vector<uint16_t>* vertices = get_vertices_in_node(node_idx);
 
-                // Insert the target vertex
-                if (arr_size != RANGE_LEAF_SIZE) {
-                    int pos_idx = find_position_to_be_inserted(src, dest, vertex, arr, arr_size, vertices);   // global position index of the target edge
-                    if (pos_idx == -1) {    // exist
-                        delete vertices;
-                        return;
-                    }
-                    auto new_arr = trace_block->allocate_range_element_segment();
+                // Insert the target vertex, an existing edge is found before a full segment is split
+                int pos_idx = find_position_to_be_inserted(src, dest, vertex, arr, arr_size, vertices);   // global position index of the target edge
+                if (pos_idx == -1) {    // exist
+                    delete vertices;
+                    replace_edge_property(src, dest, property, trace_block);
+                    return;
+                }
+                if (arr_size != layout->range_leaf_size) {
+                    auto new_arr = trace_block->allocate_range_element_segment(arr_size + 1);
 #if EDGE_PROPERTY_NUM != 0
                     auto new_property_map = trace_block->allocate_range_prop_vec();
                     range_segment_insert_copy(arr, node.property, arr_size, new_arr, new_property_map, pos_idx, dest, property);
@@ -689,7 +682,7 @@ namespace container {
                     node.arr_ptr = (uint64_t) new_arr;
 
                     // vertex_map_update(new_arr->value.begin(), arr_size + 1, node_idx);
-                    vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & VERTEX_GROUP_MASK, 1);
+                    vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & layout->group_mask(), 1);
 
                     // vertex update
                     if(vertex.degree == 0) {
@@ -731,9 +724,9 @@ namespace container {
                     node_block->insert(node_block->begin() + node_idx + 1, new_node);
 
                     // move the following nodes back
-                    for(int i = vertices->at(vertices->size() - 1) + 1; i < VERTEX_GROUP_SIZE; i++) {
+                    for(int i = vertices->at(vertices->size() - 1) + 1; i < layout->group_size(); i++) {
                         if(vertex_map->at(i).degree > 0 && !vertex_map->at(i).is_independent) {
-                            vertex_map->at(i).range_node_idx++;
+                            vertex_map->modify(i).range_node_idx++;
                         }
                     }
 
@@ -752,7 +745,7 @@ namespace container {
 #ifndef NDEBUG
             {
                 int cur_node_idx = 0;
-                for (int i = 0; i < VERTEX_GROUP_SIZE; i++) {
+                for (int i = 0; i < layout->group_size(); i++) {
                     auto ver = vertex_map->at(i);
                     if(ver.degree == 0 || ver.is_independent) continue;
                     assert(cur_node_idx <= ver.range_node_idx);
@@ -769,11 +762,12 @@ namespace container {
 #endif
         }
         else if (!vertex.is_art) {    // Use independent range storage to store
-            if(degree == ART_EXTRACT_THRESHOLD - 1) {
+            if(degree + 1 >= thresholds_of(src).art_promote) {
                 this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex.neighborhood_ptr});
                 auto new_art = ((RangeTree*)vertex.neighborhood_ptr)->range_tree2art(src, degree, dest, property, *this->next->resources, trace_block);
                 if (new_art == nullptr) {    // already exists
                     this->next->resources->pop_back();
+                    replace_edge_property(src, dest, property, trace_block);
                     return;
                 }
                 vertex.neighborhood_ptr = (uint64_t) new_art;
@@ -786,6 +780,7 @@ namespace container {
                 if(!new_range_tree->insert(src, dest, property, *this->next->resources, trace_block)) {
                     delete new_range_tree;
                     this->next->resources->pop_back();
+                    replace_edge_property(src, dest, property, trace_block);
                     return;
                 }
 
@@ -808,13 +803,26 @@ namespace container {
                 vertex.degree++;
                 vertex.neighborhood_ptr = (uint64_t) res.art_ptr;
                 this->next->resources->emplace_back(GCResourceInfo{ART_Tree, (void*) vertex_art});
+            } else {
+                replace_edge_property(src, dest, property, trace_block);
             }
         }
     }
 #endif
 
+    void NeoTreeVersion::replace_edge_property(uint64_t src, uint64_t dest, Property_t* property, WriterTraceBlock* trace_block) {
+#if EDGE_PROPERTY_NUM == 1
+        if(get_edge_property(src, dest, 0) == (Property_t) property) {
+            return;
+        }
+        // the node block is still the one of the previous version, so the batch path can take over
+        std::pair<RangeElement, RangeElement> edge{src, dest};
+        insert_edge_batch(&edge, &property, 1, trace_block);
+#endif
+    }
+
     void NeoTreeVersion::second_insert_edge(uint64_t src, RangeElement target, NeoVertex& vertex, Property_t* property, WriterTraceBlock* trace_block) {
-        NeoRangeNode &node = *find_range_node(src & VERTEX_GROUP_MASK);
+        NeoRangeNode &node = *find_range_node(src & layout->group_mask());
         uint64_t node_idx = &node - node_block->data();
         std::vector<uint16_t>* vertices = get_vertices_in_node(node_idx);
 
@@ -843,7 +851,7 @@ namespace container {
 
         // vertex_map_update(arr->value.begin(), arr_size + 1, node_idx);
 
-        vertex_map_update_split(arr, vertices->data(), vertices->size(), node_idx, src & VERTEX_GROUP_MASK, 1);
+        vertex_map_update_split(arr, vertices->data(), vertices->size(), node_idx, src & layout->group_mask(), 1);
         delete vertices;
     }
 
@@ -867,7 +875,7 @@ namespace container {
         // Fine the insertion position
         if(vertex.degree == 0) {
             // First, try to find the target vertex in vertices in the node
-            auto vertex_pos = std::lower_bound(vertices->begin(), vertices->end(), src & VERTEX_GROUP_MASK);
+            auto vertex_pos = std::lower_bound(vertices->begin(), vertices->end(), src & layout->group_mask());
             // Second, if the target vertex is not in the node, just set the pos as the start of the next vertex
             if(vertex_pos == vertices->end()) { // no next vertex
                 res = arr_size;
@@ -891,7 +899,7 @@ namespace container {
         while(cur_idx < vertices->size() - 1) {
             cur_idx += 1;
             auto cur_ver = vertices->at(cur_idx);
-            if(vertex_map->at(cur_ver).neighbor_offset >= RANGE_LEAF_SIZE / 2) {
+            if(vertex_map->at(cur_ver).neighbor_offset >= layout->range_leaf_size / 2) {
                 break;
             }
         }
@@ -900,9 +908,9 @@ namespace container {
 
     void NeoTreeVersion::remove_node(NeoRangeNode& node, uint64_t node_idx, uint16_t nodes_move_begin_point) {
         // move the following nodes forward
-        for(int i = nodes_move_begin_point; i < VERTEX_GROUP_SIZE; i++) {
+        for(int i = nodes_move_begin_point; i < layout->group_size(); i++) {
             if(vertex_map->at(i).degree > 0 && !vertex_map->at(i).is_independent) {
-                vertex_map->at(i).range_node_idx--;
+                vertex_map->modify(i).range_node_idx--;
             }
         }
         if(node.key == 0) {
@@ -926,9 +934,9 @@ namespace container {
     void NeoTreeVersion::vertex_map_update(RangeElementSegment_t* segment, uint16_t* vertices, uint16_t vertex_num, uint16_t node_idx, int offset) {
         uint16_t* cur_vertex = vertices;
         for(int i = 0; i < vertex_num; i++, cur_vertex++) {
-            vertex_map->at(*cur_vertex).neighborhood_ptr = (uint64_t)(segment);
-            vertex_map->at(*cur_vertex).neighbor_offset += offset;
-            vertex_map->at(*cur_vertex).range_node_idx = node_idx;
+            vertex_map->modify(*cur_vertex).neighborhood_ptr = (uint64_t)(segment);
+            vertex_map->modify(*cur_vertex).neighbor_offset += offset;
+            vertex_map->modify(*cur_vertex).range_node_idx = node_idx;
         }
     }
 
@@ -936,9 +944,9 @@ namespace container {
         assert(node_idx < node_block->size());
         uint16_t* cur_vertex = vertices;
         for(int i = 0; i < vertex_num; i++, cur_vertex++) {
-            vertex_map->at(*cur_vertex).neighborhood_ptr = (uint64_t )segment;  // TODO NOTE this is safe because value is the first field of RangeElementSegment
-            vertex_map->at(*cur_vertex).neighbor_offset += *cur_vertex > last_vertex_unchanged ? offset : 0;
-            vertex_map->at(*cur_vertex).range_node_idx = node_idx;
+            vertex_map->modify(*cur_vertex).neighborhood_ptr = (uint64_t )segment;  // TODO NOTE this is safe because value is the first field of RangeElementSegment
+            vertex_map->modify(*cur_vertex).neighbor_offset += *cur_vertex > last_vertex_unchanged ? offset : 0;
+            vertex_map->modify(*cur_vertex).range_node_idx = node_idx;
         }
     }
 
@@ -946,10 +954,10 @@ namespace container {
     ///@brief Extract a neighbor from range system to RangeTree
     RangeTree* NeoTreeVersion::extract2range_tree(uint64_t src, uint64_t degree, uint64_t new_element, Property_t* new_property, NeoRangeNode& range_node, WriterTraceBlock* trace_block) {
         auto arr = (RangeElementSegment_t *) range_node.arr_ptr;
-        auto vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        auto vertex = vertex_map->at(src & layout->group_mask());
         uint64_t arr_size = range_node.size + 1;
         uint64_t node_idx = &range_node - node_block->data();
-        assert(node_idx == (src & VERTEX_GROUP_MASK));
+        assert(node_idx == (src & layout->group_mask()));
 
         // find the position to be inserted
 
@@ -972,7 +980,7 @@ namespace container {
     ///@brief Extract a neighbor from range system to RangeTree
     RangeTree* NeoTreeVersion::extract2range_tree(uint64_t src, uint64_t degree, uint64_t new_element, Property_t* new_property, NeoRangeNode& range_node, WriterTraceBlock* trace_block) {
         auto arr = (RangeElementSegment_t *) range_node.arr_ptr;
-        auto vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        auto vertex = vertex_map->at(src & layout->group_mask());
         uint64_t arr_size = range_node.size + 1;
         uint64_t node_idx = &range_node - node_block->data();
 
@@ -988,7 +996,7 @@ namespace container {
 #ifndef NDEBUG
         {
             int cur_node_idx = 0;
-            for (int i = 0; i < VERTEX_GROUP_SIZE; i++) {
+            for (int i = 0; i < layout->group_size(); i++) {
                 auto ver = vertex_map->at(i);
                 if(ver.degree == 0 || ver.is_independent) continue;
                 assert(cur_node_idx <= ver.range_node_idx);
@@ -1006,17 +1014,18 @@ namespace container {
 
         // clean old array
         if(arr_size > degree) {
-            auto new_arr = trace_block->allocate_range_element_segment();
+            auto new_arr = trace_block->allocate_range_element_segment(arr_size - degree);
             range_node.arr_ptr = (uint64_t) new_arr;
             range_node.size = arr_size - degree - 1;
 
             std::copy(arr->value.begin(), neighbor_begin, new_arr->value.begin());
             std::copy(neighbor_begin + degree, arr->value.begin() + arr_size, new_arr->value.begin() + vertex.neighbor_offset);
 #if EDGE_PROPERTY_NUM != 0
-            if(prop_arr) {
+            if(range_node.property) {
+                // prop_arr points into the values, the copies take the map itself
                 auto new_prop_arr = trace_block->allocate_range_prop_vec();
-                range_property_map_copy(prop_arr, 0, vertex.neighbor_offset, new_prop_arr, 0);
-                range_property_map_copy(prop_arr, vertex.neighbor_offset + degree, arr_size, new_prop_arr,
+                range_property_map_copy(range_node.property, 0, vertex.neighbor_offset, new_prop_arr, 0);
+                range_property_map_copy(range_node.property, vertex.neighbor_offset + degree, arr_size, new_prop_arr,
                                         vertex.neighbor_offset);
                 range_node.property = new_prop_arr;
             }
@@ -1024,9 +1033,9 @@ namespace container {
 
             // vertex_map_update(new_arr->value.begin(), arr_size - degree, &range_node - node_block->data());
             // extracted vertex will be modified outside
-            vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & VERTEX_GROUP_MASK, -(int)vertex.degree);
+            vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & layout->group_mask(), -(int)vertex.degree);
             if(range_node.key != 0 && vertex.neighbor_offset == 0) {
-                assert(vertices->at(0) == (src & VERTEX_GROUP_MASK) && vertices->size() > 1);
+                assert(vertices->at(0) == (src & layout->group_mask()) && vertices->size() > 1);
                 range_node.key = vertices->at(1);
             }
         } else {
@@ -1035,9 +1044,9 @@ namespace container {
 #ifndef NDEBUG
         {
             int cur_node_idx = 0;
-            for (int i = 0; i < VERTEX_GROUP_SIZE; i++) {
+            for (int i = 0; i < layout->group_size(); i++) {
                 auto ver = vertex_map->at(i);
-                if(ver.degree == 0 || ver.is_independent || i == (src & VERTEX_GROUP_MASK)) continue;
+                if(ver.degree == 0 || ver.is_independent || i == (src & layout->group_mask())) continue;
                 assert(cur_node_idx <= ver.range_node_idx);
                 cur_node_idx = ver.range_node_idx;
                 assert(ver.range_node_idx < node_block->size());
@@ -1052,7 +1061,7 @@ namespace container {
 #if FROM_CLUSTERED_TO_SMALL_VEC_ENABLE != 0
     ART* NeoTreeVersion::direct2art(uint64_t src, uint64_t degree, uint64_t new_element, Property_t* new_property, NeoRangeNode& range_node, WriterTraceBlock* trace_block) {
         auto arr = (RangeElementSegment_t *) range_node.arr_ptr;
-        auto vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        auto vertex = vertex_map->at(src & layout->group_mask());
         uint64_t arr_size = range_node.size + 1;
 
 #if EDGE_PROPERTY_NUM != 0
@@ -1086,7 +1095,7 @@ namespace container {
 #endif
 
         ART* new_art = new ART();
-        delete new_art->root;
+        delete (ARTNode_4*) new_art->root;
         // build art
         assert(extract_list.size() == degree + 1);
 #if EDGE_PROPERTY_NUM != 0
@@ -1100,7 +1109,7 @@ namespace container {
 
     ART* NeoTreeVersion::direct2art(uint64_t src, uint64_t degree, uint64_t new_element, Property_t* new_property, NeoRangeNode& range_node, WriterTraceBlock* trace_block) {
         auto arr = (RangeElementSegment_t *) range_node.arr_ptr;
-        auto vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        auto vertex = vertex_map->at(src & layout->group_mask());
         uint64_t arr_size = range_node.size + 1;
         uint64_t node_idx = &range_node - node_block->data();
 
@@ -1116,7 +1125,7 @@ namespace container {
 #ifndef NDEBUG
         {
             int cur_node_idx = 0;
-            for (int i = 0; i < VERTEX_GROUP_SIZE; i++) {
+            for (int i = 0; i < layout->group_size(); i++) {
                 auto ver = vertex_map->at(i);
                 if(ver.degree == 0 || ver.is_independent) continue;
                 assert(cur_node_idx <= ver.range_node_idx);
@@ -1133,7 +1142,7 @@ namespace container {
 #endif
 
         ART* new_art = new ART();
-        delete new_art->root;
+        delete (ARTNode_4*) new_art->root;
 
         std::vector<RangeElement> extract_list;
         extract_list.reserve(degree + 1);
@@ -1176,17 +1185,18 @@ namespace container {
 
         // clean old array
         if(arr_size > degree) {
-            auto new_arr = trace_block->allocate_range_element_segment();
+            auto new_arr = trace_block->allocate_range_element_segment(arr_size - degree);
             range_node.arr_ptr = (uint64_t) new_arr;
             range_node.size = arr_size - degree - 1;
 
             std::copy(arr->value.begin(), neighbor_begin, new_arr->value.begin());
             std::copy(neighbor_begin + degree, arr->value.begin() + arr_size, new_arr->value.begin() + vertex.neighbor_offset);
 #if EDGE_PROPERTY_NUM != 0
-            if(prop_arr) {
+            if(range_node.property) {
+                // prop_arr points into the values, the copies take the map itself
                 auto new_prop_arr = trace_block->allocate_range_prop_vec();
-                range_property_map_copy(prop_arr, 0, vertex.neighbor_offset, new_prop_arr, 0);
-                range_property_map_copy(prop_arr, vertex.neighbor_offset + degree, arr_size, new_prop_arr,
+                range_property_map_copy(range_node.property, 0, vertex.neighbor_offset, new_prop_arr, 0);
+                range_property_map_copy(range_node.property, vertex.neighbor_offset + degree, arr_size, new_prop_arr,
                                         vertex.neighbor_offset);
                 range_node.property = new_prop_arr;
             }
@@ -1194,9 +1204,9 @@ namespace container {
 
             // vertex_map_update(new_arr->value.begin(), arr_size - degree, &range_node - node_block->data());
             // extracted vertex will be modified outside
-            vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & VERTEX_GROUP_MASK, -(int)vertex.degree);
+            vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & layout->group_mask(), -(int)vertex.degree);
             if(range_node.key != 0 && vertex.neighbor_offset == 0) {
-                assert(vertices->at(0) == (src & VERTEX_GROUP_MASK) && vertices->size() > 1);
+                assert(vertices->at(0) == (src & layout->group_mask()) && vertices->size() > 1);
                 range_node.key = vertices->at(1);
             }
         } else {
@@ -1214,12 +1224,28 @@ namespace container {
             return;
         }
 #endif
-        NeoVertex& vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex& vertex = vertex_map->modify(src & layout->group_mask());
         assert(vertex.exist);
 
+#if REPRESENTATION_DEMOTE_ENABLE
+        if(vertex.is_independent && vertex.degree > 0) {
+            // a vertex falling below its demote degree is rebuilt without the edge instead of copying its tree
+            auto current = representation_of(vertex);
+            auto target = adaptive_target(thresholds_of(src), current, vertex.degree - 1);
+            if(target < current) {
+                bool found = vertex.is_art ? ((ART*) vertex.neighborhood_ptr)->has_element(dest) : ((RangeTree*) vertex.neighborhood_ptr)->has_element(dest);
+                if(found) {
+                    std::pair<RangeElement, RangeElement> removed{src, dest};
+                    rebuild(src & layout->group_mask(), target, &removed, 1, trace_block);
+                }
+                return;
+            }
+        }
+#endif
+
         switch(vertex.is_independent + vertex.is_art) {
             case 0: {   // Outer Range
-                NeoRangeNode &node = *find_range_node(src & VERTEX_GROUP_MASK);
+                NeoRangeNode &node = *find_range_node(src & layout->group_mask());
                 uint64_t node_idx = &node - node_block->data();
 
                 if ((RangeElementSegment_t *) node.arr_ptr == nullptr) {
@@ -1250,10 +1276,10 @@ namespace container {
                         node.arr_ptr = (uint64_t) new_arr;
 
                         // vertex update
-                        vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & VERTEX_GROUP_MASK, -1);
+                        vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, src & layout->group_mask(), -1);
                         delete vertices;
                     } else {
-                        remove_node(node, node_idx, (src & VERTEX_GROUP_MASK) + 1);
+                        remove_node(node, node_idx, (src & layout->group_mask()) + 1);
                     }
                     vertex.degree -= 1;
                     if (vertex.degree == 0) {
@@ -1309,9 +1335,146 @@ namespace container {
     }
 
 
+    uint64_t NeoTreeVersion::remove_edge_batch(const std::pair<RangeElement, RangeElement>* edges, uint64_t count, WriterTraceBlock* trace_block) {
+        // runs of edges with one source, split by the storage of the source
+        std::vector<std::pair<uint64_t, uint64_t>> clustered_runs;
+        std::vector<std::pair<uint64_t, uint64_t>> independent_runs;
+        uint64_t st = 0;
+        while(st != count) {
+            auto ed = st;
+            while(ed != count && edges[ed].first == edges[st].first) {
+                ed++;
+            }
+            auto entry = vertex_map->at(edges[st].first & layout->group_mask());
+            if(entry.exist && entry.degree != 0) {
+                (entry.is_independent ? independent_runs : clustered_runs).emplace_back(st, ed);
+            }
+            st = ed;
+        }
+
+        uint64_t removed = 0;
+        // from the last node on, a node that empties only shifts the nodes behind it
+        uint64_t run_ed = clustered_runs.size();
+        while(run_ed != 0) {
+            auto node_idx = vertex_map->at(edges[clustered_runs[run_ed - 1].first].first & layout->group_mask()).range_node_idx;
+            auto run_st = run_ed - 1;
+            while(run_st != 0 && vertex_map->at(edges[clustered_runs[run_st - 1].first].first & layout->group_mask()).range_node_idx == node_idx) {
+                run_st--;
+            }
+            removed += remove_from_node(node_idx, clustered_runs.data() + run_st, run_ed - run_st, edges, trace_block);
+            run_ed = run_st;
+        }
+
+        for(auto [run_st, ed]: independent_runs) {
+            auto vertex = (uint16_t) (edges[run_st].first & layout->group_mask());
+            auto entry = vertex_map->at(vertex);
+            uint64_t found = 0;
+            for(auto i = run_st; i < ed; i++) {
+                found += entry.is_art ? ((ART*) entry.neighborhood_ptr)->has_element(edges[i].second) : ((RangeTree*) entry.neighborhood_ptr)->has_element(edges[i].second);
+            }
+            if(found == 0) {
+                continue;
+            }
+            auto current = representation_of(entry);
+#if REPRESENTATION_DEMOTE_ENABLE
+            auto target = std::min(current, adaptive_target(thresholds_of(vertex), current, entry.degree - found));
+#else
+            auto target = current;
+#endif
+            rebuild(vertex, target, edges + run_st, ed - run_st, trace_block);
+            removed += found;
+        }
+        return removed;
+    }
+
+    uint64_t NeoTreeVersion::remove_from_node(uint64_t node_idx, const std::pair<uint64_t, uint64_t>* runs, uint64_t run_num, const std::pair<RangeElement, RangeElement>* edges, WriterTraceBlock* trace_block) {
+        NeoRangeNode old_node = node_block->at(node_idx);
+        auto arr = (RangeElementSegment_t*) old_node.arr_ptr;
+        uint64_t arr_size = old_node.size + 1;
+        std::vector<uint16_t>* vertices = get_vertices_in_node(node_idx);
+        // the kept elements are not known up front, the segment is zeroed as a whole
+        auto new_arr = trace_block->allocate_range_element_segment();
+#if EDGE_PROPERTY_NUM != 0
+        auto new_property_map = old_node.property ? trace_block->allocate_range_prop_vec() : nullptr;
+#endif
+
+        // the vertices of the node follow each other in the segment, so do the runs
+        uint64_t size = 0;
+        uint64_t run = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> placed;  // new offset and degree of each vertex
+        placed.reserve(vertices->size());
+        for(auto cur: *vertices) {
+            auto entry = vertex_map->at(cur);
+            const std::pair<RangeElement, RangeElement>* removal = nullptr;
+            const std::pair<RangeElement, RangeElement>* removal_end = nullptr;
+            if(run != run_num && (edges[runs[run].first].first & layout->group_mask()) == cur) {
+                removal = edges + runs[run].first;
+                removal_end = edges + runs[run].second;
+                run++;
+            }
+            uint64_t offset = size;
+            for(uint64_t i = entry.neighbor_offset; i < entry.neighbor_offset + entry.degree; i++) {
+                auto element = arr->value.at(i);
+                while(removal != removal_end && removal->second < element) {
+                    removal++;
+                }
+                if(removal != removal_end && removal->second == element) {
+                    continue;
+                }
+                new_arr->value.at(size) = element;
+#if EDGE_PROPERTY_NUM != 0
+                if(new_property_map) {
+                    range_property_map_copy(old_node.property, i, i + 1, new_property_map, size);
+                }
+#endif
+                size++;
+            }
+            placed.emplace_back(offset, size - offset);
+        }
+        assert(run == run_num);
+
+        if(size == arr_size) {
+            trace_block->deallocate_range_element_segment(new_arr);
+#if EDGE_PROPERTY_NUM != 0
+            if(new_property_map) {
+                trace_block->deallocate_range_prop_vec(new_property_map);
+            }
+#endif
+            delete vertices;
+            return 0;
+        }
+        for(uint64_t i = 0; i < vertices->size(); i++) {
+            auto &entry = vertex_map->modify(vertices->at(i));
+            auto [offset, degree] = placed[i];
+            entry.degree = degree;
+            entry.neighborhood_ptr = degree != 0 ? (uint64_t) new_arr : 0;
+            entry.neighbor_offset = degree != 0 ? offset : 0;
+            entry.range_node_idx = degree != 0 ? node_idx : 0;
+        }
+        if(size != 0) {
+            auto &node = node_block->at(node_idx);
+            node.arr_ptr = (uint64_t) new_arr;
+            node.size = size - 1;
+#if EDGE_PROPERTY_NUM != 0
+            node.property = new_property_map;
+#endif
+        } else {
+            trace_block->deallocate_range_element_segment(new_arr);
+#if EDGE_PROPERTY_NUM != 0
+            if(new_property_map) {
+                trace_block->deallocate_range_prop_vec(new_property_map);
+            }
+#endif
+            remove_node(node_block->at(node_idx), node_idx, vertices->back() + 1);
+        }
+        delete vertices;
+        retire_segment(old_node, trace_block);
+        return arr_size - size;
+    }
+
     void NeoTreeVersion::remove_vertex(uint64_t vertex, bool is_directed, WriterTraceBlock* trace_block) {
         // remove reverse edges
-        NeoVertex& vertex_entry = vertex_map->at(vertex);
+        NeoVertex& vertex_entry = vertex_map->modify(vertex);
         if(!is_directed) {
             edges(vertex, [&] (uint64_t dest, double weight) {
                 remove_edge(dest, vertex, trace_block);
@@ -1354,7 +1517,7 @@ namespace container {
 
 #if EDGE_PROPERTY_NUM != 0
     void NeoTreeVersion::set_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, Property_t property, WriterTraceBlock* trace_block) {
-        NeoVertex &vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex &vertex = vertex_map->modify(src & layout->group_mask());
         uint64_t degree = vertex.degree;
         auto neighbor = (RangeElement*)vertex.neighborhood_ptr;
         if(degree == 0) {
@@ -1419,14 +1582,14 @@ namespace container {
 #if EDGE_PROPERTY_NUM > 1
     void NeoTreeVersion::set_edge_properties(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, Property_t* properties) {
         assert(false);
-        NeoVertex vertex = vertex_map->at(src & VERTEX_GROUP_MASK);
+        NeoVertex vertex = vertex_map->at(src & layout->group_mask());
         uint64_t degree = vertex.degree;
         auto neighbor = (RangeElement*)vertex.neighbor_ptr;
         if(degree == 0) {
             return;
         }
 
-        if(degree < RANGE_LEAF_SIZE / 2) {
+        if(degree < layout->range_leaf_size / 2) {
             auto inner_seg_idx = range_segment_find(neighbor, degree, RangeElement{src, dest});
             if(inner_seg_idx == RANGE_LEAF_SIZE) {
                 return;
@@ -1452,7 +1615,7 @@ namespace container {
                     break;
                 }
                 case Inner_Segment: {
-                    trace_block->deallocate_range_element_segment((RangeElementSegment_t*)res.ptr);
+                    trace_block->deallocate_range_tree_segment((RangeElementSegment_t*)res.ptr);
                     break;
                 }
                 case Range_Tree_Copied: {
@@ -1462,7 +1625,7 @@ namespace container {
                 case Range_Tree_Upgraded: {
                     for(int i = 0; i < ((RangeTree*)res.ptr)->node_block.size(); i++) {
                         auto node = ((RangeTree*)res.ptr)->node_block.at(i);
-                        trace_block->deallocate_range_element_segment((RangeElementSegment_t*)node.arr_ptr);
+                        trace_block->deallocate_range_tree_segment((RangeElementSegment_t*)node.arr_ptr);
 #if EDGE_PROPERTY_NUM != 0
                         trace_block->deallocate_range_prop_vec(node.property_map);
 #endif
@@ -1477,6 +1640,12 @@ namespace container {
                     delete (ART *) res.ptr;
                     break;
                 }
+                case ART_Tree_Downgraded: {
+                    auto art = (ART*)res.ptr;
+                    art->gc_ref(trace_block);
+                    delete art;
+                    break;
+                }
 #if VERTEX_PROPERTY_NUM != 0
                 case Vertex_Property_Vec: {
                     deallocate_vertex_property_vec((VertexPropertyVec_t*)res.ptr);
@@ -1584,6 +1753,10 @@ namespace container {
                     ((ART *) res.ptr)->ref_cnt -= 1;
                     break;
                 }
+                case ART_Tree_Downgraded: {
+                    ((ART *) res.ptr)->ref_cnt -= 1;
+                    break;
+                }
 #if VERTEX_PROPERTY_NUM != 0
                 case Vertex_Property_Vec: {
                     ((VertexPropertyVec_t*)res.ptr)->ref_cnt -= 1;
@@ -1665,7 +1838,7 @@ namespace container {
                     for(int i = 0; i < range_tree->node_block.size(); i++) {
                         auto arr = (RangeElementSegment_t*)range_tree->node_block.at(i).arr_ptr;
                         if(arr->ref_cnt.fetch_sub(1, std::memory_order_release) == 1) {
-                            trace_block->deallocate_range_element_segment((RangeElementSegment_t*)arr);
+                            trace_block->deallocate_range_tree_segment((RangeElementSegment_t*)arr);
 #if EDGE_PROPERTY_NUM != 0
                             trace_block->deallocate_range_prop_vec(range_tree->node_block.at(i).property_map);
 #endif
@@ -1683,34 +1856,31 @@ namespace container {
         destroy_vertex_property_map(vertex_property_map);
 #endif
 
-        for(auto & it : *vertex_map) {
+        for(uint64_t i = 0; i < layout->group_size(); i++) {
+            auto &it = vertex_map->at(i);
             if(it.is_independent) {
                 if(!it.is_art) {
                     auto tree = (RangeTree*)it.neighborhood_ptr;
                     for(int i = 0; i < tree->node_block.size(); i++) {
-                        delete ((RangeElementSegment_t*)tree->node_block.at(i).arr_ptr);
+                        release_range_tree_segment((RangeElementSegment_t*)tree->node_block.at(i).arr_ptr);
 #if EDGE_PROPERTY_NUM != 0
-                        delete (tree->node_block.at(i).property_map);
+                        release_range_prop_vec(tree->node_block.at(i).property_map);
 #endif
                     }
                     delete (RangeTree*)it.neighborhood_ptr;
-                    it.neighborhood_ptr = 0;
-                    it.range_node_idx = 0;
                 } else {
                     ((ART*)it.neighborhood_ptr)->destroy();
                     delete ((ART*)it.neighborhood_ptr);
-                    it.neighborhood_ptr = 0;
-                    it.range_node_idx = 0;
                 }
             }
         }
 
         // delete block
         for(auto & node : *node_block) {
-            delete ((RangeElementSegment_t*)node.arr_ptr);
+            release_range_element_segment((RangeElementSegment_t*)node.arr_ptr);
             node.arr_ptr = 0;
 #if EDGE_PROPERTY_NUM != 0
-            delete (node.property);
+            release_range_prop_vec(node.property);
             node.property = nullptr;
 #endif
         }
@@ -1720,12 +1890,40 @@ namespace container {
 
         delete node_block;
         node_block = nullptr;
-        delete vertex_map;
+        vertex_map->release(nullptr);
+        release_vertex_map(vertex_map);
         vertex_map = nullptr;
     }
 
+    void NeoTreeVersion::insert_to_independent(uint16_t vertex, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, std::vector<GCResourceInfo> &resources, WriterTraceBlock* trace_block) {
+        if(!vertex_map->at(vertex).is_art) {
+            auto vertex_range_tree = (RangeTree *) vertex_map->at(vertex).neighborhood_ptr;
+            if (vertex_map->at(vertex).degree + count >= thresholds_of(vertex).art_promote) {
+                resources.emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
+                RangeTreeInsertElemBatchRes res = vertex_range_tree->range_tree2art_batch(vertex, vertex_map->at(vertex).degree,
+                                                                                          edges, properties, count,
+                                                                                          resources, trace_block);
+                vertex_map->modify(vertex).is_art = true;
+                vertex_map->modify(vertex).neighborhood_ptr = (uint64_t) res.tree_ptr;
+                vertex_map->modify(vertex).degree += res.new_inserted;
+            } else {
+                resources.emplace_back(GCResourceInfo{Range_Tree_Copied, (void*) vertex_range_tree});
+                RangeTreeInsertElemBatchRes res = vertex_range_tree->insert_element_batch(vertex, edges, properties, count,
+                                                                                          resources, trace_block);
+                vertex_map->modify(vertex).neighborhood_ptr = (uint64_t) res.tree_ptr;
+                vertex_map->modify(vertex).degree += res.new_inserted;
+            }
+        } else {
+            auto vertex_art = (ART *) vertex_map->at(vertex).neighborhood_ptr;
+            resources.emplace_back(GCResourceInfo{ART_Tree, (void*) vertex_art});
+            ARTInsertElemBatchRes res = vertex_art->insert_element_batch(edges, properties, count, trace_block);
+            vertex_map->modify(vertex).neighborhood_ptr = (uint64_t) res.art_ptr;
+            vertex_map->modify(vertex).degree += res.new_inserted;
+        }
+    }
+
     // TODO need to fix GC
-    void NeoTreeVersion::append_new_list(uint64_t cur_node_num, std::vector<NeoRangeNode> &new_nodes, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block) {
+    void NeoTreeVersion::append_new_list(uint64_t cur_node_num, std::vector<NeoRangeNode> &new_nodes, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, std::vector<GCResourceInfo> &resources, WriterTraceBlock* trace_block) {
         uint64_t new_edge_st = 0;
         uint64_t new_edge_ed = 0;
 
@@ -1734,7 +1932,7 @@ namespace container {
 #if EDGE_PROPERTY_NUM > 0
         auto new_prop_segment = trace_block->allocate_range_prop_vec();
 #endif
-        uint16_t cur_least_vertex = edges[0].first & VERTEX_GROUP_MASK;
+        uint16_t cur_least_vertex = edges[0].first & layout->group_mask();
 
         auto move_to_next_node = [&]() {
             assert(new_segment_size != 0);
@@ -1748,17 +1946,17 @@ namespace container {
         };
 
         while(new_edge_ed < count) {
-            uint8_t cur_vertex = edges[new_edge_st].first & VERTEX_GROUP_MASK;
-            auto &vertex = vertex_map->at(cur_vertex);
+            uint8_t cur_vertex = edges[new_edge_st].first & layout->group_mask();
+            auto &vertex = vertex_map->modify(cur_vertex);
             vertex.exist = true;
-            while (new_edge_ed < count && (edges[new_edge_ed].first & VERTEX_GROUP_MASK) == cur_vertex) {
+            while (new_edge_ed < count && (edges[new_edge_ed].first & layout->group_mask()) == cur_vertex) {
                 new_edge_ed++;
             }
 
             // check if the new edges are needed to be inserted into an independent tree
             if (vertex.is_art) {    // To ART
                 auto vertex_art = (ART *) vertex.neighborhood_ptr;
-                this->next->resources->emplace_back(GCResourceInfo{ART_Tree, (void*) vertex_art});
+                resources.emplace_back(GCResourceInfo{ART_Tree, (void*) vertex_art});
                 ARTInsertElemBatchRes res = vertex_art->insert_element_batch(edges + new_edge_st,
                                                                              properties + new_edge_st,
                                                                              new_edge_ed - new_edge_st, trace_block);
@@ -1768,23 +1966,23 @@ namespace container {
 
                 new_edge_st = new_edge_ed;
                 continue;
-            } else if (vertex.degree >= RANGE_LEAF_SIZE / 2) {  // To RangeTree
+            } else if (vertex.is_independent) {  // To RangeTree
                 auto vertex_range_tree = (RangeTree *) vertex.neighborhood_ptr;
 
                 RangeTreeInsertElemBatchRes res{};
-                if (vertex.degree + new_edge_ed - new_edge_st >= ART_EXTRACT_THRESHOLD) {
-                    this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
+                if (vertex.degree + new_edge_ed - new_edge_st >= thresholds_of(cur_vertex).art_promote) {
+                    resources.emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
                     res = vertex_range_tree->range_tree2art_batch(cur_vertex, vertex.degree, edges + new_edge_st,
                                                                   properties + new_edge_st,
                                                                   new_edge_ed - new_edge_st,
-                                                                  *this->next->resources, trace_block);
+                                                                  resources, trace_block);
                     vertex.is_art = true;
                 } else {
-                    this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Copied, (void*) vertex_range_tree});
+                    resources.emplace_back(GCResourceInfo{Range_Tree_Copied, (void*) vertex_range_tree});
                     res = vertex_range_tree->insert_element_batch(cur_vertex, edges + new_edge_st,
                                                                   properties + new_edge_st,
                                                                   new_edge_ed - new_edge_st,
-                                                                  *this->next->resources, trace_block);
+                                                                  resources, trace_block);
                 }
                 vertex.is_independent = true;
                 vertex.neighborhood_ptr = (uint64_t) res.tree_ptr;
@@ -1796,7 +1994,7 @@ namespace container {
 
 
             // check if there is need to extract to an independent tree
-            if (new_edge_ed - new_edge_st >= RANGE_LEAF_SIZE / 2) {
+            if (new_edge_ed - new_edge_st >= thresholds_of(cur_vertex).range_promote) {
                 // Extract to an independent tree
                 std::vector<RangeElement> new_edges;
                 new_edges.reserve(new_edge_ed - new_edge_st);
@@ -1813,9 +2011,9 @@ namespace container {
                 }
 
                 void *new_tree = nullptr;
-                if (new_edges.size() >= ART_EXTRACT_THRESHOLD) {    // To ART
+                if (new_edges.size() >= thresholds_of(cur_vertex).art_promote) {    // To ART
                     new_tree = new ART();
-                    delete ((ART*)new_tree)->root;
+                    delete (ARTNode_4*) ((ART*)new_tree)->root;
 #if EDGE_PROPERTY_NUM > 0
                     batch_subtree_build<false>(&((ART *) new_tree)->root, 0, new_edges.data(), new_props.data(), new_edges.size(), trace_block);
 #else
@@ -1834,15 +2032,14 @@ namespace container {
                 vertex.degree = new_edges.size();
                 vertex.neighbor_offset = 0;
                 vertex.range_node_idx = 0;
-                independent_map.set(cur_vertex);
 
                 continue;
             }
 
             // insert the new edges into the current segment
-            if (new_edge_ed - new_edge_st + new_segment_size >= RANGE_LEAF_SIZE) {
+            if (new_edge_ed - new_edge_st + new_segment_size >= layout->range_leaf_size) {
                 move_to_next_node();
-                cur_least_vertex = edges[new_edge_st].first & VERTEX_GROUP_MASK;
+                cur_least_vertex = edges[new_edge_st].first & layout->group_mask();
             }
 
             vertex.neighborhood_ptr = (uint64_t) new_segment;
@@ -1869,7 +2066,7 @@ namespace container {
     // TODO handle the degree
     // TODO handle the vertices
     // TODO GC
-    void NeoTreeVersion::node_insert_edge_batch(uint16_t node_idx, std::vector<NeoRangeNode> &new_nodes, uint64_t cur_node_num, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block) {
+    void NeoTreeVersion::node_insert_edge_batch(uint16_t node_idx, std::vector<NeoRangeNode> &new_nodes, uint64_t cur_node_num, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, std::vector<GCResourceInfo> &resources, WriterTraceBlock* trace_block) {
 //        if(((*edges).first >> VERTEX_GROUP_BITS) != (482 >> VERTEX_GROUP_BITS)) {
 //            return;
 //        }
@@ -1878,7 +2075,6 @@ namespace container {
             std::cout << "debug" << std::endl;
         }
 #endif
-        std::vector< std::future<bool> > results;
         auto node = node_block->at(node_idx);
         auto old_segment = (RangeElementSegment_t*)node.arr_ptr;
         uint64_t old_edge_st = 0;
@@ -1915,7 +2111,7 @@ namespace container {
             while(split_vtx_idx < cur_vertices->size() - 1) {
                 split_vtx_idx += 1;
                 auto cur_ver = cur_vertices->at(split_vtx_idx);
-                if(cur_ver.second >= RANGE_LEAF_SIZE / 2) {
+                if(cur_ver.second >= layout->range_leaf_size / 2) {
                     break;
                 }
             }
@@ -1924,7 +2120,7 @@ namespace container {
             uint64_t split_idx = split_vertex.second;
             // bind vertices
             for(uint16_t i = 0; i < split_vtx_idx; i++) {
-                auto& vtx = vertex_map->at(cur_vertices->at(i).first);
+                auto& vtx = vertex_map->modify(cur_vertices->at(i).first);
                 vtx.neighborhood_ptr = (uint64_t) new_segment;
                 vtx.neighbor_offset = cur_vertices->at(i).second;
                 vtx.range_node_idx = cur_node_num + new_nodes.size();
@@ -1944,43 +2140,10 @@ namespace container {
             new_prop_segment = next_prop_segment;
         };
 
-        auto insert_to_independent = [&] (uint8_t vertex, uint64_t count) {
-            if(!vertex_map->at(vertex).is_art) {
-                auto vertex_range_tree = (RangeTree *) vertex_map->at(vertex).neighborhood_ptr;
-                if (vertex_map->at(vertex).degree + new_edge_ed - new_edge_st >= ART_EXTRACT_THRESHOLD) {
-                    this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
-                    RangeTreeInsertElemBatchRes res = vertex_range_tree->range_tree2art_batch(vertex, vertex_map->at(vertex).degree,
-                                                                  edges + new_edge_st,
-                                                                  properties + new_edge_st,
-                                                                  new_edge_ed - new_edge_st,
-                                                                  *this->next->resources, trace_block);
-                    vertex_map->at(vertex).is_art = true;
-                    vertex_map->at(vertex).neighborhood_ptr = (uint64_t) res.tree_ptr;
-                    vertex_map->at(vertex).degree += res.new_inserted;
-                } else {
-                    this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Copied, (void*) vertex_range_tree});
-                    RangeTreeInsertElemBatchRes res = vertex_range_tree->insert_element_batch(vertex, edges + new_edge_st,
-                                                                                              properties + new_edge_st,
-                                                                                              new_edge_ed - new_edge_st,
-                                                                                              *this->next->resources, trace_block);
-                    vertex_map->at(vertex).neighborhood_ptr = (uint64_t) res.tree_ptr;
-                    vertex_map->at(vertex).degree += res.new_inserted;
-                }
-            } else {
-                auto vertex_art = (ART *) vertex_map->at(vertex).neighborhood_ptr;
-                this->next->resources->emplace_back(GCResourceInfo{ART_Tree, (void*) vertex_art});
-                ARTInsertElemBatchRes res = vertex_art->insert_element_batch(edges + new_edge_st,
-                                                                     properties + new_edge_st,
-                                                                     new_edge_ed - new_edge_st, trace_block);
-                vertex_map->at(vertex).neighborhood_ptr = (uint64_t) res.art_ptr;
-                vertex_map->at(vertex).degree += res.new_inserted;
-            }
-        };
-
 //        auto insert_to_independent = [&] (uint8_t vertex, uint64_t count) {
 //            if(!vertex_map->at(vertex).is_art) {
 //                auto vertex_range_tree = (RangeTree *) vertex_map->at(vertex).neighborhood_ptr;
-//                if (vertex_map->at(vertex).degree + new_edge_ed - new_edge_st >= ART_EXTRACT_THRESHOLD) {
+//                if (vertex_map->at(vertex).degree + new_edge_ed - new_edge_st >= layout->art_extract_threshold) {
 //                    this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
 ////                    results.emplace_back(
 ////                        pool->enqueue([new_edge_st, new_edge_ed, edges, properties, this, vertex_range_tree, vertex](uint64_t thread_id) {
@@ -2026,13 +2189,13 @@ namespace container {
 //        };
 
         while(new_edge_ed < count && old_edge_ed < old_edge_count) {
-            uint16_t new_vertex = edges[new_edge_st].first & VERTEX_GROUP_MASK;
+            uint16_t new_vertex = edges[new_edge_st].first & layout->group_mask();
             uint16_t old_vertex = vertices->at(vertex_idx).first;
 
             if(new_vertex > old_vertex) {
                 old_edge_ed += vertex_map->at(old_vertex).degree;
                 assert(old_edge_ed <= old_edge_count);
-                if(new_segment_size + old_edge_ed - old_edge_st >= RANGE_LEAF_SIZE) {
+                if(new_segment_size + old_edge_ed - old_edge_st >= layout->range_leaf_size) {
                     move_to_next_node();
                 }
                 std::copy(old_segment->value.begin() + old_edge_st, old_segment->value.begin() + old_edge_ed, new_segment->value.begin() + new_segment_size);
@@ -2043,13 +2206,39 @@ namespace container {
                 vertex_idx++;
                 continue;
             } else if(new_vertex < old_vertex) {
-                while (new_edge_ed < count && (edges[new_edge_ed].first & VERTEX_GROUP_MASK) == new_vertex) {
+                while (new_edge_ed < count && (edges[new_edge_ed].first & layout->group_mask()) == new_vertex) {
                     new_edge_ed++;
                 }
                 if(!vertex_map->at(new_vertex).is_independent) {
-                    vertex_map->at(new_vertex).exist = true;
-                    vertex_map->at(new_vertex).degree = new_edge_ed - new_edge_st;
-                    if (new_segment_size + new_edge_ed - new_edge_st >= RANGE_LEAF_SIZE) {
+                    vertex_map->modify(new_vertex).exist = true;
+                    vertex_map->modify(new_vertex).degree = new_edge_ed - new_edge_st;
+                    // a new vertex with more edges than a segment split can make room for goes to its own tree
+                    if (new_edge_ed - new_edge_st >= thresholds_of(new_vertex).range_promote) {
+                        auto &vertex = vertex_map->modify(new_vertex);
+                        std::vector<RangeElement> new_edges;
+                        new_edges.reserve(new_edge_ed - new_edge_st);
+                        for(auto i = new_edge_st; i < new_edge_ed; i++) {
+                            new_edges.push_back(edges[i].second);
+                        }
+
+                        void *new_tree = nullptr;
+                        if (new_edges.size() >= thresholds_of(new_vertex).art_promote) {    // To ART
+                            new_tree = new ART();
+                            delete (ARTNode_4*) ((ART*)new_tree)->root;
+                            batch_subtree_build<true>(&((ART *) new_tree)->root, 0, new_edges.data(), properties + new_edge_st, new_edges.size(), trace_block);
+                            vertex.is_art = true;
+                        } else {    // To RangeTree
+                            new_tree = new RangeTree(new_edges, properties + new_edge_st, new_edges.size(), trace_block);
+                        }
+                        vertex.is_independent = true;
+                        vertex.neighborhood_ptr = (uint64_t) new_tree;
+                        vertex.degree = new_edges.size();
+                        vertex.range_node_idx = 0;
+                        vertex.neighbor_offset = 0;
+                        new_edge_st = new_edge_ed;
+                        continue;
+                    }
+                    if (new_segment_size + new_edge_ed - new_edge_st >= layout->range_leaf_size) {
                         move_to_next_node();
                     }
                     cur_vertices->emplace_back(new_vertex, new_segment_size);
@@ -2060,14 +2249,14 @@ namespace container {
                         new_edge_st++;
                     }
                 } else {
-                    insert_to_independent(new_vertex, new_edge_ed - new_edge_st);
+                    insert_to_independent(new_vertex, edges + new_edge_st, properties + new_edge_st, new_edge_ed - new_edge_st, resources, trace_block);
                     new_edge_st = new_edge_ed;
                 }
                 continue;
             } else {
                 uint16_t cur_vertex = new_vertex;
-                auto &vertex = vertex_map->at(cur_vertex);
-                while (new_edge_ed < count && (edges[new_edge_ed].first & VERTEX_GROUP_MASK) == cur_vertex) {
+                auto &vertex = vertex_map->modify(cur_vertex);
+                while (new_edge_ed < count && (edges[new_edge_ed].first & layout->group_mask()) == cur_vertex) {
                     new_edge_ed++;
                 }
                 uint64_t vertex_new_edge_count = new_edge_ed - new_edge_st;
@@ -2078,7 +2267,7 @@ namespace container {
                 uint64_t total_count = vertex.degree + vertex_new_edge_count;
 
                 // check if there is need to extract to an independent tree
-                if (total_count >= RANGE_LEAF_SIZE / 2) {
+                if (total_count >= thresholds_of(cur_vertex).range_promote) {
                     // Extract to an independent tree
                     std::vector<RangeElement> new_edges;
                     new_edges.reserve(total_count);
@@ -2118,9 +2307,9 @@ namespace container {
                         new_edge_st++;
                     }
 
-                    if (new_edges.size() >= ART_EXTRACT_THRESHOLD) {    // To ART
+                    if (new_edges.size() >= thresholds_of(cur_vertex).art_promote) {    // To ART
                         new_tree = new ART();
-                        delete ((ART*)new_tree)->root;
+                        delete (ARTNode_4*) ((ART*)new_tree)->root;
                         batch_subtree_build(&((ART *) new_tree)->root, 0, new_edges.data(), new_edge_properties.data(), new_edges.size(), trace_block);
                         vertex.is_art = true;
                     } else {    // To RangeTree
@@ -2132,14 +2321,13 @@ namespace container {
                     vertex.range_node_idx = 0;
                     vertex.neighbor_offset = 0;
                     vertex.degree = new_edges.size();
-                    independent_map.set(cur_vertex);
 
                     // update pointers
                     old_edge_st = old_edge_ed;
 
                     continue;
                 }
-                if (total_count + new_segment_size >= RANGE_LEAF_SIZE) {
+                if (total_count + new_segment_size >= layout->range_leaf_size) {
                     move_to_next_node();
                 }
 
@@ -2177,47 +2365,46 @@ namespace container {
         // Handle the remaining edges
         while (new_edge_ed < count) {
             assert(new_edge_st == new_edge_ed);
-            uint8_t cur_vertex = edges[new_edge_st].first & VERTEX_GROUP_MASK;
-            auto &vertex = vertex_map->at(cur_vertex);
+            uint8_t cur_vertex = edges[new_edge_st].first & layout->group_mask();
+            auto &vertex = vertex_map->modify(cur_vertex);
             vertex.exist = true;
-            while (new_edge_ed < count && (edges[new_edge_ed].first & VERTEX_GROUP_MASK) == cur_vertex) {
+            while (new_edge_ed < count && (edges[new_edge_ed].first & layout->group_mask()) == cur_vertex) {
                 new_edge_ed++;
             }
 
             // check if the new edges are needed to be inserted into an independent tree
             if(vertex.is_independent) {
-                insert_to_independent(cur_vertex, new_edge_ed - new_edge_st);
+                insert_to_independent(cur_vertex, edges + new_edge_st, properties + new_edge_st, new_edge_ed - new_edge_st, resources, trace_block);
                 new_edge_st = new_edge_ed;
                 continue;
             }
-            if (new_edge_ed - new_edge_st >= RANGE_LEAF_SIZE / 2) {
+            if (new_edge_ed - new_edge_st >= thresholds_of(cur_vertex).range_promote) {
                 // Extract to an independent tree
                 std::vector<RangeElement> new_edges;
                 new_edges.reserve(new_edge_ed - new_edge_st);
-                while(new_edge_st < new_edge_ed) {
-                    new_edges.push_back(edges[new_edge_st].second);
-                    new_edge_st++;
+                for(auto i = new_edge_st; i < new_edge_ed; i++) {
+                    new_edges.push_back(edges[i].second);
                 }
 
                 void *new_tree = nullptr;
-                if (new_edges.size() >= ART_EXTRACT_THRESHOLD) {    // To ART
+                if (new_edges.size() >= thresholds_of(cur_vertex).art_promote) {    // To ART
                     new_tree = new ART();
-                    delete ((ART*)new_tree)->root;
+                    delete (ARTNode_4*) ((ART*)new_tree)->root;
                     batch_subtree_build<true>(&((ART *) new_tree)->root, 0, new_edges.data(), properties + new_edge_st, new_edges.size(), trace_block);
                     vertex.is_art = true;
                 } else {    // To RangeTree
                     new_tree = new RangeTree(new_edges, properties + new_edge_st, new_edges.size(), trace_block);
                 }
+                new_edge_st = new_edge_ed;
                 vertex.is_independent = true;
                 vertex.neighborhood_ptr = (uint64_t) new_tree;
                 vertex.degree = new_edges.size();
                 vertex.range_node_idx = 0;
                 vertex.neighbor_offset = 0;
-                independent_map.set(cur_vertex);
 
                 continue;
             }
-            if (new_edge_ed - new_edge_st + new_segment_size >= RANGE_LEAF_SIZE) {
+            if (new_edge_ed - new_edge_st + new_segment_size >= layout->range_leaf_size) {
                 move_to_next_node();
             }
 
@@ -2234,7 +2421,7 @@ namespace container {
             vertex_idx++;
             old_edge_ed += vertex_map->at(cur_vertex).degree;
             assert(old_edge_ed <= old_edge_count);
-            if (new_segment_size + old_edge_ed - old_edge_st >= RANGE_LEAF_SIZE) {
+            if (new_segment_size + old_edge_ed - old_edge_st >= layout->range_leaf_size) {
                 move_to_next_node();
             }
 
@@ -2250,7 +2437,7 @@ namespace container {
         if (new_segment_size != 0) {
             // bind vertices
             for(uint16_t i = 0; i < cur_vertices->size(); i++) {
-                auto& vtx = vertex_map->at(cur_vertices->at(i).first);
+                auto& vtx = vertex_map->modify(cur_vertices->at(i).first);
                 vtx.neighborhood_ptr = (uint64_t) new_segment;
                 vtx.neighbor_offset = cur_vertices->at(i).second;
                 vtx.range_node_idx = cur_node_num + new_nodes.size();
@@ -2261,9 +2448,6 @@ namespace container {
             trace_block->deallocate_range_prop_vec(new_prop_segment);
         }
 
-        for(auto && result: results) {
-            result.get();
-        }
 #ifndef NDEBUG
         if(!cur_vertices->empty()) {
             for(int i = 0; i < cur_vertices->size() - 1; i++) {
@@ -2280,6 +2464,10 @@ namespace container {
         if(count == 0 || edges == nullptr) {
             throw std::runtime_error("NeoTreeVersion::insert_edge_batch(): Invalid input");
         }
+        if(count >= BATCH_UPDATE_GRAIN) {
+            insert_edge_batch_parallel(edges, properties, count);
+            return;
+        }
         auto new_node_block = new std::vector<NeoRangeNode>{};
         new_node_block->reserve(node_block->size());
 
@@ -2288,26 +2476,43 @@ namespace container {
         int64_t list_ed = 0;
         auto new_nodes = new std::vector<NeoRangeNode>{};
 
+        // an untouched node moves behind the split ones, its vertices have to follow it
+        auto keep_node = [&](int64_t node_idx) {
+            auto next_key = node_idx != node_block->size() - 1 ? node_block->at(node_idx + 1).key : layout->group_size();
+            if(new_node_block->size() != node_idx) {
+                for(uint64_t i = node_block->at(node_idx).key; i < next_key; i++) {
+                    auto &vertex = vertex_map->at(i);
+                    if(vertex.degree > 0 && !vertex.is_independent) {
+                        vertex_map->modify(i).range_node_idx = new_node_block->size();
+                    }
+                }
+            }
+            new_node_block->push_back(node_block->at(node_idx));
+        };
+
         while(list_ed < count && old_node_idx < node_block->size()) {
             auto next_key = old_node_idx != node_block->size() - 1 ? node_block->at(old_node_idx + 1).key : std::numeric_limits<uint64_t>::max();
-            if((edges[list_ed].first & VERTEX_GROUP_MASK) >= next_key) {
-                new_node_block->push_back(node_block->at(old_node_idx));
+            if((edges[list_ed].first & layout->group_mask()) >= next_key) {
+                keep_node(old_node_idx);
                 old_node_idx += 1;
                 continue;
             }
 
-            this->next->resources->emplace_back(GCResourceInfo{Outer_Segment, (void*) next->node_block->at(old_node_idx).arr_ptr});
+            // a node without any edge has no segment yet
+            if(next->node_block->at(old_node_idx).arr_ptr) {
+                this->next->resources->emplace_back(GCResourceInfo{Outer_Segment, (void*) next->node_block->at(old_node_idx).arr_ptr});
+            }
 //            std::cout << "collect:" << ((void*) next->node_block->at(old_node_idx).arr_ptr) << std::endl;
             if(next->node_block->at(old_node_idx).property) {
                 this->next->resources->emplace_back(GCResourceInfo{Range_Property_Map_All_Modified,
                                                                    (void *) next->node_block->at(
                                                                            old_node_idx).property});
             }
-            while (list_ed < count && (edges[list_ed].first & VERTEX_GROUP_MASK) < next_key) {
+            while (list_ed < count && (edges[list_ed].first & layout->group_mask()) < next_key) {
                 list_ed += 1;
             }
 
-            node_insert_edge_batch(old_node_idx, *new_nodes, new_node_block->size(), edges + list_st, properties + list_st, list_ed - list_st, trace_block);
+            node_insert_edge_batch(old_node_idx, *new_nodes, new_node_block->size(), edges + list_st, properties + list_st, list_ed - list_st, *this->next->resources, trace_block);
 
             // insert new nodes in reverse order
             for(auto & new_node : *new_nodes) {
@@ -2322,15 +2527,16 @@ namespace container {
 
         // Handle the remaining edges
         if (list_ed < count) {
-            append_new_list(new_node_block->size(), *new_nodes, edges, properties, list_ed + 1, trace_block);
+            append_new_list(new_node_block->size(), *new_nodes, edges, properties, list_ed + 1, *this->next->resources, trace_block);
             for(auto & new_node : *new_nodes) {
                 new_node_block->push_back(new_node);
             }
         }
         while(old_node_idx < node_block->size()) {
-            new_node_block->push_back(node_block->at(old_node_idx));
+            keep_node(old_node_idx);
             old_node_idx += 1;
         }
+        mark_independent_vertices(edges, count);
 
         // apply the new node block
         delete node_block;
@@ -2342,4 +2548,479 @@ namespace container {
         node_block = new_node_block;
     }
 
+    void NeoTreeVersion::insert_edge_batch_parallel(const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count) {
+        // copy every shared chunk now, afterwards modify() never writes the map itself and the tasks may call it
+        for(uint64_t i = 0; i < vertex_map->size(); i += VERTEX_MAP_CHUNK_SIZE) {
+            vertex_map->modify(i);
+        }
+        auto slice = [](Property_t ** props, uint64_t offset) {
+            return props != nullptr ? props + offset : nullptr;
+        };
+
+        // split off the vertices that already live in a tree of their own
+        std::vector<std::pair<uint64_t, uint64_t>> independent;
+        std::vector<std::pair<RangeElement, RangeElement>> clustered_edges;
+        std::vector<Property_t*> clustered_properties;
+        clustered_edges.reserve(count);
+        for(uint64_t st = 0; st != count;) {
+            auto vertex = edges[st].first & layout->group_mask();
+            auto ed = st;
+            while(ed != count && (edges[ed].first & layout->group_mask()) == vertex) {
+                ed++;
+            }
+            if(vertex_map->at(vertex).is_independent) {
+                independent.emplace_back(st, ed);
+            } else {
+                clustered_edges.insert(clustered_edges.end(), edges + st, edges + ed);
+                if(properties != nullptr) {
+                    clustered_properties.insert(clustered_properties.end(), properties + st, properties + ed);
+                }
+            }
+            st = ed;
+        }
+        auto clustered_props = properties != nullptr ? clustered_properties.data() : nullptr;
+
+        // the neighborhoods of the touched nodes are read while merging, so the independent trees go first
+        std::vector<std::vector<GCResourceInfo>> independent_resources(independent.size());
+        batch_update_pool().parallel_for(0, independent.size(), 1, [&](uint64_t begin, uint64_t end, size_t) {
+            auto tracer = batch_trace_block();
+            for(auto i = begin; i < end; i++) {
+                auto [st, ed] = independent[i];
+                insert_to_independent(edges[st].first & layout->group_mask(), edges + st, slice(properties, st), ed - st,
+                                      independent_resources[i], tracer);
+            }
+        });
+
+        // plan the nodes: an untouched one is kept, a touched one is merged with its slice of clustered_edges
+        struct Merge {
+            int64_t node_idx;
+            uint64_t st;
+            uint64_t ed;
+        };
+        std::vector<Merge> merges;
+        std::vector<int64_t> slots;  // the node index if kept, ~merge index otherwise
+        slots.reserve(node_block->size());
+        uint64_t list_st = 0;
+        for(int64_t old_node_idx = 0; old_node_idx < node_block->size(); old_node_idx++) {
+            auto next_key = old_node_idx != node_block->size() - 1 ? node_block->at(old_node_idx + 1).key : std::numeric_limits<uint64_t>::max();
+            auto list_ed = list_st;
+            while(list_ed < clustered_edges.size() && (clustered_edges[list_ed].first & layout->group_mask()) < next_key) {
+                list_ed++;
+            }
+            if(list_ed == list_st) {
+                slots.push_back(old_node_idx);
+                continue;
+            }
+            if(next->node_block->at(old_node_idx).arr_ptr) {
+                this->next->resources->emplace_back(GCResourceInfo{Outer_Segment, (void*) next->node_block->at(old_node_idx).arr_ptr});
+            }
+            if(next->node_block->at(old_node_idx).property) {
+                this->next->resources->emplace_back(GCResourceInfo{Range_Property_Map_All_Modified, (void *) next->node_block->at(old_node_idx).property});
+            }
+            slots.push_back(~(int64_t) merges.size());
+            merges.push_back(Merge{old_node_idx, list_st, list_ed});
+            list_st = list_ed;
+        }
+        assert(list_st == clustered_edges.size());
+
+        std::vector<std::vector<NeoRangeNode>> merged_nodes(merges.size());
+        std::vector<std::vector<GCResourceInfo>> merged_resources(merges.size());
+        batch_update_pool().parallel_for(0, merges.size(), 1, [&](uint64_t begin, uint64_t end, size_t) {
+            auto tracer = batch_trace_block();
+            for(auto i = begin; i < end; i++) {
+                auto &merge = merges[i];
+                node_insert_edge_batch(merge.node_idx, merged_nodes[i], 0, clustered_edges.data() + merge.st,
+                                       slice(clustered_props, merge.st), merge.ed - merge.st, merged_resources[i], tracer);
+            }
+        });
+
+        // assemble the nodes in key order and bind the clustered vertices to their final node index
+        auto new_node_block = new std::vector<NeoRangeNode>{};
+        new_node_block->reserve(node_block->size() + merges.size());
+        for(auto slot: slots) {
+            if(slot >= 0) {
+                new_node_block->push_back(node_block->at(slot));
+            } else {
+                auto &nodes = merged_nodes[~slot];
+                new_node_block->insert(new_node_block->end(), nodes.begin(), nodes.end());
+            }
+        }
+        if(new_node_block->empty()) {
+            new_node_block->push_back(NeoRangeNode{0, 0, 0, nullptr});
+        }
+        new_node_block->at(0).key = 0;
+        for(uint64_t node_idx = 0; node_idx < new_node_block->size(); node_idx++) {
+            auto next_key = node_idx != new_node_block->size() - 1 ? new_node_block->at(node_idx + 1).key : layout->group_size();
+            for(uint64_t i = new_node_block->at(node_idx).key; i < next_key; i++) {
+                auto &vertex = vertex_map->at(i);
+                if(vertex.degree > 0 && !vertex.is_independent && vertex.range_node_idx != node_idx) {
+                    vertex_map->modify(i).range_node_idx = node_idx;
+                }
+            }
+        }
+        for(auto &part: independent_resources) {
+            this->next->resources->insert(this->next->resources->end(), part.begin(), part.end());
+        }
+        for(auto &part: merged_resources) {
+            this->next->resources->insert(this->next->resources->end(), part.begin(), part.end());
+        }
+        mark_independent_vertices(edges, count);
+
+        delete node_block;
+        node_block = new_node_block;
+    }
+
+    void NeoTreeVersion::mark_independent_vertices(const std::pair<RangeElement, RangeElement>* edges, uint64_t count) {
+        for(uint64_t i = 0; i < count; i++) {
+            auto vertex = edges[i].first & layout->group_mask();
+            if((i == 0 || vertex != (edges[i - 1].first & layout->group_mask())) && vertex_map->at(vertex).is_independent) {
+                independent_map.set(vertex);
+            }
+        }
+    }
+
+    void NeoTreeVersion::bulk_build(const uint64_t* vertices, uint64_t vertex_num, const std::pair<RangeElement, RangeElement>* edges, Property_t ** properties, uint64_t count, WriterTraceBlock* trace_block) {
+        if(next != nullptr) {
+            throw std::runtime_error("NeoTreeVersion::bulk_build(): the version has a predecessor");
+        }
+        insert_vertex_batch(vertices, nullptr, vertex_num);
+        // no vertex has any edge yet, so append_new_list never releases a predecessor resource
+        node_block->clear();
+        if(count != 0) {
+            std::vector<GCResourceInfo> unused;
+            append_new_list(0, *node_block, edges, properties, count, unused, trace_block);
+            mark_independent_vertices(edges, count);
+        }
+        if(node_block->empty()) {
+            node_block->push_back(NeoRangeNode{0, 0, 0, nullptr});
+        }
+        node_block->at(0).key = 0;
+    }
+
+    void NeoTreeVersion::relayout(const std::pair<uint16_t, NeoRepresentation>* moves, uint64_t count, WriterTraceBlock* trace_block) {
+        for(uint64_t i = 0; i < count; i++) {
+            auto [vertex, target] = moves[i];
+            auto current = representation_of(vertex_map->at(vertex));
+            if(current == NEO_CLUSTERED) {
+                extract2independent(vertex, target, trace_block);
+            } else if(current == NEO_RANGE_TREE && target == NEO_ART) {
+                auto vertex_range_tree = (RangeTree*) vertex_map->at(vertex).neighborhood_ptr;
+                auto new_art = vertex_range_tree->range_tree2art(vertex_map->at(vertex).degree, trace_block);
+                this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
+                auto &entry = vertex_map->modify(vertex);
+                entry.neighborhood_ptr = (uint64_t) new_art;
+                entry.is_art = true;
+            } else if(target < current) {
+                rebuild(vertex, target, nullptr, 0, trace_block);
+            }
+        }
+    }
+
+    void NeoTreeVersion::extract2independent(uint16_t vertex, NeoRepresentation target, WriterTraceBlock* trace_block) {
+        auto entry = vertex_map->at(vertex);
+        uint64_t degree = entry.degree;
+        NeoRangeNode &node = *find_range_node(vertex);
+        NeoRangeNode old_node = node;
+        uint64_t node_idx = &node - node_block->data();
+        auto arr = (RangeElementSegment_t *) node.arr_ptr;
+        uint64_t arr_size = node.size + 1;
+        RangeElement* neighbor_begin = arr->value.begin() + entry.neighbor_offset;
+
+        std::vector<RangeElement> extract_list(neighbor_begin, neighbor_begin + degree);
+        std::vector<Property_t*> extract_prop_list;
+#if EDGE_PROPERTY_NUM != 0
+        auto prop_arr = node.property;
+        extract_prop_list.reserve(degree);
+        for(uint64_t i = 0; i < degree; i++) {
+            extract_prop_list.push_back(prop_arr ? map_get_all_range_property(prop_arr, entry.neighbor_offset + i) : nullptr);
+        }
+#endif
+        void* new_tree;
+        if(target == NEO_ART) {
+            auto new_art = new ART();
+            delete (ARTNode_4*) new_art->root;
+            batch_subtree_build<false>(&new_art->root, 0, extract_list.data(), extract_prop_list.empty() ? nullptr : extract_prop_list.data(), degree, trace_block);
+            new_tree = new_art;
+        } else {
+            new_tree = new RangeTree(extract_list, extract_prop_list.empty() ? nullptr : extract_prop_list.data(), degree, trace_block);
+        }
+#if EDGE_PROPERTY_NUM > 1
+        for(auto prop: extract_prop_list) {
+            delete [] prop;
+        }
+#endif
+
+        // clean old array
+        std::vector<uint16_t>* vertices = get_vertices_in_node(node_idx);
+        if(arr_size > degree) {
+            auto new_arr = trace_block->allocate_range_element_segment(arr_size - degree);
+            std::copy(arr->value.begin(), neighbor_begin, new_arr->value.begin());
+            std::copy(neighbor_begin + degree, arr->value.begin() + arr_size, new_arr->value.begin() + entry.neighbor_offset);
+            node.arr_ptr = (uint64_t) new_arr;
+            node.size = arr_size - degree - 1;
+#if EDGE_PROPERTY_NUM != 0
+            if(prop_arr) {
+                auto new_prop_arr = trace_block->allocate_range_prop_vec();
+                range_property_map_copy(prop_arr, 0, entry.neighbor_offset, new_prop_arr, 0);
+                range_property_map_copy(prop_arr, entry.neighbor_offset + degree, arr_size, new_prop_arr, entry.neighbor_offset);
+                node.property = new_prop_arr;
+            }
+#endif
+            vertex_map_update_split(new_arr, vertices->data(), vertices->size(), node_idx, vertex, -(int)degree);
+            if(node.key != 0 && entry.neighbor_offset == 0) {
+                assert(vertices->at(0) == vertex && vertices->size() > 1);
+                node.key = vertices->at(1);
+            }
+        } else {
+            remove_node(node, node_idx, vertices->at(vertices->size() - 1) + 1);
+        }
+        delete vertices;
+        retire_segment(old_node, trace_block);
+
+        auto &new_entry = vertex_map->modify(vertex);
+        new_entry.neighborhood_ptr = (uint64_t) new_tree;
+        new_entry.neighbor_offset = 0;
+        new_entry.range_node_idx = 0;
+        new_entry.is_independent = true;
+        new_entry.is_art = target == NEO_ART;
+        independent_map.set(vertex);
+    }
+    void NeoTreeVersion::rebuild(uint16_t vertex, NeoRepresentation target, const std::pair<RangeElement, RangeElement>* removed, uint64_t removed_num, WriterTraceBlock* trace_block) {
+        auto entry = vertex_map->at(vertex);
+        assert(entry.is_independent && target <= representation_of(entry));
+        std::vector<RangeElement> list;
+        std::vector<Property_t*> props;
+        list.reserve(entry.degree);
+        props.reserve(entry.degree);
+        auto removed_end = removed + removed_num;
+        auto collect = [&](RangeElement element, Property_t* property) {
+            // the elements come in order, so does removed
+            while(removed != removed_end && removed->second < element) {
+                removed++;
+            }
+            if(removed != removed_end && removed->second == element) {
+#if EDGE_PROPERTY_NUM > 1
+                delete [] property;
+#endif
+                return;
+            }
+            list.push_back(element);
+            props.push_back(property);
+        };
+
+        // the readers of the previous version keep the old tree until it is collected
+        if(!entry.is_art) {
+            auto vertex_range_tree = (RangeTree*) entry.neighborhood_ptr;
+            for(auto &node: vertex_range_tree->node_block) {
+                auto arr = (RangeElementSegment_t*) node.arr_ptr;
+                for(uint64_t i = 0; i < node.size; i++) {
+#if EDGE_PROPERTY_NUM != 0
+                    collect(arr->value.at(i), node.property_map ? map_get_all_range_property(node.property_map, i) : nullptr);
+#else
+                    collect(arr->value.at(i), nullptr);
+#endif
+                }
+            }
+            this->next->resources->emplace_back(GCResourceInfo{Range_Tree_Upgraded, (void*) vertex_range_tree});
+        } else {
+            auto vertex_art = (ART*) entry.neighborhood_ptr;
+            std::array<RangeElement, ART_LEAF_SIZE> block;
+            vertex_art->for_each_leaf([&](ARTLeaf* leaf) {
+                leaf_decode(leaf, 0, leaf->size, block.data());
+                for(uint16_t i = 0; i < leaf->size; i++) {
+#if EDGE_PROPERTY_NUM != 0
+                    collect(block[i], leaf->property_map ? map_get_all_art_property(leaf->property_map, i) : nullptr);
+#else
+                    collect(block[i], nullptr);
+#endif
+                }
+            });
+            this->next->resources->emplace_back(GCResourceInfo{ART_Tree_Downgraded, (void*) vertex_art});
+        }
+
+        auto &new_entry = vertex_map->modify(vertex);
+        if(target == NEO_ART && !list.empty()) {
+            auto new_art = new ART();
+            delete (ARTNode_4*) new_art->root;
+            batch_subtree_build<false>(&new_art->root, 0, list.data(), props.data(), list.size(), trace_block);
+            new_entry.neighborhood_ptr = (uint64_t) new_art;
+            new_entry.degree = list.size();
+        } else if(target == NEO_RANGE_TREE && !list.empty()) {
+            new_entry.neighborhood_ptr = (uint64_t) new RangeTree(list, props.data(), list.size(), trace_block);
+            new_entry.degree = list.size();
+            new_entry.is_art = false;
+        } else {
+            new_entry.neighborhood_ptr = 0;
+            new_entry.neighbor_offset = 0;
+            new_entry.range_node_idx = 0;
+            new_entry.degree = 0;
+            new_entry.is_independent = false;
+            new_entry.is_art = false;
+            independent_map.reset(vertex);
+            merge2clustered(vertex, list, props, trace_block);
+        }
+#if EDGE_PROPERTY_NUM > 1
+        for(auto prop: props) {
+            delete [] prop;
+        }
+#endif
+    }
+
+    void NeoTreeVersion::merge2clustered(uint16_t vertex, const std::vector<RangeElement> &list, const std::vector<Property_t*> &props, WriterTraceBlock* trace_block) {
+        uint64_t degree = list.size();
+        if(degree == 0) {
+            return;
+        }
+        assert(degree < layout->range_leaf_size);
+        uint64_t node_idx = find_range_node(vertex) - node_block->data();
+        NeoRangeNode old_node = node_block->at(node_idx);
+        auto arr = (RangeElementSegment_t *) old_node.arr_ptr;
+        uint64_t arr_size = arr ? old_node.size + 1 : 0;
+        uint64_t next_key = node_idx != node_block->size() - 1 ? node_block->at(node_idx + 1).key : layout->group_size();
+        std::vector<uint16_t>* vertices = arr ? get_vertices_in_node(node_idx) : new std::vector<uint16_t>();
+        uint64_t split = std::lower_bound(vertices->begin(), vertices->end(), vertex) - vertices->begin();
+        uint64_t pos = split != vertices->size() ? vertex_map->at(vertices->at(split)).neighbor_offset : arr_size;
+        uint64_t total = arr_size + degree;
+
+        // the merged node is [0, pos) of the old segment, the new edges, then [pos, arr_size); it is cut in front of
+        // and/or behind the new edges where the parts would overflow a segment, so the cuts fall between vertices
+        std::vector<uint64_t> cuts{0};
+        if(total > layout->range_leaf_size) {
+            if(pos + degree > layout->range_leaf_size) {
+                cuts.push_back(pos);
+            }
+            if(total - pos > layout->range_leaf_size) {
+                cuts.push_back(pos + degree);
+            }
+        }
+        cuts.push_back(total);
+
+        std::vector<NeoRangeNode> pieces;
+        pieces.reserve(cuts.size() - 1);
+        for(uint64_t p = 0; p + 1 < cuts.size(); p++) {
+            uint64_t begin = cuts[p], end = cuts[p + 1];
+            uint64_t left_end = std::min(end, pos), right_begin = std::max(begin, pos + degree);
+            uint64_t new_begin = std::max(begin, pos), new_end = std::min(end, pos + degree);
+            auto new_arr = trace_block->allocate_range_element_segment(end - begin);
+            if(begin < left_end) {
+                std::copy(arr->value.begin() + begin, arr->value.begin() + left_end, new_arr->value.begin());
+            }
+            if(new_begin < new_end) {
+                std::copy(list.begin() + (new_begin - pos), list.begin() + (new_end - pos), new_arr->value.begin() + (new_begin - begin));
+            }
+            if(right_begin < end) {
+                std::copy(arr->value.begin() + (right_begin - degree), arr->value.begin() + (end - degree), new_arr->value.begin() + (right_begin - begin));
+            }
+#if EDGE_PROPERTY_NUM != 0
+            auto new_property_map = trace_block->allocate_range_prop_vec();
+            if(old_node.property && begin < left_end) {
+                range_property_map_copy(old_node.property, begin, left_end, new_property_map, 0);
+            }
+            for(uint64_t i = new_begin; i < new_end; i++) {
+                map_set_sa_range_property(new_property_map, i - begin, props[i - pos]);
+            }
+            if(old_node.property && right_begin < end) {
+                range_property_map_copy(old_node.property, right_begin - degree, end - degree, new_property_map, right_begin - begin);
+            }
+#else
+            void* new_property_map = nullptr;
+#endif
+            uint64_t key = p == 0 ? old_node.key : begin == pos ? vertex : vertices->at(split);
+            pieces.emplace_back(key, end - begin - 1, (uint64_t) new_arr, new_property_map);
+        }
+
+        node_block->at(node_idx) = pieces[0];
+        node_block->insert(node_block->begin() + node_idx + 1, pieces.begin() + 1, pieces.end());
+        if(pieces.size() > 1) {
+            // move the following nodes back
+            for(uint64_t i = next_key; i < layout->group_size(); i++) {
+                if(vertex_map->at(i).degree > 0 && !vertex_map->at(i).is_independent) {
+                    vertex_map->modify(i).range_node_idx += pieces.size() - 1;
+                }
+            }
+        }
+
+        // every vertex of the node moves to the piece holding its offset in the merged node
+        auto place = [&](uint16_t cur, uint64_t merged_offset) {
+            uint64_t p = std::upper_bound(cuts.begin(), cuts.end(), merged_offset) - cuts.begin() - 1;
+            auto &cur_entry = vertex_map->modify(cur);
+            cur_entry.neighborhood_ptr = pieces[p].arr_ptr;
+            cur_entry.neighbor_offset = merged_offset - cuts[p];
+            cur_entry.range_node_idx = node_idx + p;
+        };
+        for(uint64_t i = 0; i < vertices->size(); i++) {
+            uint64_t offset = vertex_map->at(vertices->at(i)).neighbor_offset;
+            place(vertices->at(i), i < split ? offset : offset + degree);
+        }
+        place(vertex, pos);
+        vertex_map->modify(vertex).degree = degree;
+        delete vertices;
+
+        if(arr) {
+            retire_segment(old_node, trace_block);
+        }
+    }
+
+    void NeoTreeVersion::retire_segment(const NeoRangeNode &old_node, WriterTraceBlock* trace_block) {
+        uint64_t arr = old_node.arr_ptr;
+        bool inherited = std::any_of(next->node_block->begin(), next->node_block->end(), [arr](const NeoRangeNode &node) {
+            return node.arr_ptr == arr;
+        });
+        if(inherited) {
+            this->next->resources->emplace_back(GCResourceInfo{Outer_Segment, (void*) arr});
+#if EDGE_PROPERTY_NUM != 0
+            if(old_node.property) {
+                this->next->resources->emplace_back(GCResourceInfo{Range_Property_Map_All_Modified, (void*) old_node.property});
+            }
+#endif
+        } else {
+            // built earlier in this version, no reader has seen it
+            trace_block->deallocate_range_element_segment((RangeElementSegment_t*) arr);
+#if EDGE_PROPERTY_NUM != 0
+            if(old_node.property) {
+                trace_block->deallocate_range_prop_vec(old_node.property);
+            }
+#endif
+        }
+    }
+
+#if EDGE_TTL_ENABLE
+    void NeoTreeVersion::collect_expired(uint64_t prefix, uint64_t deadline, std::vector<std::pair<RangeElement, RangeElement>> &expired) const {
+        for(uint64_t vertex = 0; vertex < layout->group_size(); vertex++) {
+            auto entry = vertex_map->at(vertex);
+            if(!entry.exist || entry.degree == 0) {
+                continue;
+            }
+            auto src = (RangeElement) (prefix | vertex);
+            // an edge without property map was inserted before the TTL was set, it counts as epoch 0
+            auto check = [&](RangeElement dest, Property_t epoch) {
+                if(epoch <= deadline) {
+                    expired.emplace_back(src, dest);
+                }
+            };
+            if(!entry.is_independent) {
+                auto &node = node_block->at(entry.range_node_idx);
+                auto arr = (RangeElementSegment_t*) node.arr_ptr;
+                for(uint64_t i = entry.neighbor_offset; i < entry.neighbor_offset + entry.degree; i++) {
+                    check(arr->value.at(i), node.property ? map_get_range_property(node.property, i, 0) : 0);
+                }
+            } else if(!entry.is_art) {
+                for(auto &node: ((RangeTree*) entry.neighborhood_ptr)->node_block) {
+                    auto arr = (RangeElementSegment_t*) node.arr_ptr;
+                    for(uint64_t i = 0; i < node.size; i++) {
+                        check(arr->value.at(i), node.property_map ? map_get_range_property(node.property_map, i, 0) : 0);
+                    }
+                }
+            } else {
+                std::array<RangeElement, ART_LEAF_SIZE> block;
+                ((ART*) entry.neighborhood_ptr)->for_each_leaf([&](ARTLeaf* leaf) {
+                    leaf_decode(leaf, 0, leaf->size, block.data());
+                    for(uint16_t i = 0; i < leaf->size; i++) {
+                        check(block[i], leaf->property_map ? map_get_art_property(leaf->property_map, i, 0) : 0);
+                    }
+                });
+            }
+        }
+    }
+#endif
 }
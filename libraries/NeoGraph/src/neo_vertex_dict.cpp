@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include "include/neo_vertex_dict.h"
+
+namespace container {
+    NeoVertexDictionary::NeoVertexDictionary(): chunks(new std::atomic<uint64_t*>[VERTEX_DICT_MAX_CHUNK_NUM]) {
+        for(uint64_t i = 0; i < VERTEX_DICT_MAX_CHUNK_NUM; i++) {
+            chunks[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    NeoVertexDictionary::~NeoVertexDictionary() {
+        for(uint64_t i = 0; i < VERTEX_DICT_MAX_CHUNK_NUM; i++) {
+            delete[] chunks[i].load();
+        }
+        delete[] chunks;
+    }
+
+    uint64_t* NeoVertexDictionary::reserve(uint64_t internal) {
+        auto chunk_idx = internal >> VERTEX_DICT_CHUNK_BITS;
+        if(chunk_idx >= VERTEX_DICT_MAX_CHUNK_NUM) {
+            throw std::overflow_error("NeoVertexDictionary: out of internal IDs, raise VERTEX_DICT_MAX_CHUNK_NUM");
+        }
+        auto chunk = chunks[chunk_idx].load(std::memory_order_acquire);
+        if(chunk == nullptr) {
+            std::lock_guard<std::mutex> guard(grow_mutex);
+            chunk = chunks[chunk_idx].load(std::memory_order_relaxed);
+            if(chunk == nullptr) {
+                chunk = new uint64_t[VERTEX_DICT_CHUNK_SIZE];
+                std::fill(chunk, chunk + VERTEX_DICT_CHUNK_SIZE, NONE);
+                chunks[chunk_idx].store(chunk, std::memory_order_release);
+            }
+        }
+        return chunk + (internal & VERTEX_DICT_CHUNK_MASK);
+    }
+
+    uint64_t NeoVertexDictionary::assign(uint64_t external, bool* assigned) {
+        if(assigned) {
+            *assigned = false;
+        }
+        {
+            Map::const_accessor accessor;
+            if(map.find(accessor, external)) {
+                return accessor->second;
+            }
+        }
+        Map::accessor accessor;
+        if(map.insert(accessor, external)) {
+            // the entry stays write-locked until the reverse slot is filled, whoever finds the ID can translate it back
+            auto internal = next_id.load(std::memory_order_relaxed);
+            while(!next_id.compare_exchange_weak(internal, internal + 1, std::memory_order_relaxed)) {}
+            try {
+                *reserve(internal) = external;
+            } catch(...) {
+                map.erase(accessor);
+                throw;
+            }
+            accessor->second = internal;
+            if(assigned) {
+                *assigned = true;
+            }
+        }
+        return accessor->second;
+    }
+
+    void NeoVertexDictionary::restore(uint64_t external, uint64_t internal) {
+        Map::accessor accessor;
+        auto slot = reserve(internal);
+        if(!map.insert(accessor, external)) {
+            if(accessor->second != internal) {
+                throw std::runtime_error("NeoVertexDictionary::restore(): external ID is mapped twice");
+            }
+            return;
+        }
+        if(*slot != NONE) {
+            map.erase(accessor);
+            throw std::runtime_error("NeoVertexDictionary::restore(): internal ID is mapped twice");
+        }
+        accessor->second = internal;
+        *slot = external;
+        auto next = next_id.load(std::memory_order_relaxed);
+        while(next <= internal && !next_id.compare_exchange_weak(next, internal + 1, std::memory_order_release)) {}
+    }
+
+    std::vector<uint64_t> NeoVertexDictionary::externals() const {
+        std::vector<uint64_t> res(size(), NONE);
+        for(uint64_t internal = 0; internal < res.size(); internal += VERTEX_DICT_CHUNK_SIZE) {
+            auto chunk = chunks[internal >> VERTEX_DICT_CHUNK_BITS].load(std::memory_order_acquire);
+            if(chunk != nullptr) {
+                std::copy(chunk, chunk + std::min(VERTEX_DICT_CHUNK_SIZE, res.size() - internal), res.begin() + (int64_t) internal);
+            }
+        }
+        return res;
+    }
+
+    void NeoVertexDictionary::assign_all(const std::vector<uint64_t> &externals) {
+        for(auto external: externals) {
+            assign(external);
+        }
+    }
+
+    uint64_t NeoVertexDictionary::to_internal(uint64_t external) const {
+        Map::const_accessor accessor;
+        if(!map.find(accessor, external)) {
+            return NONE;
+        }
+        return accessor->second;
+    }
+
+    std::vector<uint64_t> NeoVertexDictionary::order(const std::vector<std::pair<uint64_t, uint64_t>> &edges, NeoVertexOrder order) {
+        // compact the endpoints to [0, n) and build an undirected CSR over them
+        std::vector<uint64_t> vertices;
+        vertices.reserve(edges.size() * 2);
+        for(auto &edge: edges) {
+            vertices.push_back(edge.first);
+            vertices.push_back(edge.second);
+        }
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+        auto compact = [&](uint64_t vertex) {
+            return (uint64_t) (std::lower_bound(vertices.begin(), vertices.end(), vertex) - vertices.begin());
+        };
+        std::vector<uint64_t> offsets(vertices.size() + 1, 0);
+        for(auto &edge: edges) {
+            offsets[compact(edge.first) + 1] += 1;
+            offsets[compact(edge.second) + 1] += 1;
+        }
+        for(uint64_t i = 0; i < vertices.size(); i++) {
+            offsets[i + 1] += offsets[i];
+        }
+
+        std::vector<uint64_t> by_degree(vertices.size());
+        for(uint64_t i = 0; i < vertices.size(); i++) {
+            by_degree[i] = i;
+        }
+        std::stable_sort(by_degree.begin(), by_degree.end(), [&](uint64_t a, uint64_t b) {
+            return offsets[a + 1] - offsets[a] > offsets[b + 1] - offsets[b];
+        });
+        std::vector<uint64_t> res;
+        res.reserve(vertices.size());
+        if(order == VERTEX_ORDER_DEGREE) {
+            for(auto v: by_degree) {
+                res.push_back(vertices[v]);
+            }
+            return res;
+        }
+
+        std::vector<uint64_t> neighbors(offsets.back());
+        std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+        for(auto &edge: edges) {
+            auto src = compact(edge.first);
+            auto dest = compact(edge.second);
+            neighbors[fill[src]++] = dest;
+            neighbors[fill[dest]++] = src;
+        }
+        std::vector<bool> visited(vertices.size(), false);
+        std::queue<uint64_t> frontier;
+        for(auto root: by_degree) {
+            if(visited[root]) {
+                continue;
+            }
+            visited[root] = true;
+            frontier.push(root);
+            while(!frontier.empty()) {
+                auto v = frontier.front();
+                frontier.pop();
+                res.push_back(vertices[v]);
+                for(uint64_t i = offsets[v]; i < offsets[v + 1]; i++) {
+                    if(!visited[neighbors[i]]) {
+                        visited[neighbors[i]] = true;
+                        frontier.push(neighbors[i]);
+                    }
+                }
+            }
+        }
+        return res;
+    }
+}
@@ -0,0 +1,59 @@
+#include "include/neo_vertex_map.h"
+#include <cstring>
+#include "include/neo_reader_trace.h"
+
+namespace container {
+    void VertexMap::init(uint64_t group_bits, WriterTraceBlock* trace_block) {
+        this->trace_block = trace_block;
+        chunk_num = 1ull << (group_bits - VERTEX_MAP_CHUNK_BITS);
+        for(uint64_t i = 0; i < chunk_num; i++) {
+            chunks[i] = trace_block->allocate_vertex_map_chunk();
+            memset(chunks[i]->value.data(), 0, sizeof(chunks[i]->value));
+        }
+    }
+
+    void VertexMap::share(const VertexMap &other, WriterTraceBlock* trace_block) {
+        this->trace_block = trace_block;
+        chunk_num = other.chunk_num;
+        for(uint64_t i = 0; i < chunk_num; i++) {
+            chunks[i] = other.chunks[i];
+            chunks[i]->ref_cnt += 1;
+        }
+    }
+
+    void VertexMap::release(WriterTraceBlock* trace_block) {
+        for(uint64_t i = 0; i < chunk_num; i++) {
+            auto &chunk = chunks[i];
+            if(--chunk->ref_cnt == 0) {
+                if(trace_block != nullptr) {
+                    trace_block->deallocate_vertex_map_chunk(chunk);
+                } else {
+                    release_vertex_map_chunk(chunk);
+                }
+            }
+            chunk = nullptr;
+        }
+        chunk_num = 0;
+        this->trace_block = nullptr;
+    }
+
+    void VertexMap::copy_chunk(uint64_t chunk_idx) {
+        auto &chunk = chunks[chunk_idx];
+        auto copy = trace_block->allocate_vertex_map_chunk();
+        copy->value = chunk->value;
+        chunk->ref_cnt -= 1;
+        chunk = copy;
+    }
+
+    void VertexMap::copy_to(NeoVertex* out) const {
+        for(uint64_t i = 0; i < chunk_num; i++) {
+            std::copy(chunks[i]->value.begin(), chunks[i]->value.end(), out + i * VERTEX_MAP_CHUNK_SIZE);
+        }
+    }
+
+    void VertexMap::assign(const NeoVertex* in) {
+        for(uint64_t i = 0; i < size(); i++) {
+            modify(i) = in[i];
+        }
+    }
+}
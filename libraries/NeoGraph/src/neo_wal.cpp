@@ -0,0 +1,179 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "include/neo_wal.h"
+
+namespace container {
+    static_assert(sizeof(WALRecord) == 32, "WALRecord is written to disk as is");
+
+    namespace {
+        uint64_t group_checksum(const WALRecord* records, uint64_t count) {
+            auto words = (const uint64_t*) records;
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for(uint64_t i = 0; i < count * sizeof(WALRecord) / sizeof(uint64_t); i++) {
+                hash = (hash ^ words[i]) * 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        void write_all(int fd, const void* data, uint64_t size) {
+            auto ptr = (const char*) data;
+            while(size != 0) {
+                auto written = ::write(fd, ptr, size);
+                if(written < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    throw std::runtime_error("WriteAheadLog: write failed");
+                }
+                ptr += written;
+                size -= written;
+            }
+        }
+    }
+
+    WriteAheadLog::WriteAheadLog(const std::string &path) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if(fd < 0) {
+            throw std::runtime_error("WriteAheadLog: cannot open " + path);
+        }
+        pending.reserve(WAL_GROUP_COMMIT_SIZE);
+    }
+
+    WriteAheadLog::~WriteAheadLog() {
+        try {
+            sync();
+        } catch(std::runtime_error &) {
+            // the failure was already reported to the committers
+        }
+        ::close(fd);
+    }
+
+    void WriteAheadLog::append(WALBuffer* buffer, uint64_t timestamp, WALOperation op, uint64_t src, uint64_t dest, uint64_t property) {
+        buffer->log = this;
+        buffer->records.push_back(WALRecord{timestamp, op, src, dest, property});
+        if(buffer->records.size() >= WAL_BUFFER_SIZE) {
+            std::unique_lock<std::mutex> lock(mutex);
+            hand_off(buffer, lock);
+            // bound the memory held by the log when nobody waits for durability
+            if(pending.size() >= WAL_GROUP_COMMIT_SIZE && !flushing) {
+                flush(lock);
+            }
+        }
+    }
+
+    void WriteAheadLog::commit(WALBuffer* buffer) {
+        std::unique_lock<std::mutex> lock(mutex);
+        hand_off(buffer, lock);
+        auto target = handed_off;
+        while(durable < target) {
+            if(failed) {
+                throw std::runtime_error("WriteAheadLog: an earlier group failed to write");
+            }
+            if(!flushing) {
+                flush(lock);
+            } else {
+                flushed.wait(lock);
+            }
+        }
+    }
+
+    void WriteAheadLog::sync() {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto target = handed_off;
+        while(durable < target) {
+            if(failed) {
+                throw std::runtime_error("WriteAheadLog: an earlier group failed to write");
+            }
+            if(!flushing) {
+                flush(lock);
+            } else {
+                flushed.wait(lock);
+            }
+        }
+    }
+
+    void WriteAheadLog::hand_off(WALBuffer* buffer, std::unique_lock<std::mutex> &lock) {
+        if(failed) {
+            buffer->records.clear();
+            throw std::runtime_error("WriteAheadLog: an earlier group failed to write");
+        }
+        pending.insert(pending.end(), buffer->records.begin(), buffer->records.end());
+        handed_off += buffer->records.size();
+        buffer->records.clear();
+    }
+
+    ///@brief Become the leader of a group: write out everything handed off so far with a single fdatasync.
+    /// The mutex is released during the I/O so that other writers keep handing off into the next group.
+    /// A failed group may be partially on disk, so the log is marked failed rather than retried: every waiter
+    /// and every later hand-off throws instead of waiting for a durability that will never come.
+    void WriteAheadLog::flush(std::unique_lock<std::mutex> &lock) {
+        flushing = true;
+        std::vector<WALRecord> group;
+        group.swap(pending);
+        pending.reserve(WAL_GROUP_COMMIT_SIZE);
+        auto target = handed_off;
+        lock.unlock();
+        try {
+            write_group(group);
+        } catch(...) {
+            lock.lock();
+            failed = true;
+            flushing = false;
+            flushed.notify_all();
+            throw;
+        }
+        lock.lock();
+        durable = target;
+        flushing = false;
+        flushed.notify_all();
+    }
+
+    void WriteAheadLog::write_group(const std::vector<WALRecord> &records) const {
+        if(!records.empty()) {
+            WALGroupHeader header{GROUP_MAGIC, (uint32_t) records.size(), group_checksum(records.data(), records.size())};
+            write_all(fd, &header, sizeof(header));
+            write_all(fd, records.data(), records.size() * sizeof(WALRecord));
+        }
+        if(::fdatasync(fd) != 0) {
+            throw std::runtime_error("WriteAheadLog: fdatasync failed");
+        }
+    }
+
+    uint64_t WriteAheadLog::read(const std::string &path, std::vector<WALRecord> &records) {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.good()) {
+            return 0;
+        }
+        uint64_t valid = 0;
+        WALGroupHeader header{};
+        std::vector<WALRecord> group;
+        while(file.read((char*) &header, sizeof(header))) {
+            if(header.magic != GROUP_MAGIC || header.count == 0) {
+                break;
+            }
+            group.resize(header.count);
+            if(!file.read((char*) group.data(), header.count * sizeof(WALRecord))) {
+                break;
+            }
+            if(group_checksum(group.data(), group.size()) != header.checksum) {
+                break;
+            }
+            records.insert(records.end(), group.begin(), group.end());
+            valid += sizeof(header) + header.count * sizeof(WALRecord);
+        }
+        file.clear();
+        file.seekg(0, std::ios::end);
+        if((uint64_t) file.tellg() != valid) {
+            std::cerr << "WriteAheadLog::read(): torn tail of " << (uint64_t) file.tellg() - valid << " bytes in " << path << " is ignored" << std::endl;
+        }
+        std::stable_sort(records.begin(), records.end(), [](const WALRecord &lhs, const WALRecord &rhs) {
+            return lhs.timestamp < rhs.timestamp;
+        });
+        return valid;
+    }
+}
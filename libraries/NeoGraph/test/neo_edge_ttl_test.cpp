@@ -0,0 +1,221 @@
+// Edge TTL: expiry, re-inserted edges on the batch and the single-edge path, the background expirer and the graphs a
+// TTL is refused for. Exits with the number of failed checks.
+#include "include/neo_transaction.h"
+#include "include/neo_snapshot.h"
+#include <map>
+#include <thread>
+#include <cstdio>
+
+using namespace container;
+
+namespace {
+    uint64_t failures = 0;
+
+#define CHECK(cond) do { if(!(cond)) { failures++; std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while(0)
+
+    const uint64_t VERTEX_NUM = 20000;
+    // sources whose neighborhoods end up clustered, in a RangeTree and in an ART
+    const uint64_t CLUSTERED = 3, RANGE = 600, ART_SOURCE = 1500;
+    const uint64_t RANGE_DEGREE = 300, ART_DEGREE = 9000;
+
+    NeoRepresentation representation(TransactionManager &tm, uint64_t vertex) {
+        auto tree = tm.index_impl->forest->get(tm.index_impl->gen_tree_direction(vertex));
+        return representation_of(tree->version_head.load()->vertex_map->at(vertex & tm.index_impl->layout.group_mask()));
+    }
+
+    void insert_vertices(TransactionManager &tm) {
+        auto tx = tm.get_write_transaction();
+        for(uint64_t v = 0; v < VERTEX_NUM; v++) {
+            tx->insert_vertex(v, nullptr);
+        }
+        tx->commit(true, false);
+        delete tx;
+    }
+
+    void insert_batch(TransactionManager &tm, const std::vector<PUU> &edges) {
+        WriteTransaction tx(tm.index_impl, &tm);
+        for(auto &edge: edges) {
+            tx.insert_edge(edge.first, edge.second, nullptr);
+        }
+        tx.commit(false, true);
+    }
+
+    std::vector<PUU> star(uint64_t src, uint64_t degree) {
+        std::vector<PUU> edges;
+        for(uint64_t i = 1; i <= degree; i++) {
+            edges.emplace_back(src, (src + i * 7) % VERTEX_NUM);
+        }
+        return edges;
+    }
+
+    ///@brief the edges of snapshot match expected, with expected mapping an edge to its epoch
+    void check_edges(TransactionManager &tm, const std::map<PUU, uint64_t> &expected) {
+        NeoSnapshot snapshot(&tm);
+        std::vector<uint64_t> degrees(VERTEX_NUM);
+        for(auto &[edge, epoch]: expected) {
+            CHECK(snapshot.has_edge(edge.first, edge.second));
+            CHECK(snapshot.get_edge_property(edge.first, edge.second, 0) == epoch);
+            degrees[edge.first]++;
+        }
+        for(uint64_t v = 0; v < VERTEX_NUM; v++) {
+            CHECK(snapshot.get_degree(v) == degrees[v]);
+        }
+    }
+
+    void test_expire(bool directed) {
+        TransactionManager tm(directed, false);
+        insert_vertices(tm);
+        tm.enable_edge_ttl(2);
+        auto tracer = writer_register();
+        std::map<PUU, uint64_t> expected;
+        auto insert = [&](uint64_t src, uint64_t dest) {
+            LightWriteTransaction::insert_edge(src, dest, nullptr, directed, &tm, tracer);
+            expected[{src, dest}] = tm.edge_epoch.load();
+            if(!directed) {
+                expected[{dest, src}] = tm.edge_epoch.load();
+            }
+        };
+        std::unique_ptr<NeoSnapshot> before_expiry;
+        std::map<PUU, uint64_t> before_expected;
+        for(uint64_t round = 0; round < 6; round++) {
+            for(uint64_t i = 0; i < 300; i++) {
+                auto src = (round * 31 + i * 13) % VERTEX_NUM, dest = (round * 17 + i * 29 + 1) % VERTEX_NUM;
+                if(src != dest) {
+                    insert(src, dest);
+                }
+            }
+            if(round < 3) {
+                for(auto &edge: star(RANGE, RANGE_DEGREE)) {
+                    insert(edge.first, (edge.second + round) % VERTEX_NUM);
+                }
+                for(auto &edge: star(ART_SOURCE, ART_DEGREE)) {
+                    insert(edge.first, (edge.second + round) % VERTEX_NUM);
+                }
+            }
+            if(round == 2) {
+                CHECK(representation(tm, RANGE) == NEO_RANGE_TREE);
+                CHECK(representation(tm, ART_SOURCE) == NEO_ART);
+                before_expiry = std::make_unique<NeoSnapshot>(&tm);
+                before_expected = expected;
+            }
+            auto epoch = tm.advance_edge_epoch();
+            uint64_t expired_expected = 0;
+            for(auto it = expected.begin(); it != expected.end();) {
+                if(it->second + 2 <= epoch) {
+                    it = expected.erase(it);
+                    expired_expected++;
+                } else {
+                    ++it;
+                }
+            }
+            CHECK(tm.expire_edges(tracer) == expired_expected);
+            check_edges(tm, expected);
+        }
+        // a snapshot taken before the expiry still reads the expired edges
+        for(auto &[edge, epoch]: before_expected) {
+            CHECK(before_expiry->has_edge(edge.first, edge.second));
+        }
+        writer_unregister(tracer);
+    }
+
+    void test_reinsert() {
+        TransactionManager tm(true, false);
+        insert_vertices(tm);
+        tm.enable_edge_ttl(2);
+        auto tracer = writer_register();
+        std::vector<PUU> edges;
+        for(auto src: {CLUSTERED, RANGE, ART_SOURCE}) {
+            auto neighbors = star(src, src == CLUSTERED ? 4 : src == RANGE ? RANGE_DEGREE : ART_DEGREE);
+            edges.insert(edges.end(), neighbors.begin(), neighbors.end());
+        }
+        insert_batch(tm, edges);
+        CHECK(representation(tm, CLUSTERED) == NEO_CLUSTERED);
+        CHECK(representation(tm, RANGE) == NEO_RANGE_TREE);
+        CHECK(representation(tm, ART_SOURCE) == NEO_ART);
+        tm.advance_edge_epoch();
+        // every other edge again, half of them through a batch and half through the single-edge path
+        std::map<PUU, uint64_t> expected;
+        std::vector<PUU> batch;
+        for(uint64_t i = 0; i < edges.size(); i += 2) {
+            if(i % 4 == 0) {
+                batch.push_back(edges[i]);
+            } else {
+                LightWriteTransaction::insert_edge(edges[i].first, edges[i].second, nullptr, true, &tm, tracer);
+            }
+            expected[edges[i]] = 1;
+        }
+        insert_batch(tm, batch);
+        tm.advance_edge_epoch();
+        CHECK(tm.expire_edges(tracer) == edges.size() - expected.size());
+        check_edges(tm, expected);
+        tm.advance_edge_epoch();
+        CHECK(tm.expire_edges(tracer) == expected.size());
+        check_edges(tm, {});
+        writer_unregister(tracer);
+    }
+
+    void test_expirer() {
+        TransactionManager tm(false, false);
+        insert_vertices(tm);
+        bool thrown = false;
+        try {
+            tm.start_edge_expirer(std::chrono::milliseconds(1));
+        } catch(std::runtime_error &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        tm.enable_edge_ttl(1);
+        auto tracer = writer_register();
+        for(uint64_t i = 0; i < 1000; i++) {
+            LightWriteTransaction::insert_edge(i, (i * 7 + 1) % VERTEX_NUM, nullptr, false, &tm, tracer);
+        }
+        writer_unregister(tracer);
+        tm.start_edge_expirer(std::chrono::milliseconds(2));
+        thrown = false;
+        try {
+            tm.start_edge_expirer(std::chrono::milliseconds(2));
+        } catch(std::runtime_error &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        for(int i = 0; i < 1000 && tm.edge_count() != 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        tm.stop_edge_expirer();
+        tm.stop_edge_expirer();
+        CHECK(tm.edge_count() == 0);
+        auto epoch = tm.edge_epoch.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CHECK(tm.edge_epoch.load() == epoch);
+        // it can be started again
+        tm.start_edge_expirer(std::chrono::milliseconds(2));
+        tm.stop_edge_expirer();
+    }
+
+    void test_weighted() {
+        TransactionManager tm(true, true);
+        insert_vertices(tm);
+        bool thrown = false;
+        try {
+            tm.enable_edge_ttl(1);
+        } catch(std::logic_error &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        auto tracer = writer_register();
+        LightWriteTransaction::insert_edge(1, 2, (Property_t*) 42, true, &tm, tracer);
+        writer_unregister(tracer);
+        NeoSnapshot snapshot(&tm);
+        CHECK(snapshot.get_edge_property(1, 2, 0) == 42);
+    }
+}
+
+int main() {
+    test_expire(true);
+    test_expire(false);
+    test_reinsert();
+    test_expirer();
+    test_weighted();
+    std::printf("%lu failed checks\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+// Removes half of the edges of a bulk-loaded graph, once through TransactionManager::remove_edge_batch and once
+// edge by edge, and prints the time of both.
+// Usage: neo_remove_edge_bench [log2 of the edge count, default 20]
+#include "include/neo_transaction.h"
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using namespace container;
+
+namespace {
+    double remove_edges(const std::vector<PUU> &edges, uint64_t vertex_num, bool batch) {
+        TransactionManager tm(true, false);
+        tm.bulk_load(edges);
+        std::vector<PRR> removed;
+        for(uint64_t i = vertex_num; i < vertex_num + (edges.size() - vertex_num) / 2; i++) {
+            removed.emplace_back(edges[i].first, edges[i].second);
+        }
+        auto tracer = writer_register();
+        auto start = std::chrono::steady_clock::now();
+        if(batch) {
+            tm.remove_edge_batch(removed, tracer);
+        } else {
+            for(auto &edge: removed) {
+                LightWriteTransaction::remove_edge(edge.first, edge.second, true, &tm, tracer);
+            }
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        writer_unregister(tracer);
+        return seconds;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t edge_bits = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20;
+    uint64_t vertex_num = 1ull << (edge_bits - 4), edge_num = 1ull << edge_bits;
+    // a ring keeps every vertex in the graph, the random edges on top of it are the ones removed
+    std::mt19937_64 rng(3);
+    std::vector<PUU> edges;
+    for(uint64_t v = 0; v < vertex_num; v++) {
+        edges.emplace_back(v, (v + 1) % vertex_num);
+    }
+    for(uint64_t i = 0; i < edge_num; i++) {
+        edges.emplace_back(rng() % vertex_num, rng() % vertex_num);
+    }
+    auto batch = remove_edges(edges, vertex_num, true);
+    auto single = remove_edges(edges, vertex_num, false);
+    std::printf("%lu vertices, %lu edges, %lu removed: remove_edge_batch %.3fs, per edge %.3fs\n",
+                vertex_num, edge_num, edge_num / 2, batch, single);
+}
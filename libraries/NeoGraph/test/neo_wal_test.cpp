@@ -0,0 +1,86 @@
+// WriteAheadLog: a group that fails to write, here on /dev/full, makes every committer throw instead of waiting for
+// it forever. Exits with the number of failed checks.
+#include "include/neo_wal.h"
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace container;
+
+namespace {
+    uint64_t failures = 0;
+
+#define CHECK(cond) do { if(!(cond)) { failures++; std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while(0)
+
+    ///@return whether the commit threw, a commit that hangs ends the test
+    bool commit_throws(WriteAheadLog &log, uint64_t timestamp) {
+        auto result = std::async(std::launch::async, [&log, timestamp] {
+            WALBuffer buffer;
+            log.append(&buffer, timestamp, WAL_INSERT_EDGE, timestamp, timestamp + 1);
+            try {
+                log.commit(&buffer);
+            } catch(std::runtime_error &) {
+                return true;
+            }
+            return false;
+        });
+        if(result.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+            std::printf("%s:%d: commit did not return\n", __FILE__, __LINE__);
+            std::fflush(stdout);
+            std::_Exit(1);
+        }
+        return result.get();
+    }
+
+    void test_sequential() {
+        WriteAheadLog log("/dev/full");
+        CHECK(commit_throws(log, 1));
+        CHECK(commit_throws(log, 2));
+        bool thrown = false;
+        try {
+            log.sync();
+        } catch(std::runtime_error &) {
+            thrown = true;
+        }
+        CHECK(thrown); // the records of the failed group are not durable
+    }
+
+    void test_concurrent() {
+        WriteAheadLog log("/dev/full");
+        std::vector<std::future<bool>> committers;
+        for(uint64_t i = 0; i < 8; i++) {
+            committers.push_back(std::async(std::launch::async, [&log, i] { return commit_throws(log, i + 1); }));
+        }
+        for(auto &committer: committers) {
+            CHECK(committer.get());
+        }
+    }
+
+    void test_append() {
+        WriteAheadLog log("/dev/full");
+        CHECK(commit_throws(log, 1));
+        // a full buffer is not handed off to a failed log either
+        WALBuffer buffer;
+        bool thrown = false;
+        try {
+            for(uint64_t i = 0; i < WAL_BUFFER_SIZE; i++) {
+                log.append(&buffer, i + 2, WAL_INSERT_VERTEX, i, 0);
+            }
+        } catch(std::runtime_error &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(buffer.records.empty());
+    }
+}
+
+int main() {
+    test_sequential();
+    test_concurrent();
+    test_append();
+    std::printf("%lu failed checks\n", failures);
+    return failures == 0 ? 0 : 1;
+}
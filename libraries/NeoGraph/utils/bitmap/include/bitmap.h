@@ -41,6 +41,14 @@ namespace container {
         ///NOTE this is absolute index
         [[nodiscard]] uint64_t consume(uint64_t begin);
 
+        [[nodiscard]] uint64_t count() const;
+
+        ///@return the bits set in both bitmaps
+        [[nodiscard]] Bitmap operator&(const Bitmap &other) const;
+
+        ///@return a copy that only keeps the bits within [lo, hi]
+        [[nodiscard]] Bitmap range(uint64_t lo, uint64_t hi) const;
+
         template<typename F>
         void for_each(F &&f) const {
             for (size_t i = 0; i < BLOCK_NUM; i++) {
@@ -115,6 +123,12 @@ namespace container {
         uint16_t count = 0;
         for (size_t i = 0; i < BLOCK_NUM; i++) {
             uint64_t mask = data[i];
+            // skip the whole block if the target is not inside
+            uint64_t block_cnt = __builtin_popcountll(mask);
+            if (count + block_cnt <= pos_idx) {
+                count += block_cnt;
+                continue;
+            }
             while (mask) {
                 uint64_t t = mask & -mask;
                 uint64_t index = __builtin_ctzll(mask);
@@ -222,4 +236,43 @@ namespace container {
         }
         return std::numeric_limits<uint64_t>::max();
     }
-}
\ No newline at end of file
+
+    template<size_t BLOCK_NUM>
+    uint64_t Bitmap<BLOCK_NUM>::count() const {
+        uint64_t res = 0;
+        for (size_t i = 0; i < BLOCK_NUM; i++) {
+            res += __builtin_popcountll(data[i]);
+        }
+        return res;
+    }
+
+    template<size_t BLOCK_NUM>
+    Bitmap<BLOCK_NUM> Bitmap<BLOCK_NUM>::operator&(const Bitmap &other) const {
+        Bitmap res;
+        for (size_t i = 0; i < BLOCK_NUM; i++) {
+            res.data[i] = data[i] & other.data[i];
+        }
+        return res;
+    }
+
+    template<size_t BLOCK_NUM>
+    Bitmap<BLOCK_NUM> Bitmap<BLOCK_NUM>::range(uint64_t lo, uint64_t hi) const {
+        Bitmap res;
+        for (size_t i = 0; i < BLOCK_NUM; i++) {
+            uint64_t block_lo = i * 64;
+            uint64_t block_hi = block_lo + 63;
+            if (block_hi < lo || block_lo > hi) {
+                continue;
+            }
+            uint64_t mask = data[i];
+            if (lo > block_lo) {
+                mask &= ~0ULL << (lo - block_lo);
+            }
+            if (hi < block_hi) {
+                mask &= ~0ULL >> (block_hi - hi);
+            }
+            res.data[i] = mask;
+        }
+        return res;
+    }
+}
@@ -105,6 +105,10 @@ namespace container {
 
         template<typename F>
         int for_each_element_unordered(F &&element_callback) const;
+
+        ///@brief visit every leaf once, in key order
+        template<typename F>
+        int for_each_leaf(F &&leaf_callback) const;
     };
 }
 
@@ -133,4 +137,9 @@ namespace container {
         };
         return tree_leaf_iter_unordered(root, leaf_callback);
     }
+
+    template<typename F>
+    int ART::for_each_leaf(F &&leaf_callback) const {
+        return tree_leaf_visit(root, leaf_callback);
+    }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <array>
 #include <functional>
 #include <functional>
+#include <vector>
 #include <immintrin.h>
 #include "../../config.h"
 #include "../../types.h"
@@ -78,6 +79,8 @@ namespace container {
 
         ARTLeaf8(ARTKey key, uint8_t depth, bool is_single_byte);
 
+        ~ARTLeaf8() override;
+
         [[nodiscard]] uint64_t at(uint16_t pos_idx) const override;
 
         [[nodiscard]] bool has_element(uint64_t element, uint8_t begin_idx) const override;
@@ -106,6 +109,8 @@ namespace container {
 
         ARTLeaf16(ARTKey key, uint8_t depth, bool is_single_byte);
 
+        ~ARTLeaf16() override;
+
         [[nodiscard]] uint64_t at(uint16_t pos_idx) const override;
 
         [[nodiscard]] bool has_element(uint64_t element, uint8_t begin_idx) const override;
@@ -131,6 +136,8 @@ namespace container {
 
         ARTLeaf32(ARTKey key, uint8_t depth, bool is_single_byte);
 
+        ~ARTLeaf32() override;
+
         [[nodiscard]] uint64_t at(uint16_t pos_idx) const override;
 
         [[nodiscard]] bool has_element(uint64_t element, uint8_t begin_idx) const override;
@@ -156,6 +163,8 @@ namespace container {
 
         ARTLeaf64(ARTKey key, uint8_t depth, bool is_single_byte);
 
+        ~ARTLeaf64() override;
+
         [[nodiscard]] bool has_element(uint64_t element, uint8_t begin_idx) const override;
 
         [[nodiscard]] uint64_t at(uint16_t pos_idx) const override;
@@ -183,6 +192,17 @@ namespace container {
 
     uint64_t get_list_byte_num(uint64_t* list, uint64_t size, uint8_t depth);
 
+    ///@return the end (exclusive) of the run of elements sharing the key byte at leaf->depth with the element at begin_idx
+    uint16_t leaf_run_end(const ARTLeaf* leaf, uint16_t begin_idx);
+
+    ///@brief write the elements in [begin_idx, end_idx) of the leaf to out, without going through the virtual at()
+    void leaf_decode(const ARTLeaf* leaf, uint16_t begin_idx, uint16_t end_idx, RangeElement* out);
+
+    ///@brief intersect two leaf runs, each produced by leaf_run_end; both runs must share the key bytes above the leaves' depth
+    uint64_t leaf_run_intersect(const ARTLeaf* leaf1, uint16_t begin1, uint16_t end1, const ARTLeaf* leaf2, uint16_t begin2, uint16_t end2);
+
+    void leaf_run_intersect(const ARTLeaf* leaf1, uint16_t begin1, uint16_t end1, const ARTLeaf* leaf2, uint16_t begin2, uint16_t end2, std::vector<uint64_t>& result);
+
     template<typename F>
     void ARTLeaf8::do_for_each(F &&f) const {
         uint64_t mask = key.key;
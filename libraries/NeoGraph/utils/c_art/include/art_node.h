@@ -31,6 +31,10 @@ namespace container {
         ARTNode n{};
         unsigned char keys[4]{};
         ARTNode *children[4]{};
+
+        ARTNode_4();
+
+        ~ARTNode_4();
     };
 
 /**
@@ -40,6 +44,10 @@ namespace container {
         ARTNode n{};
         unsigned char keys[16]{};
         ARTNode *children[16]{};
+
+        ARTNode_16();
+
+        ~ARTNode_16();
     };
 
 /**
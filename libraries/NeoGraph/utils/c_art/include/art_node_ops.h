@@ -103,6 +103,9 @@ namespace container {
     template<bool IS_COPY_ON_WRITE = true>
     void batch_subtree_build(ARTNode** new_node, uint8_t depth, RangeElement* elem_list, Property_t** prop_list, uint64_t list_size, WriterTraceBlock* trace_block);
 
+    ///@return the key bytes that have a child in the node, shared leaves are reported once per byte
+    Bitmap<4> node_child_bitmap(const ARTNode* node);
+
     void node_range_intersect(ARTNode* node, RangeElement* range, uint16_t range_size, std::vector<uint64_t>& result);
 
     void leaf_intersect(ARTLeaf* leaf1, uint8_t leaf_start1, ARTLeaf* leaf2, uint8_t leaf_start2, std::vector<uint64_t>& result);
@@ -124,6 +127,10 @@ namespace container {
     template<typename F>
     int tree_leaf_iter(ARTNode *n, F &&callback);
 
+    ///@brief call leaf_callback on every distinct leaf in key order, leaves shared by several bytes are visited once
+    template<typename F>
+    int tree_leaf_visit(ARTNode *n, F &&leaf_callback);
+
     /// the function make sure that the leaves are traversed in order except for Node48 though the `in_order` flag is set to false.
     template<typename F>
     int tree_leaf_iter_unordered(ARTNode *n, F &&callback);
@@ -255,6 +262,54 @@ namespace container {
         return 0;
     }
 
+    template<typename F>
+    int tree_leaf_visit(ARTNode *n, F &&leaf_callback) {
+        switch(n->type) {
+            case NODE4:
+            case NODE16: {
+                auto iter = alloc_iterator(n);
+                while (iter_is_valid(iter)) {
+                    auto child = iter_get_current_ro(iter);
+                    if (IS_LEAF(child)) {
+                        leaf_callback(LEAF_RAW(child));
+                    } else {
+                        tree_leaf_visit(child, leaf_callback);
+                    }
+                    iter_next(iter);
+                }
+                destroy_iterator(iter);
+                break;
+            }
+            case NODE48: {
+                auto node = (ARTNode_48*) n;
+                auto for_each = [&](uint8_t byte) {
+                    auto child = node->children[node->keys[byte] - 1];
+                    if (IS_LEAF(child)) {
+                        leaf_callback(LEAF_RAW(child));
+                    } else {
+                        tree_leaf_visit(child, leaf_callback);
+                    }
+                };
+                node->unique_bitmap.for_each(for_each);
+                break;
+            }
+            case NODE256: {
+                auto node = (ARTNode_256*) n;
+                auto for_each = [&](uint8_t byte) {
+                    auto child = node->children[byte];
+                    if (IS_LEAF(child)) {
+                        leaf_callback(LEAF_RAW(child));
+                    } else {
+                        tree_leaf_visit(child, leaf_callback);
+                    }
+                };
+                node->unique_bitmap.for_each(for_each);
+                break;
+            }
+        }
+        return 0;
+    }
+
     template<typename F>
     int tree_leaf_iter_unordered(ARTNode *n, F &&callback) {
         int idx = 0;
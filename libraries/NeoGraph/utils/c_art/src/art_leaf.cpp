@@ -1,6 +1,7 @@
 #include "include/helper.h"
 #include "include/art_node.h"
 #include "include/art_leaf.h"
+#include "utils/intersect/include/intersect.h"
 
 namespace container {
     ARTLeaf::ARTLeaf(ARTKey key, uint8_t depth, bool is_single_byte) :
@@ -80,15 +81,35 @@ namespace container {
     }
 
     ARTLeaf8::ARTLeaf8(ARTKey key, uint8_t depth, bool is_single_byte): ARTLeaf(key, depth, is_single_byte), value() {
+        memory_count(MEMORY_ART_LEAF8, sizeof(ARTLeaf8));
+    }
+
+    ARTLeaf8::~ARTLeaf8() {
+        memory_count(MEMORY_ART_LEAF8, -(int64_t) sizeof(ARTLeaf8));
     }
 
     ARTLeaf16::ARTLeaf16(ARTKey key, uint8_t depth, bool is_single_byte) : ARTLeaf(key, depth, is_single_byte), value() {
+        memory_count(MEMORY_ART_LEAF16, sizeof(ARTLeaf16));
+    }
+
+    ARTLeaf16::~ARTLeaf16() {
+        memory_count(MEMORY_ART_LEAF16, -(int64_t) sizeof(ARTLeaf16));
     }
 
     ARTLeaf32::ARTLeaf32(ARTKey key, uint8_t depth, bool is_single_byte) : ARTLeaf(key, depth, is_single_byte), value() {
+        memory_count(MEMORY_ART_LEAF32, sizeof(ARTLeaf32));
+    }
+
+    ARTLeaf32::~ARTLeaf32() {
+        memory_count(MEMORY_ART_LEAF32, -(int64_t) sizeof(ARTLeaf32));
     }
 
     ARTLeaf64::ARTLeaf64(ARTKey key, uint8_t depth, bool is_single_byte) : ARTLeaf(key, depth, is_single_byte), value() {
+        memory_count(MEMORY_ART_LEAF64, sizeof(ARTLeaf64));
+    }
+
+    ARTLeaf64::~ARTLeaf64() {
+        memory_count(MEMORY_ART_LEAF64, -(int64_t) sizeof(ARTLeaf64));
     }
 
     uint64_t ARTLeaf8::at(uint16_t pos_idx) const {
@@ -526,10 +547,8 @@ namespace container {
         assert(count + size <= ART_LEAF_SIZE);
         for(int i = 0; i < count; i++) {
             value.set(elem_list[i] & 0xFF);
-#if EDGE_PROPERTY_NUM > 1
+#if EDGE_PROPERTY_NUM != 0
             map_set_sa_art_property((void*) property_map, size + i, prop_list[i]);
-#elif EDGE_PROPERTY_NUM == 1
-//            static_cast<ARTPropertyVec_t*>(property_map)->append_from_list(size, (Property_t*) prop_list, count);
 #endif
         }
         size += count;
@@ -545,10 +564,8 @@ namespace container {
         assert(count + size <= ART_LEAF_SIZE);
         for(int i = 0; i < count; i++) {
             value->at(size + i) = elem_list[i] & 0xFFFF;
-#if EDGE_PROPERTY_NUM > 1
+#if EDGE_PROPERTY_NUM != 0
             map_set_sa_art_property((void*) property_map, size + i, prop_list[i]);
-#elif EDGE_PROPERTY_NUM == 1
-//            static_cast<ARTPropertyVec_t*>(property_map)->append_from_list(size, (Property_t*) prop_list, count);
 #endif
         }
         size += count;
@@ -564,10 +581,8 @@ namespace container {
         assert(count + size <= ART_LEAF_SIZE);
         for(int i = 0; i < count; i++) {
             value->at(size + i) = elem_list[i] & 0xFFFFFFFF;
-#if EDGE_PROPERTY_NUM > 1
+#if EDGE_PROPERTY_NUM != 0
             map_set_sa_art_property((void*) property_map, size + i, prop_list[i]);
-#elif EDGE_PROPERTY_NUM == 1
-//            static_cast<ARTPropertyVec_t*>(property_map)->append_from_list(size, (Property_t*) prop_list, count);
 #endif
         }
         size += count;
@@ -583,10 +598,8 @@ namespace container {
         assert(count + size <= ART_LEAF_SIZE);
         std::copy(elem_list, elem_list + count, value->begin() + size);
         for(int i = 0; i < count; i++) {
-#if EDGE_PROPERTY_NUM > 1
+#if EDGE_PROPERTY_NUM != 0
             map_set_sa_art_property((void*) property_map, size + i, prop_list[i]);
-#elif EDGE_PROPERTY_NUM == 1
-//            static_cast<ARTPropertyVec_t*>(property_map)->append_from_list(size, (Property_t*) prop_list, count);
 #endif
         }
         size += count;
@@ -610,6 +623,7 @@ namespace container {
                 case 2: {
                     res = new ARTLeaf16(key, depth, is_single_byte);
                     ((ARTLeaf16 *) res)->value = new std::array<uint16_t, ART_LEAF_SIZE>();
+                    memory_count(MEMORY_ART_LEAF16, sizeof(std::array<uint16_t, ART_LEAF_SIZE>));
                     memset(((ARTLeaf16 *) res)->value->data(), 0, ART_LEAF_SIZE);
                     res->type = LEAF16;
                     break;
@@ -677,6 +691,9 @@ namespace container {
                 break;
             }
             case 2: {
+                if(((ARTLeaf16*)leaf)->value != nullptr) {
+                    memory_count(MEMORY_ART_LEAF16, -(int64_t) sizeof(std::array<uint16_t, ART_LEAF_SIZE>));
+                }
                 delete ((ARTLeaf16*)leaf)->value;
 #if EDGE_PROPERTY_NUM != 0
                 trace_block->deallocate_art_prop_vec(((ARTLeaf16*)leaf)->property_map);
@@ -705,22 +722,25 @@ namespace container {
         switch (leaf->depth + leaf->is_single_byte) {
             case 0:
             case 1: {
-                delete ((ARTLeaf32*)leaf)->value;
+                release_art_leaf32(((ARTLeaf32*)leaf)->value);
 #if EDGE_PROPERTY_NUM != 0
-                delete ((ARTLeaf32*)leaf)->property_map;
+                release_art_prop_vec(((ARTLeaf32*)leaf)->property_map);
 #endif
                 break;
             }
             case 2: {
+                if(((ARTLeaf16*)leaf)->value != nullptr) {
+                    memory_count(MEMORY_ART_LEAF16, -(int64_t) sizeof(std::array<uint16_t, ART_LEAF_SIZE>));
+                }
                 delete ((ARTLeaf16*)leaf)->value;
 #if EDGE_PROPERTY_NUM != 0
-                delete ((ARTLeaf16*)leaf)->property_map;
+                release_art_prop_vec(((ARTLeaf16*)leaf)->property_map);
 #endif
                 break;
             }
             case 3: {
 #if EDGE_PROPERTY_NUM != 0
-                delete ((ARTLeaf8*)leaf)->property_map;
+                release_art_prop_vec(((ARTLeaf8*)leaf)->property_map);
 #endif
                 break;
             }
@@ -728,9 +748,9 @@ namespace container {
                 throw std::runtime_error("alloc_leaf(): Invalid depth");
         }
 #else
-        delete ((ARTLeaf32*)leaf)->value;
+        release_art_leaf32(((ARTLeaf32*)leaf)->value);
 #if EDGE_PROPERTY_NUM != 0
-        delete ((ARTLeaf32*)leaf)->property_map;
+        release_art_prop_vec(((ARTLeaf32*)leaf)->property_map);
 #endif
 #endif
     }
@@ -748,4 +768,159 @@ namespace container {
 
         return cur_diff_byte_num;
     }
-}
\ No newline at end of file
+
+    uint16_t leaf_run_end(const ARTLeaf* leaf, uint16_t begin_idx) {
+        if(leaf->is_single_byte) {
+            return leaf->size;
+        }
+        // the stored values keep the key byte at depth, so the run ends before the first value reaching the next byte
+        const uint8_t shift = (3 - leaf->depth) * 8;
+        switch(leaf->type) {
+            case LEAF8: {
+                // a depth-3 leaf holds one element per key byte
+                return begin_idx + 1;
+            }
+            case LEAF16: {
+                auto value = ((ARTLeaf16*)leaf)->value;
+                uint32_t limit = ((uint32_t)(value->at(begin_idx) >> shift) + 1) << shift;
+                return std::lower_bound(value->begin() + begin_idx, value->begin() + leaf->size, limit) - value->begin();
+            }
+            case LEAF32: {
+                auto value = ((ARTLeaf32*)leaf)->value;
+                uint64_t limit = ((uint64_t)(value->at(begin_idx) >> shift) + 1) << shift;
+                return std::lower_bound(value->begin() + begin_idx, value->begin() + leaf->size, limit) - value->begin();
+            }
+            default: {
+                uint8_t byte = get_key_byte(leaf->at(begin_idx), leaf->depth);
+                uint16_t end_idx = begin_idx + 1;
+                while(end_idx < leaf->size && get_key_byte(leaf->at(end_idx), leaf->depth) == byte) {
+                    end_idx++;
+                }
+                return end_idx;
+            }
+        }
+    }
+
+    void leaf_decode(const ARTLeaf* leaf, uint16_t begin_idx, uint16_t end_idx, RangeElement* out) {
+        uint32_t prefix = leaf->key.key;
+        switch(leaf->type) {
+            case LEAF8: {
+                uint16_t cnt = 0;
+                ((ARTLeaf8*)leaf)->value.for_each([&](uint64_t idx) {
+                    out[cnt++] = idx | prefix;
+                }, begin_idx, end_idx);
+                break;
+            }
+            case LEAF16: {
+                auto value = ((ARTLeaf16*)leaf)->value->data();
+                for(uint16_t i = begin_idx; i < end_idx; i++) {
+                    out[i - begin_idx] = value[i] | prefix;
+                }
+                break;
+            }
+            case LEAF32: {
+                auto value = ((ARTLeaf32*)leaf)->value->data();
+                for(uint16_t i = begin_idx; i < end_idx; i++) {
+                    out[i - begin_idx] = value[i] | prefix;
+                }
+                break;
+            }
+            default: {
+                for(uint16_t i = begin_idx; i < end_idx; i++) {
+                    out[i - begin_idx] = leaf->at(i);
+                }
+            }
+        }
+    }
+
+    static Bitmap<4> leaf8_run_bits(const ARTLeaf* leaf, uint16_t begin_idx, uint16_t end_idx) {
+        auto& value = ((ARTLeaf8*)leaf)->value;
+        if(begin_idx == 0 && end_idx == leaf->size) {
+            return value;
+        }
+        return value.range(value.at(begin_idx), value.at(end_idx - 1));
+    }
+
+    template<bool COLLECT>
+    static uint64_t leaf_run_intersect_impl(const ARTLeaf* leaf1, uint16_t begin1, uint16_t end1, const ARTLeaf* leaf2, uint16_t begin2, uint16_t end2, std::vector<uint64_t>* result) {
+        if(begin1 >= end1 || begin2 >= end2) {
+            return 0;
+        }
+        // make leaf1 the narrower one
+        if(leaf1->type > leaf2->type) {
+            std::swap(leaf1, leaf2);
+            std::swap(begin1, begin2);
+            std::swap(end1, end2);
+        }
+        uint64_t res = 0;
+        if(leaf1->type == LEAF8) {
+            auto bits1 = leaf8_run_bits(leaf1, begin1, end1);
+            if(leaf2->type == LEAF8) {
+                auto shared = bits1 & leaf8_run_bits(leaf2, begin2, end2);
+                if constexpr (COLLECT) {
+                    uint64_t prefix = leaf1->key.key;
+                    shared.for_each([&](uint64_t idx) {
+                        result->push_back(idx | prefix);
+                    });
+                }
+                return shared.count();
+            }
+            // both runs share every byte but the last one, probe the bitmap with it
+            std::array<RangeElement, ART_LEAF_SIZE> buf2;
+            leaf_decode(leaf2, begin2, end2, buf2.data());
+            for(uint16_t i = 0; i < end2 - begin2; i++) {
+                bool hit = bits1.get(buf2[i] & 0xFF);
+                if constexpr (COLLECT) {
+                    if(hit) {
+                        result->push_back(buf2[i]);
+                    }
+                }
+                res += hit;
+            }
+            return res;
+        }
+        if(leaf1->type == LEAF16 && leaf2->type == LEAF16) {
+            auto value1 = ((ARTLeaf16*)leaf1)->value->data() + begin1;
+            auto value2 = ((ARTLeaf16*)leaf2)->value->data() + begin2;
+            if constexpr (COLLECT) {
+                auto old_size = result->size();
+                sorted_intersect(value1, end1 - begin1, value2, end2 - begin2, leaf1->key.key, *result);
+                return result->size() - old_size;
+            } else {
+                return sorted_intersect(value1, end1 - begin1, value2, end2 - begin2);
+            }
+        }
+        if(leaf1->type == LEAF32 && leaf2->type == LEAF32) {
+            // the key of a 32-bit leaf carries no bits, values are the elements themselves
+            auto value1 = ((ARTLeaf32*)leaf1)->value->data() + begin1;
+            auto value2 = ((ARTLeaf32*)leaf2)->value->data() + begin2;
+            if constexpr (COLLECT) {
+                auto old_size = result->size();
+                sorted_intersect(value1, end1 - begin1, value2, end2 - begin2, *result);
+                return result->size() - old_size;
+            } else {
+                return sorted_intersect(value1, end1 - begin1, value2, end2 - begin2);
+            }
+        }
+        // mixed widths, widen both runs to full keys
+        std::array<RangeElement, ART_LEAF_SIZE> buf1;
+        std::array<RangeElement, ART_LEAF_SIZE> buf2;
+        leaf_decode(leaf1, begin1, end1, buf1.data());
+        leaf_decode(leaf2, begin2, end2, buf2.data());
+        if constexpr (COLLECT) {
+            auto old_size = result->size();
+            sorted_intersect(buf1.data(), end1 - begin1, buf2.data(), end2 - begin2, *result);
+            return result->size() - old_size;
+        } else {
+            return sorted_intersect(buf1.data(), end1 - begin1, buf2.data(), end2 - begin2);
+        }
+    }
+
+    uint64_t leaf_run_intersect(const ARTLeaf* leaf1, uint16_t begin1, uint16_t end1, const ARTLeaf* leaf2, uint16_t begin2, uint16_t end2) {
+        return leaf_run_intersect_impl<false>(leaf1, begin1, end1, leaf2, begin2, end2, nullptr);
+    }
+
+    void leaf_run_intersect(const ARTLeaf* leaf1, uint16_t begin1, uint16_t end1, const ARTLeaf* leaf2, uint16_t begin2, uint16_t end2, std::vector<uint64_t>& result) {
+        leaf_run_intersect_impl<true>(leaf1, begin1, end1, leaf2, begin2, end2, &result);
+    }
+}
@@ -10,6 +10,22 @@
 
 
 namespace container {
+    ARTNode_4::ARTNode_4() {
+        memory_count(MEMORY_ART_NODE4, sizeof(ARTNode_4));
+    }
+
+    ARTNode_4::~ARTNode_4() {
+        memory_count(MEMORY_ART_NODE4, -(int64_t) sizeof(ARTNode_4));
+    }
+
+    ARTNode_16::ARTNode_16() {
+        memory_count(MEMORY_ART_NODE16, sizeof(ARTNode_16));
+    }
+
+    ARTNode_16::~ARTNode_16() {
+        memory_count(MEMORY_ART_NODE16, -(int64_t) sizeof(ARTNode_16));
+    }
+
     ARTNode *alloc_node(uint8_t type, ARTKey prefix, uint8_t depth, WriterTraceBlock* trace_block) {
         ARTNode *n;
         switch (type) {
@@ -53,7 +69,22 @@ namespace container {
             iter_next(iter);
         }
         destroy_iterator(iter);
-        delete n;
+        switch (n->type) {
+            case NODE4:
+                delete (ARTNode_4 *) n;
+                break;
+            case NODE16:
+                delete (ARTNode_16 *) n;
+                break;
+            case NODE48:
+                release_art_node48((ARTNode_48 *) n);
+                break;
+            case NODE256:
+                release_art_node256((ARTNode_256 *) n);
+                break;
+            default:
+                throw std::runtime_error("recursive_destroy_node(): Invalid node type");
+        }
     }
 
     void delete_node(ARTNode *n, WriterTraceBlock* trace_block) {
@@ -1,6 +1,7 @@
 #include <set>
 #include "include/art_node_ops.h"
 #include "include/art_iter.h"
+#include "utils/intersect/include/intersect.h"
 
 namespace container {
     void node_ref(ARTNode* node) {
@@ -1352,97 +1353,79 @@ namespace container {
 
     void node_range_intersect(ARTNode* node, RangeElement* range, uint16_t range_size, std::vector<uint64_t>& result) {
         uint16_t cur_idx1 = 0;
-        uint64_t range_last_element = range[range_size - 1];
-//        ARTIterator iter{node};
-        ARTLeaf* node_leaf = nullptr;
+        std::array<RangeElement, ART_LEAF_SIZE> leaf_buf;
 
         while(cur_idx1 < range_size) {
-            node_leaf = node_search(node, ARTKey(range[cur_idx1]));
-            if(!node_leaf) {
+            auto raw_leaf = node_search(node, ARTKey(range[cur_idx1]));
+            if(!raw_leaf) {
                 cur_idx1 += 1;
                 continue;
             }
-            uint16_t size2 = node_leaf->size;
-            if(node_leaf->at(size2 - 1) >= range[cur_idx1]) {
-                uint16_t cur_idx2 = 0;
-                while(cur_idx1 < range_size && cur_idx2 < size2) {
-                    if(range[cur_idx1] == node_leaf->at(cur_idx2)) {
-                        result.push_back(range[cur_idx1]);
-                        cur_idx1 += 1;
-                        cur_idx2 += 1;
-                    } else if(range[cur_idx1] < node_leaf->at(cur_idx2)) {
-                        cur_idx1 += 1;
-                    } else {
-                        cur_idx2 += 1;
-                    }
-                }
+            auto node_leaf = LEAF_RAW(raw_leaf);
+            uint16_t leaf_start = GET_OFFSET(raw_leaf);
+            uint16_t size2 = node_leaf->size - leaf_start;
+            leaf_decode(node_leaf, leaf_start, node_leaf->size, leaf_buf.data());
+            if(leaf_buf[size2 - 1] < range[cur_idx1]) {
+                cur_idx1 += 1;
+                continue;
             }
+            // consume every element of range that is covered by the rest of the leaf
+            uint16_t range_end = std::upper_bound(range + cur_idx1, range + range_size, leaf_buf[size2 - 1]) - range;
+            sorted_intersect(range + cur_idx1, range_end - cur_idx1, leaf_buf.data(), size2, result);
+            cur_idx1 = range_end;
         }
     }
 
     void leaf_intersect(ARTLeaf* leaf1, uint8_t leaf_start1, ARTLeaf* leaf2, uint8_t leaf_start2, std::vector<uint64_t>& result) {
-        auto size1 = leaf1->size;
-        auto size2 = leaf2->size;
-        uint16_t cur_idx1 = leaf_start1;
-        uint16_t cur_idx2 = leaf_start2;
-        uint8_t byte1 = get_key_byte(leaf1->at(cur_idx1), leaf1->depth);
-        uint8_t byte2 = get_key_byte(leaf2->at(cur_idx2), leaf2->depth);
-
-        while(cur_idx1 < size1 && cur_idx2 < size2) {
-            if(byte1 != get_key_byte(leaf1->at(cur_idx1), leaf1->depth)) {
-                break;
-            }
-            if(byte2 != get_key_byte(leaf2->at(cur_idx2), leaf2->depth)) {
-                break;
-            }
-            if(leaf1->at(cur_idx1) == leaf2->at(cur_idx2)) {
-                result.push_back(leaf1->at(cur_idx1));
-                cur_idx1 += 1;
-                cur_idx2 += 1;
-            } else if(leaf1->at(cur_idx1) < leaf2->at(cur_idx2)) {
-                cur_idx1 += 1;
-            } else {
-                cur_idx2 += 1;
-            }
-        }
+        leaf_run_intersect(leaf1, leaf_start1, leaf_run_end(leaf1, leaf_start1), leaf2, leaf_start2, leaf_run_end(leaf2, leaf_start2), result);
     }
 
     void node_leaf_intersect(ARTNode* node, ARTLeaf* leaf, uint8_t leaf_start, std::vector<uint64_t>& result) {
-        uint16_t size1 = leaf->size;
-        uint8_t byte1 = get_key_byte(leaf->at(leaf_start), leaf->depth);
-        uint64_t leaf_last_element = leaf->at(size1 - 1);
-        uint16_t cur_idx1 = leaf_start;
-        ARTLeaf* node_leaf = nullptr;
-
-//        ARTIterator iter{node};
-        while(cur_idx1 < size1) {
-            if(byte1 != get_key_byte(leaf->at(cur_idx1), leaf->depth)) {
+        std::array<RangeElement, ART_LEAF_SIZE> run;
+        uint16_t run_size = leaf_run_end(leaf, leaf_start) - leaf_start;
+        leaf_decode(leaf, leaf_start, leaf_start + run_size, run.data());
+        node_range_intersect(node, run.data(), run_size, result);
+    }
+
+    Bitmap<4> node_child_bitmap(const ARTNode* node) {
+        Bitmap<4> res;
+        switch (node->type) {
+            case NODE4: {
+                auto node4 = (ARTNode_4*)node;
+                for(int i = 0; i < node->num_children; i++) {
+                    res.set(node4->keys[i]);
+                }
                 break;
             }
-            auto raw_leaf = node_search(node, ARTKey(leaf->at(cur_idx1)));
-            if(!raw_leaf) {
-                cur_idx1 += 1;
-                continue;
+            case NODE16: {
+                auto node16 = (ARTNode_16*)node;
+                for(int i = 0; i < node->num_children; i++) {
+                    res.set(node16->keys[i]);
+                }
+                break;
             }
-            node_leaf = LEAF_RAW(raw_leaf);
-            uint16_t size2 = node_leaf->size;
-            if(node_leaf->at(size2 - 1) >= leaf->at(cur_idx1)) {
-                uint16_t cur_idx2 = GET_OFFSET(raw_leaf);
-                while(cur_idx1 < size1 && cur_idx2 < size2) {
-                    if(leaf->at(cur_idx1) == node_leaf->at(cur_idx2)) {
-                        result.push_back(leaf->at(cur_idx1));
-                        cur_idx1 += 1;
-                        cur_idx2 += 1;
-                    } else if(leaf->at(cur_idx1) < node_leaf->at(cur_idx2)) {
-                        cur_idx1 += 1;
-                    } else {
-                        cur_idx2 += 1;
-                    }
+            case NODE48: {
+                // a non-zero key slot marks an occupied byte, 64 slots per compare
+                auto node48 = (ARTNode_48*)node;
+                for(int i = 0; i < 4; i++) {
+                    __m512i keys = _mm512_loadu_si512(node48->keys + i * 64);
+                    res.data[i] = _mm512_test_epi8_mask(keys, keys);
                 }
-            } else {
-                cur_idx1 += 1;
+                break;
+            }
+            case NODE256: {
+                auto node256 = (ARTNode_256*)node;
+                for(int i = 0; i < 32; i++) {
+                    __m512i ptrs = _mm512_loadu_si512(node256->children.data() + i * 8);
+                    res.data[i / 8] |= (uint64_t)_mm512_test_epi64_mask(ptrs, ptrs) << ((i % 8) * 8);
+                }
+                break;
+            }
+            default: {
+                throw std::runtime_error("node_child_bitmap(): Invalid node type");
             }
         }
+        return res;
     }
 
     void node_intersect(ARTNode* node1, ARTNode* node2, std::vector<uint64_t>& result) {
@@ -1467,54 +1450,32 @@ namespace container {
                 }
             }
         } else {
-            auto iter1 = alloc_iterator(node1);
-            auto iter2 = alloc_iterator(node2);
-
-            while (iter1->is_valid() && iter2->is_valid()) {
-                std::pair<uint8_t, ARTNode *> byte_pair1 = iter_get(iter1);
-                std::pair<uint8_t, ARTNode *> byte_pair2 = iter_get(iter2);
-                if (byte_pair1.first < byte_pair2.first) {
-                    iter_next_without_skip(iter1);
-                    continue;
-                } else if (byte_pair1.first > byte_pair2.first) {
-                    iter_next_without_skip(iter2);
-                    continue;
-                }
-                auto child1 = byte_pair1.second;
-                auto child2 = byte_pair2.second;
+            // only descend into the key bytes present in both nodes
+            auto shared = node_child_bitmap(node1) & node_child_bitmap(node2);
+            shared.for_each([&](uint64_t byte) {
+                auto child1 = *find_child(node1, byte);
+                auto child2 = *find_child(node2, byte);
                 if(IS_LEAF(child1)) {
                     if(IS_LEAF(child2)) {
                         leaf_intersect(LEAF_RAW(child1), GET_OFFSET(child1), LEAF_RAW(child2), GET_OFFSET(child2), result);
-                        iter_next_without_skip(iter1);
-                        iter_next_without_skip(iter2);
                     } else {
                         node_leaf_intersect(child2, LEAF_RAW(child1), GET_OFFSET(child1), result);
-                        iter_next_without_skip(iter1);
-                        iter_next(iter2);
                     }
                 } else {
                     if(IS_LEAF(child2)) {
                         node_leaf_intersect(child1, LEAF_RAW(child2), GET_OFFSET(child2), result);
-                        iter_next_without_skip(iter2);
-                        iter_next(iter1);
                     } else {
                         node_intersect(child1, child2, result);
-                        iter_next(iter1);
-                        iter_next(iter2);
                     }
                 }
-            }
-            destroy_iterator(iter1);
-            destroy_iterator(iter2);
+            });
         }
     }
 
     uint64_t node_range_intersect(ARTNode* node, RangeElement* range, uint16_t range_size) {
         uint16_t cur_idx1 = 0;
-        uint64_t range_last_element = range[range_size - 1];
-//        ARTIterator iter{node};
-        ARTLeaf* node_leaf = nullptr;
         uint64_t res = 0;
+        std::array<RangeElement, ART_LEAF_SIZE> leaf_buf;
 
         while(cur_idx1 < range_size) {
             auto raw_leaf = node_search(node, ARTKey(range[cur_idx1]));
@@ -1522,95 +1483,30 @@ namespace container {
                 cur_idx1 += 1;
                 continue;
             }
-            node_leaf = LEAF_RAW(raw_leaf);
-            uint16_t size2 = node_leaf->size;
-            if(node_leaf->at(size2 - 1) >= range[cur_idx1]) {
-                uint16_t cur_idx2 = GET_OFFSET(raw_leaf);
-                while(cur_idx1 < range_size && cur_idx2 < size2) {
-                    if(range[cur_idx1] == node_leaf->at(cur_idx2)) {
-                        res += 1;
-                        cur_idx1 += 1;
-                        cur_idx2 += 1;
-                    } else if(range[cur_idx1] < node_leaf->at(cur_idx2)) {
-                        cur_idx1 += 1;
-                    } else {
-                        cur_idx2 += 1;
-                    }
-                }
-            } else {
+            auto node_leaf = LEAF_RAW(raw_leaf);
+            uint16_t leaf_start = GET_OFFSET(raw_leaf);
+            uint16_t size2 = node_leaf->size - leaf_start;
+            leaf_decode(node_leaf, leaf_start, node_leaf->size, leaf_buf.data());
+            if(leaf_buf[size2 - 1] < range[cur_idx1]) {
                 cur_idx1 += 1;
+                continue;
             }
+            uint16_t range_end = std::upper_bound(range + cur_idx1, range + range_size, leaf_buf[size2 - 1]) - range;
+            res += sorted_intersect(range + cur_idx1, range_end - cur_idx1, leaf_buf.data(), size2);
+            cur_idx1 = range_end;
         }
         return res;
     }
 
     uint64_t leaf_intersect(ARTLeaf* leaf1, uint8_t leaf_start1, ARTLeaf* leaf2, uint8_t leaf_start2) {
-        auto size1 = leaf1->size;
-        auto size2 = leaf2->size;
-        uint16_t cur_idx1 = leaf_start1;
-        uint16_t cur_idx2 = leaf_start2;
-        uint8_t byte1 = get_key_byte(leaf1->at(cur_idx1), leaf1->depth);
-        uint8_t byte2 = get_key_byte(leaf2->at(cur_idx2), leaf2->depth);
-        uint64_t res = 0;
-
-        while(cur_idx1 < size1 && cur_idx2 < size2) {
-            if(byte1 != get_key_byte(leaf1->at(cur_idx1), leaf1->depth)) {
-                break;
-            }
-            if(byte2 != get_key_byte(leaf2->at(cur_idx2), leaf2->depth)) {
-                break;
-            }
-            if(leaf1->at(cur_idx1) == leaf2->at(cur_idx2)) {
-                res += 1;
-                cur_idx1 += 1;
-                cur_idx2 += 1;
-            } else if(leaf1->at(cur_idx1) < leaf2->at(cur_idx2)) {
-                cur_idx1 += 1;
-            } else {
-                cur_idx2 += 1;
-            }
-        }
-        return res;
+        return leaf_run_intersect(leaf1, leaf_start1, leaf_run_end(leaf1, leaf_start1), leaf2, leaf_start2, leaf_run_end(leaf2, leaf_start2));
     }
 
     uint64_t node_leaf_intersect(ARTNode* node, ARTLeaf* leaf, uint8_t leaf_start) {
-        uint16_t size1 = leaf->size;
-        uint8_t byte1 = get_key_byte(leaf->at(leaf_start), leaf->depth);
-        uint64_t leaf_last_element = leaf->at(size1 - 1);
-        uint16_t cur_idx1 = leaf_start;
-        uint64_t res = 0;
-        ARTLeaf* node_leaf = nullptr;
-
-//        ARTIterator iter{node};
-        while(cur_idx1 < size1) {
-            if(byte1 != get_key_byte(leaf->at(cur_idx1), leaf->depth)) {
-                break;
-            }
-            auto raw_leaf = node_search(node, ARTKey(leaf->at(cur_idx1)));
-            if(!raw_leaf) {
-                cur_idx1 += 1;
-                continue;
-            }
-            node_leaf = LEAF_RAW(raw_leaf);
-            uint16_t size2 = node_leaf->size;
-            if(node_leaf->at(size2 - 1) >= leaf->at(cur_idx1)) {
-                uint16_t cur_idx2 = GET_OFFSET(raw_leaf);
-                while(cur_idx1 < size1 && cur_idx2 < size2) {
-                    if(leaf->at(cur_idx1) == node_leaf->at(cur_idx2)) {
-                        res += 1;
-                        cur_idx1 += 1;
-                        cur_idx2 += 1;
-                    } else if(leaf->at(cur_idx1) < node_leaf->at(cur_idx2)) {
-                        cur_idx1 += 1;
-                    } else {
-                        cur_idx2 += 1;
-                    }
-                }
-            } else {
-                cur_idx1 += 1;
-            }
-        }
-        return res;
+        std::array<RangeElement, ART_LEAF_SIZE> run;
+        uint16_t run_size = leaf_run_end(leaf, leaf_start) - leaf_start;
+        leaf_decode(leaf, leaf_start, leaf_start + run_size, run.data());
+        return node_range_intersect(node, run.data(), run_size);
     }
 
     uint64_t node_intersect(ARTNode* node1, ARTNode* node2) {
@@ -1636,45 +1532,31 @@ namespace container {
                 }
             }
         } else {
-            auto iter1 = alloc_iterator(node1);
-            auto iter2 = alloc_iterator(node2);
-
-            while (iter1->is_valid() && iter2->is_valid()) {
-                std::pair<uint8_t, ARTNode *> byte_pair1 = iter_get(iter1);
-                std::pair<uint8_t, ARTNode *> byte_pair2 = iter_get(iter2);
-                if (byte_pair1.first < byte_pair2.first) {
-                    iter_next_without_skip(iter1);
-                    continue;
-                } else if (byte_pair1.first > byte_pair2.first) {
-                    iter_next_without_skip(iter2);
-                    continue;
-                }
-                auto child1 = byte_pair1.second;
-                auto child2 = byte_pair2.second;
+            auto shared = node_child_bitmap(node1) & node_child_bitmap(node2);
+            shared.for_each([&](uint64_t byte) {
+                auto child1 = *find_child(node1, byte);
+                auto child2 = *find_child(node2, byte);
                 if(IS_LEAF(child1)) {
                     if(IS_LEAF(child2)) {
+                        auto leaf1 = LEAF_RAW(child1);
+                        auto leaf2 = LEAF_RAW(child2);
+                        if(leaf1->type == LEAF8 && leaf2->type == LEAF8 && leaf1->is_single_byte && leaf2->is_single_byte) {
+                            // the whole leaf is the run, AND the low-byte bitmaps directly
+                            res += (((ARTLeaf8*)leaf1)->value & ((ARTLeaf8*)leaf2)->value).count();
+                            return;
+                        }
                         res += leaf_intersect(LEAF_RAW(child1), GET_OFFSET(child1), LEAF_RAW(child2), GET_OFFSET(child2));
-                        iter_next_without_skip(iter1);
-                        iter_next_without_skip(iter2);
                     } else {
                         res += node_leaf_intersect(child2, LEAF_RAW(child1), GET_OFFSET(child1));
-                        iter_next_without_skip(iter1);
-                        iter_next(iter2);
                     }
                 } else {
                     if(IS_LEAF(child2)) {
                         res += node_leaf_intersect(child1, LEAF_RAW(child2), GET_OFFSET(child2));
-                        iter_next_without_skip(iter2);
-                        iter_next(iter1);
                     } else {
                         res += node_intersect(child1, child2);
-                        iter_next(iter1);
-                        iter_next(iter2);
                     }
                 }
-            }
-            destroy_iterator(iter1);
-            destroy_iterator(iter2);
+            });
         }
         return res;
     }
@@ -1878,6 +1760,18 @@ namespace container {
         uint64_t list_idx = 0;
         uint64_t leaf_ed = leaf_idx + leaf_count;
         uint64_t total_count = leaf_count + list_count;
+        // elements already in the leaf are merged, they must not push a last-byte leaf into a new node
+        for(uint64_t i = leaf_idx, j = 0; i < leaf_ed && j < list_count;) {
+            if(leaf->at(i) < insert_list[j]) {
+                i++;
+            } else if(leaf->at(i) > insert_list[j]) {
+                j++;
+            } else {
+                total_count -= 1;
+                i++;
+                j++;
+            }
+        }
 
         if(new_leaf == nullptr || new_leaf->size + total_count > ART_LEAF_SIZE) {
             if(total_count > ART_LEAF_SIZE) { // new node
@@ -2031,7 +1925,7 @@ namespace container {
             cur_leaf_st = cur_leaf_ed;
         }
 
-        return 0;
+        return inserted;
     }
 
     void add_list_segment_to_new_leaf (ARTNode** new_node, ARTLeaf* &new_leaf, uint8_t depth, RangeElement* elem_list, Property_t** prop_list, uint64_t count, uint8_t cur_byte, WriterTraceBlock* trace_block) {
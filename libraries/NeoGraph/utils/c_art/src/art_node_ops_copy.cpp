@@ -1048,7 +1048,6 @@ namespace container {
         }
 
         if(cur_list_ed < list_size) {
-            inserted += list_size - cur_list_st;
             ARTLeaf* new_leaf = nullptr;
             while(cur_list_ed < list_size) {
                 cur_list_byte = get_key_byte(elem_list[cur_list_st], depth);
@@ -4,18 +4,38 @@
 #include <cstdint>
 
 // For NeoGraph
-#define VERTEX_GROUP_BITS 6
-constexpr uint64_t VERTEX_GROUP_SIZE = 1 << VERTEX_GROUP_BITS;
-constexpr uint64_t VERTEX_GROUP_MASK = (1 << VERTEX_GROUP_BITS) - 1;
-constexpr uint64_t INDEPENDENT_MAP_BLOCK_NUM = (VERTEX_GROUP_SIZE + 63) / 64;
-#define RANGE_LEAF_SIZE 512 // 512 by default
-#define ART_EXTRACT_THRESHOLD 8192  // 8192 by default
+#define MAX_VERTEX_GROUP_BITS 8 // largest log2 of the vertices per tree a NeoLayout may ask for, sizes the vertex maps
+constexpr uint64_t MAX_VERTEX_GROUP_SIZE = 1 << MAX_VERTEX_GROUP_BITS;
+constexpr uint64_t INDEPENDENT_MAP_BLOCK_NUM = (MAX_VERTEX_GROUP_SIZE + 63) / 64;
+#define VERTEX_MAP_CHUNK_BITS 6 // log2 of the vertex map entries a new tree version copies on its first write to them, at most the vertex_group_bits of any layout
+constexpr uint64_t VERTEX_MAP_CHUNK_SIZE = 1 << VERTEX_MAP_CHUNK_BITS;
+constexpr uint64_t VERTEX_MAP_CHUNK_MASK = VERTEX_MAP_CHUNK_SIZE - 1;
+constexpr uint64_t VERTEX_MAP_CHUNK_NUM = MAX_VERTEX_GROUP_SIZE >> VERTEX_MAP_CHUNK_BITS;
+#define RANGE_LEAF_SIZE 512 // capacity of a segment, the range_leaf_size of a layout is at most this
+#define LAYOUT_SPARSE_DEGREE 8 // choose_layout() lays out graphs of lower average degree as sparse
+#define LAYOUT_SKEWED_RATIO 1024 // and graphs whose max degree is this many times their average as skewed
 #define ART_LEAF_SIZE 256 // 16 * 16
 #define SEQUENTIAL_SCAN_THRESHOLD 16
+#define INTERSECT_GALLOPING_RATIO 32 // switch to galloping when |large| >= ratio * |small|
+#define INTERSECT_SIMD_THRESHOLD 16 // minimal size of the smaller side for the block merge
 #define EDGE_INSERT_VEC_THRESHOLD 0.8
 #define BATCH_UPDATE_THRESHOLD (1 << 2)
-#define INIT_READER_NUM 32
-#define INIT_WRITER_NUM 64
+#define FOREST_CHUNK_BITS 10 // log2 of the trees per chunk of the forest directory, chunks never move once published
+constexpr uint64_t FOREST_CHUNK_SIZE = 1 << FOREST_CHUNK_BITS;
+constexpr uint64_t FOREST_CHUNK_MASK = (1 << FOREST_CHUNK_BITS) - 1;
+#define FOREST_INIT_CHUNK_NUM 64 // initial capacity of the chunk pointer array, it is doubled when full
+#define SPIN_BACKOFF_LIMIT 1024 // pause instructions a spinning waiter doubles up to before it blocks or yields
+#define INIT_READER_NUM 32 // reader blocks per chunk of a reader shard, a full shard grows by one chunk
+#define READER_SHARD_NUM 64 // readers register in the shard of the core they run on
+#define INIT_WRITER_NUM (64 + BATCH_UPDATE_THREAD_NUM) // writer blocks, the workers of the batch update pool hold one each
+#define COMMIT_RING_BITS 12 // log2 of the finished timestamps in flight, a writer that would lap the ring waits for it
+constexpr uint64_t COMMIT_RING_SIZE = 1 << COMMIT_RING_BITS;
+constexpr uint64_t COMMIT_RING_MASK = (1 << COMMIT_RING_BITS) - 1;
+#define GROUP_COMMIT_ENABLE 1 // single-edge inserts queued on a locked tree are committed by its holder as one version
+#define VERTEX_DICT_CHUNK_BITS 16 // log2 of the internal IDs per chunk of the reverse array of NeoVertexDictionary
+constexpr uint64_t VERTEX_DICT_CHUNK_SIZE = 1 << VERTEX_DICT_CHUNK_BITS;
+constexpr uint64_t VERTEX_DICT_CHUNK_MASK = VERTEX_DICT_CHUNK_SIZE - 1;
+#define VERTEX_DICT_MAX_CHUNK_NUM (1 << 16) // chunks of the reverse array, bounds the internal IDs a dictionary can hand out
 // For Property
 #define VERTEX_PROPERTY_NUM 0
 #define EDGE_PROPERTY_NUM 1
@@ -25,7 +45,29 @@ constexpr uint64_t INDEPENDENT_MAP_BLOCK_NUM = (VERTEX_GROUP_SIZE + 63) / 64;
 #define SIMULATE_PER_EDGE_VERSIONING_ENABLE 0
 // For segment pool
 #define SEGMENT_POOL_INIT_SIZE 256
+#define SLAB_SIZE (1 << 21) // bytes of a slab of the writer pools, one huge page
+#define SLAB_MAGAZINE_SIZE 32 // free objects moved between a writer cache and the depot at once
+#define SLAB_OBJECT_ALIGN 64 // objects of a slab start on a cache line
+#define MEMORY_COUNTER_SHARD_NUM 64 // shards of the memory_report counters, threads are spread over them round-robin
 #define BATCH_UPDATE_THREAD_NUM 31
 #define BATCH_UPDATE_ENABLE_THRESHOLD 32
+#define BATCH_UPDATE_GRAIN 1024 // updates below which consecutive trees of a batch are handed to the pool as one task
+#define NUMA_TREE_SHARD_BITS 4 // log2 of the consecutive trees sharing a home node when built with NEO_NUMA
+// For adaptive representation
+#define ADAPTIVE_LAYOUT_ENABLE 1 // sample the accesses of each vertex and move it between representations during GC
+#define ADAPTIVE_SAMPLE_RATE 64 // a thread records one of this many accesses
+#define ADAPTIVE_COUNTER_BITS 10 // width of each saturating access counter of a vertex
+#define ADAPTIVE_MIN_SAMPLES 32 // samples a vertex gathers before it is classified again
+#define ADAPTIVE_DOMINANT_PERCENT 60 // share of the samples an access kind needs to give a vertex its profile
+#define ADAPTIVE_HYSTERESIS_PERCENT 20 // a vertex keeps its profile until the share drops this much below the dominant one
+#define ADAPTIVE_THRESHOLD_FACTOR 4 // a profile scales the promotion degrees it favours by this
+#define ADAPTIVE_HYSTERESIS_RATIO 2 // a vertex is demoted once its degree falls below promotion degree / ratio
+#define ADAPTIVE_MIN_PROMOTE_DEGREE 32 // no profile leaves the clustered segments below this degree
+#define REPRESENTATION_DEMOTE_ENABLE 1 // move a shrinking ART back to a RangeTree and a RangeTree back to the clustered segments
+// For edge expiration
+#define EDGE_TTL_ENABLE (EDGE_PROPERTY_NUM == 1) // once a TTL is set on an unweighted graph, the single edge property of an inserted edge holds its insertion epoch
+// For write-ahead log
+#define WAL_BUFFER_SIZE 1024 // records buffered per writer before they are handed off to the log
+#define WAL_GROUP_COMMIT_SIZE (1 << 16) // handed-off records that force a group flush without a waiting committer
 
 #define VERSION_HEAD_MASK 0x8000000000000000
\ No newline at end of file
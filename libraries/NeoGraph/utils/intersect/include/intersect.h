@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <immintrin.h>
+#include "../../config.h"
+
+namespace container {
+    // Set intersection kernels over sorted, duplicate-free uint32_t arrays.
+    // Every kernel comes in two flavours: the count-only one returns the size of the intersection,
+    // the collecting one appends the common elements (in ascending order) to result.
+
+    ///@brief plain two-pointer merge, used for tiny inputs and for the tails of the SIMD kernels
+    uint64_t scalar_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size);
+
+    void scalar_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result);
+
+    ///@brief all-pairs 16x16 block comparison: the block of b is rotated with vpermd and compared against the block of a,
+    /// then the side with the smaller block maximum advances. Suited for inputs of similar size.
+    uint64_t simd_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size);
+
+    void simd_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result);
+
+    ///@brief for each element of the smaller array a, gallop over 16-element blocks of the larger array b and probe the
+    /// located block with a single 512-bit compare. Suited for inputs with a skewed size ratio.
+    uint64_t simd_galloping_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size);
+
+    void simd_galloping_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result);
+
+    ///@brief pick a kernel by the input sizes: galloping once the size ratio reaches INTERSECT_GALLOPING_RATIO,
+    /// block merge when both sides hold at least INTERSECT_SIMD_THRESHOLD elements, scalar merge otherwise
+    uint64_t sorted_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size);
+
+    void sorted_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result);
+
+    ///@brief same dispatch over uint64_t arrays (8 lanes per block), the segments of a NEO_WIDE_VERTEX_ID build
+    uint64_t sorted_intersect(const uint64_t* a, uint64_t a_size, const uint64_t* b, uint64_t b_size);
+
+    void sorted_intersect(const uint64_t* a, uint64_t a_size, const uint64_t* b, uint64_t b_size, std::vector<uint64_t>& result);
+
+    ///@brief same dispatch over uint16_t arrays (32 lanes per block), e.g. the values of a compressed ART leaf
+    uint64_t sorted_intersect(const uint16_t* a, uint64_t a_size, const uint16_t* b, uint64_t b_size);
+
+    ///@param prefix OR-ed into every emitted element to restore the bits stripped from the 16-bit values
+    void sorted_intersect(const uint16_t* a, uint64_t a_size, const uint16_t* b, uint64_t b_size, uint64_t prefix, std::vector<uint64_t>& result);
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include "include/intersect.h"
+
+namespace container {
+    namespace {
+        // lane helpers of a 512-bit register for the supported element widths
+        template<typename T>
+        struct SimdLane;
+
+        template<>
+        struct SimdLane<uint32_t> {
+            static constexpr uint64_t LANES = 16;
+            static __m512i set1(uint32_t v) { return _mm512_set1_epi32((int)v); }
+            static __m512i lane_idx() { return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+            static __m512i rotate_idx(__m512i idx) { return _mm512_and_si512(_mm512_add_epi32(idx, _mm512_set1_epi32(1)), _mm512_set1_epi32(LANES - 1)); }
+            static __m512i permute(__m512i idx, __m512i v) { return _mm512_permutexvar_epi32(idx, v); }
+            static uint64_t cmpeq(__m512i a, __m512i b) { return _mm512_cmpeq_epi32_mask(a, b); }
+        };
+
+        template<>
+        struct SimdLane<uint64_t> {
+            static constexpr uint64_t LANES = 8;
+            static __m512i set1(uint64_t v) { return _mm512_set1_epi64((long long)v); }
+            static __m512i lane_idx() { return _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7); }
+            static __m512i rotate_idx(__m512i idx) { return _mm512_and_si512(_mm512_add_epi64(idx, _mm512_set1_epi64(1)), _mm512_set1_epi64(LANES - 1)); }
+            static __m512i permute(__m512i idx, __m512i v) { return _mm512_permutexvar_epi64(idx, v); }
+            static uint64_t cmpeq(__m512i a, __m512i b) { return _mm512_cmpeq_epi64_mask(a, b); }
+        };
+
+        template<>
+        struct SimdLane<uint16_t> {
+            static constexpr uint64_t LANES = 32;
+            static __m512i set1(uint16_t v) { return _mm512_set1_epi16((short)v); }
+            static __m512i lane_idx() {
+                return _mm512_set_epi16(31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16,
+                                        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            }
+            static __m512i rotate_idx(__m512i idx) { return _mm512_and_si512(_mm512_add_epi16(idx, _mm512_set1_epi16(1)), _mm512_set1_epi16(LANES - 1)); }
+            static __m512i permute(__m512i idx, __m512i v) { return _mm512_permutexvar_epi16(idx, v); }
+            static uint64_t cmpeq(__m512i a, __m512i b) { return _mm512_cmpeq_epi16_mask(a, b); }
+        };
+
+        template<typename T, bool COLLECT>
+        uint64_t scalar_merge_impl(const T* a, uint64_t a_size, const T* b, uint64_t b_size, uint64_t prefix, std::vector<uint64_t>* result) {
+            uint64_t idx1 = 0;
+            uint64_t idx2 = 0;
+            uint64_t res = 0;
+            while(idx1 < a_size && idx2 < b_size) {
+                if(a[idx1] == b[idx2]) {
+                    if constexpr (COLLECT) {
+                        result->push_back(a[idx1] | prefix);
+                    }
+                    res++;
+                    idx1++;
+                    idx2++;
+                } else if(a[idx1] < b[idx2]) {
+                    idx1++;
+                } else {
+                    idx2++;
+                }
+            }
+            return res;
+        }
+
+        template<typename T, bool COLLECT>
+        uint64_t simd_merge_impl(const T* a, uint64_t a_size, const T* b, uint64_t b_size, uint64_t prefix, std::vector<uint64_t>* result) {
+            using Lane = SimdLane<T>;
+            constexpr uint64_t LANES = Lane::LANES;
+            uint64_t idx1 = 0;
+            uint64_t idx2 = 0;
+            uint64_t res = 0;
+            const __m512i lane_idx = Lane::lane_idx();
+            while(idx1 + LANES <= a_size && idx2 + LANES <= b_size) {
+                T a_max = a[idx1 + LANES - 1];
+                T b_max = b[idx2 + LANES - 1];
+                // disjoint blocks, skip without comparing
+                if(a_max < b[idx2]) {
+                    idx1 += LANES;
+                    continue;
+                }
+                if(b_max < a[idx1]) {
+                    idx2 += LANES;
+                    continue;
+                }
+                __m512i va = _mm512_loadu_si512(a + idx1);
+                __m512i vb = _mm512_loadu_si512(b + idx2);
+                __m512i rotate = lane_idx;
+                uint64_t mask = Lane::cmpeq(va, vb);
+                for(uint64_t r = 1; r < LANES; r++) {
+                    rotate = Lane::rotate_idx(rotate);
+                    mask |= Lane::cmpeq(va, Lane::permute(rotate, vb));
+                }
+                res += __builtin_popcountll(mask);
+                if constexpr (COLLECT) {
+                    while(mask) {
+                        result->push_back(a[idx1 + __builtin_ctzll(mask)] | prefix);
+                        mask &= mask - 1;
+                    }
+                }
+                if(a_max <= b_max) {
+                    idx1 += LANES;
+                }
+                if(b_max <= a_max) {
+                    idx2 += LANES;
+                }
+            }
+            return res + scalar_merge_impl<T, COLLECT>(a + idx1, a_size - idx1, b + idx2, b_size - idx2, prefix, result);
+        }
+
+        template<typename T, bool COLLECT>
+        uint64_t simd_galloping_impl(const T* a, uint64_t a_size, const T* b, uint64_t b_size, uint64_t prefix, std::vector<uint64_t>* result) {
+            using Lane = SimdLane<T>;
+            constexpr uint64_t LANES = Lane::LANES;
+            uint64_t idx2 = 0;
+            uint64_t res = 0;
+            for(uint64_t idx1 = 0; idx1 < a_size && idx2 < b_size; idx1++) {
+                T target = a[idx1];
+                if(b[std::min(idx2 + LANES - 1, b_size - 1)] < target) {
+                    // b[lo] < target holds throughout, the search window is (lo, lo + bound]
+                    uint64_t lo = idx2;
+                    uint64_t bound = LANES;
+                    while(lo + bound < b_size && b[lo + bound] < target) {
+                        lo += bound;
+                        bound <<= 1;
+                    }
+                    idx2 = std::lower_bound(b + lo + 1, b + std::min(lo + bound + 1, b_size), target) - b;
+                    if(idx2 == b_size) {
+                        break;
+                    }
+                }
+                // target can only be located within b[idx2, idx2 + LANES)
+                bool found;
+                if(idx2 + LANES <= b_size) {
+                    found = Lane::cmpeq(Lane::set1(target), _mm512_loadu_si512(b + idx2)) != 0;
+                } else {
+                    found = std::binary_search(b + idx2, b + b_size, target);
+                }
+                if(found) {
+                    if constexpr (COLLECT) {
+                        result->push_back(target | prefix);
+                    }
+                    res++;
+                }
+            }
+            return res;
+        }
+
+        template<typename T, bool COLLECT>
+        uint64_t sorted_intersect_impl(const T* a, uint64_t a_size, const T* b, uint64_t b_size, uint64_t prefix, std::vector<uint64_t>* result) {
+            if(a_size == 0 || b_size == 0) {
+                return 0;
+            }
+            if(a_size > b_size) {
+                std::swap(a, b);
+                std::swap(a_size, b_size);
+            }
+            if(b_size >= a_size * INTERSECT_GALLOPING_RATIO) {
+                return simd_galloping_impl<T, COLLECT>(a, a_size, b, b_size, prefix, result);
+            }
+            if(a_size >= INTERSECT_SIMD_THRESHOLD) {
+                return simd_merge_impl<T, COLLECT>(a, a_size, b, b_size, prefix, result);
+            }
+            return scalar_merge_impl<T, COLLECT>(a, a_size, b, b_size, prefix, result);
+        }
+    }
+
+    uint64_t scalar_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size) {
+        return scalar_merge_impl<uint32_t, false>(a, a_size, b, b_size, 0, nullptr);
+    }
+
+    void scalar_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result) {
+        scalar_merge_impl<uint32_t, true>(a, a_size, b, b_size, 0, &result);
+    }
+
+    uint64_t simd_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size) {
+        return simd_merge_impl<uint32_t, false>(a, a_size, b, b_size, 0, nullptr);
+    }
+
+    void simd_merge_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result) {
+        simd_merge_impl<uint32_t, true>(a, a_size, b, b_size, 0, &result);
+    }
+
+    uint64_t simd_galloping_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size) {
+        return simd_galloping_impl<uint32_t, false>(a, a_size, b, b_size, 0, nullptr);
+    }
+
+    void simd_galloping_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result) {
+        simd_galloping_impl<uint32_t, true>(a, a_size, b, b_size, 0, &result);
+    }
+
+    uint64_t sorted_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size) {
+        return sorted_intersect_impl<uint32_t, false>(a, a_size, b, b_size, 0, nullptr);
+    }
+
+    void sorted_intersect(const uint32_t* a, uint64_t a_size, const uint32_t* b, uint64_t b_size, std::vector<uint64_t>& result) {
+        sorted_intersect_impl<uint32_t, true>(a, a_size, b, b_size, 0, &result);
+    }
+
+    uint64_t sorted_intersect(const uint64_t* a, uint64_t a_size, const uint64_t* b, uint64_t b_size) {
+        return sorted_intersect_impl<uint64_t, false>(a, a_size, b, b_size, 0, nullptr);
+    }
+
+    void sorted_intersect(const uint64_t* a, uint64_t a_size, const uint64_t* b, uint64_t b_size, std::vector<uint64_t>& result) {
+        sorted_intersect_impl<uint64_t, true>(a, a_size, b, b_size, 0, &result);
+    }
+
+    uint64_t sorted_intersect(const uint16_t* a, uint64_t a_size, const uint16_t* b, uint64_t b_size) {
+        return sorted_intersect_impl<uint16_t, false>(a, a_size, b, b_size, 0, nullptr);
+    }
+
+    void sorted_intersect(const uint16_t* a, uint64_t a_size, const uint16_t* b, uint64_t b_size, uint64_t prefix, std::vector<uint64_t>& result) {
+        sorted_intersect_impl<uint16_t, true>(a, a_size, b, b_size, prefix, &result);
+    }
+}
@@ -0,0 +1,20 @@
+#include "memory_counter.h"
+
+namespace container {
+    std::array<MemoryCounterShard, MEMORY_COUNTER_SHARD_NUM> memory_counter_shards;
+
+    uint32_t next_memory_counter_shard() {
+        static std::atomic<uint32_t> next_shard{};
+        return next_shard.fetch_add(1, std::memory_order_relaxed) % MEMORY_COUNTER_SHARD_NUM;
+    }
+
+    std::array<int64_t, MEMORY_CATEGORY_NUM> memory_counted() {
+        std::array<int64_t, MEMORY_CATEGORY_NUM> res{};
+        for(auto &shard: memory_counter_shards) {
+            for(uint64_t i = 0; i < MEMORY_CATEGORY_NUM; i++) {
+                res[i] += shard.bytes[i].load(std::memory_order_relaxed);
+            }
+        }
+        return res;
+    }
+}
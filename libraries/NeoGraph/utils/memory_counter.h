@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "config.h"
+
+namespace container {
+    enum MemoryCategory {
+        MEMORY_CLUSTERED_SEGMENT = 0,   // segments of the clustered range nodes of the versions
+        MEMORY_RANGE_TREE,              // RangeTree objects of the independent vertices
+        MEMORY_RANGE_TREE_SEGMENT,
+        MEMORY_ART_NODE4,
+        MEMORY_ART_NODE16,
+        MEMORY_ART_NODE48,
+        MEMORY_ART_NODE256,
+        MEMORY_ART_LEAF8,               // leaves with their element arrays, by element width
+        MEMORY_ART_LEAF16,
+        MEMORY_ART_LEAF32,
+        MEMORY_ART_LEAF64,
+        MEMORY_PROPERTY_VEC,
+        MEMORY_VERTEX_MAP,              // vertex maps and their chunks
+        MEMORY_VERSION,                 // NeoTreeVersion objects
+        MEMORY_SLAB_USED,               // slab objects handed out, whatever they hold
+        MEMORY_CATEGORY_NUM
+    };
+
+    ///@brief Byte counters of one shard, a thread only ever adds to the shard it was assigned
+    struct alignas(64) MemoryCounterShard {
+        std::array<std::atomic<int64_t>, MEMORY_CATEGORY_NUM> bytes{};
+    };
+
+    extern std::array<MemoryCounterShard, MEMORY_COUNTER_SHARD_NUM> memory_counter_shards;
+
+    uint32_t next_memory_counter_shard();
+
+    ///@brief Add bytes to category, negative when they are freed
+    inline void memory_count(MemoryCategory category, int64_t bytes) {
+        thread_local uint32_t shard = next_memory_counter_shard();
+        memory_counter_shards[shard].bytes[category].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    ///@return the bytes of every category summed over the shards, a snapshot that may miss counts in flight
+    std::array<int64_t, MEMORY_CATEGORY_NUM> memory_counted();
+}
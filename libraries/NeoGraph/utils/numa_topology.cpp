@@ -0,0 +1,31 @@
+#include <algorithm>
+#include "numa_topology.h"
+#include "config.h"
+#ifdef NEO_NUMA
+#include <numa.h>
+#endif
+
+namespace container {
+    uint64_t numa_node_num() {
+#ifdef NEO_NUMA
+        static const uint64_t node_num = numa_available() < 0 ? 1 : std::max(numa_num_configured_nodes(), 1);
+        return node_num;
+#else
+        return 1;
+#endif
+    }
+
+    uint64_t numa_home_node(uint64_t direction) {
+        return (direction >> NUMA_TREE_SHARD_BITS) % numa_node_num();
+    }
+
+    void numa_bind_thread(uint64_t node) {
+#ifdef NEO_NUMA
+        if(numa_node_num() > 1) {
+            numa_run_on_node((int) node);
+            // segments are zeroed by the thread allocating them, so their pages are placed on the node of the writer
+            numa_set_preferred((int) node);
+        }
+#endif
+    }
+}
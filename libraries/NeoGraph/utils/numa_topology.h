@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace container {
+    ///@return the NUMA nodes trees are spread over, 1 unless built with NEO_NUMA and run on a NUMA machine
+    uint64_t numa_node_num();
+
+    ///@return the home node of tree `direction`, runs of 2^NUMA_TREE_SHARD_BITS consecutive trees share one
+    uint64_t numa_home_node(uint64_t direction);
+
+    ///@brief Keep the calling thread on the CPUs of node and take its new pages from node's memory
+    void numa_bind_thread(uint64_t node);
+}
@@ -0,0 +1,136 @@
+#include <sys/mman.h>
+#include <new>
+#include "slab_allocator.h"
+
+namespace container {
+    static std::mutex slab_class_lock;
+
+    ///@brief Every slab class ever created, they are never destroyed since their objects may outlive any static
+    static std::vector<SlabClass*> &slab_classes() {
+        static auto* classes = new std::vector<SlabClass*>();
+        return *classes;
+    }
+
+    SlabClass::SlabClass(const char* name, uint64_t object_size): name(name) {
+        this->object_size = (object_size + SLAB_OBJECT_ALIGN - 1) / SLAB_OBJECT_ALIGN * SLAB_OBJECT_ALIGN;
+        // a slab fills at least one magazine
+        auto min_size = this->object_size * SLAB_MAGAZINE_SIZE;
+        slab_size = (min_size + SLAB_SIZE - 1) / SLAB_SIZE * SLAB_SIZE;
+        std::lock_guard<std::mutex> guard(slab_class_lock);
+        slab_classes().push_back(this);
+    }
+
+    SlabMagazine* SlabClass::take_empty() {
+        if(empties.empty()) {
+            return new SlabMagazine();
+        }
+        auto res = empties.back();
+        empties.pop_back();
+        return res;
+    }
+
+    void SlabClass::grow() {
+        // map twice the size and cut it down to an aligned slab, only aligned regions get huge pages
+        auto size = slab_size + SLAB_SIZE;
+        auto raw = (uint8_t*) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto slab = (uint8_t*) (((uintptr_t) raw + SLAB_SIZE - 1) / SLAB_SIZE * SLAB_SIZE);
+        if(slab != raw) {
+            munmap(raw, slab - raw);
+        }
+        if(raw + size != slab + slab_size) {
+            munmap(slab + slab_size, raw + size - slab - slab_size);
+        }
+        madvise(slab, slab_size, MADV_HUGEPAGE);
+
+        auto num = slab_size / object_size;
+        SlabMagazine* magazine = nullptr;
+        // pushed from the end, so the objects are handed out in address order
+        for(uint64_t i = num; i-- > 0;) {
+            if(magazine == nullptr || magazine->full()) {
+                magazine = take_empty();
+                loaded.push_back(magazine);
+            }
+            magazine->objects[magazine->count++] = (uintptr_t) (slab + i * object_size) | 1;
+        }
+        slab_num++;
+        object_num += num;
+        depot_object_num += num;
+    }
+
+    SlabMagazine* SlabClass::exchange_empty(SlabMagazine* magazine) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(magazine != nullptr) {
+            empties.push_back(magazine);
+        }
+        if(loaded.empty()) {
+            if(loose != nullptr && !loose->empty()) {
+                loaded.push_back(loose);
+                loose = nullptr;
+            } else {
+                grow();
+            }
+        }
+        auto res = loaded.back();
+        loaded.pop_back();
+        depot_object_num -= res->count;
+        exchange_num++;
+        return res;
+    }
+
+    SlabMagazine* SlabClass::exchange_full(SlabMagazine* magazine) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(magazine != nullptr) {
+            loaded.push_back(magazine);
+            depot_object_num += magazine->count;
+        }
+        exchange_num++;
+        return take_empty();
+    }
+
+    void SlabClass::put(SlabMagazine* magazine) {
+        if(magazine == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if(magazine->empty()) {
+            empties.push_back(magazine);
+        } else {
+            loaded.push_back(magazine);
+            depot_object_num += magazine->count;
+        }
+    }
+
+    void SlabClass::release(void* object) {
+        if(object == nullptr) {
+            return;
+        }
+        memory_count(MEMORY_SLAB_USED, -(int64_t) object_size);
+        std::lock_guard<std::mutex> guard(lock);
+        if(loose == nullptr) {
+            loose = take_empty();
+        }
+        loose->objects[loose->count++] = (uintptr_t) object;
+        depot_object_num++;
+        if(loose->full()) {
+            loaded.push_back(loose);
+            loose = nullptr;
+        }
+    }
+
+    SlabStats SlabClass::stats() {
+        std::lock_guard<std::mutex> guard(lock);
+        return SlabStats{name, object_size, slab_size, slab_num, object_num, depot_object_num, exchange_num};
+    }
+
+    std::vector<SlabStats> slab_stats() {
+        std::vector<SlabStats> res;
+        std::lock_guard<std::mutex> guard(slab_class_lock);
+        for(auto slab_class: slab_classes()) {
+            res.push_back(slab_class->stats());
+        }
+        return res;
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "config.h"
+#include "memory_counter.h"
+
+namespace container {
+    ///@brief Stack of up to SLAB_MAGAZINE_SIZE free objects of one SlabClass, the unit objects move in between the
+    /// depot and the writer caches. The low bit of an entry marks an object that was never handed out, its memory is
+    /// still the zero page of a fresh slab.
+    struct SlabMagazine {
+        uint64_t count{};
+        std::array<uintptr_t, SLAB_MAGAZINE_SIZE> objects;
+
+        [[nodiscard]] bool empty() const {
+            return count == 0;
+        }
+
+        [[nodiscard]] bool full() const {
+            return count == SLAB_MAGAZINE_SIZE;
+        }
+    };
+
+    struct SlabStats {
+        const char* name;
+        uint64_t object_size;       // bytes an object takes in its slab
+        uint64_t slab_size;
+        uint64_t slab_num;          // slabs mapped, never given back
+        uint64_t object_num;        // objects carved from the slabs
+        uint64_t depot_object_num;  // free objects in the depot, the rest is in use or cached by a writer
+        uint64_t exchange_num;      // magazines exchanged between the depot and the writer caches
+    };
+
+    ///@brief Objects of one size carved from SLAB_SIZE huge-page-backed slabs.
+    /// The free objects live in magazines; the depot keeps the loaded and the empty ones under a mutex, the writers
+    /// keep a SlabCache each and only come to the depot to exchange a whole magazine.
+    class SlabClass {
+    public:
+        SlabClass(const char* name, uint64_t object_size);
+
+        SlabClass(const SlabClass &) = delete;
+        SlabClass &operator=(const SlabClass &) = delete;
+
+        ///@brief Hand in an empty magazine (or nullptr) for a loaded one, carving a new slab if the depot has none
+        SlabMagazine* exchange_empty(SlabMagazine* magazine);
+
+        ///@brief Hand in a full magazine for an empty one
+        SlabMagazine* exchange_full(SlabMagazine* magazine);
+
+        ///@brief Give a magazine back to the depot for good, e.g. when its writer leaves
+        void put(SlabMagazine* magazine);
+
+        ///@brief Free one object without a writer cache, e.g. while a structure is torn down
+        void release(void* object);
+
+        [[nodiscard]] SlabStats stats();
+
+        [[nodiscard]] uint64_t get_object_size() const {
+            return object_size;
+        }
+
+    private:
+        const char* name;
+        uint64_t object_size;
+        uint64_t slab_size;
+        std::mutex lock;
+        std::vector<SlabMagazine*> loaded;  // not empty, the partial ones included
+        std::vector<SlabMagazine*> empties;
+        SlabMagazine* loose{};              // collects the objects freed through release
+        uint64_t slab_num{};
+        uint64_t object_num{};
+        uint64_t depot_object_num{};
+        uint64_t exchange_num{};
+
+        ///@brief Map a slab and load its objects into magazines, called with lock held
+        void grow();
+
+        SlabMagazine* take_empty();
+    };
+
+    ///@brief The free objects of one SlabClass held by one writer: the loaded magazine and the previous one, so that a
+    /// writer alternating between allocating and freeing around a magazine boundary does not go to the depot each time.
+    struct SlabCache {
+        SlabClass* slab_class{};
+        SlabMagazine* loaded{};
+        SlabMagazine* previous{};
+
+        ///@return an object, zeroed is set if its memory is still zero
+        void* allocate(bool &zeroed) {
+            if(loaded == nullptr || loaded->empty()) {
+                if(previous != nullptr && !previous->empty()) {
+                    std::swap(loaded, previous);
+                } else {
+                    loaded = slab_class->exchange_empty(loaded);
+                }
+            }
+            auto object = loaded->objects[--loaded->count];
+            zeroed = object & 1;
+            memory_count(MEMORY_SLAB_USED, (int64_t) slab_class->get_object_size());
+            return (void*) (object & ~(uintptr_t) 1);
+        }
+
+        void deallocate(void* object) {
+            if(object == nullptr) {
+                return;
+            }
+            if(loaded == nullptr || loaded->full()) {
+                if(previous == nullptr || previous->full()) {
+                    previous = slab_class->exchange_full(previous);
+                }
+                std::swap(loaded, previous);
+            }
+            loaded->objects[loaded->count++] = (uintptr_t) object;
+            memory_count(MEMORY_SLAB_USED, -(int64_t) slab_class->get_object_size());
+        }
+
+        ///@brief Give both magazines back to the depot
+        void flush() {
+            slab_class->put(loaded);
+            slab_class->put(previous);
+            loaded = previous = nullptr;
+        }
+    };
+
+    ///@return the stats of every slab class created so far
+    std::vector<SlabStats> slab_stats();
+}
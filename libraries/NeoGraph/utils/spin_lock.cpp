@@ -1,8 +1,23 @@
+#include <immintrin.h>
+#include <thread>
 #include "spin_lock.h"
+#include "config.h"
 
 namespace container {
     void SpinLock::lock() {
+        uint32_t backoff = 1;
         while (is_locked.exchange(true, std::memory_order_acquire)) {
+            // wait on plain loads so that the waiters do not keep stealing the line from the owner
+            while (is_locked.load(std::memory_order_relaxed)) {
+                if (backoff <= SPIN_BACKOFF_LIMIT) {
+                    for (uint32_t i = 0; i < backoff; i++) {
+                        _mm_pause();
+                    }
+                    backoff <<= 1;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
         }
     }
 
@@ -145,7 +145,11 @@ namespace container {
 //        bool operator==(const RangeElement &rhs) const;
 //        bool operator!=(const RangeElement &rhs) const;
 //    };
+#ifdef NEO_WIDE_VERTEX_ID
+    using RangeElement = uint64_t;  // see the neo_graph_wide target
+#else
     using RangeElement = uint32_t;
+#endif
 //    using InRangeElement = uint32_t;
 
     // Independent range tree node
@@ -169,6 +173,28 @@ namespace container {
         InRangeNode(const InRangeNode &rhs) = default;
     };
 
+    ///@brief Shape of the trees of one graph, fixed when its TransactionManager is constructed
+    struct NeoLayout {
+        uint64_t vertex_group_bits;     // log2 of the vertices per tree, in [VERTEX_MAP_CHUNK_BITS, MAX_VERTEX_GROUP_BITS]
+        uint64_t range_leaf_size;       // fill limit of the segments of clustered vertices, at most RANGE_LEAF_SIZE
+        uint64_t art_extract_threshold; // degree from which a neighborhood is kept in an ART
+
+        [[nodiscard]] constexpr uint64_t group_size() const {
+            return 1ull << vertex_group_bits;
+        }
+
+        [[nodiscard]] constexpr uint64_t group_mask() const {
+            return group_size() - 1;
+        }
+    };
+
+    // the layout every graph had before it could be chosen
+    constexpr NeoLayout NEO_LAYOUT_DEFAULT{6, 512, 8192};
+    // low average degree (e.g. road networks): fewer, fuller trees, and half-size leaves are cheaper to copy on write
+    constexpr NeoLayout NEO_LAYOUT_SPARSE{8, 256, 8192};
+    // heavy-tailed degrees (e.g. social networks): hubs leave the range trees for an ART earlier
+    constexpr NeoLayout NEO_LAYOUT_SKEWED{6, 512, 2048};
+
     // In vertex_map
     struct NeoVertex {
         uint64_t is_independent: 1;
@@ -187,6 +213,7 @@ namespace container {
         Range_Tree_Copied = 3,
         Range_Tree_Upgraded = 4,
         ART_Tree = 5,
+        ART_Tree_Downgraded = 12,    // replaced as a whole by a rebuilt neighborhood
 #if VERTEX_PROPERTY_NUM != 0
         Vertex_Property_Vec = 6,
         Vertex_Property_Map_All_Modified = 7,
@@ -222,7 +249,6 @@ namespace container {
     };
 
     using RangeNodeSegment_t = std::vector<NeoRangeNode>;
-    using VertexMap_t = std::array<NeoVertex, VERTEX_GROUP_SIZE>;
     struct RangeElementSegment_t {
         std::array<RangeElement, RANGE_LEAF_SIZE> value;
         std::atomic<uint32_t> ref_cnt{1};
@@ -0,0 +1,163 @@
+#include "work_stealing_pool.h"
+#include "numa_topology.h"
+#include "config.h"
+#include "include/neo_reader_trace.h"
+
+namespace container {
+    thread_local WorkStealingPool* WorkStealingPool::current_pool = nullptr;
+    thread_local size_t WorkStealingPool::current_worker = 0;
+
+    WorkStealingPool::WorkStealingPool(size_t threads, uint64_t nodes, Task on_start, Task on_exit): nodes(std::clamp<uint64_t>(nodes, 1, std::max<size_t>(threads, 1))),
+                                                                                                     on_start(std::move(on_start)), on_exit(std::move(on_exit)) {
+        for(size_t i = 0; i < threads; i++) {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->node = i % this->nodes;
+        }
+        // the deques exist before any worker may steal from them
+        for(size_t i = 0; i < threads; i++) {
+            workers[i]->thread = std::thread(&WorkStealingPool::run, this, i);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            stop = true;
+        }
+        wake.notify_all();
+        for(auto &worker: workers) {
+            worker->thread.join();
+        }
+    }
+
+    void WorkStealingPool::submit(Task task) {
+        auto idx = current_pool == this ? current_worker : next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        push(idx, std::move(task), false);
+    }
+
+    void WorkStealingPool::submit(Task task, uint64_t node) {
+        node %= nodes;
+        if(current_pool == this && workers[current_worker]->node == node) {
+            push(current_worker, std::move(task), false);
+            return;
+        }
+        // the workers of node are node, node + nodes, node + 2 * nodes, ...
+        auto node_workers = (workers.size() - node + nodes - 1) / nodes;
+        auto idx = node + next_worker.fetch_add(1, std::memory_order_relaxed) % node_workers * nodes;
+        // any sleeper may be woken by notify_one, the owner has to be among them to get the task before a remote thief
+        push(idx, std::move(task), nodes > 1);
+    }
+
+    void WorkStealingPool::push(size_t idx, Task task, bool wake_all) {
+        // counted first, so that a thief taking it right away never sees the count drop below zero
+        queued.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> guard(workers[idx]->lock);
+            workers[idx]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+        }
+        if(wake_all) {
+            wake.notify_all();
+        } else {
+            wake.notify_one();
+        }
+    }
+
+    bool WorkStealingPool::pop(size_t idx, Task &task) {
+        auto &worker = *workers[idx];
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if(worker.tasks.empty()) {
+            return false;
+        }
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool WorkStealingPool::steal(size_t idx, Task &task) {
+        // the workers of the own node are tried first, their tasks mostly touch memory of this node
+        for(uint64_t remote = 0; remote < (nodes > 1 ? 2 : 1); remote++) {
+            for(size_t i = 1; i < workers.size(); i++) {
+                auto &victim = *workers[(idx + i) % workers.size()];
+                if(nodes > 1 && (victim.node != workers[idx]->node) != (remote != 0)) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if(victim.tasks.empty()) {
+                    continue;
+                }
+                // the oldest task of a deque is the largest part of a split range
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool WorkStealingPool::help(size_t idx) {
+        Task task;
+        if(!pop(idx, task) && !steal(idx, task)) {
+            return false;
+        }
+        task(idx);
+        return true;
+    }
+
+    void WorkStealingPool::wait(const std::shared_ptr<Join> &join) {
+        if(current_pool == this) {
+            while(join->pending.load(std::memory_order_acquire) != 0) {
+                if(!help(current_worker)) {
+                    std::this_thread::yield();
+                }
+            }
+        } else {
+            std::unique_lock<std::mutex> guard(join->lock);
+            join->done.wait(guard, [&join]() {
+                return join->pending.load(std::memory_order_acquire) == 0;
+            });
+        }
+        if(join->error) {
+            std::rethrow_exception(join->error);
+        }
+    }
+
+    void WorkStealingPool::run(size_t idx) {
+        current_pool = this;
+        current_worker = idx;
+        if(nodes > 1) {
+            numa_bind_thread(workers[idx]->node);
+        }
+        if(on_start) {
+            on_start(idx);
+        }
+        while(true) {
+            if(help(idx)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleep_lock);
+            wake.wait(guard, [this]() {
+                return stop || queued.load(std::memory_order_acquire) != 0;
+            });
+            if(stop && queued.load(std::memory_order_acquire) == 0) {
+                break;
+            }
+        }
+        if(on_exit) {
+            on_exit(idx);
+        }
+    }
+
+    WorkStealingPool &batch_update_pool() {
+        static WorkStealingPool pool(BATCH_UPDATE_THREAD_NUM, numa_node_num(), [](size_t) {
+            batch_worker_register();
+        }, [](size_t) {
+            batch_worker_unregister();
+        });
+        return pool;
+    }
+}
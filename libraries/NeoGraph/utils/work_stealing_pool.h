@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace container {
+    ///@brief Fork-join pool whose workers own a deque each. A worker pops its own tasks from the back and steals from the
+    /// front of the others' deques once it runs dry, so a worker stuck in a large tree does not keep the queued work
+    /// from the rest of the pool. Tasks receive the index of the worker running them.
+    /// With nodes > 1, worker i is bound to NUMA node i % nodes and steals from the workers of its own node first.
+    class WorkStealingPool {
+    public:
+        using Task = std::function<void(size_t)>;
+
+        ///@param on_start run by every worker thread before its first task, e.g. to set up per-worker state
+        ///@param on_exit run by every worker thread after its last task, when the pool is destroyed
+        explicit WorkStealingPool(size_t threads, uint64_t nodes = 1, Task on_start = nullptr, Task on_exit = nullptr);
+
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        [[nodiscard]] size_t size() const {
+            return workers.size();
+        }
+
+        [[nodiscard]] uint64_t node_num() const {
+            return nodes;
+        }
+
+        ///@brief Queue task on the deque of the calling worker, or of the next worker in turn if called from outside
+        void submit(Task task);
+
+        ///@brief Queue task on a worker of node, the calling worker if it belongs to node
+        void submit(Task task, uint64_t node);
+
+        ///@brief Run body(begin, end, worker) over [begin, end) split in halves down to grain, the right halves are left
+        /// for thieves. Returns once every part has run, rethrowing the first exception of a part.
+        ///@note a worker calling it keeps running queued tasks while it waits, so parts may nest
+        template<typename F>
+        void parallel_for(uint64_t begin, uint64_t end, uint64_t grain, F &&body);
+
+        ///@brief Run body(i, worker) for every i of [begin, end) as a task of its own, queued on a worker of node
+        /// home_of(i). Returns once every task has run, rethrowing the first exception of a task.
+        template<typename H, typename F>
+        void parallel_for_homed(uint64_t begin, uint64_t end, H &&home_of, F &&body);
+
+    private:
+        struct Worker {
+            std::mutex lock;
+            std::deque<Task> tasks;
+            std::thread thread;
+            uint64_t node;
+        };
+
+        ///@brief Completion of one parallel_for, shared by all of its parts
+        struct Join {
+            std::atomic<uint64_t> pending{1};
+            std::mutex lock;
+            std::condition_variable done;
+            std::exception_ptr error;
+
+            void finish() {
+                if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    done.notify_all();
+                }
+            }
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        uint64_t nodes;
+        Task on_start;
+        Task on_exit;
+        std::atomic<uint64_t> queued{0};    // tasks sitting in any deque
+        std::atomic<uint64_t> next_worker{0};
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+        bool stop{false};
+
+        static thread_local WorkStealingPool* current_pool;
+        static thread_local size_t current_worker;
+
+        void run(size_t idx);
+
+        void push(size_t idx, Task task, bool wake_all);
+
+        bool pop(size_t idx, Task &task);
+
+        bool steal(size_t idx, Task &task);
+
+        ///@return whether a task was run
+        bool help(size_t idx);
+
+        ///@brief Wait for the tasks of join, helping with the queued ones if called by a worker
+        void wait(const std::shared_ptr<Join> &join);
+
+        template<typename F>
+        void run_range(const std::shared_ptr<Join> &join, uint64_t begin, uint64_t end, uint64_t grain, F* body, size_t worker);
+    };
+
+    ///@return the pool shared by the batch updates, BATCH_UPDATE_THREAD_NUM workers spread over numa_node_num() nodes.
+    /// Every worker registers a writer block of its own when it starts, see batch_trace_block
+    WorkStealingPool &batch_update_pool();
+}
+
+// ---------------------------------------Implementation---------------------------------------
+namespace container {
+    template<typename F>
+    void WorkStealingPool::run_range(const std::shared_ptr<Join> &join, uint64_t begin, uint64_t end, uint64_t grain, F* body, size_t worker) {
+        while(end - begin > grain) {
+            auto mid = begin + (end - begin) / 2;
+            join->pending.fetch_add(1, std::memory_order_relaxed);
+            submit([this, join, mid, end, grain, body](size_t thief) {
+                run_range(join, mid, end, grain, body, thief);
+            });
+            end = mid;
+        }
+        try {
+            (*body)(begin, end, worker);
+        } catch(...) {
+            std::lock_guard<std::mutex> guard(join->lock);
+            if(!join->error) {
+                join->error = std::current_exception();
+            }
+        }
+        join->finish();
+    }
+
+    template<typename F>
+    void WorkStealingPool::parallel_for(uint64_t begin, uint64_t end, uint64_t grain, F &&body) {
+        if(begin >= end) {
+            return;
+        }
+        grain = std::max<uint64_t>(grain, 1);
+        auto join = std::make_shared<Join>();
+        auto body_ptr = &body;
+        submit([this, join, begin, end, grain, body_ptr](size_t worker) {
+            run_range(join, begin, end, grain, body_ptr, worker);
+        });
+        wait(join);
+    }
+
+    template<typename H, typename F>
+    void WorkStealingPool::parallel_for_homed(uint64_t begin, uint64_t end, H &&home_of, F &&body) {
+        if(begin >= end) {
+            return;
+        }
+        auto join = std::make_shared<Join>();
+        join->pending.store(end - begin, std::memory_order_relaxed);
+        auto body_ptr = &body;
+        for(auto i = begin; i < end; i++) {
+            submit([join, i, body_ptr](size_t worker) {
+                try {
+                    (*body_ptr)(i, worker);
+                } catch(...) {
+                    std::lock_guard<std::mutex> guard(join->lock);
+                    if(!join->error) {
+                        join->error = std::current_exception();
+                    }
+                }
+                join->finish();
+            }, home_of(i));
+        }
+        wait(join);
+    }
+}
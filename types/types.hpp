@@ -31,7 +31,10 @@ enum class operationType {
     WCC,
     QUERY,
     MIXED, 
-    QOS
+    QOS,
+    READER_LATENCY,
+    COMMIT_STRESS,
+    MIXED_NUMA
 };
 
 struct operation {
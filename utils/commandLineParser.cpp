@@ -29,6 +29,12 @@ operationType get_op_type(std::string workload_type) {
         return operationType::MIXED;
     } else if (workload_type == "qos") {
         return operationType::QOS;
+    } else if (workload_type == "reader_latency") {
+        return operationType::READER_LATENCY;
+    } else if (workload_type == "commit_stress") {
+        return operationType::COMMIT_STRESS;
+    } else if (workload_type == "mixed_numa") {
+        return operationType::MIXED_NUMA;
     } else if (workload_type == "get_vertex") {
         return operationType::GET_VERTEX;
     } else if (workload_type == "get_weight") {
@@ -98,8 +104,8 @@ void commandLineParser::parse(const std::string& configFilePath) {
         ("sssp_source", po::value<uint64_t>(), "source vertex for sssp")
         ("num_iterations", po::value<int>(), "number of iterations for pr")
         ("damping_factor", po::value<double>(), "damping factor for pr")
-        ("writer_threads", po::value<int>(), "number of writer threads for mixed workload")
-        ("reader_threads", po::value<int>(), "number of reader threads for mixed workload")
+        ("writer_threads", po::value<int>(), "number of writer threads for mixed, mixed_numa, reader_latency and commit_stress workloads")
+        ("reader_threads", po::value<int>(), "number of reader threads for mixed, mixed_numa and reader_latency workloads")
         ("num_threads_search", po::value<int>(), "number of threads for search operations in qos")
         ("num_threads_scan", po::value<int>(), "number of threads for scan operations in qos")
         
@@ -296,7 +302,7 @@ void commandLineParser::parse(const std::string& configFilePath) {
     }
 
     if (vm.count("workload_type")) {
-        const std::set<std::string> workload_types = {"insert", "delete", "update", "micro_benchmark", "bfs", "sssp", "pr", "cc", "tc", "tc_op", "query", "mixed", "qos"};
+        const std::set<std::string> workload_types = {"insert", "delete", "update", "micro_benchmark", "bfs", "sssp", "pr", "cc", "tc", "tc_op", "query", "mixed", "qos", "reader_latency", "commit_stress", "mixed_numa"};
         std::string workload_type = vm["workload_type"].as<std::string>();
         if (workload_types.find(workload_type) == workload_types.end()) {
             std::cout << "Workload type is not valid.\n";
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <mutex>
+#include "libraries/NeoGraph/include/neo_frozen.h"
+#include "neo_wrapper.h"
+
+///@brief Read-only replica of the live store.
+/// Updates (e.g. the initial load of the Driver) go to the live store it derives from; snapshots are served by a
+/// NeoFrozenGraph mapped from a checkpoint of the live store, which is re-written whenever the live store has changed.
+class Neo_Frozen_Wrapper : public Neo_Graph_Wrapper {
+private:
+    const std::string m_checkpoint_path;
+    const FrozenPrefault m_prefault;
+    mutable std::mutex m_freeze_mutex;
+    mutable std::shared_ptr<const NeoFrozenGraph> m_frozen;
+    mutable uint64_t m_frozen_timestamp{};   // read timestamp of the live store the checkpoint was taken at
+
+public:
+    explicit Neo_Frozen_Wrapper(bool is_directed = true, bool is_weighted = true, std::string checkpoint_path = "neo_frozen.ckpt",
+                                FrozenPrefault prefault = FROZEN_PREFAULT_WILLNEED)
+            : Neo_Graph_Wrapper(is_directed, is_weighted), m_checkpoint_path(std::move(checkpoint_path)), m_prefault(prefault) {}
+
+    ///@brief Checkpoint the live store and map the checkpoint, unless nothing was committed since the last one
+    std::shared_ptr<const NeoFrozenGraph> freeze() const {
+        std::lock_guard<std::mutex> lock(m_freeze_mutex);
+        auto live = Neo_Graph_Wrapper::get_unique_snapshot();
+        if(m_frozen == nullptr || m_frozen_timestamp != live->read_timestamp()) {
+            m_frozen_timestamp = live->read_timestamp();
+            m_frozen = nullptr;
+            live->save(m_checkpoint_path);
+            m_frozen = std::make_shared<const NeoFrozenGraph>(m_checkpoint_path, m_prefault);
+        }
+        return m_frozen;
+    }
+
+    // Snapshot Related
+    class Snapshot {
+    private:
+        std::shared_ptr<const NeoFrozenGraph> graph;
+
+    public:
+        explicit Snapshot(std::shared_ptr<const NeoFrozenGraph> graph) : graph(std::move(graph)) {}
+
+        Snapshot(const Snapshot &other) = default;
+
+        Snapshot &operator=(const Snapshot &it) = delete;
+
+        ~Snapshot() = default;
+
+        [[nodiscard]] auto clone() const {
+            return std::make_shared<Snapshot>(*this);
+        }
+
+        [[nodiscard]] uint64_t size() const {
+            return graph->edge_count();
+        }
+
+        [[nodiscard]] inline static uint64_t physical2logical(uint64_t physical) {
+            return physical;
+        }
+
+        [[nodiscard]] inline static uint64_t logical2physical(uint64_t logical) {
+            return logical;
+        }
+
+        [[nodiscard]] uint64_t degree(uint64_t vertex, bool logical = false) const {
+            if (!has_vertex(vertex)) {
+                throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Frozen_Wrapper::snapshot::degree");
+            }
+            return graph->get_degree(vertex);
+        }
+
+        [[nodiscard]] bool has_vertex(uint64_t vertex, bool logical = false) const {
+            return graph->has_vertex(vertex);
+        }
+
+        [[nodiscard]] bool has_edge(driver::graph::weightedEdge edge, bool logical = false) const {
+            return has_edge(edge.source, edge.destination);
+        }
+
+        [[nodiscard]] bool has_edge(uint64_t source, uint64_t destination, bool logical = false) const {
+            return graph->has_edge(source, destination);
+        }
+
+        [[nodiscard]] bool has_edge(uint64_t source, uint64_t destination, double weight) const {
+            throw driver::error::FunctionNotImplementedError("frozen snapshot::has_edge::weighted");
+        }
+
+        [[nodiscard]] double get_weight(uint64_t source, uint64_t destination) const {
+            throw driver::error::FunctionNotImplementedError("frozen snapshot::get_weight");
+        }
+
+#if EDGE_PROPERTY_NUM == 1
+        [[nodiscard]] Property_t get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, bool logical = false) const {
+            return graph->get_edge_property(src, dest, property_id);
+        }
+#endif
+        [[nodiscard]] uint64_t vertex_count() const {
+            return graph->vertex_count();
+        }
+
+        [[nodiscard]] uint64_t edge_count() const {
+            return graph->edge_count();
+        }
+
+        [[nodiscard]] void* get_neighbor_addr(uint64_t index) const {
+            return (void*) graph->get_neighbor_addr(index);
+        }
+
+        uint64_t intersect(uint64_t src1, uint64_t src2) const {
+            return graph->intersect(src1, src2);
+        }
+
+        void intersect(uint64_t src1, uint64_t src2, std::vector<uint64_t> &result) const {
+            graph->intersect(src1, src2, result);
+        }
+
+        void edges(uint64_t index, std::vector<uint64_t> &neighbors) const {
+            graph->get_neighbor(index, neighbors);
+        }
+
+        template<typename F>
+        void edges(uint64_t index, F&& callback) const {
+            graph->edges(index, std::forward<F>(callback));
+        }
+
+        void edges(uint64_t index, std::vector<uint64_t> &neighbors, bool logical) const {
+            graph->get_neighbor(index, neighbors);
+        }
+
+        template<typename F>
+        void edges(uint64_t index, F&& callback, bool logical) const {
+            graph->edges(index, std::forward<F>(callback));
+        }
+    };
+
+    [[nodiscard]] std::unique_ptr<Snapshot> get_unique_snapshot() const {
+        return std::make_unique<Snapshot>(freeze());
+    }
+
+    [[nodiscard]] std::shared_ptr<Snapshot> get_shared_snapshot() const {
+        return std::make_shared<Snapshot>(freeze());
+    }
+
+    // Functions for debug purpose
+    static std::string repl() {
+        return std::string{"Neo_Frozen_Wrapper"};
+    }
+};
@@ -1,4 +1,5 @@
 #include "neo_wrapper.h"
+#include "neo_frozen_wrapper.h"
 #include <queue>
 #include <utility>
 #include <thread>
@@ -8,9 +9,15 @@ thread_local WriterTraceBlock* tracer = nullptr;
 namespace wrapper {
     void execute(const DriverConfig & config) {
         auto mem1 = getValue();
+#ifdef NEO_FROZEN_WRAPPER
+        auto wrapper = Neo_Frozen_Wrapper(false, true);
+        std::cout << getValue() - mem1 << std::endl;
+        Driver<Neo_Frozen_Wrapper, std::shared_ptr<Neo_Frozen_Wrapper::Snapshot>> d(wrapper, config);
+#else
         auto wrapper = Neo_Graph_Wrapper(false, true);
         std::cout << getValue() - mem1 << std::endl;
         Driver<Neo_Graph_Wrapper, std::shared_ptr<Neo_Graph_Wrapper::Snapshot>> d(wrapper, config);
+#endif
         d.execute(config.workload_type, config.target_stream_type);
     }
 }
@@ -56,6 +63,27 @@ void Neo_Graph_Wrapper::load(const std::string &path, driver::reader::readerType
     }
 }
 
+void Neo_Graph_Wrapper::bulk_load(const std::vector<std::pair<uint64_t, uint64_t>> &edges) {
+    if (!dictionary) {
+        tm.bulk_load(edges, m_adapt_layout);
+        return;
+    }
+    // the new mappings are logged at once instead of one log commit per vertex
+    std::vector<uint64_t> endpoints;
+    endpoints.reserve(edges.size() * 2);
+    for (auto &edge: edges) {
+        endpoints.push_back(edge.first);
+        endpoints.push_back(edge.second);
+    }
+    tm.assign_vertices(endpoints);
+    std::vector<std::pair<uint64_t, uint64_t>> internal_edges;
+    internal_edges.reserve(edges.size());
+    for (auto &edge: edges) {
+        internal_edges.emplace_back(to_internal(edge.first), to_internal(edge.second));
+    }
+    tm.bulk_load(internal_edges, m_adapt_layout);
+}
+
 std::shared_ptr<Neo_Graph_Wrapper> Neo_Graph_Wrapper::create_update_interface(const std::string& graph_type) {
     if (graph_type == "vec2vec") {
         return std::make_shared<Neo_Graph_Wrapper>();
@@ -95,7 +123,51 @@ void Neo_Graph_Wrapper::end_thread(int thread_id) {
     writer_unregister(tracer);
 }
 
+uint64_t Neo_Graph_Wrapper::numa_node_num() const {
+    return container::numa_node_num();
+}
+
+uint64_t Neo_Graph_Wrapper::home_node(uint64_t vertex) const {
+    vertex = to_internal(vertex);
+    return vertex == NeoVertexDictionary::NONE ? 0 : tm.index_impl->home_node(vertex);
+}
+
+void Neo_Graph_Wrapper::bind_thread_to_node(uint64_t node) {
+    numa_bind_thread(node);
+}
+
+std::string Neo_Graph_Wrapper::memory_report() const {
+    auto report = TransactionManager::memory_report();
+    std::pair<const char*, uint64_t> rows[] = {
+            {"clustered_segments", report.clustered_segments},
+            {"range_tree_nodes", report.range_tree_nodes},
+            {"range_tree_segments", report.range_tree_segments},
+            {"art_node4", report.art_node4},
+            {"art_node16", report.art_node16},
+            {"art_node48", report.art_node48},
+            {"art_node256", report.art_node256},
+            {"art_leaf8", report.art_leaf8},
+            {"art_leaf16", report.art_leaf16},
+            {"art_leaf32", report.art_leaf32},
+            {"art_leaf64", report.art_leaf64},
+            {"property_vecs", report.property_vecs},
+            {"vertex_maps", report.vertex_maps},
+            {"versions", report.versions},
+            {"pooled_free", report.pooled_free},
+            {"total", report.total()},
+    };
+    std::string res;
+    for(auto &[name, bytes]: rows) {
+        res += std::string(name) + ": " + std::to_string(bytes) + "\n";
+    }
+    return res;
+}
+
 bool Neo_Graph_Wrapper::has_vertex(uint64_t vertex) const {
+    vertex = to_internal(vertex);
+    if (vertex == NeoVertexDictionary::NONE) {
+        return false;
+    }
     auto tx = tm.get_read_transaction();
     auto has_vertex = tx->has_vertex(vertex);
     tx->commit();
@@ -115,6 +187,11 @@ bool Neo_Graph_Wrapper::has_edge(driver::graph::weightedEdge edge) const {
 }
 
 bool Neo_Graph_Wrapper::has_edge(uint64_t source, uint64_t destination) const {
+    source = to_internal(source);
+    destination = to_internal(destination);
+    if (source == NeoVertexDictionary::NONE || destination == NeoVertexDictionary::NONE) {
+        return false;
+    }
     auto tx = tm.get_read_transaction();
     auto has_edge = tx->has_edge(source, destination);
     tx->commit();
@@ -127,6 +204,10 @@ bool Neo_Graph_Wrapper::has_edge(uint64_t source, uint64_t destination, double w
 }
 
 uint64_t Neo_Graph_Wrapper::degree(uint64_t vertex) const {
+    vertex = to_internal(vertex);
+    if (vertex == NeoVertexDictionary::NONE) {
+        throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Graph_Wrapper::degree");
+    }
     auto tx = tm.get_read_transaction();
     if (!tx->has_vertex(vertex)) {
         throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Graph_Wrapper::degree");
@@ -153,6 +234,7 @@ double Neo_Graph_Wrapper::get_weight(uint64_t source, uint64_t destination) cons
 
 #if VERTEX_PROPERTY_NUM >= 1
 Property_t Neo_Graph_Wrapper::get_vertex_property(uint64_t vertex, uint8_t property_id) const {
+    vertex = to_internal(vertex);
     auto tx = tm.get_read_transaction();
     if (!tx->has_vertex(vertex)) {
         throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Graph_Wrapper::get_vertex_property");
@@ -165,6 +247,7 @@ Property_t Neo_Graph_Wrapper::get_vertex_property(uint64_t vertex, uint8_t prope
 #endif
 #if VERTEX_PROPERTY_NUM > 1
 void Neo_Graph_Wrapper::get_vertex_multi_property(uint64_t vertex, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res) const {
+    vertex = to_internal(vertex);
     auto tx = tm.get_read_transaction();
     if (!tx->has_vertex(vertex)) {
         throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Graph_Wrapper::get_vertex_multi_property");
@@ -176,6 +259,8 @@ void Neo_Graph_Wrapper::get_vertex_multi_property(uint64_t vertex, std::vector<u
 #endif
 #if EDGE_PROPERTY_NUM >= 1
 Property_t Neo_Graph_Wrapper::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const {
+    src = to_internal(src);
+    dest = to_internal(dest);
     auto tx = tm.get_read_transaction();
     if (!tx->has_edge(src, dest)) {
 //        throw driver::error::GraphLogicalError("Edge does not exist : Neo_Graph_Wrapper::get_edge_property");
@@ -189,6 +274,8 @@ Property_t Neo_Graph_Wrapper::get_edge_property(uint64_t src, uint64_t dest, uin
 #endif
 #if EDGE_PROPERTY_NUM > 1
 void Neo_Graph_Wrapper::get_edge_multi_property(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res) const {
+    src = to_internal(src);
+    dest = to_internal(dest);
     auto tx = tm.get_read_transaction();
     if (!tx->has_edge(src, dest)) {
         throw driver::error::GraphLogicalError("Edge does not exist : Neo_Graph_Wrapper::get_edge_multi_property");
@@ -200,11 +287,15 @@ void Neo_Graph_Wrapper::get_edge_multi_property(uint64_t src, uint64_t dest, std
 #endif
 
 uint64_t Neo_Graph_Wrapper::logical2physical(uint64_t vertex) const {
-    return vertex;
+    auto physical = to_internal(vertex);
+    if (physical == NeoVertexDictionary::NONE) {
+        throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Graph_Wrapper::logical2physical");
+    }
+    return physical;
 }
 
 uint64_t Neo_Graph_Wrapper::physical2logical(uint64_t physical) const {
-    return physical;
+    return dictionary ? dictionary->to_external(physical) : physical;
 }
 
 uint64_t Neo_Graph_Wrapper::vertex_count() const {
@@ -249,7 +340,7 @@ bool Neo_Graph_Wrapper::insert_vertex(uint64_t vertex, Property_t* property) {
     auto tx = tm.get_write_transaction();
     bool inserted = true;
     try {
-        tx->insert_vertex(vertex, property);
+        tx->insert_vertex(assign_internal(vertex), property);
         tx->commit();
     } catch (std::exception &e) {
         // print error message
@@ -281,7 +372,7 @@ bool Neo_Graph_Wrapper::set_vertex_property(uint64_t vertex, uint8_t property_id
     auto tx = tm.get_write_property_transaction();
     bool has_set = true;
     try {
-        tx->vertex_property_set(vertex, property_id, property);
+        tx->vertex_property_set(to_internal(vertex), property_id, property);
         has_set = tx->commit();
     } catch (std::exception &e) {
         // print error message
@@ -297,7 +388,7 @@ bool Neo_Graph_Wrapper::set_vertex_string_property(uint64_t vertex, uint8_t prop
     auto tx = tm.get_write_property_transaction();
     bool has_set = true;
     try {
-        tx->vertex_string_property_set(vertex, property_id, std::move(property));
+        tx->vertex_string_property_set(to_internal(vertex), property_id, std::move(property));
         has_set = tx->commit();
     } catch (std::exception &e) {
         // print error message
@@ -311,7 +402,7 @@ bool Neo_Graph_Wrapper::set_vertex_string_property(uint64_t vertex, uint8_t prop
 #endif
 
 bool Neo_Graph_Wrapper::insert_edge(uint64_t source, uint64_t destination, Property_t* property) {
-    LightWriteTransaction::insert_edge(source, destination, property, m_is_directed, &tm, tracer);
+    LightWriteTransaction::insert_edge(assign_internal(source), assign_internal(destination), property, m_is_directed, &tm, tracer);
     return true;
 }
 
@@ -345,6 +436,10 @@ bool Neo_Graph_Wrapper::set_edge_property(uint64_t src, uint64_t dest, uint8_t p
 #endif
 
 bool Neo_Graph_Wrapper::remove_vertex(uint64_t vertex) {
+    vertex = to_internal(vertex);
+    if (vertex == NeoVertexDictionary::NONE) {
+        return false;
+    }
     auto tx = tm.get_write_transaction();
     bool removed = true;
     try {
@@ -361,6 +456,11 @@ bool Neo_Graph_Wrapper::remove_vertex(uint64_t vertex) {
 }
 
 bool Neo_Graph_Wrapper::remove_edge(uint64_t source, uint64_t destination) {
+    source = to_internal(source);
+    destination = to_internal(destination);
+    if (source == NeoVertexDictionary::NONE || destination == NeoVertexDictionary::NONE) {
+        return false;
+    }
     LightWriteTransaction::remove_edge(source, destination, m_is_directed, &tm, tracer);
     return true;
 }
@@ -370,7 +470,7 @@ bool Neo_Graph_Wrapper::run_batch_vertex_update(std::vector<uint64_t> &vertices,
     bool inserted = true;
     try {
         for(int i = start; i < end; i++) {
-            tx->insert_vertex(vertices[i], nullptr);
+            tx->insert_vertex(assign_internal(vertices[i]), nullptr);
         }
         tx->commit(true, false);
     } catch (std::exception &e) {
@@ -453,11 +553,11 @@ bool Neo_Graph_Wrapper::run_batch_edge_update(std::vector<std::pair<uint64_t, ui
     auto tx = tm.get_write_transaction();
     if(type == operationType::INSERT) {
         for (int i = start; i < end; i++) {
-            tx->insert_edge(edges[i].first, edges[i].second, nullptr);
-        }
-        if (!m_is_directed) {
-            for (int i = start; i < end; i++) {
-                tx->insert_edge(edges[i].second, edges[i].first, nullptr);
+            auto source = assign_internal(edges[i].first);
+            auto destination = assign_internal(edges[i].second);
+            tx->insert_edge(source, destination, nullptr);
+            if (!m_is_directed) {
+                tx->insert_edge(destination, source, nullptr);
             }
         }
         tx->commit(false, true);
@@ -465,11 +565,14 @@ bool Neo_Graph_Wrapper::run_batch_edge_update(std::vector<std::pair<uint64_t, ui
         return inserted;
     } else {
         for (int i = start; i < end; i++) {
-            tx->remove_edge(edges[i].first, edges[i].second);
-        }
-        if (!m_is_directed) {
-            for (int i = start; i < end; i++) {
-                tx->remove_edge(edges[i].second, edges[i].first);
+            auto source = to_internal(edges[i].first);
+            auto destination = to_internal(edges[i].second);
+            if (source == NeoVertexDictionary::NONE || destination == NeoVertexDictionary::NONE) {
+                continue;
+            }
+            tx->remove_edge(source, destination);
+            if (!m_is_directed) {
+                tx->remove_edge(destination, source);
             }
         }
         tx->commit(false, false);
@@ -484,12 +587,11 @@ bool Neo_Graph_Wrapper::run_batch_edge_update(std::vector<operation> & edges, in
     auto tx = tm.get_write_transaction();
     if(type == operationType::INSERT) {
         for (int i = start; i < end; i++) {
-            tx->insert_edge(edges[i].e.source, edges[i].e.destination, (Property_t *) ((uint64_t) edges[i].e.weight));
-        }
-        if (!m_is_directed) {
-            for (int i = start; i < end; i++) {
-                tx->insert_edge(edges[i].e.destination, edges[i].e.source,
-                                (Property_t *) ((uint64_t) edges[i].e.weight));
+            auto source = assign_internal(edges[i].e.source);
+            auto destination = assign_internal(edges[i].e.destination);
+            tx->insert_edge(source, destination, (Property_t *) ((uint64_t) edges[i].e.weight));
+            if (!m_is_directed) {
+                tx->insert_edge(destination, source, (Property_t *) ((uint64_t) edges[i].e.weight));
             }
         }
         tx->commit(false, true);
@@ -497,11 +599,14 @@ bool Neo_Graph_Wrapper::run_batch_edge_update(std::vector<operation> & edges, in
         return inserted;
     } else {
         for (int i = start; i < end; i++) {
-            tx->remove_edge(edges[i].e.destination, edges[i].e.source);
-        }
-        if (!m_is_directed) {
-            for (int i = start; i < end; i++) {
-                tx->remove_edge(edges[i].e.destination, edges[i].e.source);
+            auto source = to_internal(edges[i].e.source);
+            auto destination = to_internal(edges[i].e.destination);
+            if (source == NeoVertexDictionary::NONE || destination == NeoVertexDictionary::NONE) {
+                continue;
+            }
+            tx->remove_edge(destination, source);
+            if (!m_is_directed) {
+                tx->remove_edge(destination, source);
             }
         }
         tx->commit(false, false);
@@ -602,13 +707,20 @@ void Neo_Graph_Wrapper::clear() {
 
 }
 
+void Neo_Graph_Wrapper::assign_vertex_order(const std::vector<std::pair<uint64_t, uint64_t>> &edges, NeoVertexOrder order) {
+    if (!dictionary) {
+        throw std::runtime_error("Neo_Graph_Wrapper::assign_vertex_order: the wrapper was built without a vertex dictionary");
+    }
+    tm.assign_vertices(NeoVertexDictionary::order(edges, order));
+}
+
 // Snapshot Related Function Implementations
 std::unique_ptr<Neo_Graph_Wrapper::Snapshot> Neo_Graph_Wrapper::get_unique_snapshot() const {
-    return std::make_unique<Snapshot>(tm);
+    return std::make_unique<Snapshot>(tm, dictionary);
 }
 
 std::shared_ptr<Neo_Graph_Wrapper::Snapshot> Neo_Graph_Wrapper::get_shared_snapshot() const {
-    return std::make_shared<Snapshot>(tm);
+    return std::make_shared<Snapshot>(tm, dictionary);
 }
 
 
@@ -617,22 +729,38 @@ uint64_t Neo_Graph_Wrapper::Snapshot::size() const {
 }
 
 uint64_t Neo_Graph_Wrapper::Snapshot::degree(uint64_t vertex, bool logical) const {
-    if (!has_vertex(vertex)) {
+    if (logical) {
+        vertex = logical2physical(vertex);
+    }
+    if (vertex == NeoVertexDictionary::NONE || !snapshot.has_vertex(vertex)) {
         throw driver::error::GraphLogicalError("Vertex does not exist : Neo_Graph_Wrapper::snapshot::degree");
     }
     return snapshot.get_degree(vertex);
 }
 
-bool Neo_Graph_Wrapper::Snapshot::has_vertex(uint64_t vertex) const {
+bool Neo_Graph_Wrapper::Snapshot::has_vertex(uint64_t vertex, bool logical) const {
+    if (logical) {
+        vertex = logical2physical(vertex);
+    }
+    if (vertex == NeoVertexDictionary::NONE) {
+        return false;
+    }
     auto non_const_this = const_cast<Snapshot*>(this);
     return non_const_this->snapshot.has_vertex(vertex);
 }
 
-bool Neo_Graph_Wrapper::Snapshot::has_edge(driver::graph::weightedEdge edge) const {
-    return has_edge(edge.source, edge.destination);
+bool Neo_Graph_Wrapper::Snapshot::has_edge(driver::graph::weightedEdge edge, bool logical) const {
+    return has_edge(edge.source, edge.destination, logical);
 }
 
-bool Neo_Graph_Wrapper::Snapshot::has_edge(uint64_t source, uint64_t destination) const {
+bool Neo_Graph_Wrapper::Snapshot::has_edge(uint64_t source, uint64_t destination, bool logical) const {
+    if (logical) {
+        source = logical2physical(source);
+        destination = logical2physical(destination);
+    }
+    if (source == NeoVertexDictionary::NONE || destination == NeoVertexDictionary::NONE) {
+        return false;
+    }
     return snapshot.has_edge(source, destination);
 }
 
@@ -645,22 +773,36 @@ double Neo_Graph_Wrapper::Snapshot::get_weight(uint64_t source, uint64_t destina
 }
 
 #if VERTEX_PROPERTY_NUM >= 1
-Property_t Neo_Graph_Wrapper::Snapshot::get_vertex_property(uint64_t vertex, uint8_t property_id) const {
+Property_t Neo_Graph_Wrapper::Snapshot::get_vertex_property(uint64_t vertex, uint8_t property_id, bool logical) const {
+    if (logical) {
+        vertex = logical2physical(vertex);
+    }
     return snapshot.get_vertex_property(vertex, property_id);
 }
 #endif
 #if VERTEX_PROPERTY_NUM > 1
-void Neo_Graph_Wrapper::Snapshot::get_multi_vertex_property(uint64_t vertex, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res) const {
+void Neo_Graph_Wrapper::Snapshot::get_multi_vertex_property(uint64_t vertex, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res, bool logical) const {
+    if (logical) {
+        vertex = logical2physical(vertex);
+    }
     snapshot.get_vertex_multi_property(vertex, property_ids, res);
 }
 #endif
 #if EDGE_PROPERTY_NUM >= 1
-Property_t Neo_Graph_Wrapper::Snapshot::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const {
+Property_t Neo_Graph_Wrapper::Snapshot::get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, bool logical) const {
+    if (logical) {
+        src = logical2physical(src);
+        dest = logical2physical(dest);
+    }
     return snapshot.get_edge_property(src, dest, property_id);
 }
 #endif
 #if EDGE_PROPERTY_NUM > 1
-void Neo_Graph_Wrapper::Snapshot::get_multi_edge_property(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res) const {
+void Neo_Graph_Wrapper::Snapshot::get_multi_edge_property(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res, bool logical) const {
+    if (logical) {
+        src = logical2physical(src);
+        dest = logical2physical(dest);
+    }
     snapshot.get_edge_multi_property(src, dest, property_ids, res);
 }
 #endif
@@ -676,6 +818,10 @@ void* Neo_Graph_Wrapper::Snapshot::get_neighbor_addr(uint64_t index) const {
     return snapshot.get_neighbor_addr(index);
 }
 
+NeighborRange Neo_Graph_Wrapper::Snapshot::neighbors(uint64_t index) const {
+    return snapshot.neighbors(index);
+}
+
 uint64_t Neo_Graph_Wrapper::Snapshot::intersect(uint64_t src1, uint64_t src2) const {
     return snapshot.intersect(src1, src2);
 }
@@ -695,10 +841,39 @@ void Neo_Graph_Wrapper::Snapshot::edges(uint64_t index, F&& callback) const {
 }
 
 void Neo_Graph_Wrapper::Snapshot::edges(uint64_t index, std::vector<uint64_t> &neighbors, bool logical) const {
+    if (!logical || dictionary == nullptr) {
+        snapshot.get_neighbor(index, neighbors);
+        return;
+    }
+    index = logical2physical(index);
+    if (index == NeoVertexDictionary::NONE) {
+        return;
+    }
     snapshot.get_neighbor(index, neighbors);
+    for (auto &neighbor: neighbors) {
+        neighbor = physical2logical(neighbor);
+    }
 }
 
 template<typename F>
 void Neo_Graph_Wrapper::Snapshot::edges(uint64_t index, F&& callback, bool logical) const {
-    snapshot.edges(index, std::forward<F>(callback));
-}
\ No newline at end of file
+    if (!logical || dictionary == nullptr) {
+        snapshot.edges(index, std::forward<F>(callback));
+        return;
+    }
+    index = logical2physical(index);
+    if (index == NeoVertexDictionary::NONE) {
+        return;
+    }
+    snapshot.edges(index, [&](uint64_t destination, auto&&... rest) {
+        return callback(physical2logical(destination), std::forward<decltype(rest)>(rest)...);
+    });
+}
+
+void Neo_Graph_Wrapper::Snapshot::save(const std::string &path) const {
+    snapshot.save(path);
+}
+
+uint64_t Neo_Graph_Wrapper::Snapshot::read_timestamp() const {
+    return snapshot.get_timestamp();
+}
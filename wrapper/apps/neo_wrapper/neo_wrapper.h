@@ -1,8 +1,10 @@
 #pragma once
 
+#include <optional>
 #include "libraries/NeoGraph/include/neo_index.h"
 #include "libraries/NeoGraph/include/neo_transaction.h"
 #include "libraries/NeoGraph/include/neo_snapshot.h"
+#include "libraries/NeoGraph/include/neo_vertex_dict.h"
 
 #include "../../libraries/NeoGraph/utils/types.h"
 #include "../../libraries/NeoGraph/utils/config.h"
@@ -21,10 +23,26 @@ private:
     TransactionManager tm;
     const bool m_is_directed;
     const bool m_is_weighted;
+    NeoVertexDictionary* const dictionary;  // owned by tm, nullptr if the vertex IDs are used as they are
+    const bool m_adapt_layout;  // no layout was given, bulk_load picks it
+
+    ///@return the internal ID of vertex, NeoVertexDictionary::NONE if it has none
+    [[nodiscard]] uint64_t to_internal(uint64_t vertex) const {
+        return dictionary ? dictionary->to_internal(vertex) : vertex;
+    }
+
+    [[nodiscard]] uint64_t assign_internal(uint64_t vertex) {
+        return dictionary ? tm.assign_vertex(vertex) : vertex;
+    }
 public:
     // Constructor
-    explicit Neo_Graph_Wrapper(bool is_directed = true, bool is_weighted = true, int block_size = 1024)
-            :tm(is_directed, is_weighted), m_is_weighted(is_weighted), m_is_directed(is_directed) {}
+    ///@param layout shape of the trees; without one the graph starts with NEO_LAYOUT_DEFAULT and bulk_load switches to
+    /// the layout TransactionManager::choose_layout picks for the loaded graph
+    ///@param use_dictionary remap the (possibly sparse) vertex IDs to dense internal ones, see NeoVertexDictionary.
+    /// The mappings are logged and checkpointed with the graph.
+    explicit Neo_Graph_Wrapper(bool is_directed = true, bool is_weighted = true, int block_size = 1024, std::optional<NeoLayout> layout = std::nullopt, bool use_dictionary = false)
+            :tm(is_directed, is_weighted, layout.value_or(NEO_LAYOUT_DEFAULT)), m_is_weighted(is_weighted), m_is_directed(is_directed),
+             dictionary(use_dictionary ? tm.enable_vertex_dictionary() : nullptr), m_adapt_layout(!layout.has_value()) {}
 
     Neo_Graph_Wrapper(const Neo_Graph_Wrapper &) = delete;
 
@@ -36,6 +54,9 @@ public:
 
     void load(const std::string &path, driver::reader::readerType type);
 
+    ///@brief Load an edge list into the empty graph at once, see TransactionManager::bulk_load
+    void bulk_load(const std::vector<std::pair<uint64_t, uint64_t>> &edges);
+
     // Multi-thread
     void set_max_threads(int max_threads);
 
@@ -43,6 +64,18 @@ public:
 
     void end_thread(int thread_id);
 
+    // NUMA placement, a single node unless NeoGraph is built with NEO_NUMA
+    [[nodiscard]] uint64_t numa_node_num() const;
+
+    ///@return the node whose memory holds the neighborhood of vertex
+    [[nodiscard]] uint64_t home_node(uint64_t vertex) const;
+
+    ///@brief Run the calling thread on the CPUs of node
+    void bind_thread_to_node(uint64_t node);
+
+    ///@return the bytes held per structure, one "name: bytes" line each
+    [[nodiscard]] std::string memory_report() const;
+
     // Graph operations
     [[nodiscard]] bool is_directed() const;
 
@@ -119,18 +152,24 @@ public:
 
     void clear();
 
+    ///@brief Hand out the internal IDs of the vertices of edges in the given order, before the edges are loaded
+    void assign_vertex_order(const std::vector<std::pair<uint64_t, uint64_t>> &edges, NeoVertexOrder order);
+
     // Snapshot Related
+    ///@brief Every call taking vertex IDs reads them as internal (physical) IDs unless logical is set, then they are
+    /// translated through the vertex dictionary first. neighbors, get_neighbor_addr and intersect only take physical IDs.
     class Snapshot {
     private:
         const uint64_t m_num_vertices;
         const uint64_t m_num_edges;
         NeoSnapshot snapshot;
+        const NeoVertexDictionary* dictionary;
 
     public:
-        explicit Snapshot(const TransactionManager &tm) :
+        explicit Snapshot(const TransactionManager &tm, const NeoVertexDictionary* dictionary = nullptr) :
                                                                              m_num_vertices(tm.vertex_count()),
                                                                              m_num_edges(tm.edge_count()),
-                                                                             snapshot{&tm} {
+                                                                             snapshot{&tm}, dictionary(dictionary) {
 //                                                                             snapshot{tm.index_impl, tm.global_timestamp, true} {
         }
 
@@ -147,37 +186,38 @@ public:
 
         [[nodiscard]] uint64_t size() const;
 
-        [[nodiscard]] inline static uint64_t physical2logical(uint64_t physical) {
-            return physical;
+        [[nodiscard]] inline uint64_t physical2logical(uint64_t physical) const {
+            return dictionary ? dictionary->to_external(physical) : physical;
         }
 
-        [[nodiscard]] inline static uint64_t logical2physical(uint64_t logical) {
-            return logical;
+        ///@return NeoVertexDictionary::NONE if logical is not a vertex
+        [[nodiscard]] inline uint64_t logical2physical(uint64_t logical) const {
+            return dictionary ? dictionary->to_internal(logical) : logical;
         }
 
         [[nodiscard]] uint64_t degree(uint64_t, bool logical = false) const;
 
-        [[nodiscard]] bool has_vertex(uint64_t vertex) const;
+        [[nodiscard]] bool has_vertex(uint64_t vertex, bool logical = false) const;
 
-        [[nodiscard]] bool has_edge(driver::graph::weightedEdge edge) const;
+        [[nodiscard]] bool has_edge(driver::graph::weightedEdge edge, bool logical = false) const;
 
-        [[nodiscard]] bool has_edge(uint64_t source, uint64_t destination) const;
+        [[nodiscard]] bool has_edge(uint64_t source, uint64_t destination, bool logical = false) const;
 
         [[nodiscard]] bool has_edge(uint64_t source, uint64_t destination, double weight) const;
 
         [[nodiscard]] double get_weight(uint64_t source, uint64_t destination) const;
 
 #if VERTEX_PROPERTY_NUM >= 1
-        [[nodiscard]] Property_t get_vertex_property(uint64_t vertex, uint8_t property_id) const;
+        [[nodiscard]] Property_t get_vertex_property(uint64_t vertex, uint8_t property_id, bool logical = false) const;
 #endif
 #if VERTEX_PROPERTY_NUM > 1
-        void get_multi_vertex_property(uint64_t vertex, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res) const;
+        void get_multi_vertex_property(uint64_t vertex, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res, bool logical = false) const;
 #endif
 #if EDGE_PROPERTY_NUM >= 1
-        [[nodiscard]] Property_t get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id) const;
+        [[nodiscard]] Property_t get_edge_property(uint64_t src, uint64_t dest, uint8_t property_id, bool logical = false) const;
 #endif
 #if EDGE_PROPERTY_NUM > 1
-        void get_multi_edge_property(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res) const;
+        void get_multi_edge_property(uint64_t src, uint64_t dest, std::vector<uint8_t>* property_ids, std::vector<Property_t>& res, bool logical = false) const;
 #endif
         [[nodiscard]] uint64_t vertex_count() const;
 
@@ -185,6 +225,8 @@ public:
 
         [[nodiscard]] void* get_neighbor_addr(uint64_t index) const;
 
+        [[nodiscard]] NeighborRange neighbors(uint64_t index) const;
+
         uint64_t intersect(uint64_t src1, uint64_t src2) const;
 
         void intersect(uint64_t src1, uint64_t src2, std::vector<uint64_t> &result) const;
@@ -198,6 +240,11 @@ public:
 
         template<typename F>
         void edges(uint64_t index, F&& callback, bool logical) const;
+
+        ///@brief Dump the snapshot as a checkpoint, e.g. for Neo_Frozen_Wrapper
+        void save(const std::string &path) const;
+
+        [[nodiscard]] uint64_t read_timestamp() const;
     };
 
     [[nodiscard]] std::unique_ptr<Snapshot> get_unique_snapshot() const;
@@ -89,6 +89,9 @@ private:
     void execute_query();
     void execute_mixed_reader_writer(const std::string & target_path, const std::string & target_path2, const std::string & output_path);
     void execute_qos(const std::string & target_path_search, const std::string target_path_scan, const std::string & output_path);
+    void execute_reader_latency(const std::string & target_path, const std::string & target_path2, const std::string & output_path);
+    void execute_commit_stress(const std::string & target_path, const std::string & output_path);
+    void execute_mixed_numa(const std::string & target_path, const std::string & output_path);
     void bfs(const S & snapshot, int thread_id, vertexID source, std::vector<vertexID> & result);
     void sssp(const S & snapshot, int thread_id, vertexID source, std::vector<double> & result);
     void wcc(const S & snapshot, int thread_id, std::vector<int> & result);
@@ -557,10 +560,10 @@ void Driver<F, S>::execute_microbenchmarks(const std::string & target_path, cons
 
                 switch (op.type) {
                     case operationType::GET_VERTEX:
-                        wrapper::snapshot_has_vertex(snapshot_local, edge.source);
+                        wrapper::snapshot_has_vertex(snapshot_local, edge.source, true);
                         break;
                     case operationType::GET_EDGE: {
-                        sum += wrapper::snapshot_has_edge(snapshot_local, edge.source, edge.destination);
+                        sum += wrapper::snapshot_has_edge(snapshot_local, edge.source, edge.destination, true);
                         break;
                     }
                     case operationType::GET_WEIGHT:
@@ -1278,6 +1281,265 @@ void Driver<F, S>::execute_mixed_reader_writer(const std::string & target_path,
 //}
 
 
+// Reader tail latency under write load: writers keep replacing the edges of the update stream while every read of the
+// target stream is timed on its own, including the snapshot it is served from.
+template <class F, class S>
+void Driver<F, S>::execute_reader_latency(const std::string & target_path, const std::string & target_path2, const std::string & output_path) {
+    std::cout << "reader latency, thread num: " << m_config.writer_threads << " " << m_config.reader_threads << std::endl;
+    std::vector<operation> target_stream;
+    std::vector<operation> target_stream2;
+    read_stream(target_path, target_stream);
+    read_stream(target_path2, target_stream2);
+    if (target_stream2.empty() || m_config.reader_threads <= 0) {
+        std::cerr << "reader latency: no reads to run" << std::endl;
+        return;
+    }
+    wrapper::set_max_threads(m_method, m_config.writer_threads + m_config.reader_threads);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writer_threads;
+    std::vector<uint64_t> writer_ops(m_config.writer_threads, 0);
+    uint64_t chunk_size = m_config.writer_threads <= 0 ? 0 : (target_stream.size() + m_config.writer_threads - 1) / m_config.writer_threads;
+    for (int i = 0; i < m_config.writer_threads; i++) {
+        writer_threads.emplace_back(std::thread([this, &target_stream, &stop, &writer_ops, chunk_size] (int thread_id) {
+            wrapper::init_thread(m_method, thread_id);
+            uint64_t start = std::min(thread_id * chunk_size, (uint64_t) target_stream.size());
+            uint64_t end = std::min(start + chunk_size, (uint64_t) target_stream.size());
+            while (start != end && !stop.load(std::memory_order_relaxed)) {
+                for (uint64_t j = start; j < end && !stop.load(std::memory_order_relaxed); j++) {
+                    auto edge = target_stream[j].e;
+                    wrapper::remove_edge(m_method, edge.source, edge.destination);
+                    wrapper::insert_edge(m_method, edge.source, edge.destination);
+                    writer_ops[thread_id] += 2;
+                }
+            }
+            wrapper::end_thread(m_method, thread_id);
+        }, i));
+        bind_thread_to_core(writer_threads[i], i % std::thread::hardware_concurrency());
+    }
+
+    std::vector<std::thread> reader_threads;
+    std::vector<std::vector<uint64_t>> latencies(m_config.reader_threads);
+    uint64_t reader_chunk_size = (target_stream2.size() + m_config.reader_threads - 1) / m_config.reader_threads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < m_config.reader_threads; i++) {
+        reader_threads.emplace_back(std::thread([this, &target_stream2, &latencies, reader_chunk_size] (int reader_id, int thread_id) {
+            wrapper::init_thread(m_method, thread_id);
+            uint64_t start = std::min(reader_id * reader_chunk_size, (uint64_t) target_stream2.size());
+            uint64_t end = std::min(start + reader_chunk_size, (uint64_t) target_stream2.size());
+            auto &latency = latencies[reader_id];
+            latency.reserve(end - start);
+            uint64_t sum = 0;
+            auto cb = [&sum](vertexID destination, double weight) {
+                sum += 1;
+            };
+            for (uint64_t j = start; j < end; j++) {
+                const auto &op = target_stream2[j];
+                auto op_start = std::chrono::high_resolution_clock::now();
+                auto snapshot = wrapper::get_shared_snapshot(m_method);
+                switch (op.type) {
+                    case operationType::GET_VERTEX:
+                        sum += wrapper::snapshot_has_vertex(snapshot, op.e.source, true);
+                        break;
+                    case operationType::GET_EDGE:
+                        sum += wrapper::snapshot_has_edge(snapshot, op.e.source, op.e.destination, true);
+                        break;
+                    case operationType::GET_NEIGHBOR:
+                        wrapper::snapshot_get_neighbors_addr(snapshot, op.e.source);
+                        break;
+                    case operationType::SCAN_NEIGHBOR:
+                        wrapper::snapshot_edges(snapshot, op.e.source, cb, true);
+                        break;
+                    default:
+                        throw std::runtime_error("Invalid operation type in target stream\n");
+                }
+                auto op_end = std::chrono::high_resolution_clock::now();
+                latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count());
+            }
+            wrapper::end_thread(m_method, thread_id);
+            std::cout << sum << std::endl;
+        }, i, i + m_config.writer_threads));
+        bind_thread_to_core(reader_threads[i], (i + m_config.writer_threads) % std::thread::hardware_concurrency());
+    }
+
+    for (auto &thread: reader_threads) {
+        thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    stop.store(true, std::memory_order_relaxed);
+    for (auto &thread: writer_threads) {
+        thread.join();
+    }
+
+    std::vector<uint64_t> all;
+    for (auto &latency: latencies) {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all[std::min((uint64_t) (p * all.size()), (uint64_t) all.size() - 1)];
+    };
+    double duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    uint64_t total_writes = 0;
+    for (auto ops: writer_ops) {
+        total_writes += ops;
+    }
+    log_info("reader latency (ns) p50: %lu p90: %lu p99: %lu p99.9: %lu max: %lu", percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), all.back());
+    log_info("reads: %.6lf meps writes: %.6lf meps", all.size() / duration * 1000.0, total_writes / duration * 1000.0);
+}
+
+// Commit convoying: writers, typically more than there are cores, insert every edge of the update stream and remove it
+// again, every single update is timed. The stream holds edges the loaded graph lacks, so both updates change the graph. A writer descheduled while holding an unfinished timestamp shows up in the tail of all of them
+// if committers wait for each other.
+template <class F, class S>
+void Driver<F, S>::execute_commit_stress(const std::string & target_path, const std::string & output_path) {
+    std::cout << "commit stress, thread num: " << m_config.writer_threads << " cores: " << std::thread::hardware_concurrency() << std::endl;
+    std::vector<operation> target_stream;
+    read_stream(target_path, target_stream);
+    if (target_stream.empty() || m_config.writer_threads <= 0) {
+        std::cerr << "commit stress: no updates to run" << std::endl;
+        return;
+    }
+    wrapper::set_max_threads(m_method, m_config.writer_threads);
+
+    std::vector<std::thread> writer_threads;
+    std::vector<std::vector<uint64_t>> latencies(m_config.writer_threads);
+    uint64_t chunk_size = (target_stream.size() + m_config.writer_threads - 1) / m_config.writer_threads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < m_config.writer_threads; i++) {
+        // left unbound, the scheduler is free to preempt a writer anywhere in a commit
+        writer_threads.emplace_back(std::thread([this, &target_stream, &latencies, chunk_size] (int thread_id) {
+            wrapper::init_thread(m_method, thread_id);
+            uint64_t start = std::min(thread_id * chunk_size, (uint64_t) target_stream.size());
+            uint64_t end = std::min(start + chunk_size, (uint64_t) target_stream.size());
+            auto &latency = latencies[thread_id];
+            latency.reserve(2 * (end - start));
+            for (uint64_t j = start; j < end; j++) {
+                auto edge = target_stream[j].e;
+                auto op_start = std::chrono::high_resolution_clock::now();
+                wrapper::insert_edge(m_method, edge.source, edge.destination);
+                auto op_mid = std::chrono::high_resolution_clock::now();
+                wrapper::remove_edge(m_method, edge.source, edge.destination);
+                auto op_end = std::chrono::high_resolution_clock::now();
+                latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(op_mid - op_start).count());
+                latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_mid).count());
+            }
+            wrapper::end_thread(m_method, thread_id);
+        }, i));
+    }
+    for (auto &thread: writer_threads) {
+        thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::vector<uint64_t> all;
+    for (auto &latency: latencies) {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all[std::min((uint64_t) (p * all.size()), (uint64_t) all.size() - 1)];
+    };
+    double duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    log_info("commit latency (ns) p50: %lu p90: %lu p99: %lu p99.9: %lu max: %lu", percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), all.back());
+    log_info("updates: %.6lf meps", all.size() / duration * 1000.0);
+}
+
+// Mixed workload on a NUMA machine, run twice: first with writers and readers left to the scheduler, then with every
+// writer bound to a node and fed only the edges whose source lives on that node, and the readers spread over the nodes.
+// The gap between the two runs is what the placement saves; measure the interconnect traffic with vtune as for mixed.
+template <class F, class S>
+void Driver<F, S>::execute_mixed_numa(const std::string & target_path, const std::string & output_path) {
+    uint64_t nodes = wrapper::numa_node_num(m_method);
+    std::cout << "mixed numa, thread num: " << m_config.writer_threads << " " << m_config.reader_threads << " nodes: " << nodes << std::endl;
+    std::vector<operation> target_stream;
+    read_stream(target_path, target_stream);
+    if (target_stream.empty() || m_config.writer_threads <= 0) {
+        std::cerr << "mixed numa: no updates to run" << std::endl;
+        return;
+    }
+    std::shuffle(target_stream.begin(), target_stream.end(), std::mt19937(std::random_device()()));
+    wrapper::set_max_threads(m_method, m_config.writer_threads + m_config.reader_threads);
+
+    auto snapshot = wrapper::get_shared_snapshot(m_method);
+    uint64_t num_vertices = wrapper::snapshot_vertex_count(snapshot);
+    std::vector<uint64_t> degree_list(num_vertices);
+    for (uint64_t i = 0; i < num_vertices; i++) degree_list[i] = wrapper::degree(m_method, i);
+
+    // the edges of each writer, writer i works for node i % nodes when routed
+    auto assign = [&](bool routed) {
+        std::vector<std::vector<driver::graph::weightedEdge>> streams(m_config.writer_threads);
+        std::vector<uint64_t> next_writer(nodes, 0);
+        for (uint64_t j = 0; j < target_stream.size(); j++) {
+            auto &edge = target_stream[j].e;
+            if (!routed) {
+                streams[j % m_config.writer_threads].push_back(edge);
+                continue;
+            }
+            uint64_t writers = m_config.writer_threads;
+            uint64_t node = wrapper::home_node(m_method, edge.source) % nodes;
+            if (node >= writers) {  // fewer writers than nodes
+                streams[j % writers].push_back(edge);
+                continue;
+            }
+            uint64_t node_writers = (writers - node + nodes - 1) / nodes;
+            streams[node + next_writer[node]++ % node_writers * nodes].push_back(edge);
+        }
+        return streams;
+    };
+
+    for (bool routed : {false, true}) {
+        auto streams = assign(routed);
+        std::vector<std::thread> writer_threads;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < m_config.writer_threads; i++) {
+            writer_threads.emplace_back(std::thread([this, &streams, routed, nodes] (int thread_id) {
+                if (routed) {
+                    wrapper::bind_thread_to_node(m_method, thread_id % nodes);
+                }
+                wrapper::init_thread(m_method, thread_id);
+                for (auto &edge : streams[thread_id]) {
+                    wrapper::remove_edge(m_method, edge.source, edge.destination);
+                    wrapper::insert_edge(m_method, edge.source, edge.destination);
+                }
+                wrapper::end_thread(m_method, thread_id);
+            }, i));
+        }
+
+        std::vector<std::thread> reader_threads;
+        std::vector<double> reader_time(m_config.reader_threads);
+        for (int i = 0; i < m_config.reader_threads; i++) {
+            reader_threads.emplace_back(std::thread([this, &snapshot, &degree_list, &reader_time, routed, nodes] (int reader_id, int thread_id) {
+                if (routed) {
+                    wrapper::bind_thread_to_node(m_method, reader_id % nodes);
+                }
+                wrapper::init_thread(m_method, thread_id);
+                auto snapshot_local = wrapper::snapshot_clone(snapshot);
+                auto start_time = std::chrono::high_resolution_clock::now();
+                std::vector<double> result(wrapper::snapshot_vertex_count(snapshot_local));
+                page_rank(snapshot_local, thread_id, m_config.damping_factor, m_config.num_iterations, result, degree_list);
+                auto end_time = std::chrono::high_resolution_clock::now();
+                reader_time[reader_id] = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+                wrapper::end_thread(m_method, thread_id);
+            }, i, i + m_config.writer_threads));
+        }
+
+        for (auto &thread: writer_threads) {
+            thread.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        for (auto &thread: reader_threads) {
+            thread.join();
+        }
+        double duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        double reader_avg = 0;
+        for (auto time : reader_time) {
+            reader_avg += time / reader_time.size();
+        }
+        log_info("%s: writes: %.6lf meps page rank: %.6lf us", routed ? "routed" : "unrouted", 2 * target_stream.size() / duration * 1000.0, reader_avg);
+    }
+}
+
 template <class F, class S>
 void Driver<F, S>::execute_qos(const std::string & target_path_search, const std::string target_path_scan, const std::string & output_path) {
     // Deprecated‌
@@ -1357,6 +1619,15 @@ void generate_path_type(std::string & path, operationType type) {
     else if (type == operationType::QOS) {
         path += "qos_";
     }
+    else if (type == operationType::READER_LATENCY) {
+        path += "reader_latency.stream";
+    }
+    else if (type == operationType::COMMIT_STRESS) {
+        path += "commit_stress.stream";
+    }
+    else if (type == operationType::MIXED_NUMA) {
+        path += "mixed_numa.stream";
+    }
     else {
         throw std::runtime_error("Invalid operation type\n");
     }
@@ -1390,6 +1661,7 @@ void Driver<F, S>::execute(operationType type, targetStreamType ts_type) {
 //        execute_insert_real_ldbc(m_workload_dir); // for real ldbc insertion
         mem_total += getValue() - mem1;
         std::cout << "Total Mem: " << (int)mem_total << std::endl;  // NOTE: Aspen do not have property, we manually compute and add its size to Aspen's consumption.
+        std::cout << wrapper::memory_report(m_method);
         execute_query();
         return;
     }
@@ -1540,6 +1812,57 @@ void Driver<F, S>::execute(operationType type, targetStreamType ts_type) {
             break;
         }
         
+        case operationType::READER_LATENCY : {
+            initial_path = m_workload_dir + "/initial_stream_insert_general.stream";
+            target_path = m_workload_dir + "/target_stream_";
+            output_path = m_output_dir + "/output_" + std::to_string(m_config.writer_threads) + "_";
+            generate_path_type(target_path, operationType::INSERT);
+            generate_path_ts(target_path, targetStreamType::GENERAL);
+            generate_path_type(output_path, type);
+
+            read_stream(initial_path, *initial_stream);
+            initialize_graph(initial_stream);
+
+            for (auto & operationType : m_config.mb_operation_types) {
+                for (auto target_type : m_config.mb_ts_types) {
+                    auto target_path2 = m_workload_dir + "/target_stream_";
+                    generate_path_type(target_path2, operationType);
+                    generate_path_ts(target_path2, target_type);
+
+                    execute_reader_latency(target_path, target_path2, output_path);
+                }
+            }
+            break;
+        }
+
+        case operationType::COMMIT_STRESS : {
+            initial_path = m_workload_dir + "/initial_stream_insert_general.stream";
+            target_path = m_workload_dir + "/target_stream_";
+            output_path = m_output_dir + "/output_" + std::to_string(m_config.writer_threads) + "_";
+            generate_path_type(target_path, operationType::INSERT);
+            generate_path_ts(target_path, targetStreamType::GENERAL);
+            generate_path_type(output_path, type);
+
+            read_stream(initial_path, *initial_stream);
+            initialize_graph(initial_stream);
+            execute_commit_stress(target_path, output_path);
+            break;
+        }
+
+        case operationType::MIXED_NUMA : {
+            initial_path = m_workload_dir + "/initial_stream_insert_general.stream";
+            target_path = m_workload_dir + "/target_stream_";
+            output_path = m_output_dir + "/output_" + std::to_string(m_config.writer_threads) + "_";
+            generate_path_type(target_path, operationType::INSERT);
+            generate_path_ts(target_path, targetStreamType::GENERAL);
+            generate_path_type(output_path, type);
+
+            read_stream(initial_path, *initial_stream);
+            initialize_graph(initial_stream);
+            execute_mixed_numa(target_path, output_path);
+            break;
+        }
+
         case operationType::QOS :
             initial_path = m_workload_dir + "/initial_stream_insert_full.stream";
             read_stream(initial_path, *initial_stream);
@@ -29,6 +29,40 @@ namespace wrapper {
         w.end_thread(thread_id);
     }
 
+    // NUMA placement, systems without it live on a single node
+    template<class W>
+    uint64_t numa_node_num(W &w) {
+        if constexpr (requires { w.numa_node_num(); }) {
+            return w.numa_node_num();
+        } else {
+            return 1;
+        }
+    }
+    template<class W>
+    uint64_t home_node(W &w, uint64_t vertex) {
+        if constexpr (requires { w.home_node(vertex); }) {
+            return w.home_node(vertex);
+        } else {
+            return 0;
+        }
+    }
+    template<class W>
+    void bind_thread_to_node(W &w, uint64_t node) {
+        if constexpr (requires { w.bind_thread_to_node(node); }) {
+            w.bind_thread_to_node(node);
+        }
+    }
+
+    // Per-structure memory breakdown, empty for systems that only have the process RSS
+    template<class W>
+    std::string memory_report(W &w) {
+        if constexpr (requires { w.memory_report(); }) {
+            return w.memory_report();
+        } else {
+            return "";
+        }
+    }
+
     // Graph Operations
     template<class W>
     bool is_directed(W &w) {
@@ -186,19 +220,38 @@ namespace wrapper {
         return s->degree(source, logical);
     }
 
+    // snapshots without the logical flag always take logical IDs; has_vertex tells them apart, a flag passed to
+    // has_edge would convert to the weight of the weighted overload
+    template<class S>
+    bool snapshot_has_vertex(S &s, uint64_t vertex, bool logical = false) {
+        if constexpr (requires { s->has_vertex(vertex, logical); }) {
+            return s->has_vertex(vertex, logical);
+        } else {
+            return s->has_vertex(vertex);
+        }
+    }
+
     template<class S>
-    bool snapshot_has_vertex(S &s, uint64_t vertex) {
-        return s->has_vertex(vertex);
+    bool snapshot_has_edge(S &s, driver::graph::weightedEdge edge, bool logical = false) {
+        if constexpr (requires { s->has_vertex(edge.source, logical); }) {
+            return s->has_edge(edge, logical);
+        } else {
+            return s->has_edge(edge);
+        }
     }
 
     template<class S>
-    bool snapshot_has_edge(S &s, driver::graph::weightedEdge edge) {
-        return s->has_edge(edge);
+    bool snapshot_has_edge(S &s, uint64_t source, uint64_t destination, bool logical) {
+        if constexpr (requires { s->has_vertex(source, logical); }) {
+            return s->has_edge(source, destination, logical);
+        } else {
+            return s->has_edge(source, destination);
+        }
     }
 
     template<class S>
     bool snapshot_has_edge(S &s, uint64_t source, uint64_t destination) {
-        return s->has_edge(source, destination);
+        return snapshot_has_edge(s, source, destination, false);
     }
 
     template<class S>